@@ -0,0 +1,142 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../dd-win-prof/CachedCallstack.h"
+#include "pch.h"
+
+namespace {
+const std::vector<uint64_t> Frames = {0x7FF600001000, 0x7FF600002000, 0x7FF600003000};
+
+uint64_t StackTop[CachedCallstack::HashedStackSlots] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+uint64_t GetRsp() { return reinterpret_cast<uint64_t>(StackTop); }
+
+// callstack unwound with the thread suspended, when its context switches count was 100
+CachedCallstack CreateCachedCallstack() {
+  CachedCallstack cachedCallstack;
+  auto hash = CachedCallstack::HashStackTop(GetRsp());
+  cachedCallstack.Update(0x7FF600001000, GetRsp(), hash, Frames, true, 100);
+  return cachedCallstack;
+}
+}  // namespace
+
+TEST(CachedCallstackTests, Empty_NeverReused) {
+  CachedCallstack cachedCallstack;
+  auto hash = CachedCallstack::HashStackTop(GetRsp());
+
+  EXPECT_FALSE(cachedCallstack.IsUnchanged(0));
+  EXPECT_FALSE(cachedCallstack.Matches(0, 0, 0));
+  EXPECT_FALSE(cachedCallstack.Matches(0x7FF600001000, GetRsp(), hash));
+  EXPECT_TRUE(cachedCallstack.GetFrames().empty());
+}
+
+TEST(CachedCallstackTests, Update_FramesAreCopied) {
+  auto cachedCallstack = CreateCachedCallstack();
+
+  auto frames = cachedCallstack.GetFrames();
+  ASSERT_EQ(frames.size(), Frames.size());
+  for (size_t i = 0; i < Frames.size(); i++) {
+    EXPECT_EQ(frames[i], Frames[i]);
+  }
+}
+
+TEST(CachedCallstackTests, Matches_SameContext) {
+  auto cachedCallstack = CreateCachedCallstack();
+  auto hash = CachedCallstack::HashStackTop(GetRsp());
+
+  EXPECT_TRUE(cachedCallstack.Matches(0x7FF600001000, GetRsp(), hash));
+  EXPECT_FALSE(cachedCallstack.Matches(0x7FF600001008, GetRsp(), hash));
+  EXPECT_FALSE(cachedCallstack.Matches(0x7FF600001000, GetRsp() + 8, hash));
+  EXPECT_FALSE(cachedCallstack.Matches(0x7FF600001000, GetRsp(), hash + 1));
+}
+
+TEST(CachedCallstackTests, HashStackTop_ChangesWithStack) {
+  auto hash = CachedCallstack::HashStackTop(GetRsp());
+  EXPECT_NE(hash, 0u);
+  EXPECT_EQ(CachedCallstack::HashStackTop(GetRsp()), hash);
+
+  // a return address pushed by a new call
+  StackTop[CachedCallstack::HashedStackSlots - 1]++;
+  EXPECT_NE(CachedCallstack::HashStackTop(GetRsp()), hash);
+  StackTop[CachedCallstack::HashedStackSlots - 1]--;
+}
+
+// HashStackTop returns 0 when the stack can't be read
+TEST(CachedCallstackTests, Update_NoStackHash_NeverMatches) {
+  auto cachedCallstack = CreateCachedCallstack();
+
+  cachedCallstack.Update(0x7FF600001000, 0, 0, Frames, true, 100);
+  EXPECT_FALSE(cachedCallstack.Matches(0x7FF600001000, 0, 0));
+}
+
+// The suspension that unwound the stack makes the thread switch: the count is not
+// enough until the number of switches per suspension is known
+TEST(CachedCallstackTests, IsUnchanged_AfterSuspension_LearnsSuspensionSwitches) {
+  auto cachedCallstack = CreateCachedCallstack();
+  auto hash = CachedCallstack::HashStackTop(GetRsp());
+
+  // 2 context switches caused by the suspension
+  EXPECT_FALSE(cachedCallstack.IsUnchanged(102));
+  ASSERT_TRUE(cachedCallstack.Matches(0x7FF600001000, GetRsp(), hash));
+  cachedCallstack.OnReusedAfterSuspension(true, 102);
+
+  // seen once: not trusted yet
+  EXPECT_FALSE(cachedCallstack.IsUnchanged(104));
+  cachedCallstack.OnReusedAfterSuspension(true, 104);
+
+  // seen twice
+  EXPECT_TRUE(cachedCallstack.IsUnchanged(106));
+  EXPECT_FALSE(cachedCallstack.IsUnchanged(107));
+  cachedCallstack.OnReusedWithoutSuspension(106);
+
+  // not suspended since the last sample: the count must not change
+  EXPECT_TRUE(cachedCallstack.IsUnchanged(106));
+  EXPECT_FALSE(cachedCallstack.IsUnchanged(108));
+  cachedCallstack.OnReusedWithoutSuspension(106);
+  EXPECT_TRUE(cachedCallstack.IsUnchanged(106));
+}
+
+TEST(CachedCallstackTests, IsUnchanged_DifferentSuspensionSwitches_NotLearned) {
+  auto cachedCallstack = CreateCachedCallstack();
+
+  cachedCallstack.OnReusedAfterSuspension(true, 102);
+  cachedCallstack.OnReusedAfterSuspension(true, 105);
+
+  EXPECT_FALSE(cachedCallstack.IsUnchanged(107));
+  EXPECT_FALSE(cachedCallstack.IsUnchanged(108));
+}
+
+TEST(CachedCallstackTests, IsUnchanged_CountWraps) {
+  CachedCallstack cachedCallstack;
+  auto hash = CachedCallstack::HashStackTop(GetRsp());
+  cachedCallstack.Update(0x7FF600001000, GetRsp(), hash, Frames, true, ULONG_MAX - 1);
+  cachedCallstack.OnReusedAfterSuspension(true, 0);
+  cachedCallstack.OnReusedAfterSuspension(true, 2);
+
+  EXPECT_TRUE(cachedCallstack.IsUnchanged(4));
+}
+
+TEST(CachedCallstackTests, IsUnchanged_NoContextSwitches_NeverUnchanged) {
+  CachedCallstack cachedCallstack;
+  auto hash = CachedCallstack::HashStackTop(GetRsp());
+  cachedCallstack.Update(0x7FF600001000, GetRsp(), hash, Frames, false, 0);
+
+  EXPECT_FALSE(cachedCallstack.IsUnchanged(0));
+  EXPECT_TRUE(cachedCallstack.Matches(0x7FF600001000, GetRsp(), hash));
+}
+
+TEST(CachedCallstackTests, Invalidate) {
+  auto cachedCallstack = CreateCachedCallstack();
+  auto hash = CachedCallstack::HashStackTop(GetRsp());
+  cachedCallstack.OnReusedWithoutSuspension(100);
+  ASSERT_TRUE(cachedCallstack.IsUnchanged(100));
+
+  cachedCallstack.Invalidate();
+  EXPECT_FALSE(cachedCallstack.IsUnchanged(100));
+  EXPECT_FALSE(cachedCallstack.Matches(0x7FF600001000, GetRsp(), hash));
+}
@@ -52,6 +52,17 @@ class ConfigurationTest : public ::testing::Test {
     SaveEnvVar(EnvironmentVariables::ServiceName);
     SaveEnvVar(EnvironmentVariables::AgentHost);
     SaveEnvVar(EnvironmentVariables::ApiKey);
+    SaveEnvVar(EnvironmentVariables::TimelineEnabled);
+    SaveEnvVar(EnvironmentVariables::StackSnapshotEnabled);
+    SaveEnvVar(EnvironmentVariables::FramePointerUnwindingEnabled);
+    SaveEnvVar(EnvironmentVariables::SuspensionDeadline);
+    SaveEnvVar(EnvironmentVariables::MaxMemory);
+    SaveEnvVar(EnvironmentVariables::SymbolCacheSize);
+    SaveEnvVar(EnvironmentVariables::UploadSpoolDirectory);
+    SaveEnvVar(EnvironmentVariables::UploadSpoolMaxSize);
+    SaveEnvVar(EnvironmentVariables::UploadInitialBackoff);
+    SaveEnvVar(EnvironmentVariables::SamplingJitterEnabled);
+    SaveEnvVar(EnvironmentVariables::WalltimeFoldingEnabled);
   }
 
   void TearDown() override {
@@ -213,6 +224,11 @@ TEST_F(ConfigurationTest, ResetToDefaults_RestoresAllFieldsToDefaults) {
   EXPECT_TRUE(config.IsWallTimeProfilingEnabled());
   EXPECT_TRUE(config.IsExportEnabled());
   EXPECT_FALSE(config.AreCallstacksSymbolized());
+  EXPECT_TRUE(config.IsTimelineEnabled());
+  EXPECT_FALSE(config.IsStackSnapshotEnabled());
+  EXPECT_FALSE(config.IsFramePointerUnwindingEnabled());
+  EXPECT_FALSE(config.IsSamplingJitterEnabled());
+  EXPECT_FALSE(config.IsWalltimeFoldingEnabled());
   EXPECT_FALSE(config.IsDebugLogEnabled());
   EXPECT_TRUE(config.GetProfilesOutputDirectory().empty());
 
@@ -226,6 +242,12 @@ TEST_F(ConfigurationTest, ResetToDefaults_RestoresAllFieldsToDefaults) {
   EXPECT_EQ(config.CpuWallTimeSamplingPeriod(), std::chrono::nanoseconds(20'000'000));
   EXPECT_EQ(config.WalltimeThreadsThreshold(), 5);
   EXPECT_EQ(config.CpuThreadsThreshold(), 64);
+  EXPECT_EQ(config.GetSuspensionDeadline(), std::chrono::milliseconds(200));
+  EXPECT_EQ(config.GetMaxMemory(), 256u * 1024 * 1024);
+  EXPECT_EQ(config.GetSymbolCacheSize(), 65536u);
+  EXPECT_EQ(config.GetUploadSpoolMaxSize(), 64u * 1024 * 1024);
+  EXPECT_EQ(config.GetUploadInitialBackoff(), std::chrono::milliseconds(10'000));
+  EXPECT_FALSE(config.GetUploadSpoolDirectory().empty());
 
   EXPECT_TRUE(config.GetApiKey().empty());
   EXPECT_FALSE(config.IsAgentless());
@@ -284,6 +306,212 @@ TEST_F(ConfigurationTest, SetUserTags_Works) {
   EXPECT_EQ(t[1].second, "val2");
 }
 
+TEST_F(ConfigurationTest, TimelineEnabled_FromEnvironmentVariable) {
+  UnsetTestEnvVar(EnvironmentVariables::TimelineEnabled);
+  {
+    Configuration config;
+    EXPECT_TRUE(config.IsTimelineEnabled()) << "Timeline should be enabled by default";
+  }
+
+  SetTestEnvVar(EnvironmentVariables::TimelineEnabled, "0");
+  {
+    Configuration config;
+    EXPECT_FALSE(config.IsTimelineEnabled());
+  }
+
+  SetTestEnvVar(EnvironmentVariables::TimelineEnabled, "true");
+  {
+    Configuration config;
+    EXPECT_TRUE(config.IsTimelineEnabled());
+  }
+}
+
+TEST_F(ConfigurationTest, SetTimelineEnabled_Works) {
+  Configuration config;
+  config.SetTimelineEnabled(false);
+  EXPECT_FALSE(config.IsTimelineEnabled());
+  config.SetTimelineEnabled(true);
+  EXPECT_TRUE(config.IsTimelineEnabled());
+}
+
+TEST_F(ConfigurationTest, StackSnapshotEnabled_FromEnvironmentVariable) {
+  UnsetTestEnvVar(EnvironmentVariables::StackSnapshotEnabled);
+  {
+    Configuration config;
+    EXPECT_FALSE(config.IsStackSnapshotEnabled())
+        << "Stack snapshot should be disabled by default";
+  }
+
+  SetTestEnvVar(EnvironmentVariables::StackSnapshotEnabled, "1");
+  {
+    Configuration config;
+    EXPECT_TRUE(config.IsStackSnapshotEnabled());
+  }
+}
+
+TEST_F(ConfigurationTest, FramePointerUnwindingEnabled_FromEnvironmentVariable) {
+  UnsetTestEnvVar(EnvironmentVariables::FramePointerUnwindingEnabled);
+  {
+    Configuration config;
+    EXPECT_FALSE(config.IsFramePointerUnwindingEnabled())
+        << "Frame pointer unwinding should be disabled by default";
+  }
+
+  SetTestEnvVar(EnvironmentVariables::FramePointerUnwindingEnabled, "1");
+  {
+    Configuration config;
+    EXPECT_TRUE(config.IsFramePointerUnwindingEnabled());
+  }
+}
+
+TEST_F(ConfigurationTest, SamplingJitterEnabled_FromEnvironmentVariable) {
+  UnsetTestEnvVar(EnvironmentVariables::SamplingJitterEnabled);
+  {
+    Configuration config;
+    EXPECT_FALSE(config.IsSamplingJitterEnabled())
+        << "Sampling jitter should be disabled by default";
+  }
+
+  SetTestEnvVar(EnvironmentVariables::SamplingJitterEnabled, "1");
+  {
+    Configuration config;
+    EXPECT_TRUE(config.IsSamplingJitterEnabled());
+  }
+}
+
+TEST_F(ConfigurationTest, WalltimeFoldingEnabled_FromEnvironmentVariable) {
+  UnsetTestEnvVar(EnvironmentVariables::WalltimeFoldingEnabled);
+  {
+    Configuration config;
+    EXPECT_FALSE(config.IsWalltimeFoldingEnabled())
+        << "Walltime folding should be disabled by default";
+  }
+
+  SetTestEnvVar(EnvironmentVariables::WalltimeFoldingEnabled, "1");
+  {
+    Configuration config;
+    EXPECT_TRUE(config.IsWalltimeFoldingEnabled());
+  }
+}
+
+TEST_F(ConfigurationTest, SuspensionDeadline_FromEnvironmentVariable) {
+  UnsetTestEnvVar(EnvironmentVariables::SuspensionDeadline);
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetSuspensionDeadline(), std::chrono::milliseconds(200));
+  }
+
+  SetTestEnvVar(EnvironmentVariables::SuspensionDeadline, "500");
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetSuspensionDeadline(), std::chrono::milliseconds(500));
+  }
+
+  // 0 disables the watchdog
+  SetTestEnvVar(EnvironmentVariables::SuspensionDeadline, "0");
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetSuspensionDeadline(), std::chrono::milliseconds(0));
+  }
+
+  // too short deadlines would resume threads in the middle of normal stack walks
+  SetTestEnvVar(EnvironmentVariables::SuspensionDeadline, "1");
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetSuspensionDeadline(), std::chrono::milliseconds(10));
+  }
+}
+
+TEST_F(ConfigurationTest, MaxMemory_FromEnvironmentVariable) {
+  UnsetTestEnvVar(EnvironmentVariables::MaxMemory);
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetMaxMemory(), 256u * 1024 * 1024);
+  }
+
+  SetTestEnvVar(EnvironmentVariables::MaxMemory, "64");
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetMaxMemory(), 64u * 1024 * 1024);
+  }
+
+  // 0 disables the limit
+  SetTestEnvVar(EnvironmentVariables::MaxMemory, "0");
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetMaxMemory(), 0u);
+  }
+
+  SetTestEnvVar(EnvironmentVariables::MaxMemory, "-1");
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetMaxMemory(), 256u * 1024 * 1024);
+  }
+}
+
+TEST_F(ConfigurationTest, SymbolCacheSize_FromEnvironmentVariable) {
+  UnsetTestEnvVar(EnvironmentVariables::SymbolCacheSize);
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetSymbolCacheSize(), 65536u);
+  }
+
+  SetTestEnvVar(EnvironmentVariables::SymbolCacheSize, "1000");
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetSymbolCacheSize(), 1000u);
+  }
+
+  // 0 disables the limit
+  SetTestEnvVar(EnvironmentVariables::SymbolCacheSize, "0");
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetSymbolCacheSize(), 0u);
+  }
+
+  SetTestEnvVar(EnvironmentVariables::SymbolCacheSize, "-1");
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetSymbolCacheSize(), 65536u);
+  }
+}
+
+TEST_F(ConfigurationTest, UploadSpool_FromEnvironmentVariables) {
+  UnsetTestEnvVar(EnvironmentVariables::UploadSpoolDirectory);
+  UnsetTestEnvVar(EnvironmentVariables::UploadSpoolMaxSize);
+  UnsetTestEnvVar(EnvironmentVariables::UploadInitialBackoff);
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetUploadSpoolMaxSize(), 64u * 1024 * 1024);
+    EXPECT_EQ(config.GetUploadInitialBackoff(), std::chrono::milliseconds(10'000));
+  }
+
+  SetTestEnvVar(EnvironmentVariables::UploadSpoolDirectory, "C:\\temp\\spool");
+  SetTestEnvVar(EnvironmentVariables::UploadSpoolMaxSize, "16");
+  SetTestEnvVar(EnvironmentVariables::UploadInitialBackoff, "500");
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetUploadSpoolDirectory(), fs::path("C:\\temp\\spool"));
+    EXPECT_EQ(config.GetUploadSpoolMaxSize(), 16u * 1024 * 1024);
+    EXPECT_EQ(config.GetUploadInitialBackoff(), std::chrono::milliseconds(500));
+  }
+
+  // 0 disables the spool
+  SetTestEnvVar(EnvironmentVariables::UploadSpoolMaxSize, "0");
+  SetTestEnvVar(EnvironmentVariables::UploadInitialBackoff, "0");
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetUploadSpoolMaxSize(), 0u);
+    EXPECT_EQ(config.GetUploadInitialBackoff(), std::chrono::milliseconds(10'000));
+  }
+
+  SetTestEnvVar(EnvironmentVariables::UploadSpoolMaxSize, "-1");
+  {
+    Configuration config;
+    EXPECT_EQ(config.GetUploadSpoolMaxSize(), 64u * 1024 * 1024);
+  }
+}
+
 TEST_F(ConfigurationTest, SetProfilesOutputDirectory_Works) {
   Configuration config;
   config.SetProfilesOutputDirectory(fs::path("C:\\temp\\pprof"));
@@ -319,6 +547,34 @@ TEST_F(ConfigurationTest, ProfilerConfig_ZeroInitialized_NumericFieldsAreZero) {
   EXPECT_EQ(cfg.cpuThreadsThreshold, 0);
   EXPECT_EQ(cfg.uploadIntervalSeconds, 0);
   EXPECT_FALSE(cfg.symbolizeCallstacks);
+  EXPECT_FALSE(cfg.disableTimeline);
+}
+
+// The fields appended to the struct change its size: a caller built with an older
+// header is detected and the new fields are not read
+TEST_F(ConfigurationTest, ProfilerConfig_Versions_HaveDifferentSizes) {
+  EXPECT_LT(ProfilerConfigV1Size, sizeof(ProfilerConfig));
+  EXPECT_TRUE(IsValidProfilerConfigSize(sizeof(ProfilerConfig)));
+  EXPECT_TRUE(IsValidProfilerConfigSize(ProfilerConfigV1Size));
+  EXPECT_FALSE(IsValidProfilerConfigSize(0));
+  EXPECT_FALSE(IsValidProfilerConfigSize(ProfilerConfigV1Size + 1));
+}
+
+TEST_F(ConfigurationTest, InitConfig_V1Size_DisableTimelineIgnored) {
+  Configuration config;
+  config.SetTimelineEnabled(true);
+
+  // garbage beyond the size of the struct passed by an old caller
+  auto cfg = MakeProfilerConfig();
+  cfg.size = ProfilerConfigV1Size;
+  cfg.disableTimeline = true;
+
+  ASSERT_TRUE(InitializeConfiguration(&config, &cfg));
+  EXPECT_TRUE(config.IsTimelineEnabled());
+
+  cfg.size = sizeof(ProfilerConfig);
+  ASSERT_TRUE(InitializeConfiguration(&config, &cfg));
+  EXPECT_FALSE(config.IsTimelineEnabled());
 }
 
 // ===========================================================================
@@ -394,6 +650,7 @@ TEST_F(ConfigurationTest, InitConfig_NoEnvVars_AllFieldsApplied) {
   cfg.uploadIntervalSeconds = 45;
   cfg.tags = "team:backend,region:us-east";
   cfg.symbolizeCallstacks = true;
+  cfg.disableTimeline = true;
   cfg.pprofOutputDirectory = "C:\\temp\\dd-pprof";
 
   ASSERT_TRUE(InitializeConfiguration(&config, &cfg));
@@ -409,6 +666,7 @@ TEST_F(ConfigurationTest, InitConfig_NoEnvVars_AllFieldsApplied) {
   EXPECT_EQ(config.CpuThreadsThreshold(), 32);
   EXPECT_EQ(config.GetUploadInterval(), std::chrono::seconds(45));
   EXPECT_TRUE(config.AreCallstacksSymbolized());
+  EXPECT_FALSE(config.IsTimelineEnabled());
   EXPECT_EQ(config.GetProfilesOutputDirectory(), fs::path("C:\\temp\\dd-pprof"));
 
   auto const& t = config.GetUserTags();
@@ -435,6 +693,7 @@ TEST_F(ConfigurationTest, InitConfig_NoEnvVars_PartialFields_DefaultsPreserved)
 
   EXPECT_EQ(config.GetServiceName(), "partial-svc");
 
+  EXPECT_TRUE(config.IsTimelineEnabled());
   EXPECT_EQ(config.GetVersion(), "Unspecified-Version");
   EXPECT_EQ(config.GetEnvironment(), "Unspecified-Environment");
   EXPECT_EQ(config.CpuThreadsThreshold(), 64);
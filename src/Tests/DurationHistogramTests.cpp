@@ -0,0 +1,61 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include "../dd-win-prof/DurationHistogram.h"
+#include "pch.h"
+
+using namespace std::chrono_literals;
+
+TEST(DurationHistogramTests, GetBucketIndex_PowerOfTwoMicroseconds) {
+  EXPECT_EQ(DurationHistogram::GetBucketIndex(-5ns), 0);
+  EXPECT_EQ(DurationHistogram::GetBucketIndex(0ns), 0);
+  EXPECT_EQ(DurationHistogram::GetBucketIndex(999ns), 0);
+  EXPECT_EQ(DurationHistogram::GetBucketIndex(1us), 1);
+  EXPECT_EQ(DurationHistogram::GetBucketIndex(1999ns), 1);
+  EXPECT_EQ(DurationHistogram::GetBucketIndex(2us), 2);
+  EXPECT_EQ(DurationHistogram::GetBucketIndex(3us), 2);
+  EXPECT_EQ(DurationHistogram::GetBucketIndex(4us), 3);
+  EXPECT_EQ(DurationHistogram::GetBucketIndex(100us), 7);
+  EXPECT_EQ(DurationHistogram::GetBucketIndex(1s), DurationHistogram::BucketsCount - 1);
+}
+
+TEST(DurationHistogramTests, GetAndReset_ReturnsCountsSinceLastCall) {
+  DurationHistogram histogram;
+  histogram.Record(500ns);
+  histogram.Record(3us);
+  histogram.Record(3500ns);
+  histogram.Record(10us);
+
+  auto counts = histogram.GetAndReset();
+  EXPECT_EQ(counts.count, 4);
+  EXPECT_EQ(counts.buckets[0], 1);
+  EXPECT_EQ(counts.buckets[2], 2);
+  EXPECT_EQ(counts.buckets[4], 1);
+  EXPECT_EQ(counts.total, 17us);
+  EXPECT_EQ(counts.max, 10us);
+
+  counts = histogram.GetAndReset();
+  EXPECT_EQ(counts.count, 0);
+  EXPECT_EQ(counts.total, 0ns);
+  EXPECT_EQ(counts.max, 0ns);
+}
+
+TEST(DurationHistogramTests, ToString_ListsBucketsUpToTheLastUsedOne) {
+  DurationHistogram histogram;
+  EXPECT_EQ(DurationHistogram::ToString(histogram.GetAndReset()), "count=0");
+
+  histogram.Record(500ns);
+  histogram.Record(2500ns);
+  histogram.Record(3us);
+  EXPECT_EQ(
+      DurationHistogram::ToString(histogram.GetAndReset()),
+      "count=3 avg=2us max=3us [<1us:1 1-2us:0 2-4us:2]"
+  );
+
+  histogram.Record(1s);
+  auto text = DurationHistogram::ToString(histogram.GetAndReset());
+  EXPECT_NE(text.find(">=262144us:1]"), std::string::npos) << text;
+}
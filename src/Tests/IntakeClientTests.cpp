@@ -0,0 +1,65 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "../dd-win-prof/IntakeClient.h"
+#include "pch.h"
+
+TEST(IntakeClientTests, GetProfilesUrl_Agent) {
+  EXPECT_EQ(
+      IntakeClient::GetProfilesUrl(true, "http://localhost:8126"),
+      "http://localhost:8126/profiling/v1/input"
+  );
+  EXPECT_EQ(
+      IntakeClient::GetProfilesUrl(true, "http://127.0.0.1:8126/"),
+      "http://127.0.0.1:8126/profiling/v1/input"
+  );
+}
+
+TEST(IntakeClientTests, GetProfilesUrl_Agentless) {
+  EXPECT_EQ(
+      IntakeClient::GetProfilesUrl(false, "datadoghq.eu"),
+      "https://intake.profile.datadoghq.eu/api/v2/profile"
+  );
+}
+
+TEST(IntakeClientTests, BuildMultipartBody_EventThenProfile) {
+  std::vector<uint8_t> profile = {0x1F, 0x8B, 0x00, 0xFF};
+  auto body = IntakeClient::BuildMultipartBody("xyz", R"({"version":"4"})", profile);
+
+  std::string expected =
+      "--xyz\r\n"
+      "Content-Disposition: form-data; name=\"event\"; filename=\"event.json\"\r\n"
+      "Content-Type: application/json\r\n"
+      "\r\n"
+      "{\"version\":\"4\"}\r\n"
+      "--xyz\r\n"
+      "Content-Disposition: form-data; name=\"profile.pprof\"; "
+      "filename=\"profile.pprof\"\r\n"
+      "Content-Type: application/octet-stream\r\n"
+      "\r\n";
+  expected.append(reinterpret_cast<const char*>(profile.data()), profile.size());
+  expected += "\r\n--xyz--\r\n";
+  EXPECT_EQ(body, expected);
+}
+
+TEST(IntakeClientTests, Initialize_UnsupportedUrl_Fails) {
+  IntakeClient client(
+      "unix:///var/run/datadog/apm.socket",
+      "",
+      "dd-win-prof",
+      "1.0",
+      std::chrono::seconds(1)
+  );
+  EXPECT_FALSE(client.Initialize());
+
+  uint16_t responseCode = 0;
+  std::string error;
+  EXPECT_FALSE(client.Send("{}", {}, responseCode, error));
+  EXPECT_FALSE(error.empty());
+}
@@ -0,0 +1,96 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../dd-win-prof/MemoryBudget.h"
+#include "pch.h"
+
+TEST(MemoryBudgetTests, UsageIsAccountedPerStage) {
+  MemoryBudget budget(1000);
+  budget.SetUsage(MemoryStage::SampleRings, 100);
+  budget.SetUsage(MemoryStage::ActiveProfile, 200);
+  budget.SetUsage(MemoryStage::UploadQueue, 50);
+
+  EXPECT_EQ(budget.GetUsage(MemoryStage::SampleRings), 100u);
+  EXPECT_EQ(budget.GetUsage(MemoryStage::ActiveProfile), 200u);
+  EXPECT_EQ(budget.GetUsage(MemoryStage::RetiredProfile), 0u);
+  EXPECT_EQ(budget.GetTotalUsage(), 350u);
+
+  // the usage of a stage is replaced, not added
+  budget.SetUsage(MemoryStage::ActiveProfile, 10);
+  EXPECT_EQ(budget.GetTotalUsage(), 160u);
+}
+
+TEST(MemoryBudgetTests, PressureIncreasesWithUsage) {
+  MemoryBudget budget(1000);
+  EXPECT_EQ(budget.GetPressure(), MemoryPressure::None);
+
+  budget.SetUsage(MemoryStage::ActiveProfile, 600);
+  EXPECT_EQ(budget.GetPressure(), MemoryPressure::None);
+
+  budget.SetUsage(MemoryStage::ActiveProfile, 750);
+  EXPECT_EQ(budget.GetPressure(), MemoryPressure::DropTimestamps);
+  EXPECT_TRUE(budget.IsAtLeast(MemoryPressure::DropTimestamps));
+  EXPECT_FALSE(budget.IsAtLeast(MemoryPressure::ReduceSampling));
+
+  budget.SetUsage(MemoryStage::RetiredProfile, 150);
+  EXPECT_EQ(budget.GetPressure(), MemoryPressure::ReduceSampling);
+
+  budget.SetUsage(MemoryStage::UploadQueue, 200);
+  EXPECT_EQ(budget.GetPressure(), MemoryPressure::DropSamples);
+
+  // back to normal once the memory is released
+  budget.SetUsage(MemoryStage::ActiveProfile, 0);
+  budget.SetUsage(MemoryStage::RetiredProfile, 0);
+  EXPECT_EQ(budget.GetPressure(), MemoryPressure::None);
+}
+
+TEST(MemoryBudgetTests, NoLimit_NoPressure) {
+  MemoryBudget budget(0);
+  budget.SetUsage(MemoryStage::ActiveProfile, 1024 * 1024 * 1024);
+
+  EXPECT_EQ(budget.GetTotalUsage(), 1024u * 1024 * 1024);
+  EXPECT_EQ(budget.GetPressure(), MemoryPressure::None);
+}
+
+TEST(MemoryBudgetTests, ComputePressure_Thresholds) {
+  size_t maxBytes = 256ull * 1024 * 1024;
+  EXPECT_EQ(MemoryBudget::ComputePressure(0, maxBytes), MemoryPressure::None);
+  EXPECT_EQ(
+      MemoryBudget::ComputePressure(maxBytes / 2, maxBytes), MemoryPressure::None
+  );
+  EXPECT_EQ(
+      MemoryBudget::ComputePressure(maxBytes / 100 * 71, maxBytes),
+      MemoryPressure::DropTimestamps
+  );
+  EXPECT_EQ(
+      MemoryBudget::ComputePressure(maxBytes / 10 * 9, maxBytes),
+      MemoryPressure::ReduceSampling
+  );
+  EXPECT_EQ(
+      MemoryBudget::ComputePressure(maxBytes, maxBytes), MemoryPressure::DropSamples
+  );
+  EXPECT_EQ(
+      MemoryBudget::ComputePressure(maxBytes * 4, maxBytes),
+      MemoryPressure::DropSamples
+  );
+}
+
+TEST(MemoryBudgetTests, ToJson_ReportsUsageAndPressure) {
+  MemoryBudget budget(1000);
+  budget.SetUsage(MemoryStage::SampleRings, 100);
+  budget.SetUsage(MemoryStage::ActiveProfile, 800);
+  budget.CountDroppedSamples(3);
+
+  EXPECT_EQ(
+      budget.ToJson(),
+      "{\"budget_bytes\":1000,\"usage_bytes\":900,"
+      "\"pressure\":\"reduce_sampling\",\"dropped_samples\":3,\"stages\":{"
+      "\"sample_rings\":100,\"active_profile\":800,\"retired_profile\":0,"
+      "\"symbol_cache\":0,\"upload_queue\":0}}"
+  );
+}
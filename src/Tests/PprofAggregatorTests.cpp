@@ -419,26 +419,13 @@ TEST_F(PprofAggregatorTest, IntegrationWithProfileExporterAndDebugFileWriting) {
                           .count();
   std::chrono::nanoseconds sampleTimestamp(timestamp);
 
-  // Create a valid ThreadInfo with a real handle
-  HANDLE hThread;
-  ::DuplicateHandle(
-      ::GetCurrentProcess(),
-      ::GetCurrentThread(),
-      ::GetCurrentProcess(),
-      &hThread,
-      0,
-      FALSE,
-      DUPLICATE_SAME_ACCESS
-  );
-  auto threadInfo = std::make_shared<ThreadInfo>(::GetCurrentThreadId(), hThread);
-
   // weird addresses, todo: make these more realistic
   // uint64_t callstack[] = {0x1234567890ABCDEF, 0xFEDCBA0987654321,
   // 0x0000000012345678};
   uint64_t callstack[] = {reinterpret_cast<uint64_t>(&GlobalTestFunction)};
-  auto sample = std::make_shared<Sample>(sampleTimestamp, threadInfo, callstack, 1);
-  sample->AddValue(10000000, 0);  // cpu-time in nanoseconds
-  sample->AddValue(1, 1);         // cpu-samples count
+  Sample sample(sampleTimestamp, ::GetCurrentThreadId(), callstack);
+  sample.AddValue(10000000, 0);  // cpu-time in nanoseconds
+  sample.AddValue(1, 1);         // cpu-samples count
 
   // Add the sample to the ProfileExporter - this uses the exporter's internal
   // aggregator
@@ -4,11 +4,22 @@
 
 #include <Windows.h>
 #include <gtest/gtest.h>
-
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <iostream>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "../dd-win-prof/Configuration.h"
+#include "../dd-win-prof/MemoryBudget.h"
 #include "../dd-win-prof/ProfileExporter.h"
 #include "../dd-win-prof/Sample.h"
 #include "../dd-win-prof/SampleValueType.h"
@@ -68,28 +79,16 @@ TEST_F(ProfileExporterExportTests, ExportWithSamples) {
   std::chrono::nanoseconds timestamp =
       std::chrono::nanoseconds(std::chrono::system_clock::now().time_since_epoch());
 
-  // Create a valid ThreadInfo with a real handle
-  HANDLE hThread;
-  ::DuplicateHandle(
-      ::GetCurrentProcess(),
-      ::GetCurrentThread(),
-      ::GetCurrentProcess(),
-      &hThread,
-      0,
-      FALSE,
-      DUPLICATE_SAME_ACCESS
-  );
-  auto threadInfo = std::make_shared<ThreadInfo>(::GetCurrentThreadId(), hThread);
 
   // Create frames array
   uint64_t frames[] = {0x1000, 0x2000, 0x3000};
 
   // Create sample using constructor
-  auto sample = std::make_shared<Sample>(timestamp, threadInfo, frames, 3);
+  Sample sample(timestamp, ::GetCurrentThreadId(), frames);
 
   // Add sample values for both types (cpu-time and cpu-samples)
-  sample->AddValue(1000000, 0);  // 1ms CPU time in nanoseconds
-  sample->AddValue(1, 1);        // 1 sample count
+  sample.AddValue(1000000, 0);  // 1ms CPU time in nanoseconds
+  sample.AddValue(1, 1);        // 1 sample count
 
   // Add sample to exporter
   EXPECT_TRUE(exporter->Add(sample));
@@ -102,18 +101,6 @@ TEST_F(ProfileExporterExportTests, MultipleExports) {
   // Test multiple consecutive exports
   ASSERT_TRUE(exporter->Initialize());
 
-  // Create a valid ThreadInfo with a real handle
-  HANDLE hThread;
-  ::DuplicateHandle(
-      ::GetCurrentProcess(),
-      ::GetCurrentThread(),
-      ::GetCurrentProcess(),
-      &hThread,
-      0,
-      FALSE,
-      DUPLICATE_SAME_ACCESS
-  );
-  auto threadInfo = std::make_shared<ThreadInfo>(::GetCurrentThreadId(), hThread);
 
   for (int i = 0; i < 3; ++i) {
     // Create a sample for each export
@@ -127,11 +114,11 @@ TEST_F(ProfileExporterExportTests, MultipleExports) {
     };
 
     // Create sample using constructor
-    auto sample = std::make_shared<Sample>(timestamp, threadInfo, frames, 2);
+    Sample sample(timestamp, ::GetCurrentThreadId(), frames);
 
     // Add sample values for both types
-    sample->AddValue(500000 * (i + 1), 0);  // CPU time in nanoseconds
-    sample->AddValue(1, 1);                 // sample count
+    sample.AddValue(500000 * (i + 1), 0);  // CPU time in nanoseconds
+    sample.AddValue(1, 1);                 // sample count
 
     EXPECT_TRUE(exporter->Add(sample));
     EXPECT_TRUE(exporter->Export());
@@ -159,28 +146,16 @@ TEST_F(ProfileExporterExportTests, ConfigurationIntegration) {
   std::chrono::nanoseconds timestamp =
       std::chrono::nanoseconds(std::chrono::system_clock::now().time_since_epoch());
 
-  // Create a valid ThreadInfo with a real handle
-  HANDLE hThread;
-  ::DuplicateHandle(
-      ::GetCurrentProcess(),
-      ::GetCurrentThread(),
-      ::GetCurrentProcess(),
-      &hThread,
-      0,
-      FALSE,
-      DUPLICATE_SAME_ACCESS
-  );
-  auto threadInfo = std::make_shared<ThreadInfo>(::GetCurrentThreadId(), hThread);
 
   // Create frames array
   uint64_t frames[] = {0x1000, 0x2000};
 
   // Create sample using constructor
-  auto sample = std::make_shared<Sample>(timestamp, threadInfo, frames, 2);
+  Sample sample(timestamp, ::GetCurrentThreadId(), frames);
 
   // Add sample values for both types
-  sample->AddValue(1000000, 0);  // 1ms CPU time in nanoseconds
-  sample->AddValue(1, 1);        // 1 sample count
+  sample.AddValue(1000000, 0);  // 1ms CPU time in nanoseconds
+  sample.AddValue(1, 1);        // 1 sample count
 
   EXPECT_TRUE(exporter->Add(sample));
 
@@ -196,24 +171,14 @@ TEST_F(ProfileExporterExportTests, ConfigurationIntegration) {
 // noEnvVars scenarios -- exporter with defaults-only and overridden config
 // ===========================================================================
 
-static std::shared_ptr<Sample> CreateTestSample() {
+// the frames are not owned by the sample: they must outlive it
+static Sample CreateTestSample() {
   auto timestamp =
       std::chrono::nanoseconds(std::chrono::system_clock::now().time_since_epoch());
-  HANDLE hThread;
-  ::DuplicateHandle(
-      ::GetCurrentProcess(),
-      ::GetCurrentThread(),
-      ::GetCurrentProcess(),
-      &hThread,
-      0,
-      FALSE,
-      DUPLICATE_SAME_ACCESS
-  );
-  auto threadInfo = std::make_shared<ThreadInfo>(::GetCurrentThreadId(), hThread);
-  uint64_t frames[] = {0x1000, 0x2000};
-  auto sample = std::make_shared<Sample>(timestamp, threadInfo, frames, 2);
-  sample->AddValue(1000000, 0);
-  sample->AddValue(1, 1);
+  static const uint64_t frames[] = {0x1000, 0x2000};
+  Sample sample(timestamp, ::GetCurrentThreadId(), frames);
+  sample.AddValue(1000000, 0);
+  sample.AddValue(1, 1);
   return sample;
 }
 
@@ -319,4 +284,660 @@ TEST_F(ProfileExporterExportTests, ExporterInitializesWithDefaultsAndExportEnabl
 
   // Explicit cleanup before destruction to avoid potential deadlocks
   exp->Cleanup();
-}
\ No newline at end of file
+}
+// ===========================================================================
+// Double-buffered export -- samples are added while the retired profile is exported
+// ===========================================================================
+
+TEST_F(ProfileExporterExportTests, RotateThenExportRetiredProfile) {
+  ASSERT_TRUE(exporter->Initialize());
+
+  EXPECT_TRUE(exporter->Add(CreateTestSample()));
+
+  // Nothing to export before the first rotation
+  EXPECT_FALSE(exporter->ExportRetiredProfile());
+
+  ASSERT_TRUE(exporter->RotateProfile());
+
+  // The new active profile accepts samples before the retired one is exported
+  EXPECT_TRUE(exporter->Add(CreateTestSample()));
+
+  // The retired profile must be exported before the next rotation
+  EXPECT_FALSE(exporter->RotateProfile());
+
+  EXPECT_TRUE(exporter->ExportRetiredProfile());
+  EXPECT_FALSE(exporter->ExportRetiredProfile());
+
+  // The sample added during the export ends up in the next profile
+  EXPECT_TRUE(exporter->Export());
+}
+
+TEST_F(ProfileExporterExportTests, AddWhileRetiredProfileIsExported) {
+  ASSERT_TRUE(exporter->Initialize());
+
+  // Same locking scheme as SamplesCollector: Add() and RotateProfile() share a lock
+  // but ExportRetiredProfile() runs without it
+  std::mutex collectLock;
+  std::atomic<bool> exportsDone{false};
+  constexpr int ExportCount = 5;
+
+  std::thread exportThread([&]() {
+    for (int i = 0; i < ExportCount; ++i) {
+      bool rotated = false;
+      {
+        std::lock_guard lock(collectLock);
+        rotated = exporter->RotateProfile();
+      }
+      EXPECT_TRUE(rotated);
+      EXPECT_TRUE(exporter->ExportRetiredProfile());
+    }
+    exportsDone = true;
+  });
+
+  auto sample = CreateTestSample();
+  int addedCount = 0;
+  while (!exportsDone) {
+    std::lock_guard lock(collectLock);
+    EXPECT_TRUE(exporter->Add(sample));
+    addedCount++;
+  }
+  exportThread.join();
+
+  EXPECT_GT(addedCount, 0);
+  EXPECT_TRUE(exporter->Export(true));
+}
+
+TEST_F(ProfileExporterExportTests, MemoryPressureDropsSamplesWithNewCallstacks) {
+  // the aggregation table of the active profile is already larger than the budget
+  MemoryBudget budget(1000);
+  ProfileExporter budgetedExporter(
+      config.get(), sampleTypes, nullptr, nullptr, nullptr, nullptr, &budget
+  );
+  ASSERT_TRUE(budgetedExporter.Initialize());
+
+  auto timestamp =
+      std::chrono::nanoseconds(std::chrono::system_clock::now().time_since_epoch());
+  uint64_t knownFrames[] = {0x1000, 0x2000};
+  uint64_t newFrames[] = {0x3000};
+  SampleBatch batch;
+  auto addSample = [&](std::span<const uint64_t> frames) {
+    auto& sample = batch.Add(timestamp, ::GetCurrentThreadId(), frames);
+    sample.AddValue(1000000, 0);
+    sample.AddValue(1, 1);
+  };
+
+  addSample(knownFrames);
+  EXPECT_EQ(budgetedExporter.Add(batch.GetSamples()), 1u);
+  EXPECT_GT(budget.GetUsage(MemoryStage::ActiveProfile), 1000u);
+  EXPECT_EQ(budget.GetPressure(), MemoryPressure::DropSamples);
+
+  // the known callstack still gets its values (without timestamp)
+  batch.Clear();
+  addSample(knownFrames);
+  addSample(newFrames);
+  EXPECT_EQ(budgetedExporter.Add(batch.GetSamples()), 1u);
+  EXPECT_EQ(budget.GetDroppedSamplesCount(), 1u);
+
+  ASSERT_TRUE(budgetedExporter.Export(true));
+  const auto& stats = budgetedExporter.GetLastExportStats();
+  EXPECT_EQ(stats.samplesCount, 2u);
+  EXPECT_EQ(stats.droppedSamplesCount, 1u);
+  EXPECT_EQ(stats.uniqueSamplesCount, 1u);
+  EXPECT_EQ(stats.pprofSamplesCount, 2u);  // one timed and one untimed
+}
+
+// ===========================================================================
+// Timeline vs aggregated mode -- profile size and serialization cost
+// ===========================================================================
+
+// Synthetic stream: a few threads sampling a limited set of callstacks every 10ms
+static ProfileExporter::ExportStats ExportSyntheticSamples(bool isTimelineEnabled) {
+  Configuration benchConfig;
+  benchConfig.SetExportEnabled(false);
+  benchConfig.SetTimelineEnabled(isTimelineEnabled);
+
+  std::vector<SampleValueType> types = {
+      {"cpu-time", "nanoseconds"}, {"cpu-samples", "count"}
+  };
+  Sample::SetValuesCount(types.size());
+
+  ProfileExporter exp(&benchConfig, types);
+  EXPECT_TRUE(exp.Initialize());
+
+  constexpr int ThreadsCount = 8;
+  constexpr int StacksCount = 64;
+  constexpr int SamplesCount = 20000;
+  constexpr int FramesCount = 16;
+
+  auto start =
+      std::chrono::nanoseconds(std::chrono::system_clock::now().time_since_epoch());
+  uint64_t frames[FramesCount];
+  SampleBatch batch;
+  for (int i = 0; i < SamplesCount; i++) {
+    int stack = (i * 7) % StacksCount;
+    for (int f = 0; f < FramesCount; f++) {
+      frames[f] = 0x10000 + (stack * FramesCount + f) * 0x10;
+    }
+
+    auto& sample = batch.Add(
+        start + std::chrono::milliseconds(10 * i), 1000 + (i % ThreadsCount), frames
+    );
+    sample.AddValue(10'000'000, 0);
+    sample.AddValue(1, 1);
+  }
+  EXPECT_EQ(exp.Add(batch.GetSamples()), static_cast<size_t>(SamplesCount));
+
+  EXPECT_TRUE(exp.Export(true));
+  return exp.GetLastExportStats();
+}
+
+TEST_F(ProfileExporterExportTests, TimelineVsAggregatedModeBenchmark) {
+  auto timeline = ExportSyntheticSamples(true);
+  auto aggregated = ExportSyntheticSamples(false);
+
+  auto toUs = [](const ProfileExporter::ExportStats& stats) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               stats.flushDuration + stats.serializeDuration
+    )
+        .count();
+  };
+  std::cout << "Timeline mode:   " << timeline.samplesCount << " samples -> "
+            << timeline.pprofSamplesCount << " pprof samples, "
+            << timeline.profileSize << " bytes, " << toUs(timeline) << " us"
+            << std::endl;
+  std::cout << "Aggregated mode: " << aggregated.samplesCount << " samples -> "
+            << aggregated.pprofSamplesCount << " pprof samples, "
+            << aggregated.profileSize << " bytes, " << toUs(aggregated) << " us"
+            << std::endl;
+
+  EXPECT_EQ(timeline.samplesCount, aggregated.samplesCount);
+  EXPECT_EQ(timeline.uniqueSamplesCount, aggregated.uniqueSamplesCount);
+  EXPECT_EQ(timeline.pprofSamplesCount, timeline.samplesCount);
+  EXPECT_EQ(aggregated.pprofSamplesCount, aggregated.uniqueSamplesCount);
+
+  // without timestamps, identical samples are merged into much smaller profiles
+  EXPECT_LT(aggregated.profileSize, timeline.profileSize);
+}
+
+// ===========================================================================
+// Label sets -- shared by the entries of the same thread and RUM view
+// ===========================================================================
+
+struct LabelSetBenchmarkResult {
+  ProfileExporter::ExportStats stats;
+  std::chrono::nanoseconds duration;  // Add + export
+};
+
+// Many callstacks sampled on a few threads, in and out of a RUM view
+static LabelSetBenchmarkResult ExportManyStacks(bool isLabelSetCacheEnabled) {
+  Configuration benchConfig;
+  benchConfig.SetExportEnabled(false);
+  benchConfig.SetTimelineEnabled(false);
+
+  std::vector<SampleValueType> types = {
+      {"cpu-time", "nanoseconds"}, {"cpu-samples", "count"}
+  };
+  Sample::SetValuesCount(types.size());
+
+  RumViewRegistry rumViews;
+  auto checkoutView =
+      rumViews.Enter("0f8e2f0a-3c2b-4b8e-9a55-6c1f2d3e4b5a", "checkout");
+
+  ProfileExporter exp(&benchConfig, types, nullptr, nullptr, &rumViews);
+  EXPECT_TRUE(exp.Initialize());
+  exp.SetLabelSetCacheEnabled(isLabelSetCacheEnabled);
+
+  constexpr int ThreadsCount = 8;
+  constexpr int StacksCount = 4096;
+  constexpr int SamplesCount = 50000;
+  constexpr int FramesCount = 16;
+
+  auto start =
+      std::chrono::nanoseconds(std::chrono::system_clock::now().time_since_epoch());
+  uint64_t frames[FramesCount];
+  SampleBatch batch;
+  for (int i = 0; i < SamplesCount; i++) {
+    int stack = (i * 7) % StacksCount;
+    for (int f = 0; f < FramesCount; f++) {
+      frames[f] = 0x10000 + (stack * FramesCount + f) * 0x10;
+    }
+
+    auto& sample = batch.Add(
+        start + std::chrono::milliseconds(10 * i), 1000 + (i % ThreadsCount), frames
+    );
+    sample.AddValue(10'000'000, 0);
+    sample.AddValue(1, 1);
+    if ((i / ThreadsCount) % 2 == 0) {
+      sample.SetRumViewHandle(checkoutView);
+    }
+  }
+
+  auto addStart = std::chrono::steady_clock::now();
+  EXPECT_EQ(exp.Add(batch.GetSamples()), static_cast<size_t>(SamplesCount));
+  EXPECT_TRUE(exp.Export(true));
+  auto duration = std::chrono::steady_clock::now() - addStart;
+
+  return {exp.GetLastExportStats(), duration};
+}
+
+TEST_F(ProfileExporterExportTests, LabelSetCacheBenchmark) {
+  auto before = ExportManyStacks(false);
+  auto after = ExportManyStacks(true);
+
+  auto print = [](const char* name, const LabelSetBenchmarkResult& result) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(result.duration)
+                  .count();
+    std::cout << name << result.stats.samplesCount << " samples, "
+              << result.stats.uniqueSamplesCount << " entries -> "
+              << result.stats.labelSetsCount << " label sets, " << us << " us ("
+              << (us > 0 ? result.stats.samplesCount * 1'000'000 / us : 0)
+              << " samples/s)" << std::endl;
+  };
+  print("Without label set cache: ", before);
+  print("With label set cache:    ", after);
+
+  EXPECT_EQ(before.stats.pprofSamplesCount, after.stats.pprofSamplesCount);
+  EXPECT_EQ(before.stats.labelSetsCount, before.stats.uniqueSamplesCount);
+
+  // one label set per thread and view
+  EXPECT_EQ(after.stats.labelSetsCount, 16u);
+}
+
+// ===========================================================================
+// Upload -- local HTTP intake injecting latency and failures
+// ===========================================================================
+
+// Minimal HTTP/1.1 server on 127.0.0.1 answering the scripted status codes, then the
+// default one; each request is recorded and its connection closed after the response
+class MockIntake {
+ public:
+  struct Request {
+    std::string path;
+    std::string headers;  // lower case
+    std::string body;
+    uint16_t responseCode;
+  };
+
+  ~MockIntake() { Stop(); }
+
+  bool Start() {
+    WSADATA wsaData;
+    if (::WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+      return false;
+    }
+    _isWsaStarted = true;
+
+    _listenSocket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (_listenSocket == INVALID_SOCKET) {
+      return false;
+    }
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;  // any free port
+    auto pAddress = reinterpret_cast<sockaddr*>(&address);
+    int addressSize = sizeof(address);
+    if ((::bind(_listenSocket, pAddress, addressSize) != 0) ||
+        (::listen(_listenSocket, SOMAXCONN) != 0) ||
+        (::getsockname(_listenSocket, pAddress, &addressSize) != 0)) {
+      return false;
+    }
+    _port = ::ntohs(address.sin_port);
+
+    _acceptThread = std::thread([this] { AcceptLoop(); });
+    return true;
+  }
+
+  void Stop() {
+    // unblocks accept()
+    if (_listenSocket != INVALID_SOCKET) {
+      ::closesocket(_listenSocket);
+      _listenSocket = INVALID_SOCKET;
+    }
+    if (_acceptThread.joinable()) {
+      _acceptThread.join();
+    }
+    if (_isWsaStarted) {
+      ::WSACleanup();
+      _isWsaStarted = false;
+    }
+  }
+
+  std::string GetUrl() const { return "http://127.0.0.1:" + std::to_string(_port); }
+
+  void SetResponseCodes(std::vector<uint16_t> responseCodes) {
+    std::lock_guard lock(_lock);
+    _responseCodes = std::move(responseCodes);
+  }
+
+  std::vector<Request> GetRequests() const {
+    std::lock_guard lock(_lock);
+    return _requests;
+  }
+
+  bool WaitForRequests(size_t count, std::chrono::milliseconds timeout = 10s) {
+    std::unique_lock lock(_lock);
+    return _requestReceived.wait_for(lock, timeout, [this, count] {
+      return _requests.size() >= count;
+    });
+  }
+
+ public:
+  std::atomic<uint16_t> defaultResponseCode{202};
+  std::atomic<int64_t> latencyMs{0};
+
+ private:
+  void AcceptLoop() {
+    while (true) {
+      SOCKET connection = ::accept(_listenSocket, nullptr, nullptr);
+      if (connection == INVALID_SOCKET) {
+        return;  // stopped
+      }
+      HandleConnection(connection);
+      ::closesocket(connection);
+    }
+  }
+
+  void HandleConnection(SOCKET connection) {
+    std::string received;
+    size_t headersEnd;
+    while ((headersEnd = received.find("\r\n\r\n")) == std::string::npos) {
+      if (!Receive(connection, received)) {
+        return;
+      }
+    }
+
+    Request request;
+    auto requestLine = received.substr(0, received.find("\r\n"));
+    auto pathStart = requestLine.find(' ') + 1;
+    auto pathEnd = requestLine.find(' ', pathStart);
+    request.path = requestLine.substr(pathStart, pathEnd - pathStart);
+    request.headers = received.substr(0, headersEnd);
+    for (auto& c : request.headers) {
+      c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    received.erase(0, headersEnd + 4);
+
+    if (!ReceiveBody(connection, request.headers, received, request.body)) {
+      return;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(latencyMs.load()));
+
+    {
+      std::lock_guard lock(_lock);
+      if (!_responseCodes.empty()) {
+        request.responseCode = _responseCodes.front();
+        _responseCodes.erase(_responseCodes.begin());
+      } else {
+        request.responseCode = defaultResponseCode;
+      }
+    }
+
+    auto response = "HTTP/1.1 " + std::to_string(request.responseCode) +
+                    " Mock\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    ::send(connection, response.data(), static_cast<int>(response.size()), 0);
+
+    {
+      std::lock_guard lock(_lock);
+      _requests.push_back(std::move(request));
+    }
+    _requestReceived.notify_all();
+  }
+
+  // Content-Length (WinHTTP) or chunked (libdatadog) body
+  static bool ReceiveBody(
+      SOCKET connection,
+      const std::string& headers,
+      std::string& received,
+      std::string& body
+  ) {
+    auto contentLength = headers.find("content-length:");
+    if (contentLength != std::string::npos) {
+      auto size = std::stoul(headers.substr(contentLength + 15));
+      while (received.size() < size) {
+        if (!Receive(connection, received)) {
+          return false;
+        }
+      }
+      body = received.substr(0, size);
+      return true;
+    }
+
+    if (headers.find("transfer-encoding: chunked") == std::string::npos) {
+      return true;
+    }
+
+    while (true) {
+      size_t lineEnd;
+      while ((lineEnd = received.find("\r\n")) == std::string::npos) {
+        if (!Receive(connection, received)) {
+          return false;
+        }
+      }
+      auto chunkSize = std::stoul(received.substr(0, lineEnd), nullptr, 16);
+      while (received.size() < lineEnd + 2 + chunkSize + 2) {
+        if (!Receive(connection, received)) {
+          return false;
+        }
+      }
+      body.append(received, lineEnd + 2, chunkSize);
+      received.erase(0, lineEnd + 2 + chunkSize + 2);
+      if (chunkSize == 0) {
+        return true;
+      }
+    }
+  }
+
+  static bool Receive(SOCKET connection, std::string& received) {
+    char buffer[16 * 1024];
+    int size = ::recv(connection, buffer, sizeof(buffer), 0);
+    if (size <= 0) {
+      return false;
+    }
+    received.append(buffer, size);
+    return true;
+  }
+
+ private:
+  SOCKET _listenSocket = INVALID_SOCKET;
+  uint16_t _port = 0;
+  bool _isWsaStarted = false;
+  std::thread _acceptThread;
+
+  mutable std::mutex _lock;
+  std::condition_variable _requestReceived;
+  std::vector<uint16_t> _responseCodes;
+  std::vector<Request> _requests;
+};
+
+// Sequence number of the profile, from the tags of its event.json
+static std::string GetProfileSeq(const MockIntake::Request& request) {
+  auto start = request.body.find("profile_seq:");
+  if (start == std::string::npos) {
+    return {};
+  }
+  start += 12;
+  auto end = request.body.find_first_not_of("0123456789", start);
+  return request.body.substr(start, end - start);
+}
+
+class ProfileExporterMockIntakeTests : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(intake.Start());
+
+    spoolDirectory =
+        fs::temp_directory_path() /
+        ("dd-win-prof-exporter-spool-" + std::to_string(::GetCurrentProcessId()));
+    std::error_code ec;
+    fs::remove_all(spoolDirectory, ec);
+
+    config.ResetToDefaults();
+    config.SetExportEnabled(true);
+    config.SetAgentUrl(intake.GetUrl());
+    config.SetServiceName("mock-intake-tests");
+    config.SetUploadInitialBackoff(50ms);
+    config.SetUploadSpoolDirectory(spoolDirectory);
+
+    sampleTypes = {{"cpu-time", "nanoseconds"}, {"cpu-samples", "count"}};
+    Sample::SetValuesCount(sampleTypes.size());
+  }
+
+  void TearDown() override {
+    intake.Stop();
+    std::error_code ec;
+    fs::remove_all(spoolDirectory, ec);
+  }
+
+  size_t GetSpooledFilesCount() const {
+    size_t count = 0;
+    std::error_code ec;
+    for (const auto& entry :
+         fs::directory_iterator(spoolDirectory / "mock-intake-tests", ec)) {
+      if (entry.path().extension() == UploadSpool::FileExtension) {
+        count++;
+      }
+    }
+    return count;
+  }
+
+  MockIntake intake;
+  fs::path spoolDirectory;
+  Configuration config;
+  std::vector<SampleValueType> sampleTypes;
+};
+
+TEST_F(ProfileExporterMockIntakeTests, IntakeFailing_ProfileRetriedUntilAccepted) {
+  // the intake is down, then overloaded (timeout, rate limited)
+  intake.SetResponseCodes({503, 408, 429});
+
+  ProfileExporter exp(&config, sampleTypes);
+  ASSERT_TRUE(exp.Initialize()) << exp.GetLastError();
+  EXPECT_TRUE(exp.Add(CreateTestSample()));
+  EXPECT_TRUE(exp.Export());
+
+  // the first attempt goes through libdatadog, the next ones send the same bytes
+  ASSERT_TRUE(intake.WaitForRequests(4));
+  auto requests = intake.GetRequests();
+  std::vector<uint16_t> responseCodes;
+  for (const auto& request : requests) {
+    responseCodes.push_back(request.responseCode);
+    EXPECT_EQ(request.path, "/profiling/v1/input");
+    EXPECT_NE(request.body.find("profile.pprof"), std::string::npos);
+    EXPECT_EQ(GetProfileSeq(request), GetProfileSeq(requests[0]));
+  }
+  EXPECT_EQ(responseCodes, (std::vector<uint16_t>{503, 408, 429, 202}));
+  EXPECT_FALSE(GetProfileSeq(requests[0]).empty());
+
+  exp.Cleanup();
+  EXPECT_EQ(intake.GetRequests().size(), 4u);
+  EXPECT_EQ(GetSpooledFilesCount(), 0u);
+}
+
+TEST_F(ProfileExporterMockIntakeTests, IntakeRefusing_ProfileNotRetried) {
+  intake.defaultResponseCode = 403;
+
+  ProfileExporter exp(&config, sampleTypes);
+  ASSERT_TRUE(exp.Initialize()) << exp.GetLastError();
+  EXPECT_TRUE(exp.Add(CreateTestSample()));
+  EXPECT_TRUE(exp.Export());
+
+  ASSERT_TRUE(intake.WaitForRequests(1));
+  std::this_thread::sleep_for(300ms);
+  exp.Cleanup();
+  EXPECT_EQ(intake.GetRequests().size(), 1u);
+  EXPECT_EQ(GetSpooledFilesCount(), 0u);
+}
+
+TEST_F(ProfileExporterMockIntakeTests, SlowIntake_ExportDoesNotWait) {
+  intake.latencyMs = 2000;
+
+  ProfileExporter exp(&config, sampleTypes);
+  ASSERT_TRUE(exp.Initialize()) << exp.GetLastError();
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 2; i++) {
+    EXPECT_TRUE(exp.Add(CreateTestSample()));
+    EXPECT_TRUE(exp.Export());
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+
+  // both profiles are sent, one after the other
+  ASSERT_TRUE(intake.WaitForRequests(2));
+  exp.Cleanup();
+  auto requests = intake.GetRequests();
+  ASSERT_EQ(requests.size(), 2u);
+  EXPECT_NE(GetProfileSeq(requests[0]), GetProfileSeq(requests[1]));
+}
+
+TEST_F(ProfileExporterMockIntakeTests, IntakeDown_ProfilesSpooledThenSentLater) {
+  intake.defaultResponseCode = 503;
+  std::vector<std::string> profileSeqs;
+  {
+    ProfileExporter exp(&config, sampleTypes);
+    ASSERT_TRUE(exp.Initialize()) << exp.GetLastError();
+    for (int i = 0; i < 2; i++) {
+      EXPECT_TRUE(exp.Add(CreateTestSample()));
+      EXPECT_TRUE(exp.Export());
+    }
+    ASSERT_TRUE(intake.WaitForRequests(1));
+
+    // the profiles that could not be sent are kept for the next process
+    exp.Cleanup();
+    EXPECT_EQ(GetSpooledFilesCount(), 2u);
+
+    for (const auto& request : intake.GetRequests()) {
+      EXPECT_EQ(request.responseCode, 503);
+      auto profileSeq = GetProfileSeq(request);
+      if (std::find(profileSeqs.begin(), profileSeqs.end(), profileSeq) ==
+          profileSeqs.end()) {
+        profileSeqs.push_back(profileSeq);
+      }
+    }
+  }
+
+  // the intake is back: the next exporter of the service drains the spool
+  intake.defaultResponseCode = 202;
+  auto failedRequestsCount = intake.GetRequests().size();
+
+  ProfileExporter exp(&config, sampleTypes);
+  ASSERT_TRUE(exp.Initialize()) << exp.GetLastError();
+  ASSERT_TRUE(intake.WaitForRequests(failedRequestsCount + 2));
+  exp.Cleanup();
+
+  auto requests = intake.GetRequests();
+  ASSERT_EQ(requests.size(), failedRequestsCount + 2);
+  std::vector<std::string> sentProfileSeqs;
+  for (size_t i = failedRequestsCount; i < requests.size(); i++) {
+    EXPECT_EQ(requests[i].responseCode, 202);
+    sentProfileSeqs.push_back(GetProfileSeq(requests[i]));
+  }
+
+  // oldest first; the second profile might not have been attempted before the stop
+  ASSERT_FALSE(profileSeqs.empty());
+  EXPECT_EQ(sentProfileSeqs[0], profileSeqs[0]);
+  EXPECT_NE(sentProfileSeqs[0], sentProfileSeqs[1]);
+  EXPECT_EQ(GetSpooledFilesCount(), 0u);
+}
+
+TEST(ProfileExporterUploadTests, SerializeEventToJson_SameEventAsLibdatadog) {
+  PendingUpload upload;
+  upload.exportId = 7;
+  upload.startMs = 1'700'000'000'000;
+  upload.endMs = 1'700'000'060'000;
+  upload.exportTags = {{"service", "my \"service\""}, {"profile_seq", "7"}};
+  upload.endpointCounts = {{"GET /users", 12}};
+  upload.infoJson = R"({"profiler":{"version":"1.0"}})";
+
+  EXPECT_EQ(
+      ProfileExporter::SerializeEventToJson(upload),
+      R"({"attachments":["profile.pprof"],)"
+      R"("tags_profiler":"service:my \"service\",profile_seq:7",)"
+      R"("start":"2023-11-14T22:13:20.000Z","end":"2023-11-14T22:14:20.000Z",)"
+      R"("family":"native","version":"4",)"
+      R"("endpoint_counts":{"counts":{"GET /users":12}},)"
+      R"("internal":{},"info":{"profiler":{"version":"1.0"}}})"
+  );
+}
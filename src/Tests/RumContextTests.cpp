@@ -4,13 +4,19 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <iostream>
 #include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "../dd-win-prof/Configuration.h"
 #include "../dd-win-prof/ProfileExporter.h"
 #include "../dd-win-prof/Profiler.h"
 #include "../dd-win-prof/RumContext.h"
+#include "../dd-win-prof/RumViewRegistry.h"
 #include "../dd-win-prof/Sample.h"
 #include "../dd-win-prof/SampleValueType.h"
 #include "../dd-win-prof/ThreadInfo.h"
@@ -296,51 +302,168 @@ TEST_F(ProfilerRumContextTest, ViewContextCopyIsIndependent) {
 // Sample RUM view context tests
 // ---------------------------------------------------------------------------
 
-TEST(SampleRumViewContextTests, DefaultSampleHasEmptyRumView) {
-  HANDLE hThread;
-  ::DuplicateHandle(
-      ::GetCurrentProcess(),
-      ::GetCurrentThread(),
-      ::GetCurrentProcess(),
-      &hThread,
-      0,
-      FALSE,
-      DUPLICATE_SAME_ACCESS
-  );
-  auto threadInfo = std::make_shared<ThreadInfo>(::GetCurrentThreadId(), hThread);
+TEST(SampleRumViewContextTests, DefaultSampleHasNoRumView) {
   uint64_t frames[] = {0x1000};
-  Sample sample(std::chrono::nanoseconds(0), threadInfo, frames, 1);
-
-  const auto& rumView = sample.GetRumViewContext();
-  EXPECT_TRUE(rumView.view_id.empty());
-  EXPECT_TRUE(rumView.view_name.empty());
-}
-
-TEST(SampleRumViewContextTests, SetAndGetRumViewContext) {
-  HANDLE hThread;
-  ::DuplicateHandle(
-      ::GetCurrentProcess(),
-      ::GetCurrentThread(),
-      ::GetCurrentProcess(),
-      &hThread,
-      0,
-      FALSE,
-      DUPLICATE_SAME_ACCESS
-  );
-  auto threadInfo = std::make_shared<ThreadInfo>(::GetCurrentThreadId(), hThread);
+  Sample sample(std::chrono::nanoseconds(0), ::GetCurrentThreadId(), frames);
+
+  EXPECT_EQ(sample.GetRumViewHandle(), RumViewRegistry::NoView);
+}
+
+TEST(SampleRumViewContextTests, SetAndGetRumViewHandle) {
   uint64_t frames[] = {0x1000};
-  Sample sample(std::chrono::nanoseconds(0), threadInfo, frames, 1);
+  Sample sample(std::chrono::nanoseconds(0), ::GetCurrentThreadId(), frames);
 
-  RumViewContext ctx;
-  ctx.view_id = "view-abc";
-  ctx.view_name = "TestPage";
-  sample.SetRumViewContext(std::move(ctx));
+  RumViewRegistry rumViews;
+  auto handle = rumViews.Enter("view-abc", "TestPage");
+  sample.SetRumViewHandle(handle);
 
-  const auto& rumView = sample.GetRumViewContext();
+  RumViewContext rumView;
+  ASSERT_TRUE(rumViews.Resolve(sample.GetRumViewHandle(), rumView));
   EXPECT_EQ(rumView.view_id, "view-abc");
   EXPECT_EQ(rumView.view_name, "TestPage");
 }
 
+// ---------------------------------------------------------------------------
+// RumViewRegistry tests
+// ---------------------------------------------------------------------------
+
+TEST(RumViewRegistryTests, EnterLeave_PublishesCurrentHandle) {
+  RumViewRegistry rumViews;
+  EXPECT_EQ(rumViews.GetCurrentHandle(), RumViewRegistry::NoView);
+
+  auto home = rumViews.Enter("view-1", "HomePage");
+  EXPECT_NE(home, RumViewRegistry::NoView);
+  EXPECT_EQ(rumViews.GetCurrentHandle(), home);
+
+  // re-entering the same view gets a new handle
+  auto settings = rumViews.Enter("view-2", "SettingsPage");
+  auto homeAgain = rumViews.Enter("view-1", "HomePage");
+  EXPECT_NE(settings, home);
+  EXPECT_NE(homeAgain, home);
+  EXPECT_EQ(rumViews.GetCurrentHandle(), homeAgain);
+
+  rumViews.Leave();
+  EXPECT_EQ(rumViews.GetCurrentHandle(), RumViewRegistry::NoView);
+
+  // the views left are still resolved for the samples not exported yet
+  RumViewContext view;
+  ASSERT_TRUE(rumViews.Resolve(settings, view));
+  EXPECT_EQ(view.view_id, "view-2");
+  EXPECT_EQ(view.view_name, "SettingsPage");
+  EXPECT_FALSE(rumViews.Resolve(RumViewRegistry::NoView, view));
+}
+
+TEST(RumViewRegistryTests, Resolve_OverwrittenRecord_Fails) {
+  RumViewRegistry rumViews;
+  auto first = rumViews.Enter("view-0", "Page0");
+  for (size_t i = 1; i <= RumViewRegistry::Capacity; i++) {
+    rumViews.Enter("view-" + std::to_string(i), "Page");
+  }
+
+  RumViewContext view;
+  EXPECT_FALSE(rumViews.Resolve(first, view));
+  EXPECT_TRUE(rumViews.Resolve(rumViews.GetCurrentHandle(), view));
+  EXPECT_EQ(view.view_id, "view-" + std::to_string(RumViewRegistry::Capacity));
+}
+
+// The sampler reads the current handle while the application changes views at a high
+// rate: a handle always resolves to the id and name of its own view (or fails if its
+// record has already been reused)
+TEST(RumViewRegistryTests, ConcurrentViewChanges_HandlesResolveConsistently) {
+  constexpr auto Duration = std::chrono::milliseconds(200);
+
+  RumViewRegistry rumViews;
+  std::atomic<bool> isDone = false;
+  std::atomic<uint64_t> resolvedCount = 0;
+  std::atomic<uint64_t> inconsistentCount = 0;
+
+  std::vector<std::thread> samplers;
+  for (int i = 0; i < 2; i++) {
+    samplers.emplace_back([&]() {
+      RumViewContext view;
+      while (!isDone) {
+        auto handle = rumViews.GetCurrentHandle();
+        if (handle == RumViewRegistry::NoView) {
+          continue;
+        }
+
+        if (!rumViews.Resolve(handle, view)) {
+          continue;
+        }
+
+        // the handles are given in order, starting at 1
+        auto number = std::to_string(handle - 1);
+        if ((view.view_id != "view-" + number) ||
+            (view.view_name != "page-" + number)) {
+          inconsistentCount++;
+        }
+        resolvedCount++;
+      }
+    });
+  }
+
+  uint32_t viewsCount = 0;
+  auto end = std::chrono::steady_clock::now() + Duration;
+  while (std::chrono::steady_clock::now() < end) {
+    auto number = std::to_string(viewsCount);
+    rumViews.Enter("view-" + number, "page-" + number);
+    if (viewsCount % 3 == 0) {
+      rumViews.Leave();
+    }
+    viewsCount++;
+  }
+  isDone = true;
+  for (auto& sampler : samplers) {
+    sampler.join();
+  }
+
+  EXPECT_EQ(inconsistentCount, 0u);
+  EXPECT_GT(resolvedCount, 0u);
+  std::cout << "Resolved " << resolvedCount << " views while " << viewsCount
+            << " were entered" << std::endl;
+}
+
+// Cost of getting the current view for each sample: copy of the strings under the
+// shared lock vs handle of the interned view
+TEST_F(ProfilerRumContextTest, GetCurrentView_Benchmark) {
+  constexpr int Iterations = 1'000'000;
+
+  RumSessionContext sessionCtx = {};
+  sessionCtx.application_id = "app-1";
+  sessionCtx.session_id = "session-1";
+  ASSERT_TRUE(_profiler->SetRumSession(&sessionCtx));
+
+  RumViewValues viewVals = {};
+  viewVals.view_id = "0f8e2f0a-3c2b-4b8e-9a55-6c1f2d3e4b5a";
+  viewVals.view_name = "checkout/payment-details";
+  ASSERT_TRUE(_profiler->SetRumView(&viewVals));
+
+  uint64_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < Iterations; i++) {
+    RumViewContext view;
+    _profiler->GetCurrentViewContext(view);
+    checksum += view.view_id.size();
+  }
+  auto copyDuration = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < Iterations; i++) {
+    checksum += _profiler->GetCurrentViewHandle();
+  }
+  auto handleDuration = std::chrono::steady_clock::now() - start;
+
+  EXPECT_NE(_profiler->GetCurrentViewHandle(), RumViewRegistry::NoView);
+  EXPECT_NE(checksum, 0u);
+
+  auto toNs = [](auto duration) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() /
+           Iterations;
+  };
+  std::cout << "Copy of the view:  " << toNs(copyDuration) << " ns" << std::endl;
+  std::cout << "Handle of the view: " << toNs(handleDuration) << " ns" << std::endl;
+}
+
 // ---------------------------------------------------------------------------
 // ProfileExporter RUM tag and label tests
 // ---------------------------------------------------------------------------
@@ -354,7 +477,9 @@ class ProfileExporterRumTests : public ::testing::Test {
     sampleTypes = {{"cpu-time", "nanoseconds"}, {"cpu-samples", "count"}};
     Sample::SetValuesCount(sampleTypes.size());
 
-    exporter = std::make_unique<ProfileExporter>(config.get(), sampleTypes);
+    exporter = std::make_unique<ProfileExporter>(
+        config.get(), sampleTypes, nullptr, nullptr, &rumViews
+    );
   }
 
   void TearDown() override {
@@ -362,34 +487,21 @@ class ProfileExporterRumTests : public ::testing::Test {
     config.reset();
   }
 
-  std::shared_ptr<Sample> CreateTestSample(
+  // the frames are not owned by the sample: they must outlive it
+  Sample CreateTestSample(
       const char* viewId = nullptr, const char* viewName = nullptr
   ) {
     auto timestamp =
         std::chrono::nanoseconds(std::chrono::system_clock::now().time_since_epoch());
-    HANDLE hThread;
-    ::DuplicateHandle(
-        ::GetCurrentProcess(),
-        ::GetCurrentThread(),
-        ::GetCurrentProcess(),
-        &hThread,
-        0,
-        FALSE,
-        DUPLICATE_SAME_ACCESS
-    );
-    auto threadInfo = std::make_shared<ThreadInfo>(::GetCurrentThreadId(), hThread);
-    uint64_t frames[] = {0x1000, 0x2000};
-    auto sample = std::make_shared<Sample>(timestamp, threadInfo, frames, 2);
-    sample->AddValue(1000000, 0);
-    sample->AddValue(1, 1);
+    static const uint64_t frames[] = {0x1000, 0x2000};
+    Sample sample(timestamp, ::GetCurrentThreadId(), frames);
+    sample.AddValue(1000000, 0);
+    sample.AddValue(1, 1);
 
     if (viewId != nullptr) {
-      RumViewContext rumView;
-      rumView.view_id = viewId;
-      if (viewName != nullptr) {
-        rumView.view_name = viewName;
-      }
-      sample->SetRumViewContext(std::move(rumView));
+      sample.SetRumViewHandle(
+          rumViews.Enter(viewId, (viewName != nullptr) ? viewName : "")
+      );
     }
 
     return sample;
@@ -397,6 +509,7 @@ class ProfileExporterRumTests : public ::testing::Test {
 
   std::unique_ptr<Configuration> config;
   std::vector<SampleValueType> sampleTypes;
+  RumViewRegistry rumViews;
   std::unique_ptr<ProfileExporter> exporter;
 };
 
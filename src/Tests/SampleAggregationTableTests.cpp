@@ -0,0 +1,304 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "../dd-win-prof/RumViewRegistry.h"
+#include "../dd-win-prof/SampleAggregationTable.h"
+#include "pch.h"
+
+TEST(SampleAggregationTableTests, IdenticalSamplesAreFolded) {
+  SampleAggregationTable table(2);
+  uint32_t threadId = 1;
+  uint32_t noView = RumViewRegistry::NoView;
+
+  std::vector<uint64_t> frames = {0x1000, 0x2000, 0x3000};
+  std::vector<int64_t> values1 = {10, 1};
+  std::vector<int64_t> values2 = {32, 1};
+
+  table.Add(frames, values1, threadId, noView);
+  table.Add(frames, values2, threadId, noView);
+  table.Add(frames, values1, threadId, noView);
+
+  ASSERT_EQ(table.GetEntriesCount(), 1u);
+  EXPECT_EQ(table.GetSamplesCount(), 3u);
+
+  auto storedFrames = table.GetFrames(table.GetEntries()[0]);
+  ASSERT_EQ(storedFrames.size(), frames.size());
+  for (size_t i = 0; i < frames.size(); i++) {
+    EXPECT_EQ(storedFrames[i], frames[i]);
+  }
+
+  auto values = table.GetValues(0);
+  ASSERT_EQ(values.size(), 2u);
+  EXPECT_EQ(values[0], 52);
+  EXPECT_EQ(values[1], 3);
+}
+
+TEST(SampleAggregationTableTests, DifferentKeysCreateDifferentEntries) {
+  SampleAggregationTable table(1);
+  uint32_t thread1 = 1;
+  uint32_t thread2 = 2;
+  uint32_t noView = RumViewRegistry::NoView;
+  uint32_t view = 7;  // RUM view handle
+
+  std::vector<uint64_t> frames = {0x1000, 0x2000};
+  std::vector<uint64_t> otherFrames = {0x1000, 0x2001};
+  std::vector<uint64_t> shorterFrames = {0x1000};
+  std::vector<int64_t> values = {1};
+
+  table.Add(frames, values, thread1, noView);
+  table.Add(otherFrames, values, thread1, noView);
+  table.Add(shorterFrames, values, thread1, noView);
+  table.Add(frames, values, thread2, noView);
+  table.Add(frames, values, thread1, view);
+  table.Add(frames, values, 0, noView);
+
+  EXPECT_EQ(table.GetEntriesCount(), 6u);
+  EXPECT_EQ(table.GetSamplesCount(), 6u);
+  for (size_t i = 0; i < table.GetEntriesCount(); i++) {
+    EXPECT_EQ(table.GetValues(i)[0], 1);
+  }
+
+  // the labels are kept with the entry
+  const auto& entries = table.GetEntries();
+  EXPECT_EQ(entries[3].threadId, thread2);
+  EXPECT_EQ(entries[4].rumViewHandle, view);
+  EXPECT_EQ(entries[5].threadId, 0u);
+}
+
+// The samples of different spans of the same thread are not merged
+TEST(SampleAggregationTableTests, TraceContextsCreateDifferentEntries) {
+  SampleAggregationTable table(1);
+  uint32_t noView = RumViewRegistry::NoView;
+  std::vector<uint64_t> frames = {0x1000, 0x2000};
+  std::vector<int64_t> values = {1};
+  TraceContext span1{100, 100, 1};
+  TraceContext span2{100, 101, 1};
+  auto start = std::chrono::nanoseconds(0);
+
+  table.Add(frames, values, 1, noView, start, 0, span1);
+  table.Add(frames, values, 1, noView, start, 0, span2);
+  table.Add(frames, values, 1, noView, start, 0, span1);
+  table.Add(frames, values, 1, noView);
+
+  ASSERT_EQ(table.GetEntriesCount(), 3u);
+  const auto& entries = table.GetEntries();
+  EXPECT_EQ(entries[0].traceContext, span1);
+  EXPECT_EQ(table.GetValues(0)[0], 2);
+  EXPECT_EQ(entries[1].traceContext, span2);
+  EXPECT_TRUE(entries[2].traceContext.IsEmpty());
+}
+
+// Folded walltime samples of different thread groups are not merged
+TEST(SampleAggregationTableTests, ThreadGroupsCreateDifferentEntries) {
+  SampleAggregationTable table(1);
+  uint32_t noView = RumViewRegistry::NoView;
+  std::vector<uint64_t> frames = {0x1000, 0x2000};
+  std::vector<int64_t> values = {1};
+
+  table.Add(frames, values, 0, noView, std::chrono::nanoseconds(0), 0x11);
+  table.Add(frames, values, 0, noView, std::chrono::nanoseconds(0), 0x11);
+  table.Add(frames, values, 0, noView, std::chrono::nanoseconds(0), 0x21);
+  table.Add(frames, values, 0, noView);
+
+  ASSERT_EQ(table.GetEntriesCount(), 3u);
+  EXPECT_EQ(table.GetValues(0)[0], 2);
+  EXPECT_EQ(table.GetEntries()[0].threadGroup, 0x11u);
+  EXPECT_EQ(table.GetEntries()[1].threadGroup, 0x21u);
+  EXPECT_EQ(table.GetEntries()[2].threadGroup, 0u);
+}
+
+TEST(SampleAggregationTableTests, EntriesAreFoundAfterGrowing) {
+  // start small to force several resizes of the index
+  SampleAggregationTable table(1, false, 16);
+  uint32_t threadId = 1;
+  uint32_t noView = RumViewRegistry::NoView;
+
+  const uint64_t uniqueStacks = 1000;
+  std::vector<int64_t> values = {1};
+  for (int pass = 0; pass < 3; pass++) {
+    for (uint64_t i = 0; i < uniqueStacks; i++) {
+      std::vector<uint64_t> frames = {0x1000 + i, 0x2000};
+      table.Add(frames, values, threadId, noView);
+    }
+  }
+
+  ASSERT_EQ(table.GetEntriesCount(), uniqueStacks);
+  EXPECT_EQ(table.GetSamplesCount(), 3 * uniqueStacks);
+  for (size_t i = 0; i < table.GetEntriesCount(); i++) {
+    EXPECT_EQ(table.GetValues(i)[0], 3);
+    EXPECT_EQ(table.GetFrames(table.GetEntries()[i])[0], 0x1000 + i);
+  }
+}
+
+TEST(SampleAggregationTableTests, AggregatedModeDoesNotRecordTimedSamples) {
+  SampleAggregationTable table(1);
+  std::vector<uint64_t> frames = {0x1000};
+  std::vector<int64_t> values = {1};
+
+  table.Add(frames, values, 0, RumViewRegistry::NoView, std::chrono::nanoseconds(10));
+  table.Add(frames, values, 0, RumViewRegistry::NoView, std::chrono::nanoseconds(20));
+
+  EXPECT_FALSE(table.IsTimelineEnabled());
+  EXPECT_EQ(table.GetEntriesCount(), 1u);
+  EXPECT_TRUE(table.GetTimedSamples().empty());
+}
+
+TEST(SampleAggregationTableTests, TimelineModeKeepsEachSample) {
+  SampleAggregationTable table(2, true);
+  uint32_t threadId = 1;
+  uint32_t noView = RumViewRegistry::NoView;
+
+  std::vector<uint64_t> frames = {0x1000, 0x2000};
+  std::vector<uint64_t> otherFrames = {0x3000};
+  std::vector<int64_t> values1 = {10, 1};
+  std::vector<int64_t> values2 = {20, 1};
+  std::vector<int64_t> values3 = {30, 1};
+
+  table.Add(frames, values1, threadId, noView, std::chrono::nanoseconds(100));
+  table.Add(otherFrames, values2, threadId, noView, std::chrono::nanoseconds(200));
+  table.Add(frames, values3, threadId, noView, std::chrono::nanoseconds(300));
+
+  // callstacks are still shared between samples...
+  EXPECT_TRUE(table.IsTimelineEnabled());
+  ASSERT_EQ(table.GetEntriesCount(), 2u);
+  EXPECT_EQ(table.GetValues(0)[0], 40);
+
+  // ...but each sample keeps its timestamp and values
+  const auto& timedSamples = table.GetTimedSamples();
+  ASSERT_EQ(timedSamples.size(), 3u);
+  EXPECT_EQ(timedSamples[0].entryIndex, 0u);
+  EXPECT_EQ(timedSamples[0].timestamp, 100);
+  EXPECT_EQ(table.GetTimedValues(0)[0], 10);
+  EXPECT_EQ(timedSamples[1].entryIndex, 1u);
+  EXPECT_EQ(timedSamples[1].timestamp, 200);
+  EXPECT_EQ(table.GetTimedValues(1)[0], 20);
+  EXPECT_EQ(timedSamples[2].entryIndex, 0u);
+  EXPECT_EQ(timedSamples[2].timestamp, 300);
+  EXPECT_EQ(table.GetTimedValues(2)[0], 30);
+
+  table.Clear();
+  EXPECT_TRUE(table.GetTimedSamples().empty());
+}
+
+TEST(SampleAggregationTableTests, MissingValuesAreZeroed) {
+  SampleAggregationTable table(3);
+  std::vector<uint64_t> frames = {0x1000};
+  std::vector<int64_t> values = {5};
+
+  table.Add(frames, values, 0, RumViewRegistry::NoView);
+
+  auto storedValues = table.GetValues(0);
+  ASSERT_EQ(storedValues.size(), 3u);
+  EXPECT_EQ(storedValues[0], 5);
+  EXPECT_EQ(storedValues[1], 0);
+  EXPECT_EQ(storedValues[2], 0);
+}
+
+TEST(SampleAggregationTableTests, ClearRemovesAllEntries) {
+  SampleAggregationTable table(1);
+  uint32_t threadId = 1;
+  uint32_t noView = RumViewRegistry::NoView;
+  std::vector<uint64_t> frames = {0x1000, 0x2000};
+  std::vector<int64_t> values = {7};
+
+  table.Add(frames, values, threadId, noView);
+  table.Clear();
+
+  EXPECT_EQ(table.GetEntriesCount(), 0u);
+  EXPECT_EQ(table.GetSamplesCount(), 0u);
+
+  // the same key starts again from scratch
+  table.Add(frames, values, threadId, noView);
+  ASSERT_EQ(table.GetEntriesCount(), 1u);
+  EXPECT_EQ(table.GetValues(0)[0], 7);
+}
+
+TEST(SampleAggregationTableTests, SuspendedTimelineSumsSamplesWithoutTimestamp) {
+  SampleAggregationTable table(2, true);
+  uint32_t threadId = 1;
+  uint32_t noView = RumViewRegistry::NoView;
+  std::vector<uint64_t> frames = {0x1000, 0x2000};
+  std::vector<uint64_t> otherFrames = {0x3000};
+  std::vector<int64_t> values1 = {10, 1};
+  std::vector<int64_t> values2 = {20, 1};
+
+  table.Add(frames, values1, threadId, noView, std::chrono::nanoseconds(100));
+  EXPECT_FALSE(table.HasUntimedSamples());
+
+  table.SetTimelineSuspended(true);
+  table.Add(frames, values2, threadId, noView, std::chrono::nanoseconds(200));
+  table.Add(frames, values2, threadId, noView, std::chrono::nanoseconds(300));
+  table.Add(otherFrames, values1, threadId, noView, std::chrono::nanoseconds(400));
+
+  // only the first sample keeps its timestamp...
+  ASSERT_EQ(table.GetTimedSamples().size(), 1u);
+  EXPECT_EQ(table.GetTimedSamples()[0].timestamp, 100);
+
+  // ...the other ones are summed per entry
+  ASSERT_TRUE(table.HasUntimedSamples());
+  EXPECT_EQ(table.GetUntimedValues(0)[0], 40);
+  EXPECT_EQ(table.GetUntimedValues(0)[1], 2);
+  EXPECT_EQ(table.GetUntimedValues(1)[0], 10);
+  EXPECT_EQ(table.GetValues(0)[0], 50);
+  EXPECT_EQ(table.GetSamplesCount(), 4u);
+
+  // entries created once the timeline is resumed have no untimed values
+  std::vector<uint64_t> newFrames = {0x4000};
+  table.SetTimelineSuspended(false);
+  table.Add(newFrames, values1, threadId, noView, std::chrono::nanoseconds(500));
+  EXPECT_EQ(table.GetTimedSamples().size(), 2u);
+  EXPECT_TRUE(table.GetUntimedValues(2).empty());
+
+  table.Clear();
+  EXPECT_FALSE(table.HasUntimedSamples());
+}
+
+TEST(SampleAggregationTableTests, MaxEntriesCountDropsNewKeysOnly) {
+  SampleAggregationTable table(1);
+  uint32_t noView = RumViewRegistry::NoView;
+  std::vector<uint64_t> frames = {0x1000};
+  std::vector<uint64_t> otherFrames = {0x2000};
+  std::vector<int64_t> values = {1};
+
+  table.Add(frames, values, 1, noView);
+  table.SetMaxEntriesCount(1);
+
+  // the existing entry still receives its samples
+  table.Add(frames, values, 1, noView);
+  EXPECT_EQ(table.Add(otherFrames, values, 1, noView), nullptr);
+  EXPECT_EQ(table.Add(frames, values, 2, noView), nullptr);
+
+  EXPECT_EQ(table.GetEntriesCount(), 1u);
+  EXPECT_EQ(table.GetValues(0)[0], 2);
+  EXPECT_EQ(table.GetSamplesCount(), 2u);
+  EXPECT_EQ(table.GetDroppedSamplesCount(), 2u);
+
+  table.SetMaxEntriesCount(0);
+  EXPECT_NE(table.Add(otherFrames, values, 1, noView), nullptr);
+}
+
+TEST(SampleAggregationTableTests, ClearCanReleaseMemory) {
+  SampleAggregationTable table(1, true, 16);
+  std::vector<int64_t> values = {1};
+  std::vector<uint64_t> frames = {0x1000};
+  for (uint64_t i = 0; i < 10000; i++) {
+    frames[0] = 0x1000 + i;
+    table.Add(frames, values, 1, RumViewRegistry::NoView);
+  }
+
+  auto usedSize = table.GetMemorySize();
+  table.Clear();
+  EXPECT_EQ(table.GetMemorySize(), usedSize);
+
+  table.Clear(true);
+  EXPECT_LT(table.GetMemorySize(), usedSize / 100);
+
+  // still usable
+  table.Add(frames, values, 1, RumViewRegistry::NoView);
+  EXPECT_EQ(table.GetEntriesCount(), 1u);
+}
@@ -0,0 +1,213 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "../dd-win-prof/Configuration.h"
+#include "../dd-win-prof/ProfileExporter.h"
+#include "../dd-win-prof/Sample.h"
+#include "../dd-win-prof/SampleAggregationTable.h"
+#include "../dd-win-prof/SampleRingBuffer.h"
+#include "pch.h"
+
+// ---------------------------------------------------------------------------
+// Allocation counting: the global operator new is replaced for the whole Tests
+// executable but only the allocations of the current thread are counted, and only
+// while an AllocationCounter is alive.
+// ---------------------------------------------------------------------------
+
+static thread_local bool t_isCountingAllocations = false;
+static thread_local size_t t_allocationsCount = 0;
+
+void* operator new(size_t size) {
+  if (t_isCountingAllocations) {
+    t_allocationsCount++;
+  }
+
+  void* p = std::malloc((size == 0) ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+class AllocationCounter {
+ public:
+  AllocationCounter() {
+    t_allocationsCount = 0;
+    t_isCountingAllocations = true;
+  }
+  ~AllocationCounter() { Stop(); }
+
+  // stop counting before checking the result: gtest may allocate
+  size_t Stop() {
+    t_isCountingAllocations = false;
+    return t_allocationsCount;
+  }
+};
+
+class SampleAllocationTest : public ::testing::Test {
+ protected:
+  static constexpr size_t StacksCount = 64;
+  static constexpr size_t FramesCount = 48;
+
+  void SetUp() override {
+#if defined(_ITERATOR_DEBUG_LEVEL) && (_ITERATOR_DEBUG_LEVEL != 0)
+    // debug STL containers and strings allocate a proxy each time they are created
+    GTEST_SKIP() << "allocations are only checked without iterator debugging";
+#endif
+
+    Sample::SetValuesCount(2);
+    for (size_t stack = 0; stack < StacksCount; stack++) {
+      for (size_t f = 0; f < FramesCount; f++) {
+        _frames[stack][f] = 0x10000 + (stack * FramesCount + f) * 0x10;
+      }
+    }
+  }
+
+  void TearDown() override { Sample::SetValuesCount(dd_win_prof::kMaxValuesCount); }
+
+  void FillBatch(SampleBatch& batch, size_t samplesCount) {
+    for (size_t i = 0; i < samplesCount; i++) {
+      auto& sample = batch.Add(
+          std::chrono::nanoseconds(i), static_cast<uint32_t>(1 + i % 4), GetStack(i)
+      );
+      sample.AddValue(10'000'000, 0);
+      sample.AddValue(1, 1);
+    }
+  }
+
+  std::span<const uint64_t> GetStack(size_t i) const {
+    return _frames[i % StacksCount];
+  }
+
+  uint64_t _frames[StacksCount][FramesCount];
+};
+
+TEST_F(SampleAllocationTest, AllocationCounterCountsAllocations) {
+  AllocationCounter counter;
+  std::vector<uint64_t> frames(FramesCount);
+  auto allocationsCount = counter.Stop();
+
+  EXPECT_EQ(allocationsCount, 1u);
+  EXPECT_EQ(frames.size(), FramesCount);
+}
+
+TEST_F(SampleAllocationTest, CopyingSamplesDoesNotAllocate) {
+  Sample sample(std::chrono::nanoseconds(1), 42, GetStack(0));
+  sample.AddValue(10, 0);
+  std::vector<Sample> samples;
+  samples.reserve(100);
+
+  AllocationCounter counter;
+  for (int i = 0; i < 100; i++) {
+    samples.push_back(sample);
+  }
+  Sample copy = samples.back();
+  Sample moved = std::move(copy);
+  auto allocationsCount = counter.Stop();
+
+  EXPECT_EQ(allocationsCount, 0u);
+  EXPECT_EQ(moved.GetFrames().size(), FramesCount);
+  EXPECT_EQ(moved.GetValues()[0], 10);
+}
+
+TEST_F(SampleAllocationTest, SampleBatchDoesNotAllocateOnceWarmedUp) {
+  // large enough to need several frames chunks
+  constexpr size_t SamplesCount = 1000;
+  SampleBatch batch;
+  FillBatch(batch, SamplesCount);
+  batch.Clear();
+
+  AllocationCounter counter;
+  FillBatch(batch, SamplesCount);
+  auto allocationsCount = counter.Stop();
+
+  EXPECT_EQ(allocationsCount, 0u);
+  ASSERT_EQ(batch.Size(), SamplesCount);
+
+  // the frames are copied: they do not depend on the caller buffer
+  auto samples = batch.GetSamples();
+  for (size_t i = 0; i < SamplesCount; i++) {
+    ASSERT_EQ(samples[i].GetFrames().size(), FramesCount);
+    EXPECT_NE(samples[i].GetFrames().data(), GetStack(i).data());
+    EXPECT_EQ(samples[i].GetFrames()[FramesCount - 1], GetStack(i)[FramesCount - 1]);
+    EXPECT_EQ(samples[i].GetThreadId(), 1 + i % 4);
+  }
+}
+
+TEST_F(SampleAllocationTest, RingBufferPushAndDrainDoNotAllocate) {
+  SampleRingBuffer ring(256);
+  SampleBatch batch;
+  int64_t values[] = {10'000'000, 1};
+
+  auto pushAndDrain = [&]() {
+    for (size_t i = 0; i < ring.GetCapacity(); i++) {
+      ring.TryPush(std::chrono::nanoseconds(i), 1, GetStack(i), values);
+    }
+    batch.Clear();
+    return ring.Drain(batch);
+  };
+
+  // warm up the batch
+  pushAndDrain();
+
+  AllocationCounter counter;
+  auto drainedCount = pushAndDrain();
+  auto allocationsCount = counter.Stop();
+
+  EXPECT_EQ(allocationsCount, 0u);
+  EXPECT_EQ(drainedCount, ring.GetCapacity());
+  EXPECT_EQ(ring.GetDroppedCount(), 0u);
+}
+
+TEST_F(SampleAllocationTest, AggregatingKnownCallstacksDoesNotAllocate) {
+  SampleAggregationTable table(2);
+  int64_t values[] = {10'000'000, 1};
+  for (size_t i = 0; i < StacksCount; i++) {
+    table.Add(GetStack(i), values, 1, RumViewRegistry::NoView);
+  }
+
+  uint32_t noView = RumViewRegistry::NoView;
+  AllocationCounter counter;
+  for (size_t i = 0; i < 10 * StacksCount; i++) {
+    table.Add(GetStack(i), values, 1, noView);
+  }
+  auto allocationsCount = counter.Stop();
+
+  EXPECT_EQ(allocationsCount, 0u);
+  EXPECT_EQ(table.GetEntriesCount(), StacksCount);
+}
+
+TEST_F(SampleAllocationTest, ExporterAddOfKnownCallstacksDoesNotAllocate) {
+  Configuration config;
+  config.SetExportEnabled(false);
+  config.SetTimelineEnabled(false);
+  std::vector<SampleValueType> types = {
+      {"cpu-time", "nanoseconds"}, {"cpu-samples", "count"}
+  };
+  ProfileExporter exporter(&config, types);
+  ASSERT_TRUE(exporter.Initialize());
+
+  SampleBatch batch;
+  FillBatch(batch, 4 * StacksCount);
+  EXPECT_EQ(exporter.Add(batch.GetSamples()), batch.Size());
+
+  AllocationCounter counter;
+  auto addedCount = exporter.Add(batch.GetSamples());
+  auto allocationsCount = counter.Stop();
+
+  EXPECT_EQ(allocationsCount, 0u);
+  EXPECT_EQ(addedCount, batch.Size());
+}
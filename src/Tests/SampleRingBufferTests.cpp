@@ -0,0 +1,327 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../dd-win-prof/CpuTimeProvider.h"
+#include "../dd-win-prof/RumViewRegistry.h"
+#include "../dd-win-prof/SampleRingBuffer.h"
+#include "../dd-win-prof/SampleValueTypeProvider.h"
+#include "../dd-win-prof/WalltimeProvider.h"
+#include "pch.h"
+
+class SampleRingBufferTest : public ::testing::Test {
+ protected:
+  void SetUp() override { Sample::SetValuesCount(2); }
+  void TearDown() override { Sample::SetValuesCount(dd_win_prof::kMaxValuesCount); }
+};
+
+TEST_F(SampleRingBufferTest, CapacityIsRoundedToPowerOfTwo) {
+  SampleRingBuffer ring(100);
+  EXPECT_EQ(ring.GetCapacity(), 128u);
+}
+
+TEST_F(SampleRingBufferTest, PushedSamplesAreDrainedInOrder) {
+  SampleRingBuffer ring(8);
+  uint32_t threadId = 42;
+
+  for (int i = 0; i < 5; i++) {
+    uint64_t frames[] = {0x1000 + static_cast<uint64_t>(i), 0x2000};
+    int64_t values[] = {i * 10, 1};
+    EXPECT_TRUE(ring.TryPush(std::chrono::nanoseconds(i), threadId, frames, values));
+  }
+
+  SampleBatch batch;
+  ASSERT_EQ(ring.Drain(batch), 5u);
+  auto samples = batch.GetSamples();
+  ASSERT_EQ(samples.size(), 5u);
+  for (int i = 0; i < 5; i++) {
+    EXPECT_EQ(samples[i].GetTimestamp(), std::chrono::nanoseconds(i));
+    EXPECT_EQ(samples[i].GetThreadId(), threadId);
+    ASSERT_EQ(samples[i].GetFrames().size(), 2u);
+    EXPECT_EQ(samples[i].GetFrames()[0], 0x1000u + i);
+    EXPECT_EQ(samples[i].GetValues()[0], i * 10);
+    EXPECT_EQ(samples[i].GetValues()[1], 1);
+  }
+
+  // nothing left
+  batch.Clear();
+  EXPECT_EQ(ring.Drain(batch), 0u);
+  EXPECT_EQ(ring.GetDroppedCount(), 0u);
+}
+
+TEST_F(SampleRingBufferTest, SamplesAreDroppedWhenFull) {
+  SampleRingBuffer ring(4);
+  uint64_t frames[] = {0x1000};
+  int64_t values[] = {1, 1};
+
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(ring.TryPush(std::chrono::nanoseconds(i), 0, frames, values));
+  }
+  EXPECT_FALSE(ring.TryPush(std::chrono::nanoseconds(4), 0, frames, values));
+  EXPECT_FALSE(ring.TryPush(std::chrono::nanoseconds(5), 0, frames, values));
+  EXPECT_EQ(ring.GetDroppedCount(), 2u);
+
+  // draining frees the slots
+  SampleBatch batch;
+  EXPECT_EQ(ring.Drain(batch), 4u);
+  EXPECT_EQ(batch.GetSamples().back().GetTimestamp(), std::chrono::nanoseconds(3));
+  EXPECT_TRUE(ring.TryPush(std::chrono::nanoseconds(6), 0, frames, values));
+  EXPECT_EQ(ring.GetDroppedCount(), 2u);
+}
+
+TEST_F(SampleRingBufferTest, SlotsAreReusedAfterWrapAround) {
+  SampleRingBuffer ring(4);
+  SampleBatch batch;
+
+  for (int i = 0; i < 10; i++) {
+    auto* pSlot = ring.TryReserve();
+    ASSERT_NE(pSlot, nullptr);
+
+    // values of the previous use of the slot are reset
+    EXPECT_EQ(pSlot->values[0], 0);
+    EXPECT_EQ(pSlot->values[1], 0);
+
+    pSlot->timestamp = std::chrono::nanoseconds(i);
+    pSlot->frames[0] = i;
+    pSlot->framesCount = 1;
+    pSlot->values[1] = i;
+    pSlot->rumViewHandle = (i % 2 == 0) ? 7 : 0;
+    ring.Commit();
+
+    batch.Clear();
+    ASSERT_EQ(ring.Drain(batch), 1u);
+    auto samples = batch.GetSamples();
+    EXPECT_EQ(samples[0].GetFrames()[0], static_cast<uint64_t>(i));
+    EXPECT_EQ(samples[0].GetValues()[1], i);
+    EXPECT_EQ(samples[0].GetRumViewHandle(), (i % 2 == 0) ? 7u : 0u);
+  }
+}
+
+TEST_F(SampleRingBufferTest, HighWaterMarkWakesUpTheConsumer) {
+  SampleRingBuffer ring(8);
+  WakeupSignal signal;
+  ring.SetWakeupSignal(&signal);
+  EXPECT_EQ(ring.GetHighWaterMark(), 4u);
+
+  uint64_t frames[] = {0x1000};
+  int64_t values[] = {1, 1};
+  for (int i = 0; i < 3; i++) {
+    ring.TryPush(std::chrono::nanoseconds(i), 0, frames, values);
+  }
+  EXPECT_FALSE(signal.WaitFor(std::chrono::nanoseconds::zero()));
+
+  // the notifications of the samples above the mark are merged into one wakeup
+  for (int i = 3; i < 7; i++) {
+    ring.TryPush(std::chrono::nanoseconds(i), 0, frames, values);
+  }
+  EXPECT_TRUE(signal.WaitFor(std::chrono::nanoseconds::zero()));
+  EXPECT_FALSE(signal.WaitFor(std::chrono::nanoseconds::zero()));
+
+  SampleBatch batch;
+  EXPECT_EQ(ring.Drain(batch), 7u);
+  EXPECT_EQ(ring.GetAndResetPeakPendingCount(), 7u);
+  EXPECT_EQ(ring.GetAndResetPeakPendingCount(), 0u);
+
+  // below the mark again after the drain
+  ring.TryPush(std::chrono::nanoseconds(7), 0, frames, values);
+  EXPECT_FALSE(signal.WaitFor(std::chrono::nanoseconds::zero()));
+}
+
+TEST_F(SampleRingBufferTest, WakeupSignalWakesUpWaitingThread) {
+  WakeupSignal signal;
+  std::atomic<int> wakeupsCount{0};
+
+  std::thread consumer([&signal, &wakeupsCount]() {
+    while (signal.WaitFor(std::chrono::seconds(5))) {
+      if (++wakeupsCount == 2) {
+        return;
+      }
+    }
+  });
+
+  signal.Notify();
+  while (wakeupsCount.load() == 0) {
+    std::this_thread::yield();
+  }
+  signal.Notify();
+  consumer.join();
+  EXPECT_EQ(wakeupsCount.load(), 2);
+}
+
+TEST_F(SampleRingBufferTest, CpuTimeProviderWritesValuesAtTheirOffsets) {
+  SampleValueTypeProvider valueTypeProvider;
+  CpuTimeProvider provider(valueTypeProvider);
+  Sample::SetValuesCount(valueTypeProvider.GetValueTypes().size());
+
+  uint32_t threadId = 1;
+  uint64_t frames[] = {0x1000, 0x2000, 0x3000};
+  TraceContext span{0x1234, 0x5678, 3};
+  EXPECT_TRUE(provider.Add(1000ns, threadId, 42, frames, 7, span, 20ms));
+  EXPECT_TRUE(
+      provider.Add(2000ns, threadId, 0, frames, RumViewRegistry::NoView, {}, 10ms)
+  );
+
+  SampleBatch batch;
+  ASSERT_EQ(provider.MoveSamples(batch), 2u);
+  auto samples = batch.GetSamples();
+
+  auto const& offsets = provider.GetValueOffsets();
+  EXPECT_EQ(samples[0].GetValues()[offsets[0]], 20'000'000);
+  EXPECT_EQ(samples[0].GetValues()[offsets[1]], 1);
+  EXPECT_EQ(samples[0].GetRumViewHandle(), 7u);
+  EXPECT_EQ(samples[0].GetFrames().size(), 3u);
+  EXPECT_EQ(samples[0].GetThreadGeneration(), 42u);
+  EXPECT_EQ(samples[0].GetTraceContext(), span);
+  EXPECT_EQ(samples[1].GetValues()[offsets[0]], 10'000'000);
+  EXPECT_EQ(samples[1].GetRumViewHandle(), RumViewRegistry::NoView);
+  EXPECT_TRUE(samples[1].GetTraceContext().IsEmpty());
+  EXPECT_EQ(provider.GetDroppedSamplesCount(), 0u);
+}
+
+TEST_F(SampleRingBufferTest, WallTimeProviderKeepsFoldedThreads) {
+  SampleValueTypeProvider valueTypeProvider;
+  WallTimeProvider provider(valueTypeProvider);
+  Sample::SetValuesCount(valueTypeProvider.GetValueTypes().size());
+
+  uint64_t frames[] = {0x1000, 0x2000};
+  EXPECT_TRUE(provider.AddFolded(1000ns, 4, 42, 0x77, 3, frames, 0, 30ms));
+  EXPECT_TRUE(provider.Add(2000ns, 8, 43, frames, 0, {}, 10ms, 10ms, 6));
+
+  SampleBatch batch;
+  ASSERT_EQ(provider.MoveSamples(batch), 2u);
+  auto samples = batch.GetSamples();
+
+  auto const& offsets = provider.GetValueOffsets();
+  EXPECT_EQ(samples[0].GetValues()[offsets[0]], 30'000'000);
+  EXPECT_EQ(samples[0].GetValues()[offsets[1]], 30'000'000);
+  EXPECT_EQ(samples[0].GetThreadId(), 4u);
+  EXPECT_EQ(samples[0].GetThreadGroup(), 0x77u);
+  EXPECT_EQ(samples[0].GetFoldedThreadsCount(), 3u);
+
+  // the slot of a folded sample is reused for a regular one
+  EXPECT_EQ(samples[1].GetThreadGroup(), 0u);
+  EXPECT_EQ(samples[1].GetFoldedThreadsCount(), 0u);
+}
+
+// ---------------------------------------------------------------------------
+// Contention microbenchmark: the sampler thread produces while DD_worker drains
+// ---------------------------------------------------------------------------
+
+// Baseline: the previous CollectorBase implementation (mutex + vector swap) where
+// each sample owned a heap allocated copy of its callstack
+struct LockedSample {
+  std::chrono::nanoseconds timestamp;
+  std::vector<uint64_t> frames;
+};
+
+class LockedSamplesQueue {
+ public:
+  void Add(LockedSample&& sample) {
+    std::lock_guard<std::mutex> lock(_lock);
+    _samples.push_back(std::move(sample));
+  }
+
+  size_t MoveSamples(std::vector<LockedSample>& destination) {
+    std::lock_guard<std::mutex> lock(_lock);
+    destination.clear();
+    _samples.swap(destination);
+    return destination.size();
+  }
+
+ private:
+  std::mutex _lock;
+  std::vector<LockedSample> _samples;
+};
+
+TEST_F(SampleRingBufferTest, ContentionBenchmark) {
+  constexpr int SamplesCount = 200000;
+  constexpr int FramesCount = 32;
+  uint32_t threadId = 1;
+  uint64_t frames[FramesCount];
+  for (int i = 0; i < FramesCount; i++) {
+    frames[i] = 0x10000 + i * 0x10;
+  }
+  int64_t values[] = {10'000'000, 1};
+
+  // ring buffer: the producer retries when the ring is full so that all samples go
+  // through it (each failed attempt is counted as a dropped sample)
+  SampleRingBuffer ring;
+  std::atomic<bool> producerDone{false};
+  uint64_t pushedCount = 0;
+  auto ringStart = std::chrono::steady_clock::now();
+  std::thread producer([&]() {
+    for (int i = 0; i < SamplesCount; i++) {
+      while (!ring.TryPush(std::chrono::nanoseconds(i), threadId, frames, values)) {
+        std::this_thread::yield();
+      }
+      pushedCount++;
+    }
+    producerDone = true;
+  });
+
+  uint64_t drainedCount = 0;
+  int64_t lastTimestamp = -1;
+  bool isOrdered = true;
+  SampleBatch batch;
+  while (true) {
+    bool isLastDrain = producerDone;
+    batch.Clear();
+    drainedCount += ring.Drain(batch);
+    for (auto const& sample : batch.GetSamples()) {
+      isOrdered = isOrdered && (sample.GetTimestamp().count() > lastTimestamp);
+      lastTimestamp = sample.GetTimestamp().count();
+    }
+    if (isLastDrain) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+  producer.join();
+  auto ringDuration = std::chrono::steady_clock::now() - ringStart;
+
+  EXPECT_TRUE(isOrdered);
+  EXPECT_EQ(pushedCount, static_cast<uint64_t>(SamplesCount));
+  EXPECT_EQ(drainedCount, pushedCount);
+
+  // mutex + vector baseline
+  LockedSamplesQueue queue;
+  producerDone = false;
+  auto lockedStart = std::chrono::steady_clock::now();
+  std::thread lockedProducer([&]() {
+    for (int i = 0; i < SamplesCount; i++) {
+      queue.Add({std::chrono::nanoseconds(i), {frames, frames + FramesCount}});
+    }
+    producerDone = true;
+  });
+
+  uint64_t lockedDrainedCount = 0;
+  std::vector<LockedSample> samples;
+  while (true) {
+    bool isLastDrain = producerDone;
+    lockedDrainedCount += queue.MoveSamples(samples);
+    if (isLastDrain) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+  lockedProducer.join();
+  auto lockedDuration = std::chrono::steady_clock::now() - lockedStart;
+
+  EXPECT_EQ(lockedDrainedCount, static_cast<uint64_t>(SamplesCount));
+
+  auto toMs = [](auto duration) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+  };
+  std::cout << "Ring buffer:    " << pushedCount << " samples in " << toMs(ringDuration)
+            << " ms (ring full " << ring.GetDroppedCount() << " times)" << std::endl;
+  std::cout << "Mutex + vector: " << lockedDrainedCount << " samples in "
+            << toMs(lockedDuration) << " ms" << std::endl;
+}
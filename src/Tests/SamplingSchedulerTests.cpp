@@ -0,0 +1,167 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include "../dd-win-prof/SamplingScheduler.h"
+#include "pch.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+// time only moves when the scheduler sleeps (+ slack) or when a test advances it
+class FakeClock : public IClock {
+ public:
+  explicit FakeClock(std::chrono::nanoseconds sleepSlack = 0ns)
+      : _now(1000s), _sleepSlack(sleepSlack) {}
+
+  std::chrono::nanoseconds Now() override { return _now; }
+
+  void SleepUntil(std::chrono::nanoseconds deadline) override {
+    _sleepsCount++;
+    if (deadline > _now) {
+      _now = deadline + _sleepSlack;
+    }
+  }
+
+  void Advance(std::chrono::nanoseconds duration) { _now += duration; }
+  int GetSleepsCount() const { return _sleepsCount; }
+
+ private:
+  std::chrono::nanoseconds _now;
+  std::chrono::nanoseconds _sleepSlack;
+  int _sleepsCount = 0;
+};
+}  // namespace
+
+TEST(SamplingSchedulerTests, Ticks_DoNotDriftWithTheIterationsDuration) {
+  FakeClock clock;
+  SamplingScheduler scheduler(&clock, 20ms);
+  auto start = clock.Now();
+
+  for (int i = 1; i <= 100; i++) {
+    auto tick = scheduler.WaitNextTick();
+    EXPECT_EQ(tick, start + i * 20ms);
+
+    // with Sleep(period), the next sample would be 27 ms later
+    clock.Advance(7ms);
+  }
+
+  auto stats = scheduler.GetAndResetStats();
+  EXPECT_EQ(stats.ticks, 100);
+  EXPECT_EQ(stats.overruns, 0);
+  EXPECT_EQ(stats.skippedTicks, 0);
+  EXPECT_EQ(stats.lateness.max, 0ns);
+
+  stats = scheduler.GetAndResetStats();
+  EXPECT_EQ(stats.ticks, 0);
+  EXPECT_EQ(stats.lateness.count, 0);
+}
+
+TEST(SamplingSchedulerTests, Lateness_IsRecorded) {
+  FakeClock clock(2ms);
+  SamplingScheduler scheduler(&clock, 20ms);
+  auto start = clock.Now();
+
+  for (int i = 1; i <= 10; i++) {
+    // the timer slack does not accumulate either
+    EXPECT_EQ(scheduler.WaitNextTick(), start + i * 20ms + 2ms);
+  }
+
+  auto stats = scheduler.GetAndResetStats();
+  EXPECT_EQ(stats.lateness.count, 10);
+  EXPECT_EQ(stats.lateness.max, 2ms);
+  EXPECT_EQ(stats.overruns, 0);
+}
+
+TEST(SamplingSchedulerTests, SkipPolicy_RunsTheLateTickAndDropsTheMissedOnes) {
+  FakeClock clock;
+  SamplingScheduler scheduler(&clock, 20ms, OverrunPolicy::Skip);
+  auto start = clock.Now();
+
+  EXPECT_EQ(scheduler.WaitNextTick(), start + 20ms);
+
+  // the iteration ends at 70 ms: the 40 ms tick runs late, the 60 ms one is dropped
+  clock.Advance(50ms);
+  int sleepsCount = clock.GetSleepsCount();
+  EXPECT_EQ(scheduler.WaitNextTick(), start + 70ms);
+  EXPECT_EQ(clock.GetSleepsCount(), sleepsCount);
+
+  // back on schedule
+  EXPECT_EQ(scheduler.WaitNextTick(), start + 80ms);
+  EXPECT_EQ(scheduler.WaitNextTick(), start + 100ms);
+
+  auto stats = scheduler.GetAndResetStats();
+  EXPECT_EQ(stats.ticks, 4);
+  EXPECT_EQ(stats.overruns, 1);
+  EXPECT_EQ(stats.skippedTicks, 1);
+  EXPECT_EQ(stats.lateness.max, 10ms);
+}
+
+TEST(SamplingSchedulerTests, CatchUpPolicy_RunsALimitedNumberOfMissedTicks) {
+  FakeClock clock;
+  SamplingScheduler scheduler(&clock, 20ms, OverrunPolicy::CatchUp);
+  auto start = clock.Now();
+
+  EXPECT_EQ(scheduler.WaitNextTick(), start + 20ms);
+
+  // 9 ticks are missed: 5 are dropped, the late one and 4 more run back to back
+  clock.Advance(200ms);
+  for (int i = 0; i < 1 + SamplingScheduler::MaxCatchUpTicks; i++) {
+    EXPECT_EQ(scheduler.WaitNextTick(), start + 220ms);
+  }
+
+  // back on schedule
+  EXPECT_EQ(scheduler.WaitNextTick(), start + 240ms);
+
+  auto stats = scheduler.GetAndResetStats();
+  EXPECT_EQ(stats.ticks, 7);
+  EXPECT_EQ(stats.overruns, 4);
+  EXPECT_EQ(stats.skippedTicks, 5);
+}
+
+TEST(SamplingSchedulerTests, Jitter_IsBoundedAndDoesNotDrift) {
+  FakeClock clock;
+  SamplingScheduler scheduler(&clock, 20ms, OverrunPolicy::Skip, 2ms, 42);
+  auto start = clock.Now();
+
+  int jitteredTicksCount = 0;
+  for (int i = 1; i <= 1000; i++) {
+    auto scheduled = start + i * 20ms;
+    auto tick = scheduler.WaitNextTick();
+    EXPECT_GE(tick, scheduled - 2ms);
+    EXPECT_LE(tick, scheduled + 2ms);
+    if (tick != scheduled) {
+      jitteredTicksCount++;
+    }
+  }
+  EXPECT_GT(jitteredTicksCount, 900);
+}
+
+TEST(SamplingSchedulerTests, Jitter_IsReproducibleWithTheSameSeed) {
+  FakeClock clock1;
+  FakeClock clock2;
+  SamplingScheduler scheduler1(&clock1, 20ms, OverrunPolicy::Skip, 5ms, 7);
+  SamplingScheduler scheduler2(&clock2, 20ms, OverrunPolicy::Skip, 5ms, 7);
+
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(scheduler1.WaitNextTick(), scheduler2.WaitNextTick());
+  }
+}
+
+TEST(SamplingSchedulerTests, SystemClock_KeepsThePeriod) {
+  SystemClock clock;
+  SamplingScheduler scheduler(&clock, 5ms);
+  auto start = clock.Now();
+
+  for (int i = 0; i < 20; i++) {
+    scheduler.WaitNextTick();
+  }
+
+  // never early; lateness does not accumulate
+  auto elapsed = clock.Now() - start;
+  EXPECT_GE(elapsed, 100ms);
+  EXPECT_LT(elapsed, 1s);
+  EXPECT_EQ(scheduler.GetAndResetStats().ticks, 20);
+}
@@ -0,0 +1,340 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../dd-win-prof/OpSysTools.h"
+#include "../dd-win-prof/SamplingIteration.h"
+#include "../dd-win-prof/ThreadInfo.h"
+#include "../dd-win-prof/ThreadList.h"
+#include "pch.h"
+
+using namespace std::chrono_literals;
+
+// The sampling iterations of StackSamplerLoop run on synthetic thread populations:
+// when there are more threads than the thresholds, the totals computed from the
+// samples must still match the real CPU, wall and wait times.
+namespace {
+constexpr std::chrono::nanoseconds SamplingPeriod = 10ms;
+constexpr int TicksCount = 6'000;  // 1 minute
+constexpr ULONG WrQueue = 15;
+
+// some samples are not recorded (suspension failure, stuck stack walk, full ring)
+constexpr double FailureRate = 0.05;
+
+// the threads without a valid handle are skipped by the iterations
+HANDLE MakeTestHandle() {
+  HANDLE h = NULL;
+  DuplicateHandle(
+      GetCurrentProcess(),
+      GetCurrentThread(),
+      GetCurrentProcess(),
+      &h,
+      0,
+      FALSE,
+      DUPLICATE_SAME_ACCESS
+  );
+  return h;
+}
+
+// Threads with a fake clock: each one is active (running or waiting) during a tick
+// with a probability depending on its group; the samples collected by the iterations
+// are accounted instead of being written into a ring
+class FakeThreadSampler : public IThreadSampler {
+ public:
+  struct SimulatedThread {
+    double activeRate;  // probability to be running (CPU) or waiting (walltime)
+    bool isActive = false;
+    std::chrono::milliseconds consumption{0};  // as returned by the OS
+
+    std::chrono::nanoseconds realTime{0};
+    std::chrono::nanoseconds estimatedTime{0};
+  };
+
+ public:
+  // Group the threads by activity rate: 0.1, 0.2, ... 0.9
+  FakeThreadSampler(ThreadList& threadList, size_t count, double failureRate)
+      : _threads(count), _failureRate(failureRate), _random(42) {
+    for (size_t i = 0; i < count; i++) {
+      threadList.AddThread(GetThreadId(i), MakeTestHandle());
+      _threads[i].activeRate = 0.1 * static_cast<double>(i % 9 + 1);
+    }
+    _now = OpSysTools::GetHighPrecisionTimestamp();
+    _samplingStart = _now;
+  }
+
+  static uint32_t GetThreadId(size_t index) {
+    return static_cast<uint32_t>(index + 1) * 4;
+  }
+
+  // State of the threads during the next tick; active threads consume cpuPerTick
+  void NextTick(std::chrono::milliseconds cpuPerTick) {
+    for (auto& thread : _threads) {
+      thread.isActive = Draw(thread.activeRate);
+      if (thread.isActive) {
+        thread.consumption += cpuPerTick;
+        thread.realTime += (cpuPerTick > 0ms) ? cpuPerTick : SamplingPeriod;
+      }
+    }
+    _now += SamplingPeriod;
+  }
+
+  std::chrono::nanoseconds GetTimestamp() override { return _now; }
+
+  std::tuple<bool, std::chrono::milliseconds, bool> IsRunning(
+      ThreadInfo* pThreadInfo
+  ) override {
+    auto& thread = Find(pThreadInfo);
+
+    // the state is not always available: the CPU consumption is then compared
+    if (Draw(_failureRate)) {
+      return {false, thread.consumption, true};
+    }
+    return {thread.isActive, thread.consumption, false};
+  }
+
+  std::tuple<bool, ULONG, bool> IsWaiting(ThreadInfo* pThreadInfo) override {
+    return {Find(pThreadInfo).isActive, WrQueue, false};
+  }
+
+  SampleStatus CollectOneThreadSample(
+      ThreadInfo* pThreadInfo,
+      std::chrono::nanoseconds thisSampleTimestamp,
+      std::chrono::nanoseconds duration,
+      PROFILING_TYPE profilingType,
+      ULONG waitingReason
+  ) override {
+    EXPECT_EQ(thisSampleTimestamp, _now);
+    _collectedCount++;
+    if (Draw(_failureRate)) {
+      return SampleStatus::Dropped;
+    }
+
+    // folded samples are written (and their threads marked as sampled) after the
+    // iteration
+    if (_isDeferring && (profilingType == PROFILING_TYPE::WallTime)) {
+      return SampleStatus::Deferred;
+    }
+
+    auto& thread = Find(pThreadInfo);
+    if (profilingType == PROFILING_TYPE::CpuTime) {
+      thread.estimatedTime += duration;
+    } else {
+      _wallTime += duration;
+      if (waitingReason != WAIT_REASON_NONE) {
+        thread.estimatedTime += duration;
+      }
+    }
+    return SampleStatus::Recorded;
+  }
+
+  bool IsStopRequested() override { return false; }
+
+  void SetDeferring(bool isDeferring) { _isDeferring = isDeferring; }
+
+  std::chrono::nanoseconds GetSamplingStart() const { return _samplingStart; }
+  std::chrono::nanoseconds GetWallTime() const { return _wallTime; }
+  uint64_t GetCollectedCount() const { return _collectedCount; }
+  const std::vector<SimulatedThread>& GetThreads() const { return _threads; }
+
+ private:
+  SimulatedThread& Find(ThreadInfo* pThreadInfo) {
+    return _threads[pThreadInfo->GetThreadId() / 4 - 1];
+  }
+
+  bool Draw(double probability) { return _uniform(_random) < probability; }
+
+ private:
+  std::vector<SimulatedThread> _threads;
+  double _failureRate;
+  bool _isDeferring = false;
+  std::mt19937 _random;
+  std::uniform_real_distribution<double> _uniform{0.0, 1.0};
+
+  std::chrono::nanoseconds _now{0};
+  std::chrono::nanoseconds _samplingStart{0};
+  std::chrono::nanoseconds _wallTime{0};
+  uint64_t _collectedCount = 0;
+};
+
+void ExpectGroupsMatch(const FakeThreadSampler& sampler, double tolerance) {
+  const auto& threads = sampler.GetThreads();
+  for (size_t group = 0; group < 9; group++) {
+    std::chrono::nanoseconds realTime{0};
+    std::chrono::nanoseconds estimatedTime{0};
+    for (size_t i = group; i < threads.size(); i += 9) {
+      realTime += threads[i].realTime;
+      estimatedTime += threads[i].estimatedTime;
+    }
+
+    auto error = static_cast<double>((estimatedTime - realTime).count()) /
+                 static_cast<double>(realTime.count());
+    EXPECT_LT(std::abs(error), tolerance) << "rate " << threads[group].activeRate;
+  }
+}
+}  // namespace
+
+// 300 threads, 5 sampled per tick (default walltime threshold): a thread is sampled
+// every 60 ticks
+TEST(SamplingWeightTests, Walltime_ThresholdReached_TotalsMatchRealTimes) {
+  constexpr size_t ThreadsCount = 300;
+  constexpr uint32_t WalltimeThreshold = 5;
+
+  ThreadList threadList;
+  FakeThreadSampler sampler(threadList, ThreadsCount, FailureRate);
+  SamplingIteration iteration(&threadList, &sampler, 64, WalltimeThreshold, 8);
+
+  for (int tick = 1; tick <= TicksCount; tick++) {
+    sampler.NextTick(0ms);
+
+    ThreadList::ReadGuard guard(threadList);
+    iteration.RunWalltime(guard, 0, sampler.GetSamplingStart());
+  }
+  EXPECT_EQ(sampler.GetCollectedCount(), TicksCount * WalltimeThreshold);
+
+  // only the time since the last sample of each thread is missing
+  auto wallTime = sampler.GetWallTime();
+  auto realWallTime = static_cast<int64_t>(ThreadsCount) * TicksCount * SamplingPeriod;
+  auto missingTicks = static_cast<double>(ThreadsCount / WalltimeThreshold);
+  EXPECT_LE(wallTime, realWallTime);
+  EXPECT_GT(
+      static_cast<double>(wallTime.count()),
+      static_cast<double>(realWallTime.count()) * (1.0 - 2 * missingTicks / TicksCount)
+  );
+
+  ExpectGroupsMatch(sampler, 0.1);
+}
+
+// 300 threads, 64 checked per tick and at most 8 (cores) sampled per tick
+TEST(SamplingWeightTests, Cpu_ThresholdsReached_TotalsMatchRealTimes) {
+  constexpr size_t ThreadsCount = 300;
+  constexpr uint32_t CpuThreadsThreshold = 64;
+  constexpr uint32_t CoresCount = 8;
+
+  ThreadList threadList;
+  FakeThreadSampler sampler(threadList, ThreadsCount, FailureRate);
+  SamplingIteration iteration(
+      &threadList, &sampler, CpuThreadsThreshold, 5, CoresCount
+  );
+
+  for (int tick = 1; tick <= TicksCount; tick++) {
+    // the threads share the cores: at most 1/5 of a period each
+    sampler.NextTick(2ms);
+
+    ThreadList::ReadGuard guard(threadList);
+    iteration.RunCpu(guard, 0);
+  }
+  EXPECT_LE(sampler.GetCollectedCount(), TicksCount * CoresCount);
+
+  std::chrono::nanoseconds realCpuTime{0};
+  std::chrono::nanoseconds cpuTime{0};
+  for (auto const& thread : sampler.GetThreads()) {
+    realCpuTime += thread.realTime;
+    cpuTime += thread.estimatedTime;
+  }
+  EXPECT_LE(cpuTime, realCpuTime);
+  EXPECT_GT(
+      static_cast<double>(cpuTime.count()),
+      static_cast<double>(realCpuTime.count()) * 0.98
+  );
+
+  ExpectGroupsMatch(sampler, 0.05);
+}
+
+// A sample that is not recorded does not lose its time: the next one of the same
+// thread stands for both
+TEST(SamplingWeightTests, FailedSamples_AccountedInTheNextOne) {
+  ThreadList threadList;
+  FakeThreadSampler sampler(threadList, 1, 1.0);  // all samples fail
+  SamplingIteration iteration(&threadList, &sampler, 64, 5, 8);
+
+  for (int tick = 0; tick < 10; tick++) {
+    sampler.NextTick(2ms);
+    ThreadList::ReadGuard guard(threadList);
+    iteration.RunCpu(guard, 0);
+    iteration.RunWalltime(guard, 0, sampler.GetSamplingStart());
+  }
+
+  ThreadList::ReadGuard guard(threadList);
+  auto* pThreadInfo = threadList.LoopNext(threadList.CreateIterator(), guard);
+  ASSERT_NE(pThreadInfo, nullptr);
+  EXPECT_EQ(pThreadInfo->GetCpuConsumption(), 0ms);
+  EXPECT_EQ(
+      pThreadInfo->GetWalltimeSampleWeight(
+          sampler.GetTimestamp(), sampler.GetSamplingStart()
+      ),
+      10 * SamplingPeriod
+  );
+}
+
+// A deferred (folded) sample is not committed by the iteration: until the folder writes
+// it, the thread weight keeps growing
+TEST(SamplingWeightTests, DeferredSamples_NotCommitted) {
+  ThreadList threadList;
+  FakeThreadSampler sampler(threadList, 1, 0.0);
+  sampler.SetDeferring(true);
+  SamplingIteration iteration(&threadList, &sampler, 64, 5, 8);
+
+  for (int tick = 0; tick < 10; tick++) {
+    sampler.NextTick(0ms);
+    ThreadList::ReadGuard guard(threadList);
+    iteration.RunWalltime(guard, 0, sampler.GetSamplingStart());
+  }
+  EXPECT_EQ(sampler.GetCollectedCount(), 10u);
+
+  ThreadList::ReadGuard guard(threadList);
+  auto* pThreadInfo = threadList.LoopNext(threadList.CreateIterator(), guard);
+  ASSERT_NE(pThreadInfo, nullptr);
+  EXPECT_EQ(
+      pThreadInfo->GetWalltimeSampleWeight(
+          sampler.GetTimestamp(), sampler.GetSamplingStart()
+      ),
+      10 * SamplingPeriod
+  );
+}
+
+// The sampler thread itself is never sampled
+TEST(SamplingWeightTests, SamplerThread_NotSampled) {
+  ThreadList threadList;
+  FakeThreadSampler sampler(threadList, 3, 0.0);
+  SamplingIteration iteration(&threadList, &sampler, 64, 5, 8);
+
+  uint32_t samplerThreadId = FakeThreadSampler::GetThreadId(1);
+  for (int tick = 0; tick < 10; tick++) {
+    sampler.NextTick(0ms);
+    ThreadList::ReadGuard guard(threadList);
+    iteration.RunWalltime(guard, samplerThreadId, sampler.GetSamplingStart());
+  }
+
+  EXPECT_EQ(sampler.GetCollectedCount(), 20u);
+  EXPECT_EQ(sampler.GetThreads()[1].estimatedTime, 0ns);
+}
+
+// The first sample of a thread stands for the time since it was registered (or since
+// the sampling started)
+TEST(SamplingWeightTests, Walltime_FirstSampleWeight) {
+  auto samplingStart = OpSysTools::GetHighPrecisionTimestamp();
+  ThreadInfo threadInfo(4, nullptr);
+
+  auto registration = OpSysTools::GetHighPrecisionTimestamp();
+  auto weight = threadInfo.GetWalltimeSampleWeight(registration + 500ms, samplingStart);
+  EXPECT_GE(weight, 500ms);
+  EXPECT_LE(weight, 500ms + (registration - samplingStart));
+
+  // registered before the sampling started
+  weight = threadInfo.GetWalltimeSampleWeight(
+      registration + 1500ms, registration + 1000ms
+  );
+  EXPECT_EQ(weight, 500ms);
+
+  // then the time since the previous sample
+  threadInfo.SetLastWalltimeSampleTimestamp(registration + 2000ms);
+  weight = threadInfo.GetWalltimeSampleWeight(registration + 2600ms, samplingStart);
+  EXPECT_EQ(weight, 600ms);
+}
@@ -0,0 +1,789 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../dd-win-prof/StackFrameCollector.h"
+#include "../dd-win-prof/StackSnapshot.h"
+#include "../dd-win-prof/StackUnwinder.h"
+#include "pch.h"
+
+namespace {
+
+// Synthetic stack of 8-byte slots mapped at a fake address
+class FakeStack : public IStackMemory {
+ public:
+  static constexpr uint64_t Start = 0x7FF000;
+
+  explicit FakeStack(size_t slotsCount) : _slots(slotsCount, 0) {}
+
+  uint64_t Limit() const { return Start; }
+  uint64_t Base() const { return Start + _slots.size() * sizeof(uint64_t); }
+  void Set(uint64_t address, uint64_t value) { _slots[(address - Start) / 8] = value; }
+
+  bool ReadUInt64(uint64_t address, uint64_t& value) const override {
+    if ((address < Start) || (address + sizeof(uint64_t) > Base())) {
+      return false;
+    }
+    std::memcpy(
+        &value,
+        reinterpret_cast<const uint8_t*>(_slots.data()) + (address - Start),
+        sizeof(value)
+    );
+    return true;
+  }
+
+ private:
+  std::vector<uint64_t> _slots;
+};
+
+// Synthetic image: functions with their UNWIND_INFO and code bytes
+class FakeImage : public IUnwindTable {
+ public:
+  static constexpr uint64_t ImageBase = 0x140000000;
+  static constexpr uint32_t UnwindInfoRva = 0x8000;
+
+  FakeImage() : _bytes(0x10000, 0xCC), _nextUnwindInfoRva(UnwindInfoRva) {}
+
+  static uint64_t Address(uint32_t rva) { return ImageBase + rva; }
+
+  static uint16_t Code(uint8_t codeOffset, UnwindOp op, uint8_t opInfo) {
+    return codeOffset | (static_cast<uint16_t>(op) << 8) |
+           (static_cast<uint16_t>(opInfo) << 12);
+  }
+
+  // return the rva of the unwind info
+  uint32_t AddUnwindInfo(
+      uint8_t sizeOfProlog,
+      const std::vector<uint16_t>& codes,
+      uint8_t frameRegister = 0,
+      uint8_t frameOffset = 0,
+      uint8_t flags = 0,
+      const RUNTIME_FUNCTION* pChained = nullptr
+  ) {
+    uint32_t rva = _nextUnwindInfoRva;
+    std::vector<uint8_t> info = {
+        static_cast<uint8_t>(1 | (flags << 3)),
+        sizeOfProlog,
+        static_cast<uint8_t>(codes.size()),
+        static_cast<uint8_t>(frameRegister | (frameOffset << 4))
+    };
+    for (auto code : codes) {
+      info.push_back(static_cast<uint8_t>(code & 0xFF));
+      info.push_back(static_cast<uint8_t>(code >> 8));
+    }
+    if (codes.size() % 2 != 0) {
+      info.push_back(0);
+      info.push_back(0);
+    }
+    if (pChained != nullptr) {
+      auto pBytes = reinterpret_cast<const uint8_t*>(pChained);
+      info.insert(info.end(), pBytes, pBytes + sizeof(RUNTIME_FUNCTION));
+    }
+
+    std::memcpy(_bytes.data() + rva, info.data(), info.size());
+    _nextUnwindInfoRva += static_cast<uint32_t>((info.size() + 3) & ~3ull);
+    return rva;
+  }
+
+  RUNTIME_FUNCTION AddFunction(uint32_t begin, uint32_t end, uint32_t unwindInfoRva) {
+    RUNTIME_FUNCTION function = {begin, end, unwindInfoRva};
+
+    // sorted like .pdata
+    auto position = std::lower_bound(
+        _functions.begin(),
+        _functions.end(),
+        begin,
+        [](const RUNTIME_FUNCTION& entry, uint32_t rva) {
+          return entry.BeginAddress < rva;
+        }
+    );
+    _functions.insert(position, function);
+    return function;
+  }
+
+  void SetCode(uint32_t rva, const std::vector<uint8_t>& code) {
+    std::memcpy(_bytes.data() + rva, code.data(), code.size());
+  }
+
+  uint64_t GetLookupsCount() const { return _lookupsCount; }
+
+  // binary search, like RtlLookupFunctionEntry in the .pdata of a module
+  bool LookupFunctionEntry(
+      uint64_t rip, uint64_t& imageBase, RUNTIME_FUNCTION& entry
+  ) override {
+    _lookupsCount++;
+    if (rip < ImageBase) {
+      return false;
+    }
+
+    auto rva = static_cast<uint32_t>(rip - ImageBase);
+    auto next = std::upper_bound(
+        _functions.begin(),
+        _functions.end(),
+        rva,
+        [](uint32_t rva, const RUNTIME_FUNCTION& entry) {
+          return rva < entry.BeginAddress;
+        }
+    );
+    if ((next == _functions.begin()) || (rva >= std::prev(next)->EndAddress)) {
+      return false;
+    }
+
+    imageBase = ImageBase;
+    entry = *std::prev(next);
+    return true;
+  }
+
+  bool ReadImage(uint64_t address, void* pBuffer, size_t size) override {
+    if ((address < ImageBase) || (address + size > ImageBase + _bytes.size())) {
+      return false;
+    }
+    std::memcpy(pBuffer, _bytes.data() + (address - ImageBase), size);
+    return true;
+  }
+
+ private:
+  std::vector<uint8_t> _bytes;
+  std::vector<RUNTIME_FUNCTION> _functions;
+  uint32_t _nextUnwindInfoRva;
+  uint64_t _lookupsCount = 0;
+};
+
+// code without unwind data: its callers are treated as leaf functions
+constexpr uint32_t UnknownCodeRva = 0x3000;
+
+// A: push rbx; push rbp; sub rsp, 0x28
+constexpr uint32_t FunctionA = 0x1000;
+// B: push rbp; sub rsp, 0x40; lea rbp, [rsp + 0x20] (+ dynamic allocation in the body)
+constexpr uint32_t FunctionB = 0x2000;
+
+// F: push rbp; mov rbp, rsp; sub rsp, 0x20 (frame pointer chain)
+constexpr uint32_t FunctionF = 0x4000;
+constexpr uint32_t FunctionFSize = 0x100;
+constexpr uint64_t FunctionFFrameSize = 0x30;  // locals + saved rbp + return address
+
+void AddFunctionA(FakeImage& image) {
+  auto info = image.AddUnwindInfo(
+      6,
+      {FakeImage::Code(6, UnwindOp::AllocSmall, (0x28 / 8) - 1),
+       FakeImage::Code(2, UnwindOp::PushNonVolatile, 5),
+       FakeImage::Code(1, UnwindOp::PushNonVolatile, 3)}
+  );
+  image.AddFunction(FunctionA, FunctionA + 0x100, info);
+}
+
+void AddFunctionF(FakeImage& image) {
+  auto info = image.AddUnwindInfo(
+      8,
+      {FakeImage::Code(8, UnwindOp::AllocSmall, (0x20 / 8) - 1),
+       FakeImage::Code(4, UnwindOp::SetFramePointer, 0),
+       FakeImage::Code(1, UnwindOp::PushNonVolatile, 5)},
+      5  // rbp
+  );
+  image.AddFunction(FunctionF, FunctionF + FunctionFSize, info);
+}
+
+// Recursion of F: frame i starts at Start + i * FunctionFFrameSize and the deepest
+// one returns into code without unwind data. Return the registers of the top frame.
+UnwindRegisters BuildFunctionFStack(FakeStack& stack, size_t depth) {
+  for (size_t i = 0; i < depth; i++) {
+    uint64_t rbp = FakeStack::Start + i * FunctionFFrameSize + 0x20;
+    bool isLast = (i == depth - 1);
+    stack.Set(rbp, isLast ? 0 : rbp + FunctionFFrameSize);
+    stack.Set(
+        rbp + 8, FakeImage::Address(isLast ? UnknownCodeRva : FunctionF + 0x10)
+    );
+  }
+
+  UnwindRegisters registers;
+  registers.rip = FakeImage::Address(FunctionF + 0x20);
+  registers.gpr[UnwindRegisters::Rsp] = FakeStack::Start;
+  registers.gpr[UnwindRegisters::Rbp] = FakeStack::Start + 0x20;
+  return registers;
+}
+
+void AddFunctionB(FakeImage& image) {
+  auto info = image.AddUnwindInfo(
+      10,
+      {FakeImage::Code(10, UnwindOp::SetFramePointer, 0),
+       FakeImage::Code(5, UnwindOp::AllocSmall, (0x40 / 8) - 1),
+       FakeImage::Code(1, UnwindOp::PushNonVolatile, 5)},
+      5,  // rbp
+      2   // 0x20
+  );
+  image.AddFunction(FunctionB, FunctionB + 0x100, info);
+}
+
+}  // namespace
+
+TEST(StackUnwinderTests, LeafFunctions_PopReturnAddresses) {
+  FakeImage image;
+  FakeStack stack(8);
+  stack.Set(FakeStack::Start, FakeImage::Address(UnknownCodeRva + 0x10));
+  stack.Set(FakeStack::Start + 8, FakeImage::Address(UnknownCodeRva + 0x20));
+  // slot 2 is 0: end of the stack
+
+  UnwindRegisters registers;
+  registers.rip = FakeImage::Address(UnknownCodeRva);
+  registers.gpr[UnwindRegisters::Rsp] = FakeStack::Start;
+
+  StackUnwinder unwinder(&image);
+  uint64_t frames[16];
+  uint16_t framesCount = 16;
+  bool isTruncated = true;
+  ASSERT_TRUE(unwinder.Unwind(
+      registers, stack, stack.Limit(), stack.Base(), frames, framesCount, isTruncated
+  ));
+
+  ASSERT_EQ(framesCount, 3);
+  EXPECT_FALSE(isTruncated);
+  EXPECT_EQ(frames[0], FakeImage::Address(UnknownCodeRva));
+  EXPECT_EQ(frames[1], FakeImage::Address(UnknownCodeRva + 0x10));
+  EXPECT_EQ(frames[2], FakeImage::Address(UnknownCodeRva + 0x20));
+}
+
+TEST(StackUnwinderTests, UnwindCodesAndFramePointer_RestoreCallerFrames) {
+  FakeImage image;
+  AddFunctionA(image);
+  AddFunctionB(image);
+
+  // B calls A after a dynamic allocation of 0x100 bytes: only rbp gives B's frame
+  FakeStack stack(64);
+  uint64_t rspA = FakeStack::Start;
+  uint64_t frameB = rspA + 0x40 + 0x100;
+  stack.Set(rspA + 0x28, frameB + 0x20);                         // B's rbp
+  stack.Set(rspA + 0x30, 0xB0B);                                 // caller's rbx
+  stack.Set(rspA + 0x38, FakeImage::Address(FunctionB + 0x50));  // return into B
+  stack.Set(frameB + 0x40, 0x1234);                              // caller's rbp
+  stack.Set(frameB + 0x48, FakeImage::Address(UnknownCodeRva));  // return into C
+
+  UnwindRegisters registers;
+  registers.rip = FakeImage::Address(FunctionA + 0x40);
+  registers.gpr[UnwindRegisters::Rsp] = rspA;
+  registers.gpr[UnwindRegisters::Rbp] = 0xBAD;  // used as a general register by A
+
+  StackUnwinder unwinder(&image);
+  uint64_t frames[16];
+  uint16_t framesCount = 16;
+  bool isTruncated = true;
+  ASSERT_TRUE(unwinder.Unwind(
+      registers, stack, stack.Limit(), stack.Base(), frames, framesCount, isTruncated
+  ));
+
+  ASSERT_EQ(framesCount, 3);
+  EXPECT_FALSE(isTruncated);
+  EXPECT_EQ(frames[0], FakeImage::Address(FunctionA + 0x40));
+  EXPECT_EQ(frames[1], FakeImage::Address(FunctionB + 0x50));
+  EXPECT_EQ(frames[2], FakeImage::Address(UnknownCodeRva));
+  EXPECT_EQ(registers.gpr[3], 0xB0B);  // rbx
+  EXPECT_EQ(registers.gpr[UnwindRegisters::Rbp], 0x1234);
+}
+
+TEST(StackUnwinderTests, RipInProlog_OnlyUndoesExecutedOperations) {
+  FakeImage image;
+  AddFunctionA(image);
+
+  // only "push rbx" has been executed
+  FakeStack stack(8);
+  stack.Set(FakeStack::Start, 0xB0B);
+  stack.Set(FakeStack::Start + 8, FakeImage::Address(UnknownCodeRva));
+
+  UnwindRegisters registers;
+  registers.rip = FakeImage::Address(FunctionA + 1);
+  registers.gpr[UnwindRegisters::Rsp] = FakeStack::Start;
+
+  StackUnwinder unwinder(&image);
+  uint64_t frames[16];
+  uint16_t framesCount = 16;
+  bool isTruncated = true;
+  ASSERT_TRUE(unwinder.Unwind(
+      registers, stack, stack.Limit(), stack.Base(), frames, framesCount, isTruncated
+  ));
+
+  ASSERT_EQ(framesCount, 2);
+  EXPECT_EQ(frames[1], FakeImage::Address(UnknownCodeRva));
+  EXPECT_EQ(registers.gpr[3], 0xB0B);
+}
+
+TEST(StackUnwinderTests, RipInEpilog_EmulatesRemainingInstructions) {
+  FakeImage image;
+  AddFunctionA(image);
+
+  // add rsp, 0x28; pop rbp; pop rbx; ret
+  constexpr uint32_t Epilog = FunctionA + 0x80;
+  image.SetCode(Epilog, {0x48, 0x83, 0xC4, 0x28, 0x5D, 0x5B, 0xC3});
+
+  // "add rsp, 0x28" and "pop rbp" have been executed
+  FakeStack stack(8);
+  stack.Set(FakeStack::Start, 0xB0B);
+  stack.Set(FakeStack::Start + 8, FakeImage::Address(UnknownCodeRva));
+
+  UnwindRegisters registers;
+  registers.rip = FakeImage::Address(Epilog + 5);
+  registers.gpr[UnwindRegisters::Rsp] = FakeStack::Start;
+
+  StackUnwinder unwinder(&image);
+  uint64_t frames[16];
+  uint16_t framesCount = 16;
+  bool isTruncated = true;
+  ASSERT_TRUE(unwinder.Unwind(
+      registers, stack, stack.Limit(), stack.Base(), frames, framesCount, isTruncated
+  ));
+
+  ASSERT_EQ(framesCount, 2);
+  EXPECT_EQ(frames[1], FakeImage::Address(UnknownCodeRva));
+  EXPECT_EQ(registers.gpr[3], 0xB0B);
+
+  // from the start of the epilog, the whole frame is popped
+  FakeStack fullStack(16);
+  fullStack.Set(FakeStack::Start + 0x28, 0x1234);
+  fullStack.Set(FakeStack::Start + 0x30, 0xB0B);
+  fullStack.Set(FakeStack::Start + 0x38, FakeImage::Address(UnknownCodeRva));
+
+  registers = {};
+  registers.rip = FakeImage::Address(Epilog);
+  registers.gpr[UnwindRegisters::Rsp] = FakeStack::Start;
+  framesCount = 16;
+  ASSERT_TRUE(unwinder.Unwind(
+      registers,
+      fullStack,
+      fullStack.Limit(),
+      fullStack.Base(),
+      frames,
+      framesCount,
+      isTruncated
+  ));
+
+  ASSERT_EQ(framesCount, 2);
+  EXPECT_EQ(frames[1], FakeImage::Address(UnknownCodeRva));
+  EXPECT_EQ(registers.gpr[3], 0xB0B);
+  EXPECT_EQ(registers.gpr[UnwindRegisters::Rbp], 0x1234);
+}
+
+TEST(StackUnwinderTests, ChainedUnwindInfo_AppliesPrimaryFunctionCodes) {
+  FakeImage image;
+  AddFunctionA(image);
+
+  // a cold fragment of A that saved rsi on top of A's own prolog
+  RUNTIME_FUNCTION primary;
+  uint64_t imageBase;
+  ASSERT_TRUE(
+      image.LookupFunctionEntry(FakeImage::Address(FunctionA), imageBase, primary)
+  );
+  auto info = image.AddUnwindInfo(
+      0, {FakeImage::Code(0, UnwindOp::PushNonVolatile, 6)}, 0, 0, 0x4, &primary
+  );
+  constexpr uint32_t Fragment = 0x5000;
+  image.AddFunction(Fragment, Fragment + 0x100, info);
+
+  FakeStack stack(16);
+  stack.Set(FakeStack::Start, 0x5151);             // rsi
+  stack.Set(FakeStack::Start + 8 + 0x28, 0x1234);  // rbp
+  stack.Set(FakeStack::Start + 8 + 0x30, 0xB0B);   // rbx
+  stack.Set(FakeStack::Start + 8 + 0x38, FakeImage::Address(UnknownCodeRva));
+
+  UnwindRegisters registers;
+  registers.rip = FakeImage::Address(Fragment + 0x10);
+  registers.gpr[UnwindRegisters::Rsp] = FakeStack::Start;
+
+  StackUnwinder unwinder(&image);
+  uint64_t frames[16];
+  uint16_t framesCount = 16;
+  bool isTruncated = true;
+  ASSERT_TRUE(unwinder.Unwind(
+      registers, stack, stack.Limit(), stack.Base(), frames, framesCount, isTruncated
+  ));
+
+  ASSERT_EQ(framesCount, 2);
+  EXPECT_EQ(frames[1], FakeImage::Address(UnknownCodeRva));
+  EXPECT_EQ(registers.gpr[6], 0x5151);
+  EXPECT_EQ(registers.gpr[UnwindRegisters::Rbp], 0x1234);
+  EXPECT_EQ(registers.gpr[3], 0xB0B);
+}
+
+TEST(StackUnwinderTests, TooManyFrames_IsTruncated) {
+  FakeImage image;
+  FakeStack stack(8);
+  for (uint64_t i = 0; i < 7; i++) {
+    stack.Set(FakeStack::Start + i * 8, FakeImage::Address(UnknownCodeRva + 0x10));
+  }
+
+  UnwindRegisters registers;
+  registers.rip = FakeImage::Address(UnknownCodeRva);
+  registers.gpr[UnwindRegisters::Rsp] = FakeStack::Start;
+
+  StackUnwinder unwinder(&image);
+  uint64_t frames[4];
+  uint16_t framesCount = 4;
+  bool isTruncated = false;
+  ASSERT_TRUE(unwinder.Unwind(
+      registers, stack, stack.Limit(), stack.Base(), frames, framesCount, isTruncated
+  ));
+
+  EXPECT_EQ(framesCount, 4);
+  EXPECT_TRUE(isTruncated);
+}
+
+TEST(StackUnwinderTests, CorruptedStackPointer_Fails) {
+  FakeImage image;
+  AddFunctionB(image);
+
+  // B's frame pointer points below the current stack pointer
+  FakeStack stack(16);
+  UnwindRegisters registers;
+  registers.rip = FakeImage::Address(FunctionB + 0x50);
+  registers.gpr[UnwindRegisters::Rsp] = FakeStack::Start + 0x40;
+  registers.gpr[UnwindRegisters::Rbp] = FakeStack::Start;
+
+  StackUnwinder unwinder(&image);
+  uint64_t frames[16];
+  uint16_t framesCount = 16;
+  bool isTruncated = false;
+  EXPECT_FALSE(unwinder.Unwind(
+      registers, stack, stack.Limit(), stack.Base(), frames, framesCount, isTruncated
+  ));
+}
+
+TEST(StackUnwinderTests, FramePointers_SameFramesWithoutLookups) {
+  FakeImage image;
+  AddFunctionF(image);
+
+  constexpr size_t Depth = 16;
+  FakeStack stack(Depth * FunctionFFrameSize / 8 + 8);
+  auto topRegisters = BuildFunctionFStack(stack, Depth);
+
+  uint64_t tableFrames[64];
+  uint16_t tableFramesCount = 64;
+  bool isTruncated = true;
+  auto registers = topRegisters;
+  StackUnwinder tableUnwinder(&image, UnwindStrategy::UnwindTables);
+  ASSERT_TRUE(tableUnwinder.Unwind(
+      registers,
+      stack,
+      stack.Limit(),
+      stack.Base(),
+      tableFrames,
+      tableFramesCount,
+      isTruncated
+  ));
+  EXPECT_EQ(tableFramesCount, Depth + 1);
+  auto tableLookupsCount = image.GetLookupsCount();
+
+  uint64_t frames[64];
+  uint16_t framesCount = 64;
+  registers = topRegisters;
+  StackUnwinder unwinder(&image, UnwindStrategy::FramePointers);
+  ASSERT_TRUE(unwinder.Unwind(
+      registers, stack, stack.Limit(), stack.Base(), frames, framesCount, isTruncated
+  ));
+  EXPECT_FALSE(isTruncated);
+
+  ASSERT_EQ(framesCount, tableFramesCount);
+  for (uint16_t i = 0; i < framesCount; i++) {
+    EXPECT_EQ(frames[i], tableFrames[i]) << "frame " << i;
+  }
+
+  // only the top frame and the end of the chain (rbp = 0) are looked up
+  EXPECT_EQ(image.GetLookupsCount() - tableLookupsCount, 2);
+}
+
+TEST(StackUnwinderTests, FramePointers_BrokenChain_FallsBackToUnwindTables) {
+  FakeImage image;
+  AddFunctionA(image);
+  AddFunctionF(image);
+
+  // F (top) <- A, which uses rbp as a general register <- F <- unknown code
+  FakeStack stack(64);
+  uint64_t rspA = FakeStack::Start + FunctionFFrameSize;
+  uint64_t rspF = rspA + 0x40;
+  stack.Set(FakeStack::Start + 0x20, 0xBAD);  // A's rbp
+  stack.Set(FakeStack::Start + 0x28, FakeImage::Address(FunctionA + 0x40));
+  stack.Set(rspA + 0x28, rspF + 0x20);  // the chain skips A
+  stack.Set(rspA + 0x30, 0xB0B);
+  stack.Set(rspA + 0x38, FakeImage::Address(FunctionF + 0x10));
+  stack.Set(rspF + 0x20, 0);
+  stack.Set(rspF + 0x28, FakeImage::Address(UnknownCodeRva));
+
+  UnwindRegisters registers;
+  registers.rip = FakeImage::Address(FunctionF + 0x20);
+  registers.gpr[UnwindRegisters::Rsp] = FakeStack::Start;
+  registers.gpr[UnwindRegisters::Rbp] = FakeStack::Start + 0x20;
+
+  StackUnwinder unwinder(&image, UnwindStrategy::FramePointers);
+  uint64_t frames[16];
+  uint16_t framesCount = 16;
+  bool isTruncated = true;
+  ASSERT_TRUE(unwinder.Unwind(
+      registers, stack, stack.Limit(), stack.Base(), frames, framesCount, isTruncated
+  ));
+
+  ASSERT_EQ(framesCount, 4);
+  EXPECT_EQ(frames[0], FakeImage::Address(FunctionF + 0x20));
+  EXPECT_EQ(frames[1], FakeImage::Address(FunctionA + 0x40));
+  EXPECT_EQ(frames[2], FakeImage::Address(FunctionF + 0x10));
+  EXPECT_EQ(frames[3], FakeImage::Address(UnknownCodeRva));
+  EXPECT_EQ(registers.gpr[3], 0xB0B);
+}
+
+TEST(StackUnwinderTests, FramePointersVsUnwindTables_Benchmark) {
+  constexpr size_t Depth = 64;
+  constexpr int Iterations = 20000;
+
+  // enough functions for the lookups to be a real binary search
+  FakeImage image;
+  AddFunctionF(image);
+  auto paddingInfo = image.AddUnwindInfo(0, {});
+  for (uint32_t rva = 0x5000; rva < 0x7000; rva += 4) {
+    image.AddFunction(rva, rva + 4, paddingInfo);
+  }
+
+  FakeStack stack(Depth * FunctionFFrameSize / 8 + 8);
+  auto topRegisters = BuildFunctionFStack(stack, Depth);
+
+  auto measure = [&](UnwindStrategy strategy) {
+    StackUnwinder unwinder(&image, strategy);
+    uint64_t frames[512];
+    uint64_t totalFramesCount = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Iterations; i++) {
+      auto registers = topRegisters;
+      uint16_t framesCount = 512;
+      bool isTruncated = false;
+      unwinder.Unwind(
+          registers,
+          stack,
+          stack.Limit(),
+          stack.Base(),
+          frames,
+          framesCount,
+          isTruncated
+      );
+      totalFramesCount += framesCount;
+    }
+    auto duration = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(totalFramesCount, Iterations * (Depth + 1));
+
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    return static_cast<double>(totalFramesCount) / std::max<int64_t>(us, 1);
+  };
+
+  auto tablesFramesPerUs = measure(UnwindStrategy::UnwindTables);
+  auto framePointersFramesPerUs = measure(UnwindStrategy::FramePointers);
+  std::cout << "Unwind tables:  " << tablesFramesPerUs << " frames/us" << std::endl;
+  std::cout << "Frame pointers: " << framePointersFramesPerUs << " frames/us"
+            << std::endl;
+}
+
+TEST(StackSnapshotTests, Capture_RequiresStackBoundaries) {
+  uint64_t slots[4] = {1, 2, 3, 4};
+  auto start = reinterpret_cast<uint64_t>(slots);
+
+  CONTEXT context = {};
+  context.Rsp = start;
+
+  StackSnapshot snapshot(64);
+  EXPECT_FALSE(snapshot.Capture(context, 0, 0));
+  EXPECT_FALSE(snapshot.Capture(context, start + 8, start + sizeof(slots)));
+  EXPECT_FALSE(snapshot.Capture(context, start, start));
+
+  ASSERT_TRUE(snapshot.Capture(context, start, start + sizeof(slots)));
+  EXPECT_EQ(snapshot.GetStart(), start);
+  EXPECT_EQ(snapshot.GetSize(), sizeof(slots));
+
+  uint64_t value = 0;
+  EXPECT_TRUE(snapshot.ReadUInt64(start + 24, value));
+  EXPECT_EQ(value, 4);
+  EXPECT_FALSE(snapshot.ReadUInt64(start + 25, value));
+  EXPECT_FALSE(snapshot.ReadUInt64(start + 32, value));
+  EXPECT_FALSE(snapshot.ReadUInt64(start - 8, value));
+  EXPECT_FALSE(snapshot.ReadUInt64(UINT64_MAX - 4, value));
+}
+
+TEST(StackSnapshotTests, StackLargerThanSnapshot_IsTruncated) {
+  FakeImage image;
+
+  // only the first 4 slots of the stack fit in the snapshot
+  uint64_t slots[8];
+  for (auto& slot : slots) {
+    slot = FakeImage::Address(UnknownCodeRva + 0x10);
+  }
+  auto start = reinterpret_cast<uint64_t>(slots);
+
+  CONTEXT context = {};
+  context.Rip = FakeImage::Address(UnknownCodeRva);
+  context.Rsp = start;
+
+  StackSnapshot snapshot(4 * sizeof(uint64_t));
+  ASSERT_TRUE(snapshot.Capture(context, start, start + sizeof(slots)));
+  EXPECT_EQ(snapshot.GetSize(), 4 * sizeof(uint64_t));
+
+  UnwindRegisters registers = snapshot.GetRegisters();
+  StackUnwinder unwinder(&image);
+  uint64_t frames[16];
+  uint16_t framesCount = 16;
+  bool isTruncated = false;
+  ASSERT_TRUE(unwinder.Unwind(
+      registers,
+      snapshot,
+      snapshot.GetStackLimit(),
+      snapshot.GetStackBase(),
+      frames,
+      framesCount,
+      isTruncated
+  ));
+
+  // rip + 4 return addresses + the truncation slot
+  ASSERT_EQ(framesCount, 6);
+  EXPECT_TRUE(isTruncated);
+  EXPECT_EQ(frames[5], 0);
+}
+
+#ifdef _WIN64
+namespace {
+std::atomic<bool> s_isSpinning{true};
+
+__declspec(noinline) int Recurse(int depth) {
+  if (depth == 0) {
+    while (s_isSpinning.load()) {
+      std::this_thread::yield();
+    }
+    return 0;
+  }
+  return Recurse(depth - 1) + 1;
+}
+}  // namespace
+
+TEST(StackSnapshotTests, SuspendedThread_SnapshotMatchesInPlaceUnwinding) {
+  s_isSpinning = true;
+  std::thread worker([]() { Recurse(32); });
+
+  HANDLE hThread = NULL;
+  ASSERT_TRUE(DuplicateHandle(
+      GetCurrentProcess(),
+      worker.native_handle(),
+      GetCurrentProcess(),
+      &hThread,
+      0,
+      FALSE,
+      DUPLICATE_SAME_ACCESS
+  ));
+  auto pThreadInfo = std::make_shared<ThreadInfo>(GetThreadId(hThread), hThread);
+
+  // let the worker reach the bottom of the recursion
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  StackFrameCollector collector;
+  StackSnapshot snapshot;
+  uint64_t inPlaceFrames[512];
+  uint16_t inPlaceCount = 512;
+  bool isInPlaceTruncated = false;
+  bool isInPlaceCaptured = false;
+  bool isSnapshotCaptured = false;
+
+  CONTEXT context;
+  ASSERT_TRUE(collector.TrySuspendThread(pThreadInfo.get(), context));
+  isSnapshotCaptured = collector.CaptureStackSnapshot(hThread, context, snapshot);
+  isInPlaceCaptured = collector.CaptureStack(
+      hThread, context, inPlaceFrames, inPlaceCount, isInPlaceTruncated
+  );
+  ::ResumeThread(hThread);
+
+  uint64_t snapshotFrames[512];
+  uint16_t snapshotCount = 512;
+  bool isSnapshotTruncated = false;
+  bool isUnwound = isSnapshotCaptured &&
+                   collector.UnwindStackSnapshot(
+                       snapshot, snapshotFrames, snapshotCount, isSnapshotTruncated
+                   );
+
+  s_isSpinning = false;
+  worker.join();
+
+  ASSERT_TRUE(isInPlaceCaptured);
+  ASSERT_TRUE(isSnapshotCaptured);
+  ASSERT_TRUE(isUnwound);
+  EXPECT_GT(snapshotCount, 32);
+  EXPECT_FALSE(isSnapshotTruncated);
+  ASSERT_EQ(snapshotCount, inPlaceCount);
+  for (uint16_t i = 0; i < snapshotCount; i++) {
+    EXPECT_EQ(snapshotFrames[i], inPlaceFrames[i]) << "frame " << i;
+  }
+}
+
+// In place with the frame pointer strategy (the target thread is still suspended while
+// the callers are looked up): the rbp chain only skips the functions that don't
+// maintain it, so the frames are a subsequence of the ones found with the unwind data
+TEST(StackUnwinderTests, SuspendedThread_FramePointersInPlace_MatchUnwindTables) {
+  s_isSpinning = true;
+  std::thread worker([]() { Recurse(32); });
+
+  HANDLE hThread = NULL;
+  ASSERT_TRUE(DuplicateHandle(
+      GetCurrentProcess(),
+      worker.native_handle(),
+      GetCurrentProcess(),
+      &hThread,
+      0,
+      FALSE,
+      DUPLICATE_SAME_ACCESS
+  ));
+  auto pThreadInfo = std::make_shared<ThreadInfo>(GetThreadId(hThread), hThread);
+
+  // let the worker reach the bottom of the recursion
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  StackFrameCollector collector;
+  uint64_t framePointerFrames[512];
+  uint16_t framePointerCount = 512;
+  bool isFramePointerTruncated = false;
+  uint64_t unwindTablesFrames[512];
+  uint16_t unwindTablesCount = 512;
+  bool isUnwindTablesTruncated = false;
+
+  // both walks mutate the context
+  CONTEXT context;
+  ASSERT_TRUE(collector.TrySuspendThread(pThreadInfo.get(), context));
+  CONTEXT seedContext = context;
+  collector.SetUnwindStrategy(UnwindStrategy::FramePointers);
+  bool isFramePointerCaptured = collector.CaptureStack(
+      hThread, context, framePointerFrames, framePointerCount, isFramePointerTruncated
+  );
+  collector.SetUnwindStrategy(UnwindStrategy::UnwindTables);
+  bool isUnwindTablesCaptured = collector.CaptureStack(
+      hThread,
+      seedContext,
+      unwindTablesFrames,
+      unwindTablesCount,
+      isUnwindTablesTruncated
+  );
+  ::ResumeThread(hThread);
+
+  s_isSpinning = false;
+  worker.join();
+
+  ASSERT_TRUE(isFramePointerCaptured);
+  ASSERT_TRUE(isUnwindTablesCaptured);
+  EXPECT_FALSE(isFramePointerTruncated);
+  EXPECT_GT(unwindTablesCount, 32);
+  ASSERT_GT(framePointerCount, 1);
+  EXPECT_EQ(framePointerFrames[0], unwindTablesFrames[0]);
+
+  auto pNext = unwindTablesFrames;
+  auto pEnd = unwindTablesFrames + unwindTablesCount;
+  for (uint16_t i = 0; i < framePointerCount; i++) {
+    pNext = std::find(pNext, pEnd, framePointerFrames[i]);
+    ASSERT_NE(pNext, pEnd) << "frame " << i;
+    pNext++;
+  }
+}
+#endif
@@ -0,0 +1,165 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+#include "../dd-win-prof/SuspensionWatchdog.h"
+#include "../dd-win-prof/ThreadInfo.h"
+#include "pch.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+constexpr size_t HandlesCount = 4096;
+
+// count the resumes of fake thread handles (= index in the array)
+class FakeThreadControl : public IThreadControl {
+ public:
+  void ResumeThread(HANDLE hThread) override {
+    _resumesCount[reinterpret_cast<uintptr_t>(hThread) % HandlesCount]++;
+    _totalResumesCount++;
+  }
+
+  int GetResumesCount(HANDLE hThread) const {
+    return _resumesCount[reinterpret_cast<uintptr_t>(hThread) % HandlesCount];
+  }
+
+  int GetTotalResumesCount() const { return _totalResumesCount; }
+
+ private:
+  std::array<std::atomic<int>, HandlesCount> _resumesCount{};
+  std::atomic<int> _totalResumesCount{0};
+};
+
+HANDLE MakeFakeHandle(uintptr_t value) { return reinterpret_cast<HANDLE>(value); }
+}  // namespace
+
+TEST(SuspensionWatchdogTests, ResumeThread_BeforeDeadline_ResumesOnce) {
+  FakeThreadControl threadControl;
+  SuspensionWatchdog watchdog(&threadControl, 1000ms);
+  HANDLE hThread = MakeFakeHandle(1);
+
+  watchdog.OnThreadSuspended(hThread);
+  EXPECT_FALSE(watchdog.CheckSuspension());
+  EXPECT_TRUE(watchdog.ResumeThread());
+  EXPECT_EQ(threadControl.GetResumesCount(hThread), 1);
+
+  // nothing to resume anymore
+  EXPECT_FALSE(watchdog.CheckSuspension());
+  EXPECT_EQ(threadControl.GetTotalResumesCount(), 1);
+  EXPECT_EQ(watchdog.GetStallsHistogram()->GetAndReset().count, 0);
+}
+
+TEST(SuspensionWatchdogTests, StuckStackWalk_IsResumedByTheWatchdog) {
+  FakeThreadControl threadControl;
+  SuspensionWatchdog watchdog(&threadControl, 20ms);
+  HANDLE hThread = MakeFakeHandle(2);
+
+  watchdog.OnThreadSuspended(hThread);
+  EXPECT_FALSE(watchdog.CheckSuspension());
+
+  // simulate a stack walk slower than the deadline
+  std::this_thread::sleep_for(30ms);
+  EXPECT_TRUE(watchdog.CheckSuspension());
+  EXPECT_FALSE(watchdog.CheckSuspension());
+  EXPECT_EQ(threadControl.GetResumesCount(hThread), 1);
+
+  // the sampler must not resume the thread a second time and drops the sample
+  EXPECT_FALSE(watchdog.ResumeThread());
+  EXPECT_EQ(threadControl.GetResumesCount(hThread), 1);
+
+  auto stalls = watchdog.GetStallsHistogram()->GetAndReset();
+  EXPECT_EQ(stalls.count, 1);
+  EXPECT_GE(stalls.max, 30ms);
+
+  // the next suspension is handled normally
+  watchdog.OnThreadSuspended(hThread);
+  EXPECT_TRUE(watchdog.ResumeThread());
+  EXPECT_EQ(threadControl.GetResumesCount(hThread), 2);
+}
+
+TEST(SuspensionWatchdogTests, WatchdogThread_UnblocksStuckStackWalk) {
+  FakeThreadControl threadControl;
+  SuspensionWatchdog watchdog(&threadControl, 20ms);
+  watchdog.Start();
+  HANDLE hThread = MakeFakeHandle(3);
+
+  // the stack walk waits for a lock owned by the suspended thread: it is released
+  // only when the thread is resumed
+  watchdog.OnThreadSuspended(hThread);
+  auto start = std::chrono::steady_clock::now();
+  while ((threadControl.GetResumesCount(hThread) == 0) &&
+         (std::chrono::steady_clock::now() - start < 5s)) {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_EQ(threadControl.GetResumesCount(hThread), 1);
+  EXPECT_FALSE(watchdog.ResumeThread());
+
+  watchdog.Stop();
+  EXPECT_EQ(threadControl.GetResumesCount(hThread), 1);
+  EXPECT_EQ(watchdog.GetStallsHistogram()->GetAndReset().count, 1);
+}
+
+TEST(SuspensionWatchdogTests, ConcurrentResumes_ResumeEachSuspensionOnce) {
+  FakeThreadControl threadControl;
+  SuspensionWatchdog watchdog(&threadControl, 1ms);
+  watchdog.Start();
+
+  // stack walks around the deadline so that the sampler and the watchdog race
+  constexpr int SuspensionsCount = 2000;
+  int droppedSamplesCount = 0;
+  for (int i = 0; i < SuspensionsCount; i++) {
+    HANDLE hThread = MakeFakeHandle(i + 1);
+    watchdog.OnThreadSuspended(hThread);
+
+    auto walkDuration = std::chrono::microseconds((i * 37) % 2000);
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < walkDuration) {
+    }
+
+    if (!watchdog.ResumeThread()) {
+      droppedSamplesCount++;
+    }
+  }
+  watchdog.Stop();
+
+  for (int i = 0; i < SuspensionsCount; i++) {
+    ASSERT_EQ(threadControl.GetResumesCount(MakeFakeHandle(i + 1)), 1) << i;
+  }
+  EXPECT_EQ(threadControl.GetTotalResumesCount(), SuspensionsCount);
+  EXPECT_EQ(watchdog.GetStallsHistogram()->GetAndReset().count, droppedSamplesCount);
+}
+
+TEST(SuspensionWatchdogTests, ThreadInfo_BacksOffAfterStuckStackWalks) {
+  ThreadInfo threadInfo(1, nullptr);
+  auto now = 1000s;
+  EXPECT_FALSE(threadInfo.IsSamplingBackedOff(now));
+
+  threadInfo.OnStuckStackWalk(now);
+  EXPECT_TRUE(threadInfo.IsSamplingBackedOff(now + 500ms));
+  EXPECT_FALSE(threadInfo.IsSamplingBackedOff(now + 1s));
+
+  // the delay doubles for each consecutive stuck stack walk...
+  now += 1s;
+  threadInfo.OnStuckStackWalk(now);
+  EXPECT_TRUE(threadInfo.IsSamplingBackedOff(now + 1500ms));
+  EXPECT_FALSE(threadInfo.IsSamplingBackedOff(now + 2s));
+
+  // ...up to a maximum
+  for (int i = 0; i < 10; i++) {
+    threadInfo.OnStuckStackWalk(now);
+  }
+  EXPECT_TRUE(threadInfo.IsSamplingBackedOff(now + 59s));
+  EXPECT_FALSE(threadInfo.IsSamplingBackedOff(now + 60s));
+  EXPECT_EQ(threadInfo.GetStuckStackWalksCount(), 12);
+
+  // and restarts from the minimum after a successful stack walk
+  threadInfo.OnStackWalkCompleted();
+  threadInfo.OnStuckStackWalk(now);
+  EXPECT_FALSE(threadInfo.IsSamplingBackedOff(now + 1s));
+}
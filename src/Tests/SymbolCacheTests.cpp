@@ -0,0 +1,248 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../dd-win-prof/SymbolCache.h"
+#include "pch.h"
+
+static CachedSymbolInfo CreateSymbol(uint64_t address) {
+  CachedSymbolInfo symbol;
+  symbol.FunctionNameId.value = static_cast<uint32_t>(address);
+  symbol.isValid = true;
+  return symbol;
+}
+
+TEST(SymbolCacheTests, Find_InsertedAddresses) {
+  SymbolCache cache(0);
+  EXPECT_EQ(cache.Find(0x1000, 0), nullptr);
+
+  cache.Insert(0x1000, CreateSymbol(0x1000), 0);
+  cache.Insert(0x2000, CreateSymbol(0x2000), 0);
+
+  const auto* pSymbol = cache.Find(0x1000, 0);
+  ASSERT_NE(pSymbol, nullptr);
+  EXPECT_EQ(pSymbol->FunctionNameId.value, 0x1000u);
+  pSymbol = cache.Find(0x2000, 0);
+  ASSERT_NE(pSymbol, nullptr);
+  EXPECT_EQ(pSymbol->FunctionNameId.value, 0x2000u);
+  EXPECT_EQ(cache.Find(0x3000, 0), nullptr);
+
+  EXPECT_EQ(cache.GetSize(), 2u);
+  EXPECT_EQ(cache.GetHitsCount(), 2u);
+  EXPECT_EQ(cache.GetMissesCount(), 2u);
+  EXPECT_EQ(cache.GetEvictionsCount(), 0u);
+}
+
+TEST(SymbolCacheTests, Unlimited_NoEviction) {
+  SymbolCache cache(0);
+  for (uint64_t address = 0; address < 10000; address++) {
+    cache.Insert(address, CreateSymbol(address), 0);
+  }
+
+  EXPECT_EQ(cache.GetSize(), 10000u);
+  EXPECT_EQ(cache.GetEvictionsCount(), 0u);
+  for (uint64_t address = 0; address < 10000; address++) {
+    ASSERT_NE(cache.Find(address, 0), nullptr) << address;
+  }
+}
+
+TEST(SymbolCacheTests, Full_EvictsTheEntriesNotUsedFirst) {
+  SymbolCache cache(4);
+  for (uint64_t address = 1; address <= 4; address++) {
+    cache.Insert(address, CreateSymbol(address), 0);
+  }
+
+  // second chance for the used entries
+  ASSERT_NE(cache.Find(1, 0), nullptr);
+  ASSERT_NE(cache.Find(3, 0), nullptr);
+
+  cache.Insert(5, CreateSymbol(5), 0);
+  cache.Insert(6, CreateSymbol(6), 0);
+
+  EXPECT_EQ(cache.GetSize(), 4u);
+  EXPECT_EQ(cache.GetEvictionsCount(), 2u);
+  EXPECT_NE(cache.Find(1, 0), nullptr);
+  EXPECT_NE(cache.Find(3, 0), nullptr);
+  EXPECT_NE(cache.Find(5, 0), nullptr);
+  EXPECT_NE(cache.Find(6, 0), nullptr);
+  EXPECT_EQ(cache.Find(2, 0), nullptr);
+  EXPECT_EQ(cache.Find(4, 0), nullptr);
+}
+
+TEST(SymbolCacheTests, Full_AllEntriesUsed) {
+  SymbolCache cache(3);
+  for (uint64_t address = 1; address <= 3; address++) {
+    cache.Insert(address, CreateSymbol(address), 0);
+    cache.Find(address, 0);
+  }
+
+  // a full turn clears the reference bits: the entry under the hand is evicted
+  cache.Insert(4, CreateSymbol(4), 0);
+  EXPECT_EQ(cache.GetSize(), 3u);
+  EXPECT_EQ(cache.GetEvictionsCount(), 1u);
+  EXPECT_EQ(cache.Find(1, 0), nullptr);
+
+  const auto* pSymbol = cache.Find(4, 0);
+  ASSERT_NE(pSymbol, nullptr);
+  EXPECT_EQ(pSymbol->FunctionNameId.value, 4u);
+}
+
+TEST(SymbolCacheTests, EvictUnused_UsesTheLastExportId) {
+  SymbolCache cache(0);
+  cache.Insert(1, CreateSymbol(1), 0);
+  cache.Insert(2, CreateSymbol(2), 0);
+  cache.Insert(3, CreateSymbol(3), 5);
+  cache.Find(2, 8);
+
+  // 1 was last used 10 exports ago
+  EXPECT_EQ(cache.EvictUnused(10, 5), 1u);
+  EXPECT_EQ(cache.GetSize(), 2u);
+  EXPECT_EQ(cache.GetEvictionsCount(), 1u);
+  EXPECT_EQ(cache.Find(1, 10), nullptr);
+  EXPECT_NE(cache.Find(2, 10), nullptr);
+  EXPECT_NE(cache.Find(3, 10), nullptr);
+
+  // the remaining entries are still found after the slots were compacted
+  EXPECT_EQ(cache.EvictUnused(20, 5), 2u);
+  EXPECT_EQ(cache.GetSize(), 0u);
+  cache.Insert(4, CreateSymbol(4), 20);
+  EXPECT_NE(cache.Find(4, 20), nullptr);
+}
+
+TEST(SymbolCacheTests, EvictUnused_ExportIdWrapAround) {
+  SymbolCache cache(0);
+  cache.Insert(1, CreateSymbol(1), UINT32_MAX - 1);
+  cache.Insert(2, CreateSymbol(2), UINT32_MAX - 10);
+
+  EXPECT_EQ(cache.EvictUnused(2, 5), 1u);
+  EXPECT_NE(cache.Find(1, 2), nullptr);
+  EXPECT_EQ(cache.Find(2, 2), nullptr);
+}
+
+TEST(SymbolCacheTests, Clear) {
+  SymbolCache cache(2);
+  cache.Insert(1, CreateSymbol(1), 0);
+  cache.Insert(2, CreateSymbol(2), 0);
+  cache.Insert(3, CreateSymbol(3), 0);
+  cache.Find(3, 0);
+  EXPECT_GT(cache.GetMemorySize(), 0u);
+
+  cache.Clear();
+  EXPECT_EQ(cache.GetSize(), 0u);
+  EXPECT_EQ(cache.GetHitsCount(), 0u);
+  EXPECT_EQ(cache.GetMissesCount(), 0u);
+  EXPECT_EQ(cache.GetEvictionsCount(), 0u);
+  EXPECT_EQ(cache.Find(3, 0), nullptr);
+}
+
+TEST(SymbolCacheTests, ToJson) {
+  SymbolCache cache(2);
+  cache.Insert(1, CreateSymbol(1), 0);
+  cache.Insert(2, CreateSymbol(2), 0);
+  cache.Insert(3, CreateSymbol(3), 0);
+  cache.Find(3, 0);
+  cache.Find(4, 0);
+
+  EXPECT_EQ(
+      cache.ToJson(),
+      "{\"size\":2,\"capacity\":2,\"hits\":1,\"misses\":1,\"evictions\":1}"
+  );
+}
+
+// Frames of a process with a few hot functions and a long tail of cold addresses
+// (e.g. JIT-compiled code): the addresses follow a Zipf distribution (s = 1) and each
+// miss is symbolicated then inserted, as on the export path
+struct ZipfBenchmarkResult {
+  double hitRate;
+  size_t memorySize;
+  double nsPerLookup;
+};
+
+static ZipfBenchmarkResult RunZipfBenchmark(
+    size_t capacity, const std::vector<uint64_t>& addresses
+) {
+  SymbolCache cache(capacity);
+  auto start = std::chrono::steady_clock::now();
+  uint32_t exportId = 0;
+  for (size_t i = 0; i < addresses.size(); i++) {
+    // one export every 10k frames
+    if ((i % 10000) == 0) {
+      exportId++;
+    }
+    if (cache.Find(addresses[i], exportId) == nullptr) {
+      cache.Insert(addresses[i], CreateSymbol(addresses[i]), exportId);
+    }
+  }
+  auto duration = std::chrono::steady_clock::now() - start;
+
+  if (capacity != 0) {
+    EXPECT_LE(cache.GetSize(), capacity);
+  }
+  EXPECT_EQ(cache.GetHitsCount() + cache.GetMissesCount(), addresses.size());
+
+  return {
+      static_cast<double>(cache.GetHitsCount()) / addresses.size(),
+      cache.GetMemorySize(),
+      static_cast<double>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()
+      ) / addresses.size()
+  };
+}
+
+TEST(SymbolCacheTests, ZipfHitRate_Benchmark) {
+  constexpr size_t DistinctAddressesCount = 100'000;
+  constexpr size_t LookupsCount = 2'000'000;
+
+  std::vector<double> weights(DistinctAddressesCount);
+  for (size_t rank = 0; rank < DistinctAddressesCount; rank++) {
+    weights[rank] = 1.0 / static_cast<double>(rank + 1);
+  }
+  std::discrete_distribution<size_t> zipf(weights.begin(), weights.end());
+
+  // the rank of an address is not related to its value
+  std::mt19937_64 random(42);
+  std::vector<uint64_t> rankToAddress(DistinctAddressesCount);
+  for (size_t rank = 0; rank < DistinctAddressesCount; rank++) {
+    rankToAddress[rank] = 0x7FF600000000 + rank * 0x10;
+  }
+  std::shuffle(rankToAddress.begin(), rankToAddress.end(), random);
+
+  std::vector<uint64_t> addresses(LookupsCount);
+  for (auto& address : addresses) {
+    address = rankToAddress[zipf(random)];
+  }
+
+  auto unlimited = RunZipfBenchmark(0, addresses);
+  auto print = [&](const char* name, const ZipfBenchmarkResult& result) {
+    std::cout << name << ": hit rate " << result.hitRate * 100 << "% ("
+              << result.hitRate * 100 / unlimited.hitRate << "% of unlimited), "
+              << result.memorySize / 1024 << " KB, " << result.nsPerLookup
+              << " ns/lookup" << std::endl;
+  };
+  print("unlimited", unlimited);
+
+  // the hot addresses stay in the cache: the hit rate is close to the one of the
+  // top capacity addresses (the best a cache of this size could do)
+  for (size_t capacity : {20'000, 10'000, 5'000}) {
+    auto result = RunZipfBenchmark(capacity, addresses);
+    std::string name = "capacity " + std::to_string(capacity);
+    print(name.c_str(), result);
+
+    double topMass = 0;
+    double totalMass = 0;
+    for (size_t rank = 0; rank < DistinctAddressesCount; rank++) {
+      totalMass += weights[rank];
+      topMass += (rank < capacity) ? weights[rank] : 0;
+    }
+    EXPECT_GT(result.hitRate, 0.8 * topMass / totalMass) << capacity;
+    EXPECT_LT(result.memorySize, unlimited.memorySize) << capacity;
+  }
+}
@@ -0,0 +1,179 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include "../dd-win-prof/SymbolRangeCache.h"
+#include "pch.h"
+
+static CachedSymbolInfo CreateSymbol(uint32_t functionNameId) {
+  CachedSymbolInfo symbol;
+  symbol.FunctionNameId.value = functionNameId;
+  symbol.isValid = true;
+  return symbol;
+}
+
+TEST(SymbolRangeCacheTests, Find_AddressesOfTheSameRangeShareTheSymbol) {
+  SymbolRangeCache cache(0);
+  cache.Insert(0x1000, 0x1100, CreateSymbol(1), 1);
+  cache.Insert(0x2000, 0x2080, CreateSymbol(2), 1);
+
+  const auto* pSymbol = cache.Find(0x1000, 1);
+  ASSERT_NE(pSymbol, nullptr);
+  EXPECT_EQ(pSymbol->FunctionNameId.value, 1u);
+
+  pSymbol = cache.Find(0x10FF, 1);
+  ASSERT_NE(pSymbol, nullptr);
+  EXPECT_EQ(pSymbol->FunctionNameId.value, 1u);
+
+  pSymbol = cache.Find(0x2042, 1);
+  ASSERT_NE(pSymbol, nullptr);
+  EXPECT_EQ(pSymbol->FunctionNameId.value, 2u);
+
+  EXPECT_EQ(cache.GetSize(), 2u);
+  EXPECT_EQ(cache.GetHitsCount(), 3u);
+  EXPECT_EQ(cache.GetMissesCount(), 0u);
+}
+
+TEST(SymbolRangeCacheTests, Find_AddressesOutsideOfTheRanges) {
+  SymbolRangeCache cache(0);
+  EXPECT_EQ(cache.Find(0x1000, 1), nullptr);
+
+  cache.Insert(0x1000, 0x1100, CreateSymbol(1), 1);
+  cache.Insert(0x2000, 0x2080, CreateSymbol(2), 1);
+
+  EXPECT_EQ(cache.Find(0x0FFF, 1), nullptr);  // before
+  EXPECT_EQ(cache.Find(0x1100, 1), nullptr);  // end is excluded
+  EXPECT_EQ(cache.Find(0x1800, 1), nullptr);  // between two ranges
+  EXPECT_EQ(cache.Find(0x2080, 1), nullptr);  // after
+
+  EXPECT_EQ(cache.GetHitsCount(), 0u);
+  EXPECT_EQ(cache.GetMissesCount(), 5u);
+}
+
+TEST(SymbolRangeCacheTests, Insert_KeepsTheRangesSorted) {
+  SymbolRangeCache cache(0);
+
+  // inserted in random order
+  uint64_t starts[] = {0x5000, 0x1000, 0x9000, 0x3000, 0x7000, 0x2000};
+  for (auto start : starts) {
+    cache.Insert(start, start + 0x100, CreateSymbol(static_cast<uint32_t>(start)), 1);
+  }
+  EXPECT_EQ(cache.GetSize(), 6u);
+
+  for (auto start : starts) {
+    const auto* pSymbol = cache.Find(start + 0x80, 1);
+    ASSERT_NE(pSymbol, nullptr);
+    EXPECT_EQ(pSymbol->FunctionNameId.value, start);
+  }
+}
+
+TEST(SymbolRangeCacheTests, Insert_OverlappingRangesAreReplaced) {
+  SymbolRangeCache cache(0);
+  cache.Insert(0x1000, 0x1100, CreateSymbol(1), 1);
+  cache.Insert(0x1200, 0x1300, CreateSymbol(2), 1);
+  cache.Insert(0x1400, 0x1500, CreateSymbol(3), 1);
+
+  // e.g. a module loaded where functions of an unloaded one were
+  cache.Insert(0x1080, 0x1280, CreateSymbol(4), 1);
+  EXPECT_EQ(cache.GetSize(), 2u);
+
+  EXPECT_EQ(cache.Find(0x1000, 1), nullptr);
+  EXPECT_EQ(cache.Find(0x1290, 1), nullptr);
+
+  const auto* pSymbol = cache.Find(0x1100, 1);
+  ASSERT_NE(pSymbol, nullptr);
+  EXPECT_EQ(pSymbol->FunctionNameId.value, 4u);
+
+  pSymbol = cache.Find(0x1400, 1);
+  ASSERT_NE(pSymbol, nullptr);
+  EXPECT_EQ(pSymbol->FunctionNameId.value, 3u);
+
+  // adjacent ranges don't overlap
+  cache.Insert(0x1280, 0x1400, CreateSymbol(5), 1);
+  EXPECT_EQ(cache.GetSize(), 3u);
+  EXPECT_EQ(cache.Find(0x127F, 1)->FunctionNameId.value, 4u);
+  EXPECT_EQ(cache.Find(0x1280, 1)->FunctionNameId.value, 5u);
+  EXPECT_EQ(cache.Find(0x1400, 1)->FunctionNameId.value, 3u);
+}
+
+TEST(SymbolRangeCacheTests, Insert_EmptyRangesAreIgnored) {
+  SymbolRangeCache cache(0);
+  cache.Insert(0x1000, 0x1000, CreateSymbol(1), 1);
+  cache.Insert(0, 0, CreateSymbol(2), 1);
+
+  EXPECT_EQ(cache.GetSize(), 0u);
+  EXPECT_EQ(cache.Find(0x1000, 1), nullptr);
+}
+
+TEST(SymbolRangeCacheTests, Clear) {
+  SymbolRangeCache cache(0);
+  cache.Insert(0x1000, 0x1100, CreateSymbol(1), 1);
+  cache.Find(0x1000, 1);
+  cache.Find(0x2000, 1);
+  EXPECT_GT(cache.GetMemorySize(), 0u);
+
+  cache.Clear();
+  EXPECT_EQ(cache.GetSize(), 0u);
+  EXPECT_EQ(cache.GetHitsCount(), 0u);
+  EXPECT_EQ(cache.GetMissesCount(), 0u);
+  EXPECT_EQ(cache.Find(0x1000, 1), nullptr);
+}
+
+// When full, the ranges not used during the current export make room for the new ones
+TEST(SymbolRangeCacheTests, Insert_Full_UnusedRangesEvicted) {
+  SymbolRangeCache cache(3);
+  cache.Insert(0x1000, 0x1100, CreateSymbol(1), 1);
+  cache.Insert(0x2000, 0x2100, CreateSymbol(2), 1);
+  cache.Insert(0x3000, 0x3100, CreateSymbol(3), 1);
+  EXPECT_EQ(cache.GetCapacity(), 3u);
+
+  // only the second range is used during the next export
+  ASSERT_NE(cache.Find(0x2010, 2), nullptr);
+  cache.Insert(0x4000, 0x4100, CreateSymbol(4), 2);
+  EXPECT_EQ(cache.GetSize(), 2u);
+  EXPECT_EQ(cache.GetEvictionsCount(), 2u);
+  EXPECT_EQ(cache.Find(0x1010, 2), nullptr);
+  EXPECT_EQ(cache.Find(0x3010, 2), nullptr);
+  EXPECT_EQ(cache.Find(0x2010, 2)->FunctionNameId.value, 2u);
+  EXPECT_EQ(cache.Find(0x4010, 2)->FunctionNameId.value, 4u);
+
+  // all the ranges are used during the current export: the new one is not cached
+  cache.Insert(0x5000, 0x5100, CreateSymbol(5), 2);
+  cache.Insert(0x6000, 0x6100, CreateSymbol(6), 2);
+  EXPECT_EQ(cache.GetSize(), 3u);
+  EXPECT_EQ(cache.Find(0x6010, 2), nullptr);
+  EXPECT_EQ(cache.GetEvictionsCount(), 2u);
+}
+
+TEST(SymbolRangeCacheTests, EvictUnused_OldRangesEvicted) {
+  SymbolRangeCache cache(0);
+  cache.Insert(0x1000, 0x1100, CreateSymbol(1), 1);
+  cache.Insert(0x2000, 0x2100, CreateSymbol(2), 1);
+  cache.Insert(0x3000, 0x3100, CreateSymbol(3), 1);
+  ASSERT_NE(cache.Find(0x3010, 90), nullptr);
+
+  EXPECT_EQ(cache.EvictUnused(150, 100), 2u);
+  EXPECT_EQ(cache.GetSize(), 1u);
+  EXPECT_EQ(cache.GetEvictionsCount(), 2u);
+  EXPECT_EQ(cache.Find(0x3010, 150)->FunctionNameId.value, 3u);
+
+  // the export ids wrap around
+  SymbolRangeCache wrappedCache(0);
+  wrappedCache.Insert(0x4000, 0x4100, CreateSymbol(4), UINT32_MAX);
+  EXPECT_EQ(wrappedCache.EvictUnused(10, 100), 0u);
+  EXPECT_EQ(wrappedCache.EvictUnused(110, 100), 1u);
+}
+
+TEST(SymbolRangeCacheTests, ToJson) {
+  SymbolRangeCache cache(16);
+  cache.Insert(0x1000, 0x1100, CreateSymbol(1), 1);
+  cache.Find(0x1010, 1);
+  cache.Find(0x2000, 1);
+
+  EXPECT_EQ(
+      cache.ToJson(),
+      "{\"size\":1,\"capacity\":16,\"hits\":1,\"misses\":1,\"evictions\":0}"
+  );
+}
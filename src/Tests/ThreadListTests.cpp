@@ -4,6 +4,13 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "../dd-win-prof/ThreadList.h"
 #include "pch.h"
 
@@ -406,3 +413,348 @@ TEST(ThreadListTests, AddThread_DuringIteration_IsEventuallyReturned) {
   EXPECT_EQ(threadList.LoopNext(it)->GetThreadId(), 3);  // new one picked up
   EXPECT_EQ(threadList.LoopNext(it)->GetThreadId(), 1);  // wrap
 }
+
+// ============================================================================
+// Lock-free readers
+// ============================================================================
+
+// A removed thread is not destroyed while a reader might still be using it.
+TEST(ThreadListTests, RemoveThread_ThreadAliveWhileReadGuardIsHeld) {
+  ThreadList threadList;
+  threadList.AddThread(1, MakeTestHandle());
+  threadList.AddThread(2, MakeTestHandle());
+  uint32_t it = threadList.CreateIterator();
+  std::weak_ptr<ThreadInfo> weakThread = threadList.FindThread(1);
+
+  {
+    ThreadList::ReadGuard guard(threadList);
+    ThreadInfo* pThread = threadList.LoopNext(it, guard);
+    ASSERT_NE(pThread, nullptr);
+    EXPECT_EQ(pThread->GetThreadId(), 1);
+
+    threadList.RemoveThread(1);
+    EXPECT_EQ(threadList.Count(), 1);
+    EXPECT_EQ(threadList.FindThread(1), nullptr);
+    EXPECT_FALSE(weakThread.expired());
+    EXPECT_EQ(pThread->GetThreadId(), 1);
+
+    // the new version is visible to the reader
+    EXPECT_EQ(threadList.LoopNext(it, guard)->GetThreadId(), 2);
+  }
+
+  // destroyed when the last reader leaves
+  EXPECT_TRUE(weakThread.expired());
+}
+
+// Removed threads are destroyed by the next writer if no reader is active
+TEST(ThreadListTests, RemoveThread_ThreadDestroyedWithoutReader) {
+  ThreadList threadList;
+  threadList.AddThread(1, MakeTestHandle());
+  std::weak_ptr<ThreadInfo> weakThread = threadList.FindThread(1);
+
+  threadList.RemoveThread(1);
+  EXPECT_TRUE(weakThread.expired());
+}
+
+// Threads are added and removed (as by DLL_THREAD_ATTACH/DETACH) while a sampler
+// iterates: the sampler must always get live threads from the list.
+TEST(ThreadListTests, LoopNext_ConcurrentAddRemove_ReturnsLiveThreads) {
+  constexpr uint32_t WritersCount = 4;
+  constexpr uint32_t ThreadsPerWriter = 64;
+  constexpr uint32_t IterationsPerWriter = 2'000;
+
+  ThreadList threadList;
+  std::atomic<bool> stopRequested = false;
+  std::atomic<uint64_t> invalidThreadsCount = 0;
+  uint64_t sampledThreadsCount = 0;
+
+  std::thread sampler([&]() {
+    uint32_t it = threadList.CreateIterator();
+    while (!stopRequested) {
+      ThreadList::ReadGuard guard(threadList);
+      for (int i = 0; i < 16; i++) {
+        ThreadInfo* pThread = threadList.LoopNext(it, guard);
+        if (pThread == nullptr) {
+          break;
+        }
+
+        auto tid = pThread->GetThreadId();
+        if (tid == 0 || tid > WritersCount * ThreadsPerWriter) {
+          invalidThreadsCount++;
+        }
+        sampledThreadsCount++;
+      }
+    }
+  });
+
+  // each writer owns its range of thread ids
+  std::vector<std::thread> writers;
+  for (uint32_t writer = 0; writer < WritersCount; writer++) {
+    writers.emplace_back([&threadList, writer]() {
+      uint32_t firstTid = writer * ThreadsPerWriter + 1;
+      for (uint32_t i = 0; i < IterationsPerWriter; i++) {
+        uint32_t tid = firstTid + i % ThreadsPerWriter;
+        if (i >= ThreadsPerWriter) {
+          threadList.RemoveThread(tid);
+        }
+        threadList.AddThread(tid, MakeTestHandle());
+      }
+    });
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  stopRequested = true;
+  sampler.join();
+
+  EXPECT_EQ(invalidThreadsCount, 0);
+  EXPECT_GT(sampledThreadsCount, 0);
+  EXPECT_EQ(threadList.Count(), WritersCount * ThreadsPerWriter);
+
+  // no duplicate: each thread is seen once per round
+  uint32_t it = threadList.CreateIterator();
+  std::vector<bool> isSeen(WritersCount * ThreadsPerWriter + 1, false);
+  for (uint32_t i = 0; i < WritersCount * ThreadsPerWriter; i++) {
+    auto pThread = threadList.LoopNext(it);
+    ASSERT_NE(pThread, nullptr);
+    EXPECT_FALSE(isSeen[pThread->GetThreadId()]) << pThread->GetThreadId();
+    isSeen[pThread->GetThreadId()] = true;
+  }
+}
+
+// Cost of LoopNext for the sampler (1 ms ticks over 100 threads) while threads
+// are created and destroyed
+TEST(ThreadListTests, LoopNext_Benchmark) {
+  constexpr uint32_t ThreadsCount = 100;
+
+  ThreadList threadList;
+  for (uint32_t tid = 1; tid <= ThreadsCount; tid++) {
+    threadList.AddThread(tid, MakeTestHandle());
+  }
+
+  std::atomic<bool> stopRequested = false;
+  uint64_t writesCount = 0;
+  std::thread writer([&]() {
+    uint32_t tid = ThreadsCount + 1;
+    while (!stopRequested) {
+      threadList.AddThread(tid, MakeTestHandle());
+      threadList.RemoveThread(tid);
+      writesCount += 2;
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  });
+
+  constexpr int TicksCount = 200;
+  uint32_t it = threadList.CreateIterator();
+  uint64_t foundCount = 0;
+  std::chrono::nanoseconds loopNextDuration{0};
+  for (int tick = 0; tick < TicksCount; tick++) {
+    auto start = std::chrono::steady_clock::now();
+    {
+      ThreadList::ReadGuard guard(threadList);
+      for (uint32_t i = 0; i < ThreadsCount; i++) {
+        foundCount += (threadList.LoopNext(it, guard) != nullptr) ? 1 : 0;
+      }
+    }
+    loopNextDuration += std::chrono::steady_clock::now() - start;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  stopRequested = true;
+  writer.join();
+
+  EXPECT_EQ(foundCount, TicksCount * ThreadsCount);
+  std::cout << "LoopNext: " << loopNextDuration.count() / (TicksCount * ThreadsCount)
+            << " ns/thread (" << writesCount << " concurrent adds/removes)"
+            << std::endl;
+}
+
+// ============================================================================
+// Slots and generations
+// ============================================================================
+
+// The OS reused the id of a thread whose detach was missed: the new thread replaces
+// the previous one and gets a different generation.
+TEST(ThreadListTests, AddThread_DuplicateTid_ReplacesPreviousThread) {
+  ThreadList threadList;
+  threadList.AddThread(1, MakeTestHandle());
+  threadList.AddThread(2, MakeTestHandle());
+  auto pPrevious = threadList.FindThread(2);
+  ASSERT_NE(pPrevious, nullptr);
+
+  threadList.AddThread(2, MakeTestHandle());
+  EXPECT_EQ(threadList.Count(), 2u);
+
+  auto pCurrent = threadList.FindThread(2);
+  ASSERT_NE(pCurrent, nullptr);
+  EXPECT_NE(pCurrent, pPrevious);
+  EXPECT_NE(pCurrent->GetGeneration(), pPrevious->GetGeneration());
+
+  // the samples of the previous thread are not attributed to the new one
+  EXPECT_EQ(threadList.FindThread(2, pPrevious->GetGeneration()), nullptr);
+  EXPECT_EQ(threadList.FindThread(2, pCurrent->GetGeneration()), pCurrent);
+
+  // each thread is returned once per round
+  uint32_t it = threadList.CreateIterator();
+  EXPECT_EQ(threadList.LoopNext(it)->GetThreadId(), 1);
+  EXPECT_EQ(threadList.LoopNext(it), pCurrent);
+  EXPECT_EQ(threadList.LoopNext(it)->GetThreadId(), 1);
+}
+
+// The slot of an exited thread is reused with a new generation
+TEST(ThreadListTests, AddThread_ReusedSlot_GetsNewGeneration) {
+  ThreadList threadList;
+  threadList.AddThread(1, MakeTestHandle());
+  threadList.AddThread(2, MakeTestHandle());
+  threadList.AddThread(3, MakeTestHandle());
+  auto firstGeneration = threadList.FindThread(2)->GetGeneration();
+  EXPECT_NE(firstGeneration, 0u);
+
+  threadList.RemoveThread(2);
+  threadList.AddThread(4, MakeTestHandle());
+  auto secondGeneration = threadList.FindThread(4)->GetGeneration();
+  EXPECT_NE(secondGeneration, firstGeneration);
+
+  // same slot: the new thread takes the place of the removed one in the round robin
+  EXPECT_EQ(secondGeneration & 0xFFFFFFFF, firstGeneration & 0xFFFFFFFF);
+  uint32_t it = threadList.CreateIterator();
+  EXPECT_EQ(threadList.LoopNext(it)->GetThreadId(), 1);
+  EXPECT_EQ(threadList.LoopNext(it)->GetThreadId(), 4);
+  EXPECT_EQ(threadList.LoopNext(it)->GetThreadId(), 3);
+}
+
+// Thousands of threads: growing the slots keeps the registered threads
+TEST(ThreadListTests, AddThread_ManyThreads_AllFound) {
+  constexpr uint32_t ThreadsCount = 5'000;
+
+  ThreadList threadList;
+  for (uint32_t tid = 1; tid <= ThreadsCount; tid++) {
+    threadList.AddThread(tid * 4, MakeTestHandle());
+  }
+  EXPECT_EQ(threadList.Count(), ThreadsCount);
+
+  for (uint32_t tid = 1; tid <= ThreadsCount; tid++) {
+    auto pThread = threadList.FindThread(tid * 4);
+    ASSERT_NE(pThread, nullptr) << tid;
+    EXPECT_EQ(pThread->GetThreadId(), tid * 4);
+  }
+
+  // remove the last half: the sampler does not scan the free slots anymore
+  for (uint32_t tid = ThreadsCount / 2 + 1; tid <= ThreadsCount; tid++) {
+    threadList.RemoveThread(tid * 4);
+  }
+  uint32_t it = threadList.CreateIterator();
+  for (uint32_t i = 0; i < ThreadsCount / 2; i++) {
+    threadList.LoopNext(it);
+  }
+  EXPECT_EQ(threadList.LoopNext(it)->GetThreadId(), 4u);  // wrapped
+}
+
+// Cost of registering and removing short-lived threads (thread pools) depending on
+// the number of threads already registered
+TEST(ThreadListTests, AddRemove_Benchmark) {
+  constexpr int Iterations = 20'000;
+
+  for (uint32_t threadsCount : {10u, 1'000u, 10'000u}) {
+    ThreadList threadList;
+    for (uint32_t tid = 1; tid <= threadsCount; tid++) {
+      threadList.AddThread(tid * 4, MakeTestHandle());
+    }
+
+    // remove and re-add threads spread over the list
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Iterations; i++) {
+      uint32_t tid = (static_cast<uint32_t>(i * 7919) % threadsCount + 1) * 4;
+      threadList.RemoveThread(tid);
+      threadList.AddThread(tid, MakeTestHandle());
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(threadList.Count(), threadsCount);
+    std::cout << "Add + Remove with " << threadsCount << " threads: "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() /
+                     Iterations
+              << " ns" << std::endl;
+  }
+}
+
+TEST(ThreadListTests, NameTable_InternsEachNameOnce) {
+  NameTable names;
+  EXPECT_EQ(names.GetName(NameTable::UnnamedId), "");
+  EXPECT_EQ(names.GetName(1000), "");
+
+  uint32_t workerId = NameTable::UnnamedId;
+  uint32_t renderId = NameTable::UnnamedId;
+  ASSERT_TRUE(names.TryIntern("Worker #1", workerId));
+  ASSERT_TRUE(names.TryIntern("Render", renderId));
+  EXPECT_NE(workerId, NameTable::UnnamedId);
+  EXPECT_NE(workerId, renderId);
+
+  // the views stay valid while other names are added
+  auto workerName = names.GetName(workerId);
+  for (int i = 0; i < 100; i++) {
+    uint32_t id = 0;
+    ASSERT_TRUE(names.TryIntern("Pool #" + std::to_string(i), id));
+  }
+  EXPECT_EQ(workerName, "Worker #1");
+
+  uint32_t id = 0;
+  ASSERT_TRUE(names.TryIntern(std::string("Worker #") + "1", id));
+  EXPECT_EQ(id, workerId);
+  EXPECT_EQ(names.Count(), 103u);
+}
+
+TEST(ThreadListTests, NameTable_Full_KnownNamesStillFound) {
+  NameTable names;
+  uint32_t id = 0;
+  for (size_t i = names.Count(); i < NameTable::MaxNamesCount; i++) {
+    ASSERT_TRUE(names.TryIntern("Thread " + std::to_string(i), id));
+  }
+
+  EXPECT_FALSE(names.TryIntern("New", id));
+  ASSERT_TRUE(names.TryIntern("Thread 1", id));
+  EXPECT_EQ(names.GetName(id), "Thread 1");
+}
+
+// Threads renamed after they start get a new name id and version at the next refresh
+TEST(ThreadListTests, RefreshThreadNames_TracksRenamedThreads) {
+  ThreadList threadList;
+  threadList.AddThread(1, MakeTestHandle());
+  auto pThread = threadList.FindThread(1);
+  ASSERT_NE(pThread, nullptr);
+  EXPECT_EQ(pThread->GetThreadNameId(), NameTable::UnnamedId);
+  EXPECT_EQ(
+      pThread->GetThreadNameGroupKey(), ThreadInfo::ComputeThreadNameGroupKey("")
+  );
+
+  // the test handles are duplicates of the current thread handle
+  if (!OpSysTools::SetNativeThreadName(L"Worker #1")) {
+    GTEST_SKIP() << "SetThreadDescription is not available";
+  }
+
+  EXPECT_EQ(threadList.RefreshThreadNames(), 1u);
+  auto firstNameId = pThread->GetThreadNameId();
+  EXPECT_EQ(threadList.GetThreadName(firstNameId), "Worker #1");
+  EXPECT_EQ(pThread->GetThreadNameVersion(), 1u);
+  EXPECT_EQ(
+      pThread->GetThreadNameGroupKey(), ThreadInfo::ComputeThreadNameGroupKey("Worker")
+  );
+
+  // not renamed: nothing is published
+  EXPECT_EQ(threadList.RefreshThreadNames(), 0u);
+  EXPECT_EQ(pThread->GetThreadNameVersion(), 1u);
+
+  // renamed by its pool: same group
+  OpSysTools::SetNativeThreadName(L"Worker #2");
+  EXPECT_EQ(threadList.RefreshThreadNames(), 1u);
+  EXPECT_NE(pThread->GetThreadNameId(), firstNameId);
+  EXPECT_EQ(threadList.GetThreadName(pThread->GetThreadNameId()), "Worker #2");
+  EXPECT_EQ(pThread->GetThreadNameVersion(), 2u);
+  EXPECT_EQ(
+      pThread->GetThreadNameGroupKey(), ThreadInfo::ComputeThreadNameGroupKey("Worker")
+  );
+
+  // the previous name is still known
+  EXPECT_EQ(threadList.GetThreadName(firstNameId), "Worker #1");
+
+  OpSysTools::SetNativeThreadName(L"");
+}
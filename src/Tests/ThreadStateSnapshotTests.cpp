@@ -0,0 +1,208 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "../dd-win-prof/OsSpecificApi.h"
+#include "../dd-win-prof/ThreadStateSnapshot.h"
+#include "pch.h"
+
+using ProcessEntry = ThreadStateSnapshot::ProcessEntry;
+using ThreadEntry = ThreadStateSnapshot::ThreadEntry;
+
+namespace {
+constexpr ULONG WaitingState = 5;
+constexpr ULONG RunningState = 2;
+
+// SystemProcessInformation buffer as returned by NtQuerySystemInformation
+class SystemProcessInformationBuilder {
+ public:
+  void AddProcess(uint32_t pid, const std::vector<ThreadEntry>& threads) {
+    // link the previous process to this one
+    if (_lastProcessOffset != SIZE_MAX) {
+      GetProcess(_lastProcessOffset).NextEntryOffset =
+          static_cast<ULONG>(_buffer.size() - _lastProcessOffset);
+    }
+
+    _lastProcessOffset = _buffer.size();
+    _buffer.resize(
+        _buffer.size() + sizeof(ProcessEntry) + sizeof(ThreadEntry) * threads.size()
+    );
+
+    auto& process = GetProcess(_lastProcessOffset);
+    process.NumberOfThreads = static_cast<ULONG>(threads.size());
+    process.UniqueProcessId = reinterpret_cast<HANDLE>(static_cast<uintptr_t>(pid));
+    if (!threads.empty()) {
+      memcpy(&process + 1, threads.data(), sizeof(ThreadEntry) * threads.size());
+    }
+  }
+
+  const std::vector<uint8_t>& GetBuffer() const { return _buffer; }
+
+ private:
+  ProcessEntry& GetProcess(size_t offset) {
+    return *reinterpret_cast<ProcessEntry*>(_buffer.data() + offset);
+  }
+
+ private:
+  std::vector<uint8_t> _buffer;
+  size_t _lastProcessOffset = SIZE_MAX;
+};
+
+ThreadEntry MakeThread(
+    uint32_t tid, ULONG state, ULONG waitReason = 0, int64_t cpuTime100ns = 0
+) {
+  ThreadEntry thread = {};
+  thread.UniqueThread = reinterpret_cast<HANDLE>(static_cast<uintptr_t>(tid));
+  thread.ThreadState = state;
+  thread.WaitReason = waitReason;
+  thread.UserTime.QuadPart = cpuTime100ns / 2;
+  thread.KernelTime.QuadPart = cpuTime100ns - cpuTime100ns / 2;
+  thread.ContextSwitches = tid * 10;
+  return thread;
+}
+
+std::vector<ThreadEntry> MakeThreads(uint32_t firstTid, size_t count) {
+  std::vector<ThreadEntry> threads;
+  for (size_t i = 0; i < count; i++) {
+    auto tid = firstTid + static_cast<uint32_t>(i) * 4;
+    threads.push_back(MakeThread(tid, WaitingState));
+  }
+  return threads;
+}
+}  // namespace
+
+TEST(ThreadStateSnapshotTests, Parse_KeepsTheThreadsOfTheProcess) {
+  SystemProcessInformationBuilder builder;
+  builder.AddProcess(4, MakeThreads(8, 10));
+  builder.AddProcess(
+      1234,
+      {MakeThread(100, RunningState, 0, 25'000'000),  // 2.5 s
+       MakeThread(104, WaitingState, 6, 10'000)}
+  );
+  builder.AddProcess(5678, {MakeThread(200, RunningState)});
+
+  ThreadStateSnapshot snapshot;
+  auto const& buffer = builder.GetBuffer();
+  ASSERT_TRUE(snapshot.Parse(buffer.data(), buffer.size(), 1234));
+  EXPECT_TRUE(snapshot.IsValid());
+  EXPECT_EQ(snapshot.GetThreadsCount(), 2);
+
+  auto pRunning = snapshot.Find(100);
+  ASSERT_NE(pRunning, nullptr);
+  EXPECT_EQ(pRunning->state, RunningState);
+  EXPECT_EQ(pRunning->cpuTime, std::chrono::milliseconds(2500));
+  EXPECT_EQ(pRunning->contextSwitches, 1000);
+  EXPECT_TRUE(OsSpecificApi::IsRunningThreadState(pRunning->state));
+
+  auto pWaiting = snapshot.Find(104);
+  ASSERT_NE(pWaiting, nullptr);
+  EXPECT_EQ(pWaiting->waitReason, 6);
+  EXPECT_EQ(pWaiting->cpuTime, std::chrono::milliseconds(1));
+  EXPECT_TRUE(OsSpecificApi::IsWaitingThreadState(pWaiting->state));
+
+  // threads of the other processes
+  EXPECT_EQ(snapshot.Find(8), nullptr);
+  EXPECT_EQ(snapshot.Find(200), nullptr);
+}
+
+TEST(ThreadStateSnapshotTests, Parse_FailsWithoutTheProcess) {
+  SystemProcessInformationBuilder builder;
+  builder.AddProcess(4, MakeThreads(8, 10));
+
+  ThreadStateSnapshot snapshot;
+  auto const& buffer = builder.GetBuffer();
+  ASSERT_TRUE(snapshot.Parse(buffer.data(), buffer.size(), 4));
+
+  // the previous threads are forgotten
+  EXPECT_FALSE(snapshot.Parse(buffer.data(), buffer.size(), 1234));
+  EXPECT_FALSE(snapshot.IsValid());
+  EXPECT_EQ(snapshot.GetThreadsCount(), 0);
+  EXPECT_EQ(snapshot.Find(8), nullptr);
+
+  EXPECT_FALSE(snapshot.Parse(buffer.data(), 0, 4));
+}
+
+TEST(ThreadStateSnapshotTests, Parse_StopsAtTruncatedEntries) {
+  SystemProcessInformationBuilder builder;
+  builder.AddProcess(4, MakeThreads(8, 10));
+  builder.AddProcess(1234, MakeThreads(100, 10));
+
+  ThreadStateSnapshot snapshot;
+  auto const& buffer = builder.GetBuffer();
+  EXPECT_FALSE(snapshot.Parse(buffer.data(), buffer.size() - 1, 1234));
+  EXPECT_TRUE(snapshot.Parse(buffer.data(), buffer.size() - 1, 4));
+}
+
+TEST(ThreadStateSnapshotTests, Refresh_ReplacesThePreviousThreads) {
+  ThreadStateSnapshot snapshot;
+
+  SystemProcessInformationBuilder bigProcess;
+  bigProcess.AddProcess(1234, MakeThreads(100, 2000));
+  auto const& bigBuffer = bigProcess.GetBuffer();
+  ASSERT_TRUE(snapshot.Parse(bigBuffer.data(), bigBuffer.size(), 1234));
+  EXPECT_EQ(snapshot.GetThreadsCount(), 2000);
+  for (uint32_t i = 0; i < 2000; i++) {
+    ASSERT_NE(snapshot.Find(100 + i * 4), nullptr) << i;
+  }
+
+  // some threads exited
+  SystemProcessInformationBuilder smallProcess;
+  smallProcess.AddProcess(1234, MakeThreads(100, 10));
+  auto const& smallBuffer = smallProcess.GetBuffer();
+  ASSERT_TRUE(snapshot.Parse(smallBuffer.data(), smallBuffer.size(), 1234));
+  EXPECT_EQ(snapshot.GetThreadsCount(), 10);
+  EXPECT_NE(snapshot.Find(100 + 9 * 4), nullptr);
+  EXPECT_EQ(snapshot.Find(100 + 10 * 4), nullptr);
+}
+
+#ifdef _WIN64
+TEST(ThreadStateSnapshotTests, Refresh_FindsTheCurrentThread) {
+  ThreadStateSnapshot snapshot;
+  ASSERT_TRUE(snapshot.Refresh());
+  EXPECT_GE(snapshot.GetThreadsCount(), 1);
+
+  auto pState = snapshot.Find(::GetCurrentThreadId());
+  ASSERT_NE(pState, nullptr);
+
+  // the current thread was running the query
+  EXPECT_TRUE(OsSpecificApi::IsRunningThreadState(pState->state));
+  auto [isRunning, cpuTime, failure] = OsSpecificApi::IsRunning(::GetCurrentThread());
+  ASSERT_FALSE(failure);
+  EXPECT_LE(pState->cpuTime, cpuTime);
+}
+#endif
+
+// Time to parse a busy machine snapshot vs the 1000 threads of the process
+TEST(ThreadStateSnapshotTests, Parse_Benchmark) {
+  SystemProcessInformationBuilder builder;
+  uint32_t tid = 8;
+  for (uint32_t pid = 4; pid < 4 + 300 * 4; pid += 4) {
+    size_t threadsCount = (pid == 600) ? 1000 : 30;
+    builder.AddProcess(pid, MakeThreads(tid, threadsCount));
+    tid += static_cast<uint32_t>(threadsCount) * 4;
+  }
+  auto const& buffer = builder.GetBuffer();
+
+  ThreadStateSnapshot snapshot;
+  constexpr int Iterations = 1000;
+  uint64_t foundCount = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < Iterations; i++) {
+    snapshot.Parse(buffer.data(), buffer.size(), 600);
+    foundCount += (snapshot.Find(tid / 2) != nullptr) ? 1 : 0;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  EXPECT_EQ(snapshot.GetThreadsCount(), 1000);
+  std::cout << "Parse of " << buffer.size() / 1024 << " KB: "
+            << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() /
+                   Iterations
+            << " us (" << foundCount << " lookups)" << std::endl;
+}
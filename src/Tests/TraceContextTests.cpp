@@ -0,0 +1,120 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../dd-win-prof/TraceContext.h"
+#include "pch.h"
+
+using namespace std::chrono_literals;
+
+TEST(TraceContextTests, Slot_Empty) {
+  TraceContextSlot slot;
+
+  TraceContext context{1, 2, 3};
+  ASSERT_TRUE(slot.TryRead(context));
+  EXPECT_TRUE(context.IsEmpty());
+  EXPECT_EQ(context.endpointId, TraceEndpoints::NoEndpoint);
+}
+
+TEST(TraceContextTests, Slot_WriteThenRead) {
+  TraceContextSlot slot;
+  TraceContext span{0x1122334455667788, 0x99, 5};
+  slot.Write(span);
+  EXPECT_EQ(slot.GetLocalRootSpanId(), span.localRootSpanId);
+
+  TraceContext context;
+  ASSERT_TRUE(slot.TryRead(context));
+  EXPECT_EQ(context, span);
+
+  // the span ends
+  slot.Write({});
+  ASSERT_TRUE(slot.TryRead(context));
+  EXPECT_TRUE(context.IsEmpty());
+}
+
+// The sampler reads the slot while its thread keeps changing the current span: a read
+// either fails or returns a context that was written as a whole
+TEST(TraceContextTests, Slot_ConcurrentWrites_NoTornRead) {
+  TraceContextSlot slot;
+  std::atomic<bool> isStopped{false};
+
+  std::thread writer([&slot, &isStopped]() {
+    uint64_t id = 1;
+    while (!isStopped.load(std::memory_order_relaxed)) {
+      slot.Write({id, id + 1, static_cast<uint32_t>(id % 7)});
+      id++;
+    }
+  });
+
+  uint64_t readCount = 0;
+  uint64_t failedCount = 0;
+  auto end = std::chrono::steady_clock::now() + 200ms;
+  while (std::chrono::steady_clock::now() < end) {
+    TraceContext context;
+    if (!slot.TryRead(context)) {
+      failedCount++;
+      continue;
+    }
+
+    readCount++;
+    if (context.IsEmpty()) {
+      continue;
+    }
+    ASSERT_EQ(context.spanId, context.localRootSpanId + 1);
+    ASSERT_EQ(context.endpointId, context.localRootSpanId % 7);
+  }
+
+  isStopped = true;
+  writer.join();
+
+  EXPECT_GT(readCount, 0u);
+  std::cout << "Reads: " << readCount << " (" << failedCount << " failed)"
+            << std::endl;
+}
+
+TEST(TraceContextTests, Endpoints_InternedOnce) {
+  TraceEndpoints endpoints;
+  EXPECT_EQ(endpoints.Intern(""), TraceEndpoints::NoEndpoint);
+
+  auto getUsers = endpoints.Intern("GET /users");
+  auto postUsers = endpoints.Intern("POST /users");
+  EXPECT_NE(getUsers, TraceEndpoints::NoEndpoint);
+  EXPECT_NE(postUsers, TraceEndpoints::NoEndpoint);
+  EXPECT_NE(getUsers, postUsers);
+  EXPECT_EQ(endpoints.Intern("GET /users"), getUsers);
+  EXPECT_EQ(endpoints.GetEndpoint(getUsers), "GET /users");
+}
+
+TEST(TraceContextTests, Endpoints_CountsConsumedOnce) {
+  TraceEndpoints endpoints;
+  auto getUsers = endpoints.Intern("GET /users");
+  auto postUsers = endpoints.Intern("POST /users");
+
+  endpoints.CountLocalRootSpan(getUsers);
+  endpoints.CountLocalRootSpan(postUsers);
+  endpoints.CountLocalRootSpan(getUsers);
+  endpoints.CountLocalRootSpan(TraceEndpoints::NoEndpoint);
+
+  std::vector<std::pair<uint32_t, int64_t>> counts;
+  endpoints.ConsumeCounts(counts);
+  ASSERT_EQ(counts.size(), 2u);
+  EXPECT_EQ(counts[0], std::make_pair(getUsers, int64_t{2}));
+  EXPECT_EQ(counts[1], std::make_pair(postUsers, int64_t{1}));
+
+  // the next profile only gets the new local root spans
+  endpoints.ConsumeCounts(counts);
+  EXPECT_TRUE(counts.empty());
+
+  endpoints.CountLocalRootSpan(postUsers);
+  endpoints.ConsumeCounts(counts);
+  ASSERT_EQ(counts.size(), 1u);
+  EXPECT_EQ(counts[0], std::make_pair(postUsers, int64_t{1}));
+}
@@ -0,0 +1,220 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <intrin.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../dd-win-prof/StackUnwinder.h"
+#include "../dd-win-prof/UnwindInfoCache.h"
+#include "pch.h"
+
+namespace {
+constexpr uint64_t ImageBase = 0x140000000;
+constexpr uint64_t OtherImageBase = 0x7FF800000000;
+
+// the unwind data is derived from the address so that readers can check it
+RUNTIME_FUNCTION MakeEntry(uint64_t rip, uint64_t imageBase) {
+  auto rva = static_cast<uint32_t>(rip - imageBase);
+  return RUNTIME_FUNCTION{rva & ~0xFFFu, (rva & ~0xFFFu) + 0x1000, rva ^ 0x5A5A5A5A};
+}
+}  // namespace
+
+TEST(UnwindInfoCacheTests, TryGet_ReturnsAddedEntries) {
+  UnwindInfoCache cache;
+  uint64_t rip = ImageBase + 0x1234;
+  auto expected = MakeEntry(rip, ImageBase);
+
+  uint64_t imageBase = 0;
+  RUNTIME_FUNCTION entry;
+  EXPECT_FALSE(cache.TryGet(rip, imageBase, entry));
+
+  cache.Add(rip, ImageBase, expected, cache.GetEpoch());
+  ASSERT_TRUE(cache.TryGet(rip, imageBase, entry));
+  EXPECT_EQ(imageBase, ImageBase);
+  EXPECT_EQ(entry.BeginAddress, expected.BeginAddress);
+  EXPECT_EQ(entry.EndAddress, expected.EndAddress);
+  EXPECT_EQ(entry.UnwindData, expected.UnwindData);
+
+  // same function, other return address
+  EXPECT_FALSE(cache.TryGet(rip + 1, imageBase, entry));
+
+  auto stats = cache.GetAndResetStats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 2);
+
+  stats = cache.GetAndResetStats();
+  EXPECT_EQ(stats.hits, 0);
+  EXPECT_EQ(stats.misses, 0);
+}
+
+TEST(UnwindInfoCacheTests, Add_IsBounded) {
+  UnwindInfoCache cache(64);
+  EXPECT_EQ(cache.GetCapacity(), 64);
+
+  // more addresses than entries: the last ones replace the previous ones
+  for (uint64_t i = 0; i < 1000; i++) {
+    uint64_t rip = ImageBase + i * 16;
+    cache.Add(rip, ImageBase, MakeEntry(rip, ImageBase), cache.GetEpoch());
+  }
+
+  size_t hitsCount = 0;
+  for (uint64_t i = 0; i < 1000; i++) {
+    uint64_t rip = ImageBase + i * 16;
+    uint64_t imageBase;
+    RUNTIME_FUNCTION entry;
+    if (cache.TryGet(rip, imageBase, entry)) {
+      hitsCount++;
+      EXPECT_EQ(entry.UnwindData, MakeEntry(rip, ImageBase).UnwindData);
+    }
+  }
+  EXPECT_GT(hitsCount, 0);
+  EXPECT_LE(hitsCount, 64);
+}
+
+TEST(UnwindInfoCacheTests, Invalidate_RemovesOnlyTheModuleEntries) {
+  UnwindInfoCache cache;
+  uint64_t rip = ImageBase + 0x1000;
+  uint64_t otherRip = OtherImageBase + 0x1000;
+  cache.Add(rip, ImageBase, MakeEntry(rip, ImageBase), cache.GetEpoch());
+  cache.Add(
+      otherRip, OtherImageBase, MakeEntry(otherRip, OtherImageBase), cache.GetEpoch()
+  );
+
+  cache.Invalidate(ImageBase);
+
+  uint64_t imageBase;
+  RUNTIME_FUNCTION entry;
+  EXPECT_FALSE(cache.TryGet(rip, imageBase, entry));
+  EXPECT_TRUE(cache.TryGet(otherRip, imageBase, entry));
+  EXPECT_EQ(cache.GetAndResetStats().invalidatedEntries, 1);
+}
+
+TEST(UnwindInfoCacheTests, Add_IgnoresLookupsDoneBeforeAnUnload) {
+  UnwindInfoCache cache;
+  uint64_t rip = ImageBase + 0x1000;
+
+  // the module is unloaded between the lookup and the Add
+  auto epoch = cache.GetEpoch();
+  cache.Invalidate(ImageBase);
+  cache.Add(rip, ImageBase, MakeEntry(rip, ImageBase), epoch);
+
+  uint64_t imageBase;
+  RUNTIME_FUNCTION entry;
+  EXPECT_FALSE(cache.TryGet(rip, imageBase, entry));
+}
+
+TEST(UnwindInfoCacheTests, ConcurrentInvalidations_NeverReturnTornEntries) {
+  UnwindInfoCache cache(256);
+  constexpr uint64_t AddressesCount = 128;
+  std::atomic<bool> isDone{false};
+
+  // the sampler thread is both the reader and the main writer...
+  std::thread sampler([&]() {
+    for (int iteration = 0; iteration < 2000; iteration++) {
+      for (uint64_t i = 0; i < AddressesCount; i++) {
+        uint64_t base = ((i % 2) == 0) ? ImageBase : OtherImageBase;
+        uint64_t rip = base + i * 8;
+        auto expected = MakeEntry(rip, base);
+
+        uint64_t imageBase;
+        RUNTIME_FUNCTION entry;
+        if (cache.TryGet(rip, imageBase, entry)) {
+          ASSERT_EQ(imageBase, base);
+          ASSERT_EQ(entry.BeginAddress, expected.BeginAddress);
+          ASSERT_EQ(entry.EndAddress, expected.EndAddress);
+          ASSERT_EQ(entry.UnwindData, expected.UnwindData);
+        } else {
+          cache.Add(rip, base, expected, cache.GetEpoch());
+        }
+      }
+    }
+    isDone = true;
+  });
+
+  // ...while modules are unloaded by other threads
+  uint64_t invalidationsCount = 0;
+  while (!isDone) {
+    cache.Invalidate(((invalidationsCount % 2) == 0) ? ImageBase : OtherImageBase);
+    invalidationsCount++;
+  }
+  sampler.join();
+
+  auto stats = cache.GetAndResetStats();
+  EXPECT_GT(stats.hits, 0);
+  EXPECT_GT(invalidationsCount, 0);
+}
+
+TEST(UnwindInfoCacheTests, ImageUnwindTable_CachesLookups) {
+  UnwindInfoCache cache;
+  ImageUnwindTable unwindTable(&cache);
+
+  // the caller of the test body has unwind data
+  auto rip = reinterpret_cast<uint64_t>(_ReturnAddress());
+
+  uint64_t imageBase = 0;
+  RUNTIME_FUNCTION entry;
+  ASSERT_TRUE(unwindTable.LookupFunctionEntry(rip, imageBase, entry));
+  RUNTIME_FUNCTION cachedEntry;
+  ASSERT_TRUE(unwindTable.LookupFunctionEntry(rip, imageBase, cachedEntry));
+  EXPECT_EQ(cachedEntry.BeginAddress, entry.BeginAddress);
+  EXPECT_EQ(cachedEntry.UnwindData, entry.UnwindData);
+
+  auto stats = cache.GetAndResetStats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+}
+
+// address of the first function listed in the exception directory (.pdata) of a module
+static uint64_t GetFirstFunctionWithUnwindData(HMODULE hModule) {
+  auto base = reinterpret_cast<const uint8_t*>(hModule);
+  auto pDosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
+  auto pNtHeaders =
+      reinterpret_cast<const IMAGE_NT_HEADERS64*>(base + pDosHeader->e_lfanew);
+  auto const& directory =
+      pNtHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXCEPTION];
+  if (directory.Size < sizeof(RUNTIME_FUNCTION)) {
+    return 0;
+  }
+
+  auto pFunctions =
+      reinterpret_cast<const RUNTIME_FUNCTION*>(base + directory.VirtualAddress);
+  return reinterpret_cast<uint64_t>(base) + pFunctions[0].BeginAddress;
+}
+
+TEST(UnwindInfoCacheTests, ModuleUnload_InvalidatesItsEntries) {
+  // a DLL not loaded by the test process
+  const wchar_t* dllName = L"winmm.dll";
+  if (GetModuleHandle(dllName) != nullptr) {
+    dllName = L"winspool.drv";
+  }
+  if (GetModuleHandle(dllName) != nullptr) {
+    GTEST_SKIP() << "test DLLs are already loaded";
+  }
+
+  UnwindInfoCache cache;
+  ASSERT_TRUE(cache.StartInvalidationOnModuleUnload());
+  ImageUnwindTable unwindTable(&cache);
+
+  HMODULE hModule = LoadLibrary(dllName);
+  ASSERT_NE(hModule, nullptr);
+  auto rip = GetFirstFunctionWithUnwindData(hModule);
+  ASSERT_NE(rip, 0);
+
+  uint64_t imageBase = 0;
+  RUNTIME_FUNCTION entry;
+  ASSERT_TRUE(unwindTable.LookupFunctionEntry(rip, imageBase, entry));
+  EXPECT_EQ(imageBase, reinterpret_cast<uint64_t>(hModule));
+  EXPECT_TRUE(cache.TryGet(rip, imageBase, entry));
+
+  FreeLibrary(hModule);
+  EXPECT_FALSE(cache.TryGet(rip, imageBase, entry));
+  EXPECT_GE(cache.GetAndResetStats().invalidatedEntries, 1);
+
+  cache.StopInvalidationOnModuleUnload();
+}
@@ -0,0 +1,336 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../dd-win-prof/UploadQueue.h"
+#include "../dd-win-prof/UploadSpool.h"
+#include "pch.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+// Mock intake: records the profiles it receives and can be slow, down or refusing
+class FakeIntake : public IProfileSender {
+ public:
+  UploadStatus Send(PendingUpload& upload) override {
+    std::this_thread::sleep_for(latency);
+
+    // libdatadog consumes the encoded profile
+    upload.encodedProfile = {};
+
+    std::lock_guard lock(_lock);
+    if (status == UploadStatus::Sent) {
+      _sentIds.push_back(upload.exportId);
+    }
+    _attemptsCount++;
+    return status;
+  }
+
+  void Discard(PendingUpload& upload) override {
+    std::lock_guard lock(_lock);
+    _discardedIds.push_back(upload.exportId);
+  }
+
+  std::vector<uint32_t> GetSentIds() const {
+    std::lock_guard lock(_lock);
+    return _sentIds;
+  }
+
+  std::vector<uint32_t> GetDiscardedIds() const {
+    std::lock_guard lock(_lock);
+    return _discardedIds;
+  }
+
+  int GetAttemptsCount() const {
+    std::lock_guard lock(_lock);
+    return _attemptsCount;
+  }
+
+ public:
+  std::atomic<UploadStatus> status{UploadStatus::Sent};
+  std::chrono::milliseconds latency{0};
+
+ private:
+  mutable std::mutex _lock;
+  std::vector<uint32_t> _sentIds;
+  std::vector<uint32_t> _discardedIds;
+  int _attemptsCount = 0;
+};
+
+PendingUpload MakeUpload(uint32_t exportId) {
+  PendingUpload upload;
+  upload.exportId = exportId;
+  upload.profileBytes.assign(1024, static_cast<uint8_t>(exportId));
+  upload.startMs = 1'700'000'000'000 + exportId;
+  upload.endMs = upload.startMs + 60'000;
+  upload.size = upload.profileBytes.size();
+  return upload;
+}
+
+class UploadQueueSpoolTests : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    directory = fs::temp_directory_path() /
+                ("dd-win-prof-queue-spool-" + std::to_string(::GetCurrentProcessId()));
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+  }
+
+  void TearDown() override {
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+  }
+
+  fs::path directory;
+};
+
+bool WaitFor(std::function<bool()> condition, std::chrono::milliseconds timeout = 2s) {
+  auto end = std::chrono::steady_clock::now() + timeout;
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() > end) {
+      return false;
+    }
+    std::this_thread::sleep_for(1ms);
+  }
+  return true;
+}
+}  // namespace
+
+TEST(UploadQueueTests, SlowIntake_EnqueueDoesNotWait) {
+  FakeIntake intake;
+  intake.latency = 100ms;
+  UploadQueue queue(&intake);
+  queue.Start();
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t id = 1; id <= 3; id++) {
+    queue.Enqueue(MakeUpload(id));
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 50ms);
+
+  // the pending profiles are sent before stopping
+  queue.Stop();
+  EXPECT_EQ(intake.GetSentIds(), (std::vector<uint32_t>{1, 2, 3}));
+  EXPECT_EQ(queue.GetSentCount(), 3u);
+  EXPECT_EQ(queue.GetPendingCount(), 0u);
+}
+
+TEST(UploadQueueTests, IntakeDown_BacksOffThenRetriesAndSendsPendingProfiles) {
+  FakeIntake intake;
+  intake.status = UploadStatus::Failed;
+  UploadQueue queue(&intake, 8, 400ms, 1000ms);
+  queue.Start();
+
+  queue.Enqueue(MakeUpload(1));
+  ASSERT_TRUE(WaitFor([&queue]() { return queue.GetFailedCount() == 1; }));
+
+  // no attempt before the end of the backoff: the failed profile is kept and the next
+  // profiles wait in the queue
+  queue.Enqueue(MakeUpload(2));
+  queue.Enqueue(MakeUpload(3));
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(intake.GetAttemptsCount(), 1);
+  EXPECT_EQ(queue.GetPendingCount(), 3u);
+
+  // the intake is back: the failed profile is retried first, then the pending ones
+  intake.status = UploadStatus::Sent;
+  ASSERT_TRUE(WaitFor([&queue]() { return queue.GetSentCount() == 3; }));
+  EXPECT_EQ(intake.GetSentIds(), (std::vector<uint32_t>{1, 2, 3}));
+  EXPECT_EQ(queue.GetFailedCount(), 1u);
+  EXPECT_TRUE(intake.GetDiscardedIds().empty());
+
+  queue.Stop();
+}
+
+TEST(UploadQueueTests, IntakeDown_ProfileRetriedWithBackoff) {
+  FakeIntake intake;
+  intake.status = UploadStatus::Failed;
+  UploadQueue queue(&intake, 8, 20ms, 40ms);
+  queue.Start();
+
+  queue.Enqueue(MakeUpload(1));
+  ASSERT_TRUE(WaitFor([&queue]() { return queue.GetFailedCount() >= 3; }));
+  EXPECT_EQ(queue.GetPendingCount(), 1u);
+
+  intake.status = UploadStatus::Sent;
+  ASSERT_TRUE(WaitFor([&queue]() { return queue.GetSentCount() == 1; }));
+  EXPECT_EQ(intake.GetSentIds(), (std::vector<uint32_t>{1}));
+  EXPECT_EQ(queue.GetDiscardedCount(), 0u);
+
+  queue.Stop();
+}
+
+TEST(UploadQueueTests, IntakeRefusing_NoBackoff) {
+  FakeIntake intake;
+  intake.status = UploadStatus::Rejected;
+  UploadQueue queue(&intake, 8, 10s, 10s);
+  queue.Start();
+
+  queue.Enqueue(MakeUpload(1));
+  queue.Enqueue(MakeUpload(2));
+  EXPECT_TRUE(WaitFor([&queue]() { return queue.GetFailedCount() == 2; }));
+
+  queue.Stop();
+  EXPECT_EQ(intake.GetAttemptsCount(), 2);
+}
+
+TEST(UploadQueueTests, QueueFull_OldestProfileDiscarded) {
+  FakeIntake intake;
+  UploadQueue queue(&intake, 2);
+
+  queue.Enqueue(MakeUpload(1));
+  queue.Enqueue(MakeUpload(2));
+  queue.Enqueue(MakeUpload(3));
+  EXPECT_EQ(queue.GetPendingCount(), 2u);
+  EXPECT_EQ(queue.GetPendingSize(), 2u * 1024);
+  EXPECT_EQ(queue.GetDiscardedCount(), 1u);
+  EXPECT_EQ(intake.GetDiscardedIds(), (std::vector<uint32_t>{1}));
+
+  queue.Stop();
+  EXPECT_EQ(intake.GetSentIds(), (std::vector<uint32_t>{2, 3}));
+}
+
+TEST(UploadQueueTests, Stop_IntakeDown_PendingProfilesDiscarded) {
+  FakeIntake intake;
+  intake.status = UploadStatus::Failed;
+  intake.latency = 20ms;
+  UploadQueue queue(&intake, 8, 10s, 10s);
+  queue.Start();
+
+  queue.Enqueue(MakeUpload(1));
+  ASSERT_TRUE(WaitFor([&queue]() { return queue.GetFailedCount() == 1; }));
+  queue.Enqueue(MakeUpload(2));
+  queue.Enqueue(MakeUpload(3));
+
+  // stopping does not wait for attempts that would time out; without spool, the
+  // pending profiles are lost
+  auto start = std::chrono::steady_clock::now();
+  queue.Stop();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+  EXPECT_EQ(intake.GetAttemptsCount(), 1);
+  EXPECT_EQ(intake.GetDiscardedIds(), (std::vector<uint32_t>{1, 2, 3}));
+  EXPECT_EQ(queue.GetDiscardedCount(), 3u);
+}
+
+TEST(UploadQueueTests, Stop_WithoutSending_PendingProfilesDiscarded) {
+  FakeIntake intake;
+  UploadQueue queue(&intake);
+
+  queue.Enqueue(MakeUpload(1));
+  queue.Enqueue(MakeUpload(2));
+  queue.Stop(false);
+
+  EXPECT_EQ(intake.GetAttemptsCount(), 0);
+  EXPECT_EQ(intake.GetDiscardedIds(), (std::vector<uint32_t>{1, 2}));
+}
+
+TEST_F(UploadQueueSpoolTests, QueueFull_OldestProfileSpooledAndSentFirst) {
+  UploadSpool spool(directory, 1024 * 1024);
+  ASSERT_TRUE(spool.Initialize());
+  FakeIntake intake;
+  UploadQueue queue(&intake, 2, 10s, 10s, &spool);
+
+  queue.Enqueue(MakeUpload(1));
+  queue.Enqueue(MakeUpload(2));
+  queue.Enqueue(MakeUpload(3));
+  EXPECT_EQ(queue.GetPendingCount(), 2u);
+  EXPECT_EQ(queue.GetSpooledCount(), 1u);
+  EXPECT_EQ(queue.GetDiscardedCount(), 0u);
+  EXPECT_EQ(spool.GetFilesCount(), 1u);
+
+  // the spooled profile is older than the queued ones
+  queue.Start();
+  ASSERT_TRUE(WaitFor([&queue]() { return queue.GetSentCount() == 3; }));
+  EXPECT_EQ(intake.GetSentIds(), (std::vector<uint32_t>{1, 2, 3}));
+  EXPECT_TRUE(spool.IsEmpty());
+
+  queue.Stop();
+}
+
+TEST_F(UploadQueueSpoolTests, IntakeDown_ProfilesSpooledThenDrainedOnReconnect) {
+  UploadSpool spool(directory, 1024 * 1024);
+  ASSERT_TRUE(spool.Initialize());
+  FakeIntake intake;
+  intake.status = UploadStatus::Failed;
+  UploadQueue queue(&intake, 2, 200ms, 400ms, &spool);
+  queue.Start();
+
+  queue.Enqueue(MakeUpload(1));
+  ASSERT_TRUE(WaitFor([&queue]() { return queue.GetFailedCount() == 1; }));
+  for (uint32_t id = 2; id <= 5; id++) {
+    queue.Enqueue(MakeUpload(id));
+  }
+  EXPECT_EQ(queue.GetPendingCount(), 2u);
+  EXPECT_EQ(queue.GetSpooledCount(), 3u);
+
+  // nothing is lost: the spool drains once the intake is back
+  intake.status = UploadStatus::Sent;
+  ASSERT_TRUE(WaitFor([&queue]() { return queue.GetSentCount() == 5; }));
+  EXPECT_EQ(intake.GetSentIds(), (std::vector<uint32_t>{1, 2, 3, 4, 5}));
+  EXPECT_TRUE(spool.IsEmpty());
+  EXPECT_EQ(queue.GetDiscardedCount(), 0u);
+
+  queue.Stop();
+}
+
+TEST_F(UploadQueueSpoolTests, Stop_IntakeDown_PendingProfilesSpooledForNextProcess) {
+  {
+    UploadSpool spool(directory, 1024 * 1024);
+    ASSERT_TRUE(spool.Initialize());
+    FakeIntake intake;
+    intake.status = UploadStatus::Failed;
+    UploadQueue queue(&intake, 8, 10s, 10s, &spool);
+    queue.Start();
+
+    queue.Enqueue(MakeUpload(1));
+    ASSERT_TRUE(WaitFor([&queue]() { return queue.GetFailedCount() == 1; }));
+    queue.Enqueue(MakeUpload(2));
+    queue.Enqueue(MakeUpload(3));
+
+    queue.Stop();
+    EXPECT_EQ(queue.GetSpooledCount(), 3u);
+    EXPECT_EQ(queue.GetDiscardedCount(), 0u);
+    EXPECT_EQ(intake.GetDiscardedIds(), (std::vector<uint32_t>{1, 2, 3}));
+  }
+
+  // the next process sends the spooled profiles with their original content
+  UploadSpool spool(directory, 1024 * 1024);
+  ASSERT_TRUE(spool.Initialize());
+  EXPECT_EQ(spool.GetFilesCount(), 3u);
+
+  FakeIntake intake;
+  UploadQueue queue(&intake, 8, 10s, 10s, &spool);
+  queue.Start();
+  ASSERT_TRUE(WaitFor([&queue]() { return queue.GetSentCount() == 3; }));
+  EXPECT_EQ(intake.GetSentIds(), (std::vector<uint32_t>{1, 2, 3}));
+  EXPECT_TRUE(spool.IsEmpty());
+
+  queue.Stop();
+}
+
+TEST(UploadQueueTests, ComputeBackoff_ExponentialJitteredAndCapped) {
+  auto initial = 1000ms;
+  auto max = 30000ms;
+  EXPECT_EQ(UploadQueue::ComputeBackoff(0, 0.5, initial, max), 0ms);
+
+  // [delay/2, delay]
+  EXPECT_EQ(UploadQueue::ComputeBackoff(1, 0.0, initial, max), 500ms);
+  EXPECT_EQ(UploadQueue::ComputeBackoff(1, 0.5, initial, max), 750ms);
+  EXPECT_EQ(UploadQueue::ComputeBackoff(2, 0.0, initial, max), 1000ms);
+  EXPECT_EQ(UploadQueue::ComputeBackoff(3, 0.0, initial, max), 2000ms);
+  EXPECT_EQ(UploadQueue::ComputeBackoff(5, 0.0, initial, max), 8000ms);
+
+  // capped, even after many failures
+  EXPECT_EQ(UploadQueue::ComputeBackoff(6, 0.0, initial, max), 15000ms);
+  EXPECT_EQ(UploadQueue::ComputeBackoff(7, 0.0, initial, max), 15000ms);
+  EXPECT_EQ(UploadQueue::ComputeBackoff(1000, 0.999, initial, max), 29985ms);
+}
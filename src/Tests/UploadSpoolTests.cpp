@@ -0,0 +1,192 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../dd-win-prof/UploadSpool.h"
+#include "pch.h"
+
+namespace {
+PendingUpload MakeUpload(uint32_t exportId, size_t profileSize = 1024) {
+  PendingUpload upload;
+  upload.exportId = exportId;
+  upload.profileBytes.assign(profileSize, static_cast<uint8_t>(exportId));
+  upload.startMs = 1'700'000'000'000 + exportId;
+  upload.endMs = upload.startMs + 60'000;
+  upload.exportTags = {
+      {"service", "my-service"}, {"profile_seq", std::to_string(exportId)}
+  };
+  upload.size = upload.profileBytes.size();
+  return upload;
+}
+
+size_t GetSpooledSize(const PendingUpload& upload) {
+  return UploadSpool::Serialize(upload).size();
+}
+
+class UploadSpoolTests : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    directory = fs::temp_directory_path() /
+                ("dd-win-prof-spool-" + std::to_string(::GetCurrentProcessId()));
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+  }
+
+  void TearDown() override {
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+  }
+
+  fs::path directory;
+};
+}  // namespace
+
+TEST(UploadSpoolSerializationTests, RoundTrip_AllFieldsKept) {
+  auto upload = MakeUpload(42);
+  upload.attemptsCount = 3;
+  upload.endpointCounts = {{"GET /users", 12}, {"POST /orders", 3}};
+  upload.internalMetadataJson = R"({"cpu_sampling_period_ms":20})";
+  upload.infoJson = R"({"application":{"start_time":"2025-01-01T00:00:00Z"}})";
+
+  PendingUpload result;
+  ASSERT_TRUE(UploadSpool::Deserialize(UploadSpool::Serialize(upload), result));
+  EXPECT_EQ(result.exportId, 42u);
+  EXPECT_EQ(result.attemptsCount, 3u);
+  EXPECT_EQ(result.startMs, upload.startMs);
+  EXPECT_EQ(result.endMs, upload.endMs);
+  EXPECT_EQ(result.exportTags, upload.exportTags);
+  EXPECT_EQ(result.endpointCounts, upload.endpointCounts);
+  EXPECT_EQ(result.internalMetadataJson, upload.internalMetadataJson);
+  EXPECT_EQ(result.infoJson, upload.infoJson);
+  EXPECT_EQ(result.profileBytes, upload.profileBytes);
+  EXPECT_EQ(result.size, 1024u);
+  EXPECT_EQ(result.encodedProfile.inner, nullptr);
+}
+
+TEST(UploadSpoolSerializationTests, Deserialize_TruncatedOrInvalid_Fails) {
+  auto content = UploadSpool::Serialize(MakeUpload(1));
+  PendingUpload result;
+
+  EXPECT_FALSE(UploadSpool::Deserialize({}, result));
+
+  // no profile
+  std::span<const uint8_t> truncated(content.data(), content.size() - 1024);
+  EXPECT_FALSE(UploadSpool::Deserialize(truncated, result));
+
+  // in the middle of the tags
+  EXPECT_FALSE(UploadSpool::Deserialize(truncated.first(40), result));
+
+  auto badMagic = content;
+  badMagic[0] ^= 0xFF;
+  EXPECT_FALSE(UploadSpool::Deserialize(badMagic, result));
+}
+
+TEST(UploadSpoolSerializationTests, ToFileName_InvalidCharactersReplaced) {
+  EXPECT_EQ(UploadSpool::ToFileName("my-service_2"), "my-service_2");
+  EXPECT_EQ(UploadSpool::ToFileName("my service/api:v2.1"), "my_service_api_v2_1");
+  EXPECT_EQ(UploadSpool::ToFileName("..\\x*?"), "___x__");
+}
+
+TEST_F(UploadSpoolTests, Write_ThenReadOldestFirst) {
+  UploadSpool spool(directory, 1024 * 1024);
+  ASSERT_TRUE(spool.Initialize());
+  EXPECT_TRUE(spool.IsEmpty());
+
+  // a retried profile is older than the ones already spooled
+  ASSERT_TRUE(spool.Write(MakeUpload(2)));
+  ASSERT_TRUE(spool.Write(MakeUpload(3)));
+  ASSERT_TRUE(spool.Write(MakeUpload(1)));
+  EXPECT_EQ(spool.GetFilesCount(), 3u);
+  EXPECT_EQ(spool.GetSize(), 3 * GetSpooledSize(MakeUpload(1)));
+
+  PendingUpload upload;
+  for (uint32_t id = 1; id <= 3; id++) {
+    ASSERT_TRUE(spool.ReadOldest(upload));
+    EXPECT_EQ(upload.exportId, id);
+    EXPECT_EQ(upload.profileBytes, MakeUpload(id).profileBytes);
+  }
+  EXPECT_FALSE(spool.ReadOldest(upload));
+  EXPECT_TRUE(spool.IsEmpty());
+  EXPECT_EQ(spool.GetSize(), 0u);
+
+  // the files are removed once read
+  EXPECT_TRUE(fs::is_empty(directory));
+}
+
+TEST_F(UploadSpoolTests, Write_CapReached_OldestEvicted) {
+  auto fileSize = GetSpooledSize(MakeUpload(1));
+  UploadSpool spool(directory, 2 * fileSize + fileSize / 2);
+  ASSERT_TRUE(spool.Initialize());
+
+  for (uint32_t id = 1; id <= 4; id++) {
+    ASSERT_TRUE(spool.Write(MakeUpload(id)));
+  }
+  EXPECT_EQ(spool.GetFilesCount(), 2u);
+  EXPECT_EQ(spool.GetEvictedCount(), 2u);
+  EXPECT_LE(spool.GetSize(), 2 * fileSize + fileSize / 2);
+
+  PendingUpload upload;
+  ASSERT_TRUE(spool.ReadOldest(upload));
+  EXPECT_EQ(upload.exportId, 3u);
+  ASSERT_TRUE(spool.ReadOldest(upload));
+  EXPECT_EQ(upload.exportId, 4u);
+}
+
+TEST_F(UploadSpoolTests, Write_LargerThanCap_Refused) {
+  UploadSpool spool(directory, 4096);
+  ASSERT_TRUE(spool.Initialize());
+  ASSERT_TRUE(spool.Write(MakeUpload(1)));
+
+  // the spooled profiles are not evicted for a profile that would not fit anyway
+  EXPECT_FALSE(spool.Write(MakeUpload(2, 8192)));
+  EXPECT_EQ(spool.GetFilesCount(), 1u);
+  EXPECT_EQ(spool.GetEvictedCount(), 0u);
+}
+
+TEST_F(UploadSpoolTests, Initialize_FilesOfPreviousProcessFound) {
+  {
+    UploadSpool spool(directory, 1024 * 1024);
+    ASSERT_TRUE(spool.Initialize());
+    ASSERT_TRUE(spool.Write(MakeUpload(1)));
+    ASSERT_TRUE(spool.Write(MakeUpload(2)));
+  }
+
+  // not a spooled profile
+  std::ofstream(directory / "readme.txt") << "not a profile";
+
+  UploadSpool spool(directory, 1024 * 1024);
+  ASSERT_TRUE(spool.Initialize());
+  EXPECT_EQ(spool.GetFilesCount(), 2u);
+  EXPECT_EQ(spool.GetSize(), 2 * GetSpooledSize(MakeUpload(1)));
+
+  PendingUpload upload;
+  ASSERT_TRUE(spool.ReadOldest(upload));
+  EXPECT_EQ(upload.exportId, 1u);
+  EXPECT_EQ(upload.exportTags, MakeUpload(1).exportTags);
+}
+
+TEST_F(UploadSpoolTests, ReadOldest_CorruptedFile_Deleted) {
+  fs::create_directories(directory);
+  auto path = directory / (std::string("00000000000000000001-1-1") +
+                           UploadSpool::FileExtension);
+  std::ofstream(path, std::ios::binary) << "corrupted";
+
+  UploadSpool spool(directory, 1024 * 1024);
+  ASSERT_TRUE(spool.Initialize());
+  ASSERT_TRUE(spool.Write(MakeUpload(2)));
+  EXPECT_EQ(spool.GetFilesCount(), 2u);
+
+  PendingUpload upload;
+  EXPECT_FALSE(spool.ReadOldest(upload));
+  EXPECT_FALSE(fs::exists(path));
+
+  // the next profile can still be read
+  ASSERT_TRUE(spool.ReadOldest(upload));
+  EXPECT_EQ(upload.exportId, 2u);
+}
@@ -0,0 +1,187 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <span>
+#include <vector>
+
+#include "../dd-win-prof/Sample.h"
+#include "../dd-win-prof/SampleValueTypeProvider.h"
+#include "../dd-win-prof/ThreadInfo.h"
+#include "../dd-win-prof/WalltimeProvider.h"
+#include "../dd-win-prof/WalltimeSampleFolder.h"
+#include "pch.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+const std::vector<uint64_t> IdleStack = {
+    0x7FF800001000, 0x7FF800002000, 0x7FF600003000
+};
+const std::vector<uint64_t> OtherStack = {0x7FF800001000, 0x7FF600004000};
+}  // namespace
+
+// A pool of 48 workers parked in the same wait produces a single record
+TEST(WalltimeSampleFolderTests, SameWait_FoldedIntoOneRecord) {
+  WalltimeSampleFolder folder;
+  for (uint32_t i = 0; i < 48; i++) {
+    folder.Add((i + 1) * 4, i + 100, 0x11, IdleStack, 10ms);
+  }
+
+  auto records = folder.GetRecords();
+  ASSERT_EQ(records.size(), 1u);
+  EXPECT_EQ(records[0].threadsCount, 48u);
+  EXPECT_EQ(records[0].duration, 480ms);
+  EXPECT_EQ(records[0].threadGroup, 0x11u);
+
+  // the first thread identifies the group
+  EXPECT_EQ(records[0].threadId, 4u);
+  EXPECT_EQ(records[0].threadGeneration, 100u);
+
+  auto frames = folder.GetFrames(records[0]);
+  ASSERT_EQ(frames.size(), IdleStack.size());
+  EXPECT_TRUE(std::equal(frames.begin(), frames.end(), IdleStack.begin()));
+}
+
+TEST(WalltimeSampleFolderTests, DifferentKeys_NotFolded) {
+  WalltimeSampleFolder folder;
+  folder.Add(4, 1, 0x11, IdleStack, 10ms);
+  folder.Add(8, 2, 0x11, OtherStack, 10ms);
+  folder.Add(16, 4, 0x21, IdleStack, 10ms);
+  folder.Add(20, 5, 0x11, IdleStack, 20ms);
+
+  auto records = folder.GetRecords();
+  ASSERT_EQ(records.size(), 3u);
+  EXPECT_EQ(records[0].threadsCount, 2u);
+  EXPECT_EQ(records[0].duration, 30ms);
+  for (size_t i = 1; i < records.size(); i++) {
+    EXPECT_EQ(records[i].threadsCount, 1u);
+  }
+
+  auto frames = folder.GetFrames(records[1]);
+  ASSERT_EQ(frames.size(), OtherStack.size());
+  EXPECT_TRUE(std::equal(frames.begin(), frames.end(), OtherStack.begin()));
+}
+
+TEST(WalltimeSampleFolderTests, Clear_NextTickStartsEmpty) {
+  WalltimeSampleFolder folder;
+  folder.Add(4, 1, 0x11, IdleStack, 10ms);
+  ASSERT_FALSE(folder.IsEmpty());
+
+  folder.Clear();
+  EXPECT_TRUE(folder.IsEmpty());
+
+  folder.Add(8, 2, 0x11, OtherStack, 10ms);
+  auto records = folder.GetRecords();
+  ASSERT_EQ(records.size(), 1u);
+  EXPECT_EQ(records[0].threadId, 8u);
+  EXPECT_EQ(folder.GetFrames(records[0]).size(), OtherStack.size());
+}
+
+TEST(WalltimeSampleFolderTests, ThreadNameGroup) {
+  EXPECT_EQ(ThreadInfo::GetThreadNameGroup("Worker #12"), "Worker");
+  EXPECT_EQ(ThreadInfo::GetThreadNameGroup("Worker-3"), "Worker");
+  EXPECT_EQ(ThreadInfo::GetThreadNameGroup("io_pool_07"), "io_pool");
+  EXPECT_EQ(ThreadInfo::GetThreadNameGroup("Render.1.2"), "Render");
+  EXPECT_EQ(ThreadInfo::GetThreadNameGroup("Main"), "Main");
+  EXPECT_EQ(ThreadInfo::GetThreadNameGroup("v2 loader"), "v2 loader");
+  EXPECT_EQ(ThreadInfo::GetThreadNameGroup("42"), "42");
+  EXPECT_EQ(ThreadInfo::GetThreadNameGroup(""), "");
+}
+
+// The ring is full when the folded samples are written: their threads are not marked
+// as sampled so that their wall time is accounted in the next flush
+TEST(WalltimeSampleFolderTests, Flush_FullRing_ThreadsNotMarkedAsSampled) {
+  SampleValueTypeProvider valueTypeProvider;
+  WallTimeProvider provider(valueTypeProvider);
+  Sample::SetValuesCount(valueTypeProvider.GetValueTypes().size());
+
+  auto samplingStart = 1s;
+  ThreadInfo idleThread(4, nullptr);
+  ThreadInfo otherThread(8, nullptr);
+  idleThread.SetLastWalltimeSampleTimestamp(samplingStart);
+  otherThread.SetLastWalltimeSampleTimestamp(samplingStart);
+  auto writeRecord = [&provider](
+                         const WalltimeSampleFolder::Record& record,
+                         std::span<const uint64_t> frames
+                     ) {
+    return provider.AddFolded(
+        1000ns,
+        record.threadId,
+        record.threadGeneration,
+        record.threadGroup,
+        record.threadsCount,
+        frames,
+        0,
+        record.duration
+    );
+  };
+
+  // fill the ring
+  uint64_t frames[] = {0x1000, 0x2000};
+  while (provider.AddFolded(1000ns, 12, 1, 0x11, 1, frames, 0, 10ms)) {
+  }
+
+  WalltimeSampleFolder folder;
+  auto tick = samplingStart + 10ms;
+  folder.Add(4, 1, 0x11, IdleStack, 10ms, &idleThread, tick);
+  folder.Add(8, 2, 0x11, OtherStack, 10ms, &otherThread, tick);
+
+  auto stats = folder.Flush(writeRecord);
+  EXPECT_EQ(stats.samplesCount, 0u);
+  EXPECT_EQ(stats.threadsCount, 0u);
+  EXPECT_EQ(stats.duration, 0ns);
+  EXPECT_TRUE(folder.IsEmpty());
+  EXPECT_EQ(idleThread.GetWalltimeSampleWeight(tick, samplingStart), 10ms);
+  EXPECT_EQ(otherThread.GetWalltimeSampleWeight(tick, samplingStart), 10ms);
+
+  // the exporter drains the ring: the next sample stands for both ticks
+  SampleBatch batch;
+  provider.MoveSamples(batch);
+  tick += 10ms;
+  folder.Add(4, 1, 0x11, IdleStack, 20ms, &idleThread, tick);
+  folder.Add(8, 2, 0x11, OtherStack, 20ms, &otherThread, tick);
+
+  stats = folder.Flush(writeRecord);
+  EXPECT_EQ(stats.samplesCount, 2u);
+  EXPECT_EQ(stats.threadsCount, 2u);
+  EXPECT_EQ(stats.duration, 40ms);
+  EXPECT_EQ(idleThread.GetWalltimeSampleWeight(tick + 10ms, samplingStart), 10ms);
+  EXPECT_EQ(otherThread.GetWalltimeSampleWeight(tick + 10ms, samplingStart), 10ms);
+
+  Sample::SetValuesCount(dd_win_prof::kMaxValuesCount);
+}
+
+// Only the threads of the written records are marked as sampled
+TEST(WalltimeSampleFolderTests, Flush_DroppedRecord_OnlyWrittenThreadsMarked) {
+  ThreadInfo idleThread1(4, nullptr);
+  ThreadInfo idleThread2(8, nullptr);
+  ThreadInfo otherThread(12, nullptr);
+  auto samplingStart = 1s;
+  auto tick = samplingStart + 10ms;
+  for (auto* pThreadInfo : {&idleThread1, &idleThread2, &otherThread}) {
+    pThreadInfo->SetLastWalltimeSampleTimestamp(samplingStart);
+  }
+
+  WalltimeSampleFolder folder;
+  folder.Add(4, 1, 0x11, IdleStack, 10ms, &idleThread1, tick);
+  folder.Add(12, 3, 0x11, OtherStack, 10ms, &otherThread, tick);
+  folder.Add(8, 2, 0x11, IdleStack, 10ms, &idleThread2, tick);
+
+  // the second record (OtherStack) is dropped
+  auto stats = folder.Flush(
+      [](const WalltimeSampleFolder::Record& record, std::span<const uint64_t>) {
+        return record.threadsCount == 2;
+      }
+  );
+  EXPECT_EQ(stats.samplesCount, 1u);
+  EXPECT_EQ(stats.threadsCount, 2u);
+  EXPECT_EQ(stats.duration, 20ms);
+  EXPECT_EQ(idleThread1.GetWalltimeSampleWeight(tick, samplingStart), 0ns);
+  EXPECT_EQ(idleThread2.GetWalltimeSampleWeight(tick, samplingStart), 0ns);
+  EXPECT_EQ(otherThread.GetWalltimeSampleWeight(tick, samplingStart), 10ms);
+}
@@ -0,0 +1,110 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "CachedCallstack.h"
+
+#include "StackUnwinder.h"
+#include "pch.h"
+
+namespace {
+constexpr ULONG UnknownContextSwitches = ULONG_MAX;
+}  // namespace
+
+CachedCallstack::CachedCallstack()
+    : _isValid(false),
+      _rip(0),
+      _rsp(0),
+      _stackHash(0),
+      _hasBaseline(false),
+      _baselineContextSwitches(0),
+      _isSuspendedSinceBaseline(false),
+      _suspensionContextSwitches(0),
+      _candidateSuspensionContextSwitches(UnknownContextSwitches),
+      _isSuspensionContextSwitchesKnown(false) {}
+
+bool CachedCallstack::IsUnchanged(ULONG contextSwitches) const {
+  if (!_isValid || !_hasBaseline) {
+    return false;
+  }
+
+  // the count is not reset when it wraps: unsigned difference
+  ULONG delta = contextSwitches - _baselineContextSwitches;
+  if (!_isSuspendedSinceBaseline) {
+    return delta == 0;
+  }
+
+  return _isSuspensionContextSwitchesKnown && (delta == _suspensionContextSwitches);
+}
+
+void CachedCallstack::OnReusedWithoutSuspension(ULONG contextSwitches) {
+  SetBaseline(true, contextSwitches, false);
+}
+
+bool CachedCallstack::Matches(uint64_t rip, uint64_t rsp, uint64_t stackHash) const {
+  return _isValid && (stackHash != 0) && (rip == _rip) && (rsp == _rsp) &&
+         (stackHash == _stackHash);
+}
+
+void CachedCallstack::OnReusedAfterSuspension(
+    bool hasContextSwitches, ULONG contextSwitches
+) {
+  // the thread did not run since the baseline, except to handle the previous
+  // suspension: learn how many context switches it costs
+  if (hasContextSwitches && _hasBaseline && _isSuspendedSinceBaseline) {
+    ULONG delta = contextSwitches - _baselineContextSwitches;
+    if (delta == _candidateSuspensionContextSwitches) {
+      _suspensionContextSwitches = delta;
+      _isSuspensionContextSwitchesKnown = true;
+    }
+    _candidateSuspensionContextSwitches = delta;
+  }
+
+  SetBaseline(hasContextSwitches, contextSwitches, true);
+}
+
+void CachedCallstack::Update(
+    uint64_t rip,
+    uint64_t rsp,
+    uint64_t stackHash,
+    std::span<const uint64_t> frames,
+    bool hasContextSwitches,
+    ULONG contextSwitches
+) {
+  _isValid = (stackHash != 0);
+  _rip = rip;
+  _rsp = rsp;
+  _stackHash = stackHash;
+  _frames.assign(frames.begin(), frames.end());
+  SetBaseline(hasContextSwitches, contextSwitches, true);
+}
+
+void CachedCallstack::Invalidate() {
+  _isValid = false;
+  _hasBaseline = false;
+}
+
+void CachedCallstack::SetBaseline(
+    bool hasContextSwitches, ULONG contextSwitches, bool isSuspended
+) {
+  _hasBaseline = hasContextSwitches;
+  _baselineContextSwitches = contextSwitches;
+  _isSuspendedSinceBaseline = isSuspended;
+}
+
+uint64_t CachedCallstack::HashStackTop(uint64_t rsp) {
+  InPlaceStackMemory memory;
+
+  // FNV-1a on the 64 bit slots
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < HashedStackSlots; i++) {
+    uint64_t value = 0;
+    if (!memory.ReadUInt64(rsp + i * sizeof(uint64_t), value)) {
+      return 0;
+    }
+
+    hash = (hash ^ value) * 1099511628211ull;
+  }
+
+  return (hash != 0) ? hash : 1;
+}
@@ -0,0 +1,84 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "pch.h"
+
+// Last callstack of a waiting thread, reused while the thread stays parked in the same
+// wait (e.g. idle pool workers blocked for minutes) instead of unwinding it again:
+// - with the thread suspended: same rip, rsp and top of the stack
+// - without suspending it: the thread was not scheduled since the callstack was
+//   cached, according to its context switches count (see ThreadStateSnapshot).
+//   Suspending and resuming a waiting thread makes it run kernel code, so the count
+//   increases by a fixed number with each suspension: this number is learned from
+//   the suspensions that did not change the context.
+//
+// Only used by the sampler thread.
+class CachedCallstack {
+ public:
+  // number of stack slots (from rsp) hashed to check that the top of the stack did
+  // not change
+  static constexpr size_t HashedStackSlots = 8;
+
+ public:
+  CachedCallstack();
+
+  // Return true if the thread (waiting) has not run since its callstack was cached
+  bool IsUnchanged(ULONG contextSwitches) const;
+
+  // The cached callstack is reused without suspending the thread
+  void OnReusedWithoutSuspension(ULONG contextSwitches);
+
+  // Return true if the context of the suspended (waiting) thread is the cached one
+  bool Matches(uint64_t rip, uint64_t rsp, uint64_t stackHash) const;
+
+  // The cached callstack is reused after the context of the suspended thread
+  // matched; hasContextSwitches is false if the count of the thread is not known
+  void OnReusedAfterSuspension(bool hasContextSwitches, ULONG contextSwitches);
+
+  // Cache the callstack just unwound (after the thread was resumed: it allocates)
+  void Update(
+      uint64_t rip,
+      uint64_t rsp,
+      uint64_t stackHash,
+      std::span<const uint64_t> frames,
+      bool hasContextSwitches,
+      ULONG contextSwitches
+  );
+
+  void Invalidate();
+
+  std::span<const uint64_t> GetFrames() const { return _frames; }
+
+  // Hash of the slots at the top of the stack of a suspended thread of the current
+  // process; 0 if they can't be read
+  static uint64_t HashStackTop(uint64_t rsp);
+
+ private:
+  void SetBaseline(bool hasContextSwitches, ULONG contextSwitches, bool isSuspended);
+
+ private:
+  bool _isValid;
+  uint64_t _rip;
+  uint64_t _rsp;
+  uint64_t _stackHash;
+  std::vector<uint64_t> _frames;
+
+  // context switches count when the callstack was cached or last reused, and whether
+  // the thread was suspended since then
+  bool _hasBaseline;
+  ULONG _baselineContextSwitches;
+  bool _isSuspendedSinceBaseline;
+
+  // context switches caused by one suspension: known once the same value has been
+  // seen twice in a row
+  ULONG _suspensionContextSwitches;
+  ULONG _candidateSuspensionContextSwitches;
+  bool _isSuspensionContextSwitchesKnown;
+};
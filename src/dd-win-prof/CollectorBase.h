@@ -4,43 +4,87 @@
 
 #pragma once
 
+#include <algorithm>
+
 #include "ISamplesProvider.h"
 #include "OpSysTools.h"
 #include "Sample.h"
+#include "SampleRingBuffer.h"
 #include "SampleValueTypeProvider.h"
 #include "pch.h"
 
+// Samples are added by the sampler thread and moved by the DD_worker thread through a
+// lock-free single-producer/single-consumer ring: Add never waits nor allocates. The
+// DD_worker thread is woken up when the ring gets half full.
 class CollectorBase : public ISamplesProvider {
  public:
   CollectorBase(
-      const char* name, std::vector<SampleValueTypeProvider::Offset> valueOffsets
+      const char* name,
+      std::vector<SampleValueTypeProvider::Offset> valueOffsets,
+      size_t capacity = SampleRingBuffer::DefaultCapacity
   )
-      : _name(name), _valueOffsets{std::move(valueOffsets)} {}
+      : _name(name), _valueOffsets{std::move(valueOffsets)}, _samples(capacity) {}
 
-  void Add(Sample&& sample) {
-    std::lock_guard<std::mutex> lock(_lock);
-    _collectedSamples.push_back(std::move(sample));
+  // ISamplesProvider interface
+  size_t MoveSamples(SampleBatch& destination) override {
+    return _samples.Drain(destination);
   }
 
-  // ISamplesProvider interface
-  size_t MoveSamples(std::vector<Sample>& destination) override {
-    std::lock_guard<std::mutex> lock(_lock);
+  uint64_t GetDroppedSamplesCount() override { return _samples.GetDroppedCount(); }
 
-    destination.clear();
-    _collectedSamples.swap(destination);
+  size_t GetAndResetPeakPendingCount() override {
+    return _samples.GetAndResetPeakPendingCount();
+  }
 
-    return destination.size();
+  // the ring notifies the signal when half full
+  void SetWakeupSignal(WakeupSignal* pSignal) override {
+    _samples.SetWakeupSignal(pSignal);
   }
 
   const char* GetName() override { return _name.c_str(); }
 
+  // the ring is allocated once: its size never changes
+  size_t GetMemorySize() const { return _samples.GetMemorySize(); }
+
   std::vector<SampleValueTypeProvider::Offset> const& GetValueOffsets() const {
     return _valueOffsets;
   }
 
+ protected:
+  // Sampler thread only: reserve a slot for a sample and copy its callstack and
+  // labels; the values must be set before calling CommitSample().
+  // Return nullptr if the ring is full (the sample is dropped).
+  SampleRingBuffer::Slot* ReserveSample(
+      std::chrono::nanoseconds timestamp,
+      uint32_t threadId,
+      uint64_t threadGeneration,
+      std::span<const uint64_t> frames,
+      uint32_t rumViewHandle,
+      const TraceContext& traceContext
+  ) {
+    auto* pSlot = _samples.TryReserve();
+    if (pSlot == nullptr) {
+      return nullptr;
+    }
+
+    auto framesCount = std::min(frames.size(), dd_win_prof::kMaxStackDepth);
+    pSlot->timestamp = timestamp;
+    pSlot->threadId = threadId;
+    pSlot->threadGeneration = threadGeneration;
+    pSlot->threadGroup = 0;
+    pSlot->foldedThreadsCount = 0;
+    pSlot->rumViewHandle = rumViewHandle;
+    pSlot->traceContext = traceContext;
+    pSlot->framesCount = static_cast<uint16_t>(framesCount);
+    std::copy_n(frames.begin(), framesCount, pSlot->frames);
+
+    return pSlot;
+  }
+
+  void CommitSample() { _samples.Commit(); }
+
  private:
-  std::mutex _lock;
   std::string _name;
   std::vector<SampleValueTypeProvider::Offset> _valueOffsets;
-  std::vector<Sample> _collectedSamples;
-};
\ No newline at end of file
+  SampleRingBuffer _samples;
+};
@@ -60,6 +60,12 @@ void Configuration::InitDefaults() {
       std::chrono::nanoseconds(DefaultSamplingPeriod * 1'000'000);
   _walltimeThreadsThreshold = DefaultWalltimeThreadsThreshold;
   _cpuThreadsThreshold = DefaultCpuThreadsThreshold;
+  _suspensionDeadline = std::chrono::milliseconds(DefaultSuspensionDeadline);
+  _maxMemory = static_cast<size_t>(DefaultMaxMemoryMB) * 1024 * 1024;
+  _symbolCacheSize = DefaultSymbolCacheSize;
+  _uploadSpoolDirectory = GetDefaultUploadSpoolDirectory();
+  _uploadSpoolMaxSize = static_cast<size_t>(DefaultUploadSpoolMaxSizeMB) * 1024 * 1024;
+  _uploadInitialBackoff = std::chrono::milliseconds(DefaultUploadInitialBackoff);
   _apiKey = DefaultEmptyString;
   _isAgentLess = false;
   _agentUrl = DefaultEmptyString;
@@ -68,6 +74,11 @@ void Configuration::InitDefaults() {
   _site = DefaultProdSite;
   _namedPipeName = DefaultEmptyString;
   _areCallstacksSymbolized = false;
+  _isTimelineEnabled = true;
+  _isStackSnapshotEnabled = false;
+  _isFramePointerUnwindingEnabled = false;
+  _isSamplingJitterEnabled = false;
+  _isWalltimeFoldingEnabled = false;
 }
 
 void Configuration::ResetToDefaults() { InitDefaults(); }
@@ -105,6 +116,12 @@ Configuration::Configuration() {
   _cpuWallTimeSamplingPeriod = ExtractCpuWallTimeSamplingRate();
   _walltimeThreadsThreshold = ExtractWallTimeThreadsThreshold();
   _cpuThreadsThreshold = ExtractCpuThreadsThreshold();
+  _suspensionDeadline = ExtractSuspensionDeadline();
+  _maxMemory = ExtractMaxMemory();
+  _symbolCacheSize = ExtractSymbolCacheSize();
+  _uploadSpoolDirectory = ExtractUploadSpoolDirectory();
+  _uploadSpoolMaxSize = ExtractUploadSpoolMaxSize();
+  _uploadInitialBackoff = ExtractUploadInitialBackoff();
   _apiKey = GetEnvironmentValue(EnvironmentVariables::ApiKey, DefaultEmptyString);
 
   _isAgentLess = GetEnvironmentValue(EnvironmentVariables::Agentless, false);
@@ -117,6 +134,15 @@ Configuration::Configuration() {
 
   _areCallstacksSymbolized =
       GetEnvironmentValue<bool>(EnvironmentVariables::SymbolizeCallstacks, false);
+  _isTimelineEnabled = GetEnvironmentValue(EnvironmentVariables::TimelineEnabled, true);
+  _isStackSnapshotEnabled =
+      GetEnvironmentValue(EnvironmentVariables::StackSnapshotEnabled, false);
+  _isFramePointerUnwindingEnabled =
+      GetEnvironmentValue(EnvironmentVariables::FramePointerUnwindingEnabled, false);
+  _isSamplingJitterEnabled =
+      GetEnvironmentValue(EnvironmentVariables::SamplingJitterEnabled, false);
+  _isWalltimeFoldingEnabled =
+      GetEnvironmentValue(EnvironmentVariables::WalltimeFoldingEnabled, false);
 }
 
 bool EnvironmentExist(const char* name) {
@@ -280,6 +306,38 @@ bool Configuration::AreCallstacksSymbolized() const { return _areCallstacksSymbo
 
 void Configuration::EnableSymbolizedCallstacks() { _areCallstacksSymbolized = true; }
 
+bool Configuration::IsTimelineEnabled() const { return _isTimelineEnabled; }
+
+void Configuration::SetTimelineEnabled(bool enabled) { _isTimelineEnabled = enabled; }
+
+bool Configuration::IsStackSnapshotEnabled() const { return _isStackSnapshotEnabled; }
+
+void Configuration::SetStackSnapshotEnabled(bool enabled) {
+  _isStackSnapshotEnabled = enabled;
+}
+
+bool Configuration::IsFramePointerUnwindingEnabled() const {
+  return _isFramePointerUnwindingEnabled;
+}
+
+void Configuration::SetFramePointerUnwindingEnabled(bool enabled) {
+  _isFramePointerUnwindingEnabled = enabled;
+}
+
+bool Configuration::IsSamplingJitterEnabled() const { return _isSamplingJitterEnabled; }
+
+void Configuration::SetSamplingJitterEnabled(bool enabled) {
+  _isSamplingJitterEnabled = enabled;
+}
+
+bool Configuration::IsWalltimeFoldingEnabled() const {
+  return _isWalltimeFoldingEnabled;
+}
+
+void Configuration::SetWalltimeFoldingEnabled(bool enabled) {
+  _isWalltimeFoldingEnabled = enabled;
+}
+
 std::chrono::nanoseconds Configuration::CpuWallTimeSamplingPeriod() const {
   return _cpuWallTimeSamplingPeriod;
 }
@@ -305,6 +363,96 @@ int32_t Configuration::ExtractCpuThreadsThreshold() {
   return threshold;
 }
 
+std::chrono::milliseconds Configuration::GetSuspensionDeadline() const {
+  return _suspensionDeadline;
+}
+
+std::chrono::milliseconds Configuration::ExtractSuspensionDeadline() {
+  // a sampled thread should be suspended for a few microseconds: a much longer
+  // suspension means a stuck stack walk. 0 disables the watchdog
+  int32_t deadline = GetEnvironmentValue(
+      EnvironmentVariables::SuspensionDeadline, DefaultSuspensionDeadline
+  );
+  if (deadline < 0) {
+    deadline = DefaultSuspensionDeadline;
+  } else if ((deadline > 0) && (deadline < 10)) {
+    deadline = 10;
+  }
+
+  return std::chrono::milliseconds(deadline);
+}
+
+size_t Configuration::GetMaxMemory() const { return _maxMemory; }
+
+size_t Configuration::ExtractMaxMemory() {
+  // budget of the samples pipeline: above it, the samples are degraded then dropped.
+  // 0 disables the limit
+  int32_t maxMemoryMB =
+      GetEnvironmentValue(EnvironmentVariables::MaxMemory, DefaultMaxMemoryMB);
+  if (maxMemoryMB < 0) {
+    maxMemoryMB = DefaultMaxMemoryMB;
+  }
+
+  return static_cast<size_t>(maxMemoryMB) * 1024 * 1024;
+}
+
+size_t Configuration::GetSymbolCacheSize() const { return _symbolCacheSize; }
+
+size_t Configuration::ExtractSymbolCacheSize() {
+  // symbolicated addresses kept across exports: above it, the least recently used ones
+  // are evicted. 0 disables the limit
+  int32_t size = GetEnvironmentValue(
+      EnvironmentVariables::SymbolCacheSize, DefaultSymbolCacheSize
+  );
+  if (size < 0) {
+    size = DefaultSymbolCacheSize;
+  }
+
+  return static_cast<size_t>(size);
+}
+
+fs::path const& Configuration::GetUploadSpoolDirectory() const {
+  return _uploadSpoolDirectory;
+}
+
+fs::path Configuration::ExtractUploadSpoolDirectory() {
+  auto value = ::GetEnvironmentValue(EnvironmentVariables::UploadSpoolDirectory);
+  if (value.empty()) return GetDefaultUploadSpoolDirectory();
+
+  return fs::path(value);
+}
+
+size_t Configuration::GetUploadSpoolMaxSize() const { return _uploadSpoolMaxSize; }
+
+size_t Configuration::ExtractUploadSpoolMaxSize() {
+  // profiles kept on disk while the agent or the intake is down: above it, the oldest
+  // ones are evicted. 0 disables the spool
+  int32_t maxSizeMB = GetEnvironmentValue(
+      EnvironmentVariables::UploadSpoolMaxSize, DefaultUploadSpoolMaxSizeMB
+  );
+  if (maxSizeMB < 0) {
+    maxSizeMB = DefaultUploadSpoolMaxSizeMB;
+  }
+
+  return static_cast<size_t>(maxSizeMB) * 1024 * 1024;
+}
+
+std::chrono::milliseconds Configuration::GetUploadInitialBackoff() const {
+  return _uploadInitialBackoff;
+}
+
+std::chrono::milliseconds Configuration::ExtractUploadInitialBackoff() {
+  // delay before retrying a failed upload, doubled for each consecutive failure
+  int32_t backoff = GetEnvironmentValue(
+      EnvironmentVariables::UploadInitialBackoff, DefaultUploadInitialBackoff
+  );
+  if (backoff <= 0) {
+    backoff = DefaultUploadInitialBackoff;
+  }
+
+  return std::chrono::milliseconds(backoff);
+}
+
 std::chrono::seconds Configuration::GetUploadInterval() const { return _uploadPeriod; }
 
 tags const& Configuration::GetUserTags() const { return _userTags; }
@@ -346,6 +494,11 @@ fs::path Configuration::GetDefaultLogDirectoryPath() {
   return baseDirectory / R"(Datadog Tracer\logs)";
 }
 
+fs::path Configuration::GetDefaultUploadSpoolDirectory() {
+  auto baseDirectory = fs::path(GetApmBaseDirectory());
+  return baseDirectory / R"(Datadog Tracer\profiles-spool)";
+}
+
 tags Configuration::ExtractUserTags() {
   return TagsHelper::Parse(
       GetEnvironmentValue(EnvironmentVariables::Tags, DefaultEmptyString)
@@ -515,5 +668,10 @@ bool InitializeConfiguration(Configuration* pConfig, const ProfilerConfig* pSett
     pConfig->EnableSymbolizedCallstacks();
   }
 
+  if (PROFILER_CONFIG_HAS_FIELD(pSettings, disableTimeline) &&
+      pSettings->disableTimeline) {
+    pConfig->SetTimelineEnabled(false);
+  }
+
   return true;
 }
@@ -37,13 +37,29 @@ class Configuration {
   bool IsWallTimeProfilingEnabled() const;
   bool IsExportEnabled() const;
   bool AreCallstacksSymbolized() const;
+  bool IsTimelineEnabled() const;
+  bool IsStackSnapshotEnabled() const;
+  bool IsFramePointerUnwindingEnabled() const;
+  bool IsSamplingJitterEnabled() const;
+  bool IsWalltimeFoldingEnabled() const;
 
   // Manual configuration methods (primarily for testing)
   void SetExportEnabled(bool enabled);
+  void SetTimelineEnabled(bool enabled);
+  void SetStackSnapshotEnabled(bool enabled);
+  void SetFramePointerUnwindingEnabled(bool enabled);
+  void SetSamplingJitterEnabled(bool enabled);
+  void SetWalltimeFoldingEnabled(bool enabled);
 
   std::chrono::nanoseconds CpuWallTimeSamplingPeriod() const;
   int32_t WalltimeThreadsThreshold() const;
   int32_t CpuThreadsThreshold() const;
+  std::chrono::milliseconds GetSuspensionDeadline() const;  // 0 = no watchdog
+  size_t GetMaxMemory() const;                              // in bytes, 0 = no limit
+  size_t GetSymbolCacheSize() const;                        // entries, 0 = no limit
+  fs::path const& GetUploadSpoolDirectory() const;
+  size_t GetUploadSpoolMaxSize() const;  // in bytes, 0 = no spool
+  std::chrono::milliseconds GetUploadInitialBackoff() const;
 
   template <typename T>
   static T GetEnvironmentValue(char const* name, T const& defaultValue);
@@ -69,7 +85,21 @@ class Configuration {
     _walltimeThreadsThreshold = threshold;
   }
   void SetCpuThreadsThreshold(int32_t threshold) { _cpuThreadsThreshold = threshold; }
+  void SetSuspensionDeadline(std::chrono::milliseconds deadline) {
+    _suspensionDeadline = deadline;
+  }
   void SetUploadInterval(std::chrono::seconds interval) { _uploadPeriod = interval; }
+  void SetMaxMemory(size_t maxMemory) { _maxMemory = maxMemory; }
+  void SetSymbolCacheSize(size_t size) { _symbolCacheSize = size; }
+  void SetUploadSpoolDirectory(const fs::path& dir) { _uploadSpoolDirectory = dir; }
+  void SetUploadSpoolMaxSize(size_t maxSize) { _uploadSpoolMaxSize = maxSize; }
+  void SetUploadInitialBackoff(std::chrono::milliseconds backoff) {
+    _uploadInitialBackoff = backoff;
+  }
+  void SetAgentUrl(const std::string& url) {
+    _agentUrl = url;
+    _isAgentLess = false;
+  }
   void SetUserTags(tags userTags) { _userTags = std::move(userTags); }
   void SetProfilesOutputDirectory(const fs::path& dir) { _pprofDirectory = dir; }
 
@@ -90,6 +120,13 @@ class Configuration {
   static std::chrono::nanoseconds ExtractCpuWallTimeSamplingRate();
   static int32_t ExtractWallTimeThreadsThreshold();
   static int32_t ExtractCpuThreadsThreshold();
+  static std::chrono::milliseconds ExtractSuspensionDeadline();
+  static size_t ExtractMaxMemory();
+  static size_t ExtractSymbolCacheSize();
+  static fs::path GetDefaultUploadSpoolDirectory();
+  static fs::path ExtractUploadSpoolDirectory();
+  static size_t ExtractUploadSpoolMaxSize();
+  static std::chrono::milliseconds ExtractUploadInitialBackoff();
 
  private:
   // default values
@@ -111,6 +148,11 @@ class Configuration {
   bool _isWallTimeProfilingEnabled;
   bool _isExportEnabled;
   bool _areCallstacksSymbolized;
+  bool _isTimelineEnabled;
+  bool _isStackSnapshotEnabled;
+  bool _isFramePointerUnwindingEnabled;
+  bool _isSamplingJitterEnabled;
+  bool _isWalltimeFoldingEnabled;
   bool _debugLogEnabled;
   fs::path _logDirectory;
   fs::path _pprofDirectory;
@@ -130,9 +172,20 @@ class Configuration {
   std::chrono::nanoseconds _cpuWallTimeSamplingPeriod;
   int32_t _walltimeThreadsThreshold;
   int32_t _cpuThreadsThreshold;
+  std::chrono::milliseconds _suspensionDeadline;
+  size_t _maxMemory;
+  size_t _symbolCacheSize;
+  fs::path _uploadSpoolDirectory;
+  size_t _uploadSpoolMaxSize;
+  std::chrono::milliseconds _uploadInitialBackoff;
 
   static const uint64_t DefaultSamplingPeriod = 20;
   static const uint64_t MinimumSamplingPeriod = 5;
   static const int32_t DefaultWalltimeThreadsThreshold = 5;
   static const int32_t DefaultCpuThreadsThreshold = 64;
+  static const int32_t DefaultSuspensionDeadline = 200;
+  static const int32_t DefaultMaxMemoryMB = 256;
+  static const int32_t DefaultSymbolCacheSize = 65536;
+  static const int32_t DefaultUploadSpoolMaxSizeMB = 64;
+  static const int32_t DefaultUploadInitialBackoff = 10000;
 };
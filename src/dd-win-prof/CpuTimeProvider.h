@@ -12,11 +12,27 @@ class CpuTimeProvider : public CollectorBase {
  public:
   CpuTimeProvider(SampleValueTypeProvider& valueTypeProvider);
 
-  inline void Add(Sample&& sample, std::chrono::nanoseconds cpuDuration) {
-    auto offsets = GetValueOffsets();
-    sample.AddValue(cpuDuration.count(), offsets[0]);
-    sample.AddValue(1, offsets[1]);
-    CollectorBase::Add(std::move(sample));
+  inline bool Add(
+      std::chrono::nanoseconds timestamp,
+      uint32_t threadId,
+      uint64_t threadGeneration,
+      std::span<const uint64_t> frames,
+      uint32_t rumViewHandle,
+      const TraceContext& traceContext,
+      std::chrono::nanoseconds cpuDuration
+  ) {
+    auto* pSlot = ReserveSample(
+        timestamp, threadId, threadGeneration, frames, rumViewHandle, traceContext
+    );
+    if (pSlot == nullptr) {
+      return false;
+    }
+
+    auto const& offsets = GetValueOffsets();
+    pSlot->values[offsets[0]] = cpuDuration.count();
+    pSlot->values[offsets[1]] = 1;
+    CommitSample();
+    return true;
   }
 
   static std::vector<SampleValueType> SampleTypeDefinitions;
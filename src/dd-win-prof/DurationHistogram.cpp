@@ -0,0 +1,84 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "DurationHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <sstream>
+
+#include "pch.h"
+
+size_t DurationHistogram::GetBucketIndex(std::chrono::nanoseconds duration) {
+  auto us = static_cast<uint64_t>(std::max<int64_t>(0, duration.count()) / 1000);
+
+  // bit_width(0) = 0, bit_width(1) = 1, bit_width(2..3) = 2, ...
+  return std::min<size_t>(std::bit_width(us), BucketsCount - 1);
+}
+
+void DurationHistogram::Record(std::chrono::nanoseconds duration) {
+  _buckets[GetBucketIndex(duration)].fetch_add(1, std::memory_order_relaxed);
+
+  auto ns = static_cast<uint64_t>(std::max<int64_t>(0, duration.count()));
+  _totalNs.fetch_add(ns, std::memory_order_relaxed);
+
+  // single writer: no need for a CAS loop
+  if (ns > _maxNs.load(std::memory_order_relaxed)) {
+    _maxNs.store(ns, std::memory_order_relaxed);
+  }
+}
+
+DurationHistogram::Counts DurationHistogram::GetAndReset() {
+  Counts counts;
+  for (size_t i = 0; i < BucketsCount; i++) {
+    counts.buckets[i] = _buckets[i].exchange(0, std::memory_order_relaxed);
+    counts.count += counts.buckets[i];
+  }
+  counts.total =
+      std::chrono::nanoseconds(_totalNs.exchange(0, std::memory_order_relaxed));
+  counts.max = std::chrono::nanoseconds(_maxNs.exchange(0, std::memory_order_relaxed));
+
+  return counts;
+}
+
+std::string DurationHistogram::ToString(const Counts& counts) {
+  auto toUs = [](std::chrono::nanoseconds duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  };
+
+  std::stringstream builder;
+  builder << "count=" << counts.count;
+  if (counts.count == 0) {
+    return builder.str();
+  }
+
+  builder << " avg=" << toUs(counts.total / counts.count) << "us"
+          << " max=" << toUs(counts.max) << "us [";
+
+  // skip the empty buckets after the last used one
+  size_t lastBucket = 0;
+  for (size_t i = 0; i < BucketsCount; i++) {
+    if (counts.buckets[i] != 0) {
+      lastBucket = i;
+    }
+  }
+
+  for (size_t i = 0; i <= lastBucket; i++) {
+    if (i != 0) {
+      builder << " ";
+    }
+
+    if (i == 0) {
+      builder << "<1us";
+    } else if (i == BucketsCount - 1) {
+      builder << ">=" << (1ull << (i - 1)) << "us";
+    } else {
+      builder << (1ull << (i - 1)) << "-" << (1ull << i) << "us";
+    }
+    builder << ":" << counts.buckets[i];
+  }
+  builder << "]";
+
+  return builder.str();
+}
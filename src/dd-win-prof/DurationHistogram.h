@@ -0,0 +1,49 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "pch.h"
+
+// Power-of-two buckets histogram of durations in microseconds:
+//   bucket 0 counts durations < 1 us, bucket i counts [2^(i-1), 2^i) us
+//   and the last bucket counts everything above.
+// Record() is lock-free and meant to be called by a single thread (e.g. the sampler)
+// while another thread periodically reads and resets the counts.
+class DurationHistogram {
+ public:
+  static constexpr size_t BucketsCount = 20;  // last bucket: >= 262 ms
+
+  struct Counts {
+    std::array<uint64_t, BucketsCount> buckets{};
+    uint64_t count = 0;
+    std::chrono::nanoseconds total{0};
+    std::chrono::nanoseconds max{0};
+  };
+
+ public:
+  DurationHistogram() = default;
+  DurationHistogram(const DurationHistogram&) = delete;
+  DurationHistogram& operator=(const DurationHistogram&) = delete;
+
+  void Record(std::chrono::nanoseconds duration);
+
+  // Return the counts recorded since the last call
+  Counts GetAndReset();
+
+  static size_t GetBucketIndex(std::chrono::nanoseconds duration);
+
+  // e.g. "count=12 avg=3us max=9us [<1us:0 1-2us:4 2-4us:5 4-8us:2 8-16us:1]"
+  static std::string ToString(const Counts& counts);
+
+ private:
+  std::array<std::atomic<uint64_t>, BucketsCount> _buckets{};
+  std::atomic<uint64_t> _totalNs{0};
+  std::atomic<uint64_t> _maxNs{0};
+};
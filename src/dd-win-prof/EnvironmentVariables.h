@@ -14,12 +14,30 @@ class EnvironmentVariables final {
   constexpr static const char* WallTimeProfilingEnabled =
       "DD_PROFILING_WALLTIME_ENABLED";
   constexpr static const char* ExportEnabled = "DD_INTERNAL_PROFILING_EXPORT_ENABLED";
+  constexpr static const char* TimelineEnabled = "DD_PROFILING_TIMELINE_ENABLED";
+  constexpr static const char* MaxMemory = "DD_PROFILING_MAX_MEMORY_MB";
+  constexpr static const char* SymbolCacheSize = "DD_PROFILING_SYMBOL_CACHE_SIZE";
+  constexpr static const char* UploadSpoolDirectory = "DD_PROFILING_UPLOAD_SPOOL_DIR";
+  constexpr static const char* UploadSpoolMaxSize =
+      "DD_PROFILING_UPLOAD_SPOOL_MAX_SIZE_MB";
+  constexpr static const char* UploadInitialBackoff =
+      "DD_INTERNAL_PROFILING_UPLOAD_INITIAL_BACKOFF_MS";
   constexpr static const char* CpuWallTimeSamplingPeriod =
       "DD_INTERNAL_PROFILING_SAMPLING_RATE";
   constexpr static const char* WalltimeThreadsThreshold =
       "DD_INTERNAL_PROFILING_WALLTIME_THREADS_THRESHOLD";
   constexpr static const char* CpuTimeThreadsThreshold =
       "DD_INTERNAL_PROFILING_CPUTIME_THREADS_THRESHOLD";
+  constexpr static const char* StackSnapshotEnabled =
+      "DD_INTERNAL_PROFILING_STACK_SNAPSHOT_ENABLED";
+  constexpr static const char* FramePointerUnwindingEnabled =
+      "DD_INTERNAL_PROFILING_FRAME_POINTER_UNWINDING_ENABLED";
+  constexpr static const char* SuspensionDeadline =
+      "DD_INTERNAL_PROFILING_SUSPENSION_DEADLINE_MS";
+  constexpr static const char* SamplingJitterEnabled =
+      "DD_INTERNAL_PROFILING_SAMPLING_JITTER_ENABLED";
+  constexpr static const char* WalltimeFoldingEnabled =
+      "DD_INTERNAL_PROFILING_WALLTIME_FOLDING_ENABLED";
 
   constexpr static const char* Version = "DD_VERSION";
   constexpr static const char* ServiceName = "DD_SERVICE";
@@ -5,11 +5,18 @@
 #pragma once
 
 #include "Sample.h"
+#include "WakeupSignal.h"
 #include "pch.h"
 
 class ISamplesProvider {
  public:
   virtual ~ISamplesProvider() = default;
-  virtual size_t MoveSamples(std::vector<Sample>& destination) = 0;
+  // append the collected samples to the given batch
+  virtual size_t MoveSamples(SampleBatch& destination) = 0;
+  virtual uint64_t GetDroppedSamplesCount() = 0;
+  // max number of samples waiting to be moved since the previous call
+  virtual size_t GetAndResetPeakPendingCount() = 0;
+  // notify the signal when the samples waiting to be moved reach a high-water mark
+  virtual void SetWakeupSignal(WakeupSignal* pSignal) = 0;
   virtual const char* GetName() = 0;
 };
\ No newline at end of file
@@ -0,0 +1,199 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "IntakeClient.h"
+
+#include "Log.h"
+#include "pch.h"
+
+namespace {
+// The URLs and the headers are ASCII
+std::wstring ToWide(std::string_view s) { return std::wstring(s.begin(), s.end()); }
+}  // namespace
+
+IntakeClient::IntakeClient(
+    std::string url,
+    std::string apiKey,
+    std::string origin,
+    std::string originVersion,
+    std::chrono::milliseconds timeout
+)
+    : _url(std::move(url)),
+      _apiKey(std::move(apiKey)),
+      _origin(std::move(origin)),
+      _originVersion(std::move(originVersion)),
+      _timeout(timeout),
+      _isSecure(false),
+      _hSession(nullptr),
+      _hConnection(nullptr) {}
+
+IntakeClient::~IntakeClient() {
+  if (_hConnection != nullptr) {
+    ::WinHttpCloseHandle(_hConnection);
+  }
+  if (_hSession != nullptr) {
+    ::WinHttpCloseHandle(_hSession);
+  }
+}
+
+bool IntakeClient::Initialize() {
+  auto url = ToWide(_url);
+  URL_COMPONENTS components{};
+  components.dwStructSize = sizeof(components);
+  components.dwHostNameLength = static_cast<DWORD>(-1);
+  components.dwUrlPathLength = static_cast<DWORD>(-1);
+  components.dwExtraInfoLength = static_cast<DWORD>(-1);
+  if (!::WinHttpCrackUrl(url.c_str(), 0, 0, &components) ||
+      ((components.nScheme != INTERNET_SCHEME_HTTP) &&
+       (components.nScheme != INTERNET_SCHEME_HTTPS))) {
+    Log::Warn("Unsupported URL to send the profiles again: ", _url);
+    return false;
+  }
+
+  std::wstring hostName(components.lpszHostName, components.dwHostNameLength);
+  _path.assign(components.lpszUrlPath, components.dwUrlPathLength);
+  _path.append(components.lpszExtraInfo, components.dwExtraInfoLength);
+  _isSecure = (components.nScheme == INTERNET_SCHEME_HTTPS);
+
+  auto userAgent = ToWide(_origin + "/" + _originVersion);
+  _hSession = ::WinHttpOpen(
+      userAgent.c_str(),
+      WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+      WINHTTP_NO_PROXY_NAME,
+      WINHTTP_NO_PROXY_BYPASS,
+      0
+  );
+  if (_hSession == nullptr) {
+    Log::Warn(GetLastErrorMessage("WinHttpOpen"));
+    return false;
+  }
+
+  auto timeoutMs = static_cast<int>(_timeout.count());
+  ::WinHttpSetTimeouts(_hSession, timeoutMs, timeoutMs, timeoutMs, timeoutMs);
+
+  _hConnection = ::WinHttpConnect(_hSession, hostName.c_str(), components.nPort, 0);
+  if (_hConnection == nullptr) {
+    Log::Warn(GetLastErrorMessage("WinHttpConnect"));
+    return false;
+  }
+
+  return true;
+}
+
+bool IntakeClient::Send(
+    const std::string& eventJson,
+    std::span<const uint8_t> profile,
+    uint16_t& responseCode,
+    std::string& error
+) {
+  if (_hConnection == nullptr) {
+    error = "not initialized";
+    return false;
+  }
+
+  auto body = BuildMultipartBody(Boundary, eventJson, profile);
+
+  std::string headers = "Content-Type: multipart/form-data; boundary=";
+  headers += Boundary;
+  headers += "\r\nDD-EVP-ORIGIN: " + _origin;
+  headers += "\r\nDD-EVP-ORIGIN-VERSION: " + _originVersion;
+  if (!_apiKey.empty()) {
+    headers += "\r\nDD-API-KEY: " + _apiKey;
+  }
+  headers += "\r\n";
+  auto wideHeaders = ToWide(headers);
+
+  HINTERNET hRequest = ::WinHttpOpenRequest(
+      _hConnection,
+      L"POST",
+      _path.c_str(),
+      nullptr,
+      WINHTTP_NO_REFERER,
+      WINHTTP_DEFAULT_ACCEPT_TYPES,
+      _isSecure ? WINHTTP_FLAG_SECURE : 0
+  );
+  if (hRequest == nullptr) {
+    error = GetLastErrorMessage("WinHttpOpenRequest");
+    return false;
+  }
+
+  auto bodySize = static_cast<DWORD>(body.size());
+  if (!::WinHttpSendRequest(
+          hRequest,
+          wideHeaders.c_str(),
+          static_cast<DWORD>(-1),
+          body.data(),
+          bodySize,
+          bodySize,
+          0
+      ) ||
+      !::WinHttpReceiveResponse(hRequest, nullptr)) {
+    error = GetLastErrorMessage("Sending the request");
+    ::WinHttpCloseHandle(hRequest);
+    return false;
+  }
+
+  DWORD statusCode = 0;
+  DWORD statusCodeSize = sizeof(statusCode);
+  bool hasStatusCode = ::WinHttpQueryHeaders(
+      hRequest,
+      WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+      WINHTTP_HEADER_NAME_BY_INDEX,
+      &statusCode,
+      &statusCodeSize,
+      WINHTTP_NO_HEADER_INDEX
+  );
+  if (!hasStatusCode) {
+    error = GetLastErrorMessage("WinHttpQueryHeaders");
+  }
+  ::WinHttpCloseHandle(hRequest);
+
+  responseCode = static_cast<uint16_t>(statusCode);
+  return hasStatusCode;
+}
+
+std::string IntakeClient::GetProfilesUrl(bool agentMode, const std::string& urlOrSite) {
+  if (!agentMode) {
+    return "https://intake.profile." + urlOrSite + "/api/v2/profile";
+  }
+
+  auto url = urlOrSite;
+  while (!url.empty() && (url.back() == '/')) {
+    url.pop_back();
+  }
+  return url + "/profiling/v1/input";
+}
+
+std::string IntakeClient::BuildMultipartBody(
+    std::string_view boundary,
+    std::string_view eventJson,
+    std::span<const uint8_t> profile
+) {
+  std::string body;
+  body.reserve(eventJson.size() + profile.size() + 512);
+
+  body += "--";
+  body += boundary;
+  body += "\r\nContent-Disposition: form-data; name=\"event\"; filename=\"event.json\"";
+  body += "\r\nContent-Type: application/json\r\n\r\n";
+  body += eventJson;
+
+  body += "\r\n--";
+  body += boundary;
+  body +=
+      "\r\nContent-Disposition: form-data; name=\"profile.pprof\"; "
+      "filename=\"profile.pprof\"";
+  body += "\r\nContent-Type: application/octet-stream\r\n\r\n";
+  body.append(reinterpret_cast<const char*>(profile.data()), profile.size());
+
+  body += "\r\n--";
+  body += boundary;
+  body += "--\r\n";
+  return body;
+}
+
+std::string IntakeClient::GetLastErrorMessage(const char* operation) {
+  return std::string(operation) + " failed (error " + std::to_string(::GetLastError()) +
+         ")";
+}
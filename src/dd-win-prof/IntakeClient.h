@@ -0,0 +1,74 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <winhttp.h>
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "pch.h"
+
+// HTTP client posting a serialized profile and its event.json to the agent or to the
+// intake, with the same multipart request as libdatadog. It is used to send the
+// profiles again after a failed attempt or from the spool (see UploadQueue): libdatadog
+// can only build a request from the encoded profile it consumes.
+//
+// Only http(s) URLs are supported (not the unix sockets nor the named pipes).
+class IntakeClient {
+ public:
+  IntakeClient(
+      std::string url,     // profiles endpoint (see GetProfilesUrl)
+      std::string apiKey,  // agentless only
+      std::string origin,  // DD-EVP-ORIGIN header, as given to libdatadog
+      std::string originVersion,
+      std::chrono::milliseconds timeout
+  );
+  ~IntakeClient();
+
+  IntakeClient(const IntakeClient&) = delete;
+  IntakeClient& operator=(const IntakeClient&) = delete;
+
+  bool Initialize();
+  const std::string& GetUrl() const { return _url; }
+
+  // false if the request could not be sent or no response was received; otherwise
+  // the HTTP status of the response is returned in responseCode
+  bool Send(
+      const std::string& eventJson,
+      std::span<const uint8_t> profile,
+      uint16_t& responseCode,
+      std::string& error
+  );
+
+  // Profiles endpoint of the agent (base URL) or of the intake (site), like libdatadog
+  static std::string GetProfilesUrl(bool agentMode, const std::string& urlOrSite);
+
+  static std::string BuildMultipartBody(
+      std::string_view boundary,
+      std::string_view eventJson,
+      std::span<const uint8_t> profile
+  );
+
+ private:
+  static std::string GetLastErrorMessage(const char* operation);
+
+ private:
+  static constexpr const char* Boundary = "dd-win-prof-7f8e2c3b9a4d41e6";
+
+  const std::string _url;
+  const std::string _apiKey;
+  const std::string _origin;
+  const std::string _originVersion;
+  const std::chrono::milliseconds _timeout;
+
+  std::wstring _path;
+  bool _isSecure;
+  HINTERNET _hSession;
+  HINTERNET _hConnection;
+};
@@ -0,0 +1,110 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "MemoryBudget.h"
+
+#include <sstream>
+
+#include "pch.h"
+
+MemoryBudget::MemoryBudget(size_t maxBytes)
+    : _maxBytes(maxBytes), _pressure(MemoryPressure::None), _droppedSamplesCount(0) {}
+
+void MemoryBudget::SetUsage(MemoryStage stage, size_t bytes) {
+  _usages[static_cast<size_t>(stage)].store(bytes, std::memory_order_relaxed);
+
+  // concurrent reports might compute the pressure from slightly different totals:
+  // the next report fixes it
+  _pressure.store(
+      ComputePressure(GetTotalUsage(), _maxBytes), std::memory_order_relaxed
+  );
+}
+
+size_t MemoryBudget::GetUsage(MemoryStage stage) const {
+  return _usages[static_cast<size_t>(stage)].load(std::memory_order_relaxed);
+}
+
+size_t MemoryBudget::GetTotalUsage() const {
+  size_t total = 0;
+  for (const auto& usage : _usages) {
+    total += usage.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+void MemoryBudget::CountDroppedSamples(uint64_t count) {
+  _droppedSamplesCount.fetch_add(count, std::memory_order_relaxed);
+}
+
+uint64_t MemoryBudget::GetDroppedSamplesCount() const {
+  return _droppedSamplesCount.load(std::memory_order_relaxed);
+}
+
+MemoryPressure MemoryBudget::ComputePressure(size_t usage, size_t maxBytes) {
+  if (maxBytes == 0) {
+    return MemoryPressure::None;
+  }
+
+  // in percents of the budget (no overflow for any realistic usage)
+  auto scaledUsage = static_cast<uint64_t>(usage) * 100;
+  auto budget = static_cast<uint64_t>(maxBytes);
+  if (scaledUsage >= 100 * budget) {
+    return MemoryPressure::DropSamples;
+  }
+  if (scaledUsage >= 85 * budget) {
+    return MemoryPressure::ReduceSampling;
+  }
+  if (scaledUsage >= 70 * budget) {
+    return MemoryPressure::DropTimestamps;
+  }
+  return MemoryPressure::None;
+}
+
+const char* MemoryBudget::ToString(MemoryStage stage) {
+  switch (stage) {
+    case MemoryStage::SampleRings:
+      return "sample_rings";
+    case MemoryStage::ActiveProfile:
+      return "active_profile";
+    case MemoryStage::RetiredProfile:
+      return "retired_profile";
+    case MemoryStage::SymbolCache:
+      return "symbol_cache";
+    case MemoryStage::UploadQueue:
+      return "upload_queue";
+    default:
+      return "unknown";
+  }
+}
+
+const char* MemoryBudget::ToString(MemoryPressure pressure) {
+  switch (pressure) {
+    case MemoryPressure::None:
+      return "none";
+    case MemoryPressure::DropTimestamps:
+      return "drop_timestamps";
+    case MemoryPressure::ReduceSampling:
+      return "reduce_sampling";
+    case MemoryPressure::DropSamples:
+      return "drop_samples";
+    default:
+      return "unknown";
+  }
+}
+
+std::string MemoryBudget::ToJson() const {
+  std::ostringstream ss;
+  ss << "{\"budget_bytes\":" << _maxBytes
+     << ",\"usage_bytes\":" << GetTotalUsage() << ",\"pressure\":\""
+     << ToString(GetPressure()) << "\",\"dropped_samples\":" << GetDroppedSamplesCount()
+     << ",\"stages\":{";
+  for (size_t i = 0; i < StagesCount; i++) {
+    if (i > 0) {
+      ss << ',';
+    }
+    ss << '"' << ToString(static_cast<MemoryStage>(i)) << "\":" << _usages[i].load();
+  }
+  ss << "}}";
+  return ss.str();
+}
@@ -0,0 +1,77 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "pch.h"
+
+// Stages of the samples pipeline whose memory is accounted
+enum class MemoryStage : uint32_t {
+  SampleRings,     // rings of the providers (fixed size)
+  ActiveProfile,   // pre-aggregated samples of the profile being filled
+  RetiredProfile,  // pre-aggregated samples of the profile being exported
+  SymbolCache,     // symbolication results kept across exports
+  UploadQueue,     // serialized profiles waiting to be uploaded
+  Count
+};
+
+// Degradation applied while the usage is above a ratio of the budget; each level
+// includes the previous ones
+enum class MemoryPressure : uint32_t {
+  None = 0,
+  DropTimestamps = 1,  // >= 70%: new samples are aggregated without timestamp
+  ReduceSampling = 2,  // >= 85%: one sampling tick out of two is skipped
+  DropSamples = 3,     // >= 100%: samples with a new callstack or labels are dropped
+};
+
+// Memory budget of the samples pipeline (DD_PROFILING_MAX_MEMORY_MB). Each stage
+// reports its usage from its own thread; the pressure is recomputed at each report and
+// read without lock by the sampler and the exporter. The usage is an estimate based
+// on the capacity of the containers: the memory of the libdatadog profile built at
+// export time is not included.
+class MemoryBudget {
+ public:
+  // 0 means unlimited: the usage is still accounted but the pressure stays None
+  explicit MemoryBudget(size_t maxBytes);
+
+  MemoryBudget(const MemoryBudget&) = delete;
+  MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+  void SetUsage(MemoryStage stage, size_t bytes);
+  size_t GetUsage(MemoryStage stage) const;
+  size_t GetTotalUsage() const;
+  inline size_t GetMaxBytes() const { return _maxBytes; }
+
+  inline MemoryPressure GetPressure() const {
+    return _pressure.load(std::memory_order_relaxed);
+  }
+  inline bool IsAtLeast(MemoryPressure pressure) const {
+    return GetPressure() >= pressure;
+  }
+
+  // samples dropped because of the DropSamples pressure
+  void CountDroppedSamples(uint64_t count);
+  uint64_t GetDroppedSamplesCount() const;
+
+  static MemoryPressure ComputePressure(size_t usage, size_t maxBytes);
+  static const char* ToString(MemoryStage stage);
+  static const char* ToString(MemoryPressure pressure);
+
+  // e.g. {"budget_bytes":268435456,"usage_bytes":1024,"pressure":"none",
+  //   "dropped_samples":0,"stages":{"sample_rings":1024,...}}
+  std::string ToJson() const;
+
+ private:
+  static constexpr size_t StagesCount = static_cast<size_t>(MemoryStage::Count);
+
+  const size_t _maxBytes;
+  std::array<std::atomic<size_t>, StagesCount> _usages{};
+  std::atomic<MemoryPressure> _pressure;
+  std::atomic<uint64_t> _droppedSamplesCount;
+};
@@ -0,0 +1,52 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "NameTable.h"
+
+#include <mutex>
+
+#include "pch.h"
+
+NameTable::NameTable() {
+  _names.emplace_back();
+  _nameIds.emplace(_names.back(), UnnamedId);
+}
+
+bool NameTable::TryIntern(std::string_view name, uint32_t& nameId) {
+  {
+    std::shared_lock<std::shared_mutex> lock(_namesMutex);
+    auto it = _nameIds.find(name);
+    if (it != _nameIds.end()) {
+      nameId = it->second;
+      return true;
+    }
+  }
+
+  std::unique_lock<std::shared_mutex> lock(_namesMutex);
+  auto it = _nameIds.find(name);
+  if (it != _nameIds.end()) {
+    nameId = it->second;
+    return true;
+  }
+
+  if (_names.size() >= MaxNamesCount) {
+    return false;
+  }
+
+  nameId = static_cast<uint32_t>(_names.size());
+  _names.emplace_back(name);
+  _nameIds.emplace(_names.back(), nameId);
+  return true;
+}
+
+std::string_view NameTable::GetName(uint32_t nameId) const {
+  std::shared_lock<std::shared_mutex> lock(_namesMutex);
+  return (nameId < _names.size()) ? std::string_view(_names[nameId])
+                                  : std::string_view();
+}
+
+size_t NameTable::Count() const {
+  std::shared_lock<std::shared_mutex> lock(_namesMutex);
+  return _names.size();
+}
@@ -0,0 +1,49 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "pch.h"
+
+// Interned names: each distinct name gets a small id so that a thread can publish its
+// current name (or the endpoint of its trace context) with a single atomic store, and
+// the exporter can read it without copying the string.
+// The names are never removed: the threads of a pool share the same few names and an
+// application has a bounded set of endpoints. The table stops growing after
+// MaxNamesCount names.
+//
+// Thread names are interned by the thread names refresher (see
+// ThreadList::RefreshThreadNames), trace endpoints by the threads that publish their
+// trace context (see TraceEndpoints); both are looked up by the exporter.
+class NameTable {
+ public:
+  // id of the empty name, for the threads without a name (or spans without endpoint)
+  static constexpr uint32_t UnnamedId = 0;
+  static constexpr size_t MaxNamesCount = 4096;
+
+ public:
+  NameTable();
+
+  // Return false if the table is full and the name is not already known
+  bool TryIntern(std::string_view name, uint32_t& nameId);
+
+  // The view stays valid as long as the table; empty for an unknown id
+  std::string_view GetName(uint32_t nameId) const;
+
+  size_t Count() const;
+
+ private:
+  mutable std::shared_mutex _namesMutex;
+
+  // index = id; the strings are never moved when the deque grows
+  std::deque<std::string> _names;
+  std::unordered_map<std::string_view, uint32_t> _nameIds;
+};
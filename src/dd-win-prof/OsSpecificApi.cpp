@@ -116,7 +116,7 @@ bool InitializeNtQueryInformationThreadCallback() {
   return true;
 }
 
-bool IsRunning(ULONG threadState) {
+bool IsRunningThreadState(ULONG threadState) {
   return (THREAD_STATE::Running == threadState) ||
          (THREAD_STATE::DeferredReady == threadState) ||
          (THREAD_STATE::Standby == threadState);
@@ -127,6 +127,10 @@ bool IsRunning(ULONG threadState) {
   // return true only for Running state
 }
 
+bool IsWaitingThreadState(ULONG threadState) {
+  return (THREAD_STATE::Waiting == threadState);
+}
+
 // internal helper to call NtQueryInformationThread undocumented API
 bool QueryInformationThread(HANDLE hThread, SYSTEM_THREAD_INFORMATION& sti) {
   if (NtQueryInformationThread == nullptr) {
@@ -161,7 +165,7 @@ std::tuple<bool, std::chrono::milliseconds, bool> IsRunning(HANDLE hThread) {
       GetTotalMilliseconds(sti.UserTime) + GetTotalMilliseconds(sti.KernelTime)
   );
 
-  return {IsRunning(sti.ThreadState), cpuTime, false};
+  return {IsRunningThreadState(sti.ThreadState), cpuTime, false};
 }
 
 std::tuple<bool, ULONG, bool> IsWaiting(HANDLE hThread) {
@@ -170,7 +174,7 @@ std::tuple<bool, ULONG, bool> IsWaiting(HANDLE hThread) {
     return {false, 0xFFFF, true};
   }
 
-  return {(sti.ThreadState == THREAD_STATE::Waiting), sti.ThreadWaitReason, false};
+  return {IsWaitingThreadState(sti.ThreadState), sti.ThreadWaitReason, false};
 }
 
 uint32_t GetProcessorCount() {
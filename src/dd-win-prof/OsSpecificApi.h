@@ -15,6 +15,10 @@ std::tuple<bool, std::chrono::milliseconds, bool> IsRunning(HANDLE hThread);
 //    isRunning,  wait reason,        failed
 std::tuple<bool, ULONG, bool> IsWaiting(HANDLE hThread);
 
+// from the ThreadState field of SYSTEM_THREAD_INFORMATION
+bool IsRunningThreadState(ULONG threadState);
+bool IsWaitingThreadState(ULONG threadState);
+
 uint32_t GetProcessorCount();
 
 std::string GetCpuVendor();
@@ -173,6 +173,41 @@ bool PprofAggregator::AddSample(
   return true;
 }
 
+bool PprofAggregator::AddEndpoint(uint64_t localRootSpanId, std::string_view endpoint) {
+  if (!m_initialized) {
+    m_lastError = "PprofAggregator not initialized";
+    return false;
+  }
+
+  auto result = ddog_prof_Profile_set_endpoint(
+      &m_profile, localRootSpanId, to_CharSlice(endpoint)
+  );
+  if (result.tag != DDOG_PROF_PROFILE_RESULT_OK) {
+    m_lastError = "Failed to set endpoint";
+    Log::Error("AddEndpoint failed: ", m_lastError, " (tag: ", result.tag, ")");
+    return false;
+  }
+
+  return true;
+}
+
+bool PprofAggregator::AddEndpointCount(std::string_view endpoint, int64_t value) {
+  if (!m_initialized) {
+    m_lastError = "PprofAggregator not initialized";
+    return false;
+  }
+
+  auto result =
+      ddog_prof_Profile_add_endpoint_count(&m_profile, to_CharSlice(endpoint), value);
+  if (result.tag != DDOG_PROF_PROFILE_RESULT_OK) {
+    m_lastError = "Failed to add endpoint count";
+    Log::Error("AddEndpointCount failed: ", m_lastError, " (tag: ", result.tag, ")");
+    return false;
+  }
+
+  return true;
+}
+
 std::vector<ddog_prof_ValueType> PprofAggregator::ConvertSampleValueTypes(
     std::span<const SampleValueType> sampleValueTypes
 ) {
@@ -10,6 +10,7 @@
 #include <memory>
 #include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "SampleValueType.h"
@@ -101,10 +102,25 @@ class PprofAggregator {
   /// <returns>Pointer to the internal profile, or nullptr if not initialized</returns>
   ddog_prof_Profile* GetProfile() { return m_initialized ? &m_profile : nullptr; }
 
+  /// <summary>
+  /// Associates an endpoint to a local root span: libdatadog adds the "trace endpoint"
+  /// label to the samples having the "local root span id" label with this value
+  /// </summary>
+  /// <param name="localRootSpanId">Id of the local root span</param>
+  /// <param name="endpoint">Endpoint of the local root span</param>
+  /// <returns>True if the endpoint was added successfully, false otherwise</returns>
+  bool AddEndpoint(uint64_t localRootSpanId, std::string_view endpoint);
+
+  /// <summary>
+  /// Adds to the number of times an endpoint was called during the profile
+  /// </summary>
+  /// <param name="endpoint">Endpoint of the local root spans</param>
+  /// <param name="value">Number of local root spans to add</param>
+  /// <returns>True if the count was added successfully, false otherwise</returns>
+  bool AddEndpointCount(std::string_view endpoint, int64_t value);
+
   // TODO: Future methods for adding samples will be added here
   // - AddSample(const StackTrace& stackTrace, const std::vector<int64_t>& values, ...)
-  // - AddEndpoint(uint64_t localRootSpanId, const std::string& endpoint)
-  // - AddEndpointCount(const std::string& endpoint, int64_t value)
 
  private:
   /// <summary>
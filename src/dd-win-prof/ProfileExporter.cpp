@@ -31,7 +31,11 @@ using namespace OsSpecificApi;
 ProfileExporter::ProfileExporter(
     Configuration* pConfiguration,
     std::span<const SampleValueType> sampleTypeDefinitions,
-    IRumRecordProvider* pRumRecordProvider
+    IRumRecordProvider* pRumRecordProvider,
+    ThreadList* pThreadList,
+    const RumViewRegistry* pRumViewRegistry,
+    TraceEndpoints* pTraceEndpoints,
+    MemoryBudget* pMemoryBudget
 )
     : _pConfiguration(pConfiguration),
       _sampleTypeDefinitions{
@@ -39,14 +43,27 @@ ProfileExporter::ProfileExporter(
       },
       _initialized(false),
       _processId{0},
+      _isRetiredProfilePending(false),
+      _isTimelineEnabled(true),
+      // unlimited without configuration
+      _persistentSymbolCache(
+          (pConfiguration != nullptr) ? pConfiguration->GetSymbolCacheSize() : 0
+      ),
+      _symbolRanges(
+          (pConfiguration != nullptr) ? pConfiguration->GetSymbolCacheSize() : 0
+      ),
       _currentExportId(0),
       _debugPprofFileWritingEnabled(false),
       _debugPprofPrefix(""),
       _exportEnabled(false),
       _exporter(nullptr),
       _agentMode(true),
-      _consecutiveErrors(0),
-      _pRumRecordProvider(pRumRecordProvider) {
+      _pRumRecordProvider(pRumRecordProvider),
+      _pThreadList(pThreadList),
+      _pRumViewRegistry(pRumViewRegistry),
+      _pTraceEndpoints(pTraceEndpoints),
+      _pMemoryBudget(pMemoryBudget),
+      _memoryPressure(MemoryPressure::None) {
   _runtimeId = ComputeRuntimeId();
 
   _kProfilerVersion = PROFILER_VERSION_STRING;
@@ -54,6 +71,8 @@ ProfileExporter::ProfileExporter(
 
   // Configure debug output from Configuration
   if (_pConfiguration != nullptr) {
+    _isTimelineEnabled = _pConfiguration->IsTimelineEnabled();
+
     auto outputDir = _pConfiguration->GetProfilesOutputDirectory();
     if (!outputDir.empty()) {
       // ensure the output directory exists
@@ -96,6 +115,26 @@ void ProfileExporter::Cleanup(bool skipExporterCleanup) {
 
   Log::Debug("Starting exporter cleanup, skipExporterCleanup=", skipExporterCleanup);
 
+  // The pending profiles can only be sent while the exporter is still alive; the ones
+  // that are not sent are spooled
+  if (_pUploadQueue != nullptr) {
+    _pUploadQueue->Stop(!skipExporterCleanup);
+    Log::Debug(
+        "Upload queue stopped: ",
+        _pUploadQueue->GetSentCount(),
+        " profiles sent, ",
+        _pUploadQueue->GetFailedCount(),
+        " failed, ",
+        _pUploadQueue->GetSpooledCount(),
+        " spooled, ",
+        _pUploadQueue->GetDiscardedCount(),
+        " discarded"
+    );
+    _pUploadQueue.reset();
+  }
+  _pUploadSpool.reset();
+  _pIntakeClient.reset();
+
   // Clean up exporter first if not skipping
   if (!skipExporterCleanup) {
     CleanupExporter();
@@ -135,26 +174,20 @@ bool ProfileExporter::Initialize() {
       return false;
     }
 
-    // Initialize PprofAggregator directly with SampleValueType (no enum conversion
-    // needed)
-    _aggregator = std::make_unique<dd_win_prof::PprofAggregator>(
-        _sampleTypeDefinitions, _stringStorage, 10
-    );
-
-    if (!_aggregator->IsInitialized()) {
-      _lastError =
-          "Failed to initialize PprofAggregator: " + _aggregator->GetLastError();
+    // Two profile generations are needed so that one can be exported while samples
+    // keep being added to the other one
+    _activeProfile = CreateProfileGeneration();
+    if (_activeProfile == nullptr) {
       return false;
     }
-
-    // Intern sample labels that will be reused across samples
-    if (!InternSampleLabels(_sampleLabels)) {
-      _lastError = "Failed to intern sample labels";
+    _retiredProfile = CreateProfileGeneration();
+    if (_retiredProfile == nullptr) {
       return false;
     }
+    _isRetiredProfilePending = false;
 
     // Set the profile start time
-    _profileStartTime = std::chrono::system_clock::now();
+    _activeProfile->startTime = std::chrono::system_clock::now();
 
     // Log debug output configuration
     if (_debugPprofFileWritingEnabled) {
@@ -167,6 +200,18 @@ bool ProfileExporter::Initialize() {
         _lastError = "Failed to initialize exporter: " + _lastError;
         return false;
       }
+      CreateUploadSpool();
+      auto initialBackoff = (_pConfiguration != nullptr)
+                                ? _pConfiguration->GetUploadInitialBackoff()
+                                : UploadQueue::DefaultInitialBackoff;
+      _pUploadQueue = std::make_unique<UploadQueue>(
+          this,
+          UploadQueue::DefaultCapacity,
+          initialBackoff,
+          UploadQueue::DefaultMaxBackoff,
+          _pUploadSpool.get()
+      );
+      _pUploadQueue->Start();
       Log::Info(
           "Profiles export enabled, mode: ",
           (_agentMode ? "agent" : "agentless"),
@@ -185,71 +230,492 @@ bool ProfileExporter::Initialize() {
   }
 }
 
-bool ProfileExporter::Add(std::shared_ptr<Sample> const& sample) {
+std::unique_ptr<ProfileExporter::ProfileGeneration>
+ProfileExporter::CreateProfileGeneration() {
+  auto generation = std::make_unique<ProfileGeneration>(
+      _sampleTypeDefinitions.size(), _isTimelineEnabled
+  );
+
+  // Initialize PprofAggregator directly with SampleValueType (no enum conversion
+  // needed)
+  generation->aggregator = std::make_unique<dd_win_prof::PprofAggregator>(
+      _sampleTypeDefinitions, _stringStorage, 10
+  );
+
+  if (!generation->aggregator->IsInitialized()) {
+    _lastError = "Failed to initialize PprofAggregator: " +
+                 generation->aggregator->GetLastError();
+    return nullptr;
+  }
+
+  // Intern sample labels that will be reused across samples
+  if (!InternSampleLabels(
+          generation->aggregator->GetProfile(), generation->sampleLabels
+      )) {
+    _lastError = "Failed to intern sample labels";
+    return nullptr;
+  }
+
+  return generation;
+}
+
+bool ProfileExporter::ResetProfileGeneration(ProfileGeneration& generation) {
+  // Reset the aggregator for next collection cycle
+  generation.aggregator->Reset();
+
+  // Clear per-profile caches since location and mapping IDs become invalid after
+  // profile reset
+  generation.locationCache.clear();
+  generation.mappingCache.clear();
+  generation.functionCache.clear();
+  generation.labelSetCache.clear();
+  generation.rumViews.clear();
+  generation.localRootSpanEndpoints.clear();
+
+  // give the memory back instead of keeping it for the next profile when the budget
+  // is tight
+  bool releaseMemory = (_pMemoryBudget != nullptr) &&
+                       _pMemoryBudget->IsAtLeast(MemoryPressure::DropTimestamps);
+  generation.samples.Clear(releaseMemory);
+  generation.internedEntries.clear();
+  generation.locationIds.clear();
+
+  // Re-intern sample labels since they become invalid after profile reset
+  if (!InternSampleLabels(
+          generation.aggregator->GetProfile(), generation.sampleLabels
+      )) {
+    Log::Error("Failed to re-intern sample labels after reset");
+    // Continue anyway - this will cause Add() calls to fail but won't crash
+    return false;
+  }
+
+  return true;
+}
+
+bool ProfileExporter::Add(const Sample& sample) {
   if (!_initialized) {
     LogOnce(Error, "Trying to add sample but exporter is not initialized");
     return false;
   }
 
-  // Convert callstack addresses to LocationIds
-  std::vector<ddog_prof_LocationId> locationIds;
-  std::span<const uint64_t> callstack = sample->GetFrames();
-  locationIds.reserve(callstack.size());
+  std::span<const int64_t> sampleValues = sample.GetValues();
+  if (sampleValues.size() != _sampleTypeDefinitions.size()) {
+    LogOnce(
+        Error,
+        "Failed to add sample: ",
+        sampleValues.size(),
+        " values for ",
+        _sampleTypeDefinitions.size(),
+        " sample types"
+    );
+    return false;
+  }
+
+  // Samples always go to the active generation where they are only folded with the
+  // ones having the same callstack and labels: interning them into the pprof profile
+  // is done once per unique entry when the profile is exported.
+  // Folded walltime samples are keyed by their thread group instead of their thread
+  // id: the id is only used to find the name of the group.
+  bool isFolded = (sample.GetFoldedThreadsCount() > 0);
+  auto& table = _activeProfile->samples;
+  auto droppedSamplesCount = table.GetDroppedSamplesCount();
+  auto* pNewEntry = table.Add(
+      sample.GetFrames(),
+      sampleValues,
+      isFolded ? 0 : sample.GetThreadId(),
+      sample.GetRumViewHandle(),
+      sample.GetTimestamp(),
+      sample.GetThreadGroup(),
+      sample.GetTraceContext()
+  );
+
+  // new callstack or new labels while the memory budget is exceeded
+  if (table.GetDroppedSamplesCount() != droppedSamplesCount) {
+    return false;
+  }
+
+  // keep the thread alive with its new callstacks so that its name is still available
+  // at export time even if it exits in between. If the thread id has been reused by a
+  // new thread since the sample was taken, the name is unknown.
+  if ((pNewEntry != nullptr) && (_pThreadList != nullptr)) {
+    auto threadGeneration = sample.GetThreadGeneration();
+    pNewEntry->threadInfo =
+        (threadGeneration != 0)
+            ? _pThreadList->FindThread(sample.GetThreadId(), threadGeneration)
+            : _pThreadList->FindThread(sample.GetThreadId());
+  }
+
+  if (pNewEntry != nullptr) {
+    ResolveRumView(*_activeProfile, sample.GetRumViewHandle());
+
+    const auto& traceContext = sample.GetTraceContext();
+    if ((traceContext.localRootSpanId != 0) &&
+        (traceContext.endpointId != TraceEndpoints::NoEndpoint)) {
+      _activeProfile->localRootSpanEndpoints.try_emplace(
+          traceContext.localRootSpanId, traceContext.endpointId
+      );
+    }
+  }
+
+  return true;
+}
+
+void ProfileExporter::ResolveRumView(
+    ProfileGeneration& generation, uint32_t rumViewHandle
+) {
+  if ((rumViewHandle == RumViewRegistry::NoView) || (_pRumViewRegistry == nullptr)) {
+    return;
+  }
+
+  // the strings are copied once per view and per profile: the view record might be
+  // overwritten in the registry before the profile is exported
+  auto [it, isNew] = generation.rumViews.try_emplace(rumViewHandle);
+  if (isNew && !_pRumViewRegistry->Resolve(rumViewHandle, it->second)) {
+    LogOnce(Debug, "RUM view ", rumViewHandle, " not found: no view labels");
+  }
+}
+
+void ProfileExporter::AddTraceEndpoints(ProfileGeneration& generation) {
+  if (_pTraceEndpoints == nullptr) {
+    return;
+  }
+
+  // libdatadog adds the endpoint label to the samples of each local root span
+  for (const auto& [localRootSpanId, endpointId] : generation.localRootSpanEndpoints) {
+    generation.aggregator->AddEndpoint(
+        localRootSpanId, _pTraceEndpoints->GetEndpoint(endpointId)
+    );
+  }
+
+  // the local root spans started since the previous export
+  _pTraceEndpoints->ConsumeCounts(_endpointCountsBuffer);
+  for (const auto& [endpointId, count] : _endpointCountsBuffer) {
+    generation.aggregator->AddEndpointCount(
+        _pTraceEndpoints->GetEndpoint(endpointId), count
+    );
+  }
+}
+
+size_t ProfileExporter::Add(std::span<const Sample> samples) {
+  bool isBudgeted = _initialized && (_pMemoryBudget != nullptr);
+  uint64_t droppedSamplesCount = 0;
+  if (isBudgeted) {
+    ApplyMemoryPressure(*_activeProfile);
+    droppedSamplesCount = _activeProfile->samples.GetDroppedSamplesCount();
+  }
+
+  size_t addedCount = 0;
+  for (const auto& sample : samples) {
+    if (Add(sample)) {
+      addedCount++;
+    }
+  }
+
+  if (isBudgeted) {
+    const auto& table = _activeProfile->samples;
+    _pMemoryBudget->CountDroppedSamples(
+        table.GetDroppedSamplesCount() - droppedSamplesCount
+    );
+    _pMemoryBudget->SetUsage(MemoryStage::ActiveProfile, table.GetMemorySize());
+  }
+
+  return addedCount;
+}
+
+void ProfileExporter::ApplyMemoryPressure(ProfileGeneration& generation) {
+  auto pressure = _pMemoryBudget->GetPressure();
+  if (pressure != _memoryPressure) {
+    Log::Info(
+        "Memory pressure changed from ",
+        MemoryBudget::ToString(_memoryPressure),
+        " to ",
+        MemoryBudget::ToString(pressure),
+        ": ",
+        _pMemoryBudget->GetTotalUsage(),
+        " bytes used for a budget of ",
+        _pMemoryBudget->GetMaxBytes(),
+        " bytes"
+    );
+    _memoryPressure = pressure;
+  }
+
+  // the levels are cumulative; the sampling rate is reduced by StackSamplerLoop
+  auto& table = generation.samples;
+  table.SetTimelineSuspended(pressure >= MemoryPressure::DropTimestamps);
+
+  // the known callstacks still receive their values but no entry is created
+  size_t maxEntriesCount = 0;
+  if (pressure >= MemoryPressure::DropSamples) {
+    maxEntriesCount = (std::max)(table.GetEntriesCount(), size_t{1});
+  }
+  table.SetMaxEntriesCount(maxEntriesCount);
+}
+
+void ProfileExporter::ReportExportMemoryUsage(const ProfileGeneration& generation) {
+  if (_pMemoryBudget == nullptr) {
+    return;
+  }
+
+  _pMemoryBudget->SetUsage(
+      MemoryStage::RetiredProfile, generation.samples.GetMemorySize()
+  );
+
+  // the strings of the symbols are stored by libdatadog: only the caches are accounted
+  _pMemoryBudget->SetUsage(
+      MemoryStage::SymbolCache,
+      _persistentSymbolCache.GetMemorySize() + _symbolRanges.GetMemorySize()
+  );
+
+  // refreshed at each export only: the profiles are sent by another thread
+  if (_pUploadQueue != nullptr) {
+    _pMemoryBudget->SetUsage(MemoryStage::UploadQueue, _pUploadQueue->GetPendingSize());
+  }
+}
+
+std::string ProfileExporter::SerializeInfoToJson() const {
+  // libdatadog stores it in the `info` field of the profile's event.json
+  std::string json = "{\"profiler\":{";
+  if (_pMemoryBudget != nullptr) {
+    json += "\"memory\":" + _pMemoryBudget->ToJson() + ",";
+  }
+  json += "\"symbol_cache\":" + _persistentSymbolCache.ToJson() + ",";
+  json += "\"symbol_ranges\":" + _symbolRanges.ToJson() + "}}";
+  return json;
+}
+
+bool ProfileExporter::InternAggregatedEntries(ProfileGeneration& generation) {
+  const auto& table = generation.samples;
+  auto& internedEntries = generation.internedEntries;
+  auto& locationIds = generation.locationIds;
+  internedEntries.clear();
+  locationIds.clear();
+  generation.createdLabelSetsCount = 0;
+
+  bool hasValidEntries = false;
+  for (const auto& entry : table.GetEntries()) {
+    auto& interned = internedEntries.emplace_back();
+    interned.locationsOffset = static_cast<uint32_t>(locationIds.size());
+    interned.locationsCount = 0;
+    interned.isValid = false;
+
+    // Convert callstack addresses to LocationIds
+    bool success = true;
+    for (uint64_t address : table.GetFrames(entry)) {
+      auto locationIdOpt = InternLocation(generation, address);
+      if (!locationIdOpt.has_value()) {
+        LogOnce(
+            Error,
+            "Failed to intern location for address 0x",
+            std::hex,
+            address,
+            std::dec,
+            " when flushing samples"
+        );
+        success = false;
+        break;
+      }
+      locationIds.push_back(locationIdOpt.value());
+    }
+    if (!success) {
+      locationIds.resize(interned.locationsOffset);
+      continue;
+    }
+
+    // Create labelset for this entry (includes thread name and RUM labels if available)
+    interned.locationsCount =
+        static_cast<uint32_t>(locationIds.size() - interned.locationsOffset);
+    interned.labelsetId = GetOrCreateLabelSet(generation, entry);
+    interned.isValid = true;
+    hasValidEntries = true;
+  }
+
+  return hasValidEntries;
+}
+
+size_t ProfileExporter::FlushAggregatedSamples(ProfileGeneration& generation) {
+  if (!InternAggregatedEntries(generation)) {
+    return 0;
+  }
+
+  const auto& table = generation.samples;
+  const auto& internedEntries = generation.internedEntries;
+  auto getLocations = [&generation](const ProfileGeneration::InternedEntry& interned) {
+    return std::span<const ddog_prof_LocationId>(
+        generation.locationIds.data() + interned.locationsOffset,
+        interned.locationsCount
+    );
+  };
+
+  size_t flushedCount = 0;
+  if (table.IsTimelineEnabled()) {
+    // one pprof sample per recorded sample to keep the timestamps
+    const auto& timedSamples = table.GetTimedSamples();
+    for (size_t i = 0; i < timedSamples.size(); i++) {
+      const auto& interned = internedEntries[timedSamples[i].entryIndex];
+      if (!interned.isValid) {
+        continue;
+      }
+
+      if (!generation.aggregator->AddSample(
+              getLocations(interned),
+              table.GetTimedValues(i),
+              timedSamples[i].timestamp,
+              interned.labelsetId
+          )) {
+        LogOnce(
+            Error,
+            "Failed to add sample to aggregator: ",
+            generation.aggregator->GetLastError()
+        );
+        continue;
+      }
+
+      flushedCount++;
+    }
+
+    // the samples added while the timeline was suspended under memory pressure are
+    // summed per entry, without timestamp
+    if (!table.HasUntimedSamples()) {
+      return flushedCount;
+    }
+
+    for (size_t i = 0; i < internedEntries.size(); i++) {
+      const auto& interned = internedEntries[i];
+      auto untimedValues = table.GetUntimedValues(i);
+      if (!interned.isValid || untimedValues.empty() ||
+          std::all_of(untimedValues.begin(), untimedValues.end(), [](int64_t value) {
+            return value == 0;
+          })) {
+        continue;
+      }
+
+      if (!generation.aggregator->AddSample(
+              getLocations(interned), untimedValues, 0, interned.labelsetId
+          )) {
+        LogOnce(
+            Error,
+            "Failed to add sample to aggregator: ",
+            generation.aggregator->GetLastError()
+        );
+        continue;
+      }
+
+      flushedCount++;
+    }
+
+    return flushedCount;
+  }
+
+  // one pprof sample per entry: aggregated samples don't have a timestamp
+  for (size_t i = 0; i < internedEntries.size(); i++) {
+    const auto& interned = internedEntries[i];
+    if (!interned.isValid) {
+      continue;
+    }
 
-  for (size_t i = 0; i < callstack.size(); ++i) {
-    uint64_t address = callstack[i];
-    auto locationIdOpt = InternLocation(address);
-    if (!locationIdOpt.has_value()) {
+    if (!generation.aggregator->AddSample(
+            getLocations(interned), table.GetValues(i), 0, interned.labelsetId
+        )) {
       LogOnce(
           Error,
-          "Failed to intern location for address 0x",
-          std::hex,
-          address,
-          std::dec,
-          " when adding sample"
+          "Failed to add sample to aggregator: ",
+          generation.aggregator->GetLastError()
       );
-      return false;  // Return false to indicate failure
+      continue;
     }
-    locationIds.push_back(locationIdOpt.value());
-  }
 
-  // Get sample values directly
-  std::span<const int64_t> sampleValues = sample->GetValues();
+    flushedCount++;
+  }
 
-  // Get timestamp - convert nanoseconds to int64_t
-  int64_t timestampNs = sample->GetTimestamp().count();
+  return flushedCount;
+}
 
-  // Get thread info for labeling
-  std::shared_ptr<ThreadInfo> threadInfo = sample->GetThreadInfo();
+bool ProfileExporter::Export(bool lastCall) {
+  if (!RotateProfile()) {
+    return false;
+  }
 
-  // Get RUM view context for labeling
-  const auto& rumView = sample->GetRumViewContext();
+  return ExportRetiredProfile(lastCall);
+}
 
-  // Create labelset for this sample (includes thread name and RUM labels if available)
-  ddog_prof_LabelSetId labelsetId = CreateLabelSet(_sampleLabels, threadInfo, rumView);
+bool ProfileExporter::RotateProfile() {
+  if (!_initialized) {
+    Log::Error("ProfileExporter::RotateProfile() called but not initialized");
+    return false;
+  }
 
-  // Add sample to aggregator with labels
-  if (!_aggregator->AddSample(locationIds, sampleValues, timestampNs, labelsetId)) {
-    LogOnce(Error, "Failed to add sample to aggregator: ", _aggregator->GetLastError());
+  if (_isRetiredProfilePending) {
+    // Keep adding samples to the active profile: it will be exported next time
+    Log::Warn(
+        "Profile #",
+        _retiredProfile->exportId,
+        " is still being exported, skipping rotation"
+    );
     return false;
   }
 
+  auto currentTime = std::chrono::system_clock::now();
+  _activeProfile->endTime = currentTime;
+  _activeProfile->exportId = _currentExportId;
+  _activeProfile->persistentSymbolCacheSize = _persistentSymbolCache.GetSize();
+
+  // The retired generation has already been reset after its last export so it can
+  // immediately receive new samples
+  std::swap(_activeProfile, _retiredProfile);
+  _activeProfile->startTime = currentTime;
+  _isRetiredProfilePending = true;
+
+  if (_pMemoryBudget != nullptr) {
+    _pMemoryBudget->SetUsage(
+        MemoryStage::ActiveProfile, _activeProfile->samples.GetMemorySize()
+    );
+    _pMemoryBudget->SetUsage(
+        MemoryStage::RetiredProfile, _retiredProfile->samples.GetMemorySize()
+    );
+  }
+
+  // Increment export ID for next export
+  _currentExportId++;
+
+  // Periodic cleanup for large persistent cache
+  if (_currentExportId % CACHE_CLEANUP_THRESHOLD == 0) {
+    CleanupUnusedCacheEntries(_currentExportId);
+  }
+
   return true;
 }
 
-bool ProfileExporter::Export(bool lastCall) {
+bool ProfileExporter::ExportRetiredProfile(bool lastCall) {
   if (!_initialized) {
-    Log::Error("ProfileExporter::Export() called but not initialized");
+    Log::Error("ProfileExporter::ExportRetiredProfile() called but not initialized");
+    return false;
+  }
+
+  if (!_isRetiredProfilePending) {
+    Log::Debug("No retired profile to export");
     return false;
   }
 
-  // Clear per-export caches since location IDs become invalid after profile reset
-  OnExportStart();
+  // Only the retired generation is touched from now on: Add() keeps filling the
+  // active one concurrently
+  ProfileGeneration& generation = *_retiredProfile;
+
+  // Intern the folded samples into the pprof profile
+  ExportStats stats;
+  stats.samplesCount = generation.samples.GetSamplesCount();
+  stats.droppedSamplesCount = generation.samples.GetDroppedSamplesCount();
+  stats.uniqueSamplesCount = generation.samples.GetEntriesCount();
+  auto flushStart = std::chrono::steady_clock::now();
+  stats.pprofSamplesCount = FlushAggregatedSamples(generation);
+  AddTraceEndpoints(generation);
+  stats.labelSetsCount = generation.createdLabelSetsCount;
+  auto serializeStart = std::chrono::steady_clock::now();
+  stats.flushDuration = serializeStart - flushStart;
 
   // Serialize the profile using the aggregator
-  auto currentTime = std::chrono::system_clock::now();
+  auto currentTime = generation.endTime;
   auto startMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-                     _profileStartTime.time_since_epoch()
+                     generation.startTime.time_since_epoch()
   )
                      .count();
   auto endMs = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -257,9 +723,16 @@ bool ProfileExporter::Export(bool lastCall) {
   )
                    .count();
 
-  auto encodedProfile = _aggregator->Serialize(startMs, endMs);
+  auto encodedProfile = generation.aggregator->Serialize(startMs, endMs);
+  stats.serializeDuration = std::chrono::steady_clock::now() - serializeStart;
   if (!encodedProfile) {
-    Log::Error("Failed to serialize profile: ", _aggregator->GetLastError());
+    Log::Error(
+        "Failed to serialize profile: ", generation.aggregator->GetLastError()
+    );
+
+    // Drop the retired profile: the active one must be able to rotate next time
+    ResetProfileGeneration(generation);
+    _isRetiredProfilePending = false;
     return false;
   }
 
@@ -294,32 +767,70 @@ bool ProfileExporter::Export(bool lastCall) {
     }
   }
 
-  // Export profile to backend if enabled
-  bool exportSuccess = true;
-  if (_exportEnabled && _exporter.inner) {
-    exportSuccess = ExportProfile(encodedProfile, _currentExportId, rumRecordsJson);
-    if (!exportSuccess) {
-      Log::Error("Failed to export profile to backend");
-      // Continue with cleanup even if export failed
-    }
-  }
+  // the usage reported with the profile includes its pre-aggregated samples
+  ReportExportMemoryUsage(generation);
 
-  // Get profile bytes for logging before export consumes it
-  // TODO: if this call is expensive, get it from ExportProfile call
+  // Get profile bytes before the upload consumes it
   auto bytesResult = ddog_prof_EncodedProfile_bytes(encodedProfile);
-  size_t profileSize = 0;
+  std::span<const uint8_t> profileBytes;
   if (bytesResult.tag == DDOG_PROF_RESULT_BYTE_SLICE_OK_BYTE_SLICE) {
-    profileSize = bytesResult.ok.len;
+    profileBytes = {bytesResult.ok.ptr, bytesResult.ok.len};
+  }
+  stats.profileSize = profileBytes.size();
+  _lastExportStats = stats;
+
+  // Hand the profile to the upload queue if the export is enabled: it now owns the
+  // encoded profile and sends it from its own thread. The bytes and the metadata are
+  // copied to send it again if the first attempt fails.
+  if (_exportEnabled && _exporter.inner && (_pUploadQueue != nullptr)) {
+    PendingUpload upload;
+    upload.exportId = generation.exportId;
+    upload.encodedProfile = *encodedProfile;
+    if (_pIntakeClient != nullptr) {
+      upload.profileBytes.assign(profileBytes.begin(), profileBytes.end());
+    }
+    upload.startMs = startMs;
+    upload.endMs = endMs;
+    upload.exportTags = _stableTags;
+    PrepareAdditionalTags(upload.exportTags, generation.exportId);
+    if (_pTraceEndpoints != nullptr) {
+      for (const auto& [endpointId, count] : _endpointCountsBuffer) {
+        upload.endpointCounts.emplace_back(
+            _pTraceEndpoints->GetEndpoint(endpointId), count
+        );
+      }
+    }
+    upload.internalMetadataJson = std::move(rumRecordsJson);
+    upload.infoJson = SerializeInfoToJson();
+    upload.size = profileBytes.size();
+    _pUploadQueue->Enqueue(std::move(upload));
+  } else {
+    ddog_prof_EncodedProfile_drop(encodedProfile);
   }
+  delete encodedProfile;
 
   // Calculate profile duration
   auto profileDurationMs = endMs - startMs;
 
+  if ((stats.droppedSamplesCount > 0) && (_pMemoryBudget != nullptr)) {
+    Log::Warn(
+        "Profile #",
+        generation.exportId,
+        ": ",
+        stats.droppedSamplesCount,
+        " samples dropped under memory pressure (",
+        _pMemoryBudget->GetTotalUsage(),
+        " bytes used for a budget of ",
+        _pMemoryBudget->GetMaxBytes(),
+        " bytes)"
+    );
+  }
+
   // For now, just log with current export ID and system info
   if (lastCall) {
     Log::Info(
         "Export last profile #",
-        _currentExportId,
+        generation.exportId,
         ", Process ID: ",
         _processId,
         ", Runtime ID: ",
@@ -328,15 +839,26 @@ bool ProfileExporter::Export(bool lastCall) {
         profileDurationMs,
         "ms",
         ", Profile buffer size: ",
-        profileSize,
+        stats.profileSize,
         " bytes",
         ", Persistent symbol cache size: ",
-        _persistentSymbolCache.size()
+        generation.persistentSymbolCacheSize,
+        ", Samples: ",
+        stats.samplesCount,
+        " (",
+        stats.uniqueSamplesCount,
+        " unique)",
+        ", Serialize duration: ",
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            stats.flushDuration + stats.serializeDuration
+        )
+            .count(),
+        "ms"
     );
   } else {
     Log::Info(
         "Export profile #",
-        _currentExportId,
+        generation.exportId,
         ", Process ID: ",
         _processId,
         ", Runtime ID: ",
@@ -345,35 +867,55 @@ bool ProfileExporter::Export(bool lastCall) {
         profileDurationMs,
         "ms",
         ", Profile buffer size: ",
-        profileSize,
+        stats.profileSize,
         " bytes",
         ", Persistent symbol cache size: ",
-        _persistentSymbolCache.size()
+        generation.persistentSymbolCacheSize,
+        ", Samples: ",
+        stats.samplesCount,
+        " (",
+        stats.uniqueSamplesCount,
+        " unique)",
+        ", Serialize duration: ",
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            stats.flushDuration + stats.serializeDuration
+        )
+            .count(),
+        "ms"
     );
   }
 
-  // Clean up encoded profile
-  ddog_prof_EncodedProfile_drop(encodedProfile);
-
-  // Reset the aggregator for next collection cycle
-  _aggregator->Reset();
-
-  // Re-intern sample labels since they become invalid after profile reset
-  if (!InternSampleLabels(_sampleLabels)) {
-    Log::Error("Failed to re-intern sample labels after reset");
-    // Continue anyway - this will cause Add() calls to fail but won't crash
-  }
-
-  // Reset the profile start time for the next collection cycle
-  _profileStartTime = currentTime;
-
-  // Increment export ID for next export
-  _currentExportId++;
+  Log::Debug(
+      "Symbol cache: ",
+      _persistentSymbolCache.GetSize(),
+      "/",
+      _persistentSymbolCache.GetCapacity(),
+      " (hits=",
+      _persistentSymbolCache.GetHitsCount(),
+      " misses=",
+      _persistentSymbolCache.GetMissesCount(),
+      " evictions=",
+      _persistentSymbolCache.GetEvictionsCount(),
+      ")"
+  );
+  Log::Debug(
+      "Symbol ranges: ",
+      _symbolRanges.GetSize(),
+      "/",
+      _symbolRanges.GetCapacity(),
+      " (hits=",
+      _symbolRanges.GetHitsCount(),
+      " misses=",
+      _symbolRanges.GetMissesCount(),
+      " evictions=",
+      _symbolRanges.GetEvictionsCount(),
+      ")"
+  );
 
-  // Periodic cleanup for large persistent cache
-  if (_currentExportId % CACHE_CLEANUP_THRESHOLD == 0) {
-    CleanupUnusedCacheEntries(_currentExportId);
-  }
+  // Make the retired generation ready to become the active one at next rotation
+  ResetProfileGeneration(generation);
+  ReportExportMemoryUsage(generation);
+  _isRetiredProfilePending = false;
 
   return true;
 }
@@ -384,15 +926,17 @@ std::string ProfileExporter::ComputeRuntimeId() {
   return uuid.to_string();
 }
 
-std::optional<ddog_prof_LocationId> ProfileExporter::InternLocation(uint64_t address) {
+std::optional<ddog_prof_LocationId> ProfileExporter::InternLocation(
+    ProfileGeneration& generation, uint64_t address
+) {
   // Check current export location cache first
-  auto it = _currentExportLocationCache.find(address);
-  if (it != _currentExportLocationCache.end()) {
+  auto it = generation.locationCache.find(address);
+  if (it != generation.locationCache.end()) {
     return it->second;
   }
 
   // Get profile for interning operations
-  ddog_prof_Profile* profile = _aggregator->GetProfile();
+  ddog_prof_Profile* profile = generation.aggregator->GetProfile();
   if (profile == nullptr) {
     // this should never happen if aggregator is properly initialized
     //  i.e. we should avoid calling InternLocation before aggregator is ready
@@ -401,19 +945,19 @@ std::optional<ddog_prof_LocationId> ProfileExporter::InternLocation(uint64_t add
 
   // Check persistent symbol cache first
   CachedSymbolInfo symbolInfo;
-  auto symbolIt = _persistentSymbolCache.find(address);
-  if (symbolIt != _persistentSymbolCache.end()) {
+  const auto* pCachedSymbol = _persistentSymbolCache.Find(address, generation.exportId);
+  if (pCachedSymbol != nullptr) {
     // Use cached symbol info
-    symbolInfo = symbolIt->second;
+    symbolInfo = *pCachedSymbol;
   } else {
     // Symbolicate and cache the result persistently
-    auto symbolInfoOpt = _symbolication->SymbolicateAndIntern(address, _stringStorage);
+    auto symbolInfoOpt = Symbolicate(address, generation.exportId);
     if (!symbolInfoOpt.has_value()) {
       LogOnce(Error, "Failed to symbolicate address 0x", std::hex, address, std::dec);
       return std::nullopt;
     }
     symbolInfo = symbolInfoOpt.value();
-    _persistentSymbolCache[address] = symbolInfo;
+    _persistentSymbolCache.Insert(address, symbolInfo, generation.exportId);
   }
 
   uint64_t addressForProfile = address;
@@ -425,15 +969,13 @@ std::optional<ddog_prof_LocationId> ProfileExporter::InternLocation(uint64_t add
   // Intern the mapping using the cached symbol info (module name and build ID)
   std::optional<ddog_prof_MappingId> mappingIdOpt;
   if (symbolInfo.ModuleNameId.value != 0 || symbolInfo.BuildIdId.value != 0) {
-    mappingIdOpt = InternMapping(symbolInfo, profile);
+    mappingIdOpt = InternMapping(generation, symbolInfo, profile);
     // Note: We continue even if mapping creation fails - location can exist without
     // mapping
   }
 
-  // Intern the function using the cached symbol info
-  // todo: we could have a cache that has start / end addresses of the function (cf
-  // ddprof)
-  auto functionIdOpt = InternFunction(symbolInfo, profile);
+  // Intern the function using the cached symbol info (once per function and profile)
+  auto functionIdOpt = InternFunction(generation, symbolInfo, profile);
   if (!functionIdOpt.has_value()) {
     LogOnce(
         Error, "Failed to intern function for address 0x", std::hex, address, std::dec
@@ -465,7 +1007,7 @@ std::optional<ddog_prof_LocationId> ProfileExporter::InternLocation(uint64_t add
   if (locationResult.tag ==
       DDOG_PROF_LOCATION_ID_RESULT_OK_GENERATIONAL_ID_LOCATION_ID) {
     // Cache the result for this export only
-    _currentExportLocationCache[address] = locationResult.ok;
+    generation.locationCache[address] = locationResult.ok;
     return locationResult.ok;
   }
 
@@ -482,8 +1024,33 @@ std::optional<ddog_prof_LocationId> ProfileExporter::InternLocation(uint64_t add
   return std::nullopt;
 }
 
+std::optional<CachedSymbolInfo> ProfileExporter::Symbolicate(
+    uint64_t address, uint32_t exportId
+) {
+  // another address of a known function (or module if not symbolized): only its line
+  // number is missing
+  const auto* pRangeSymbol = _symbolRanges.Find(address, exportId);
+  if (pRangeSymbol != nullptr) {
+    return _symbolication->SymbolicateInRange(address, *pRangeSymbol);
+  }
+
+  auto symbolInfoOpt = _symbolication->SymbolicateAndIntern(address, _stringStorage);
+  if (symbolInfoOpt.has_value()) {
+    _symbolRanges.Insert(
+        symbolInfoOpt->rangeStart,
+        symbolInfoOpt->rangeEnd,
+        symbolInfoOpt.value(),
+        exportId
+    );
+  }
+
+  return symbolInfoOpt;
+}
+
 std::optional<ddog_prof_MappingId> ProfileExporter::InternMapping(
-    const CachedSymbolInfo& symbolInfo, ddog_prof_Profile* profile
+    ProfileGeneration& generation,
+    const CachedSymbolInfo& symbolInfo,
+    ddog_prof_Profile* profile
 ) {
   // Create a cache key based on module name and build ID
   // Use hash_combine for proper hash combination
@@ -491,8 +1058,8 @@ std::optional<ddog_prof_MappingId> ProfileExporter::InternMapping(
   hash_combine(mappingKey, static_cast<uint64_t>(symbolInfo.BuildIdId.value));
 
   // Check if we've already interned this mapping
-  auto it = _currentExportMappingCache.find(mappingKey);
-  if (it != _currentExportMappingCache.end()) {
+  auto it = generation.mappingCache.find(mappingKey);
+  if (it != generation.mappingCache.end()) {
     return it->second;
   }
 
@@ -549,7 +1116,7 @@ std::optional<ddog_prof_MappingId> ProfileExporter::InternMapping(
 
   if (mappingResult.tag == DDOG_PROF_MAPPING_ID_RESULT_OK_GENERATIONAL_ID_MAPPING_ID) {
     // Cache the mapping for reuse
-    _currentExportMappingCache[mappingKey] = mappingResult.ok;
+    generation.mappingCache[mappingKey] = mappingResult.ok;
     return mappingResult.ok;
   }
 
@@ -562,8 +1129,19 @@ std::optional<ddog_prof_MappingId> ProfileExporter::InternMapping(
 static bool s_hasLoggedInternFunctionNameError = false;
 
 std::optional<ddog_prof_FunctionId> ProfileExporter::InternFunction(
-    const CachedSymbolInfo& symbolInfo, ddog_prof_Profile* profile
+    ProfileGeneration& generation,
+    const CachedSymbolInfo& symbolInfo,
+    ddog_prof_Profile* profile
 ) {
+  // all the addresses of a range have the same function
+  bool hasRange = (symbolInfo.rangeStart < symbolInfo.rangeEnd);
+  if (hasRange) {
+    auto it = generation.functionCache.find(symbolInfo.rangeStart);
+    if (it != generation.functionCache.end()) {
+      return it->second;
+    }
+  }
+
   // Convert ManagedStringId to StringId (now using shared string storage)
   auto nameResult =
       ddog_prof_Profile_intern_managed_string(profile, symbolInfo.FunctionNameId);
@@ -617,6 +1195,9 @@ std::optional<ddog_prof_FunctionId> ProfileExporter::InternFunction(
   );
   if (functionResult.tag ==
       DDOG_PROF_FUNCTION_ID_RESULT_OK_GENERATIONAL_ID_FUNCTION_ID) {
+    if (hasRange) {
+      generation.functionCache[symbolInfo.rangeStart] = functionResult.ok;
+    }
     return functionResult.ok;
   }
 
@@ -626,110 +1207,87 @@ std::optional<ddog_prof_FunctionId> ProfileExporter::InternFunction(
   return std::nullopt;
 }
 
-void ProfileExporter::OnExportStart() {
-  // Clear per-export caches since location and mapping IDs become invalid after profile
-  // reset
-  _currentExportLocationCache.clear();
-  _currentExportMappingCache.clear();
-
-  Log::Debug(
-      "Cleared location and mapping caches, keeping ",
-      _persistentSymbolCache.size(),
-      " persistent symbol entries"
-  );
-}
-
 void ProfileExporter::ClearCaches() {
   // This method can now be used for emergency cleanup or testing
-  _currentExportLocationCache.clear();
-  _currentExportMappingCache.clear();
-  _persistentSymbolCache.clear();
+  for (auto* generation : {_activeProfile.get(), _retiredProfile.get()}) {
+    if (generation != nullptr) {
+      generation->locationCache.clear();
+      generation->mappingCache.clear();
+      generation->functionCache.clear();
+      generation->labelSetCache.clear();
+    }
+  }
+  _persistentSymbolCache.Clear();
+  _symbolRanges.Clear();
 
   Log::Debug("Cleared all caches");
 }
 
 void ProfileExporter::CleanupUnusedCacheEntries(uint32_t currentExportId) {
-  // Periodic cleanup for persistent symbol cache if it gets too large
-  if (_persistentSymbolCache.size() > 10000) {  // Max 10k entries
-    Log::Warn(
-        "CleanupUnusedCacheEntries: Symbol cache size (",
-        _persistentSymbolCache.size(),
-        ") exceeds limit, consider cleanup"
+  // The full cache evicts its least recently used entries by itself; this removes the
+  // symbols of code that is not executed anymore (e.g. unloaded modules or collected
+  // JIT code) even when the cache is not full
+  auto evictedCount =
+      _persistentSymbolCache.EvictUnused(currentExportId, CACHE_CLEANUP_THRESHOLD);
+  auto evictedRangesCount =
+      _symbolRanges.EvictUnused(currentExportId, CACHE_CLEANUP_THRESHOLD);
+  if ((evictedCount > 0) || (evictedRangesCount > 0)) {
+    Log::Debug(
+        "CleanupUnusedCacheEntries: ",
+        evictedCount,
+        " symbols evicted (",
+        _persistentSymbolCache.GetSize(),
+        " left), ",
+        evictedRangesCount,
+        " symbol ranges evicted (",
+        _symbolRanges.GetSize(),
+        " left)"
     );
-    // Note: We could implement LRU cleanup here if needed, but for now just log
-    // The symbol cache should generally stay reasonable in size since it's bounded by
-    // the number of unique addresses in the process
   }
 }
 
-bool ProfileExporter::AddSingleTag(
-    ddog_Vec_Tag& tags, std::string_view key, std::string_view value
-) {
-  ddog_CharSlice keySlice = to_CharSlice(key);
-  ddog_CharSlice valueSlice = to_CharSlice(value);
-
-  ddog_Vec_Tag_PushResult pushResult = ddog_Vec_Tag_push(&tags, keySlice, valueSlice);
-  if (pushResult.tag == DDOG_VEC_TAG_PUSH_RESULT_ERR) {
-    LogOnce(Error, "Failed to add tag: ", key, "=", value);
-    return false;
+bool ProfileExporter::AddTags(ddog_Vec_Tag& vecTags, std::span<const tag> tags) {
+  for (const auto& [key, value] : tags) {
+    ddog_Vec_Tag_PushResult pushResult =
+        ddog_Vec_Tag_push(&vecTags, to_CharSlice(key), to_CharSlice(value));
+    if (pushResult.tag == DDOG_VEC_TAG_PUSH_RESULT_ERR) {
+      LogOnce(Error, "Failed to add tag: ", key, "=", value);
+      return false;
+    }
   }
 
   return true;
 }
 
-bool ProfileExporter::PrepareStableTags(ddog_Vec_Tag& tags) {
+void ProfileExporter::PrepareStableTags(tags& stableTags) {
   // Add runtime-id tag (stable across exports)
-  if (!AddSingleTag(tags, TAG_RUNTIME_ID, _runtimeId)) {
-    return false;
-  }
-
-  if (!AddSingleTag(tags, "profiler_version", _kProfilerVersion)) {
-    return false;
-  }
+  stableTags.emplace_back(TAG_RUNTIME_ID, _runtimeId);
+  stableTags.emplace_back("profiler_version", _kProfilerVersion);
 
   // add CPU related tags
   int physicalCores;
   int logicalCores;
   if (GetCpuCores(logicalCores, physicalCores)) {
-    if (!AddSingleTag(tags, TAG_CPU_CORES_COUNT, std::to_string(physicalCores))) {
-      return false;
-    }
-    if (!AddSingleTag(
-            tags, TAG_CPU_LOGICAL_CORES_COUNT, std::to_string(logicalCores)
-        )) {
-      return false;
-    }
+    stableTags.emplace_back(TAG_CPU_CORES_COUNT, std::to_string(physicalCores));
+    stableTags.emplace_back(TAG_CPU_LOGICAL_CORES_COUNT, std::to_string(logicalCores));
   }
 
   std::string cpuVendor = GetCpuVendor();
   if (!cpuVendor.empty()) {
-    if (!AddSingleTag(tags, TAG_CPU_VENDOR, cpuVendor)) {
-      return false;
-    }
+    stableTags.emplace_back(TAG_CPU_VENDOR, cpuVendor);
   }
 
   std::string cpuModel = GetCpuModel();
   if (!cpuModel.empty()) {
-    if (!AddSingleTag(tags, TAG_CPU_DESC, cpuModel)) {
-      return false;
-    }
+    stableTags.emplace_back(TAG_CPU_DESC, cpuModel);
   }
 
   std::string cpuArch = GetCpuArchitecture();
   if (!cpuArch.empty()) {
-    if (!AddSingleTag(tags, TAG_CPU_ARCH, cpuArch)) {
-      return false;
-    }
+    stableTags.emplace_back(TAG_CPU_ARCH, cpuArch);
   }
 
   // GPU tags depend on the number of GPUs
-  std::string driverDescTag;
-  std::string driverVersionTag;
-  std::string driverDateTag;
-  std::string gpuNameTag;
-  std::string gpuChipTag;
-  std::string gpuRamTag;
-
   std::string driverDesc;
   std::string driverVersion;
   std::string driverDate;
@@ -745,70 +1303,53 @@ bool ProfileExporter::PrepareStableTags(ddog_Vec_Tag& tags) {
       continue;
     }
 
-    driverDescTag = TAG_GPU_DRIVER_DESC_PREFIX + std::to_string(device);
-    if (!driverDesc.empty() && !AddSingleTag(tags, driverDescTag, driverDesc)) {
-      return false;
+    auto deviceSuffix = std::to_string(device);
+    if (!driverDesc.empty()) {
+      stableTags.emplace_back(TAG_GPU_DRIVER_DESC_PREFIX + deviceSuffix, driverDesc);
     }
-
-    driverVersionTag = TAG_GPU_DRIVER_VERSION_PREFIX + std::to_string(device);
-    if (!driverVersion.empty() &&
-        !AddSingleTag(tags, driverVersionTag, driverVersion)) {
-      return false;
+    if (!driverVersion.empty()) {
+      stableTags.emplace_back(
+          TAG_GPU_DRIVER_VERSION_PREFIX + deviceSuffix, driverVersion
+      );
     }
-
-    driverDateTag = TAG_GPU_DRIVER_DATE_PREFIX + std::to_string(device);
-    if (!driverDate.empty() && !AddSingleTag(tags, driverDateTag, driverDate)) {
-      return false;
+    if (!driverDate.empty()) {
+      stableTags.emplace_back(TAG_GPU_DRIVER_DATE_PREFIX + deviceSuffix, driverDate);
     }
-
-    gpuNameTag = TAG_GPU_NAME_PREFIX + std::to_string(device);
-    if (!gpuName.empty() && !AddSingleTag(tags, gpuNameTag, gpuName)) {
-      return false;
+    if (!gpuName.empty()) {
+      stableTags.emplace_back(TAG_GPU_NAME_PREFIX + deviceSuffix, gpuName);
     }
-
-    gpuChipTag = TAG_GPU_CHIP_PREFIX + std::to_string(device);
-    if (!gpuChip.empty() && !AddSingleTag(tags, gpuChipTag, gpuChip)) {
-      return false;
+    if (!gpuChip.empty()) {
+      stableTags.emplace_back(TAG_GPU_CHIP_PREFIX + deviceSuffix, gpuChip);
     }
-
-    gpuRamTag = TAG_GPU_RAM_PREFIX + std::to_string(device);
-    if (gpuRam > 0 && !AddSingleTag(tags, gpuRamTag, std::to_string(gpuRam))) {
-      return false;
+    if (gpuRam > 0) {
+      stableTags.emplace_back(
+          TAG_GPU_RAM_PREFIX + deviceSuffix, std::to_string(gpuRam)
+      );
     }
 
     device++;
   }
 
-  if (!AddSingleTag(tags, TAG_GPU_COUNT, std::to_string(device))) {
-    return false;
-  }
+  stableTags.emplace_back(TAG_GPU_COUNT, std::to_string(device));
 
   // add memory related tags
   uint64_t totalPhys;
   uint64_t availPhys;
   uint32_t memoryLoad;
   if (GetMemoryInfo(totalPhys, availPhys, memoryLoad)) {
-    if (!AddSingleTag(tags, TAG_RAM_SIZE, std::to_string(totalPhys))) {
-      return false;
-    }
+    stableTags.emplace_back(TAG_RAM_SIZE, std::to_string(totalPhys));
   }
 
   // Add remote_symbols tag to indicate symbolication support
-  if (!AddSingleTag(tags, TAG_REMOTE_SYMBOLS, "yes")) {
-    return false;
-  }
+  stableTags.emplace_back(TAG_REMOTE_SYMBOLS, "yes");
 
   // Add runtime_os tag to indicate the operating system
-  if (!AddSingleTag(tags, TAG_RUNTIME_OS, "windows")) {
-    return false;
-  }
-
-  return true;
+  stableTags.emplace_back(TAG_RUNTIME_OS, "windows");
 }
 
-bool ProfileExporter::InternSampleLabels(SampleLabels& labels) {
-  // Get profile for interning operations
-  ddog_prof_Profile* profile = _aggregator->GetProfile();
+bool ProfileExporter::InternSampleLabels(
+    ddog_prof_Profile* profile, SampleLabels& labels
+) {
   if (profile == nullptr) {
     return false;
   }
@@ -916,31 +1457,124 @@ bool ProfileExporter::InternSampleLabels(SampleLabels& labels) {
   }
   labels.traceEndpointKeyId = traceEndpointKeyResult.ok;
 
+  // Intern trace context label keys (the ids are numeric labels)
+  auto localRootSpanIdKeyResult =
+      ddog_prof_Profile_intern_string(profile, to_CharSlice(LABEL_LOCAL_ROOT_SPAN_ID));
+  if (localRootSpanIdKeyResult.tag !=
+      DDOG_PROF_STRING_ID_RESULT_OK_GENERATIONAL_ID_STRING_ID) {
+    LogOnce(
+        Error,
+        "InternSampleLabels: Failed to intern local root span id label key (tag: ",
+        localRootSpanIdKeyResult.tag,
+        ")"
+    );
+    return false;
+  }
+  labels.localRootSpanIdKeyId = localRootSpanIdKeyResult.ok;
+
+  auto spanIdKeyResult =
+      ddog_prof_Profile_intern_string(profile, to_CharSlice(LABEL_SPAN_ID));
+  if (spanIdKeyResult.tag != DDOG_PROF_STRING_ID_RESULT_OK_GENERATIONAL_ID_STRING_ID) {
+    LogOnce(
+        Error,
+        "InternSampleLabels: Failed to intern span id label key (tag: ",
+        spanIdKeyResult.tag,
+        ")"
+    );
+    return false;
+  }
+  labels.spanIdKeyId = spanIdKeyResult.ok;
+
   return true;
 }
 
+size_t ProfileExporter::ProfileGeneration::LabelSetKeyHash::operator()(
+    const LabelSetKey& key
+) const {
+  uint64_t hash = key.threadId;
+  hash_combine(hash, key.threadNameId);
+  hash_combine(hash, key.threadGroup);
+  hash_combine(hash, key.rumViewHandle);
+  hash_combine(hash, key.localRootSpanId);
+  hash_combine(hash, key.spanId);
+  return static_cast<size_t>(hash);
+}
+
+ddog_prof_LabelSetId ProfileExporter::GetOrCreateLabelSet(
+    ProfileGeneration& generation, const SampleAggregationTable::Entry& entry
+) {
+  // the name is read once per entry, from the names interned by the ThreadList: no
+  // syscall nor copy on the export path
+  uint32_t threadNameId = NameTable::UnnamedId;
+  if (((entry.threadId != 0) || (entry.threadGroup != 0)) &&
+      (entry.threadInfo != nullptr) && (_pThreadList != nullptr)) {
+    threadNameId = entry.threadInfo->GetThreadNameId();
+  }
+
+  // the entries of the same thread, view and span (i.e. with different callstacks)
+  // have the same labels: their thread name and strings are interned only once
+  ProfileGeneration::LabelSetKey key{
+      entry.threadId,
+      threadNameId,
+      entry.threadGroup,
+      entry.rumViewHandle,
+      entry.traceContext.localRootSpanId,
+      entry.traceContext.spanId
+  };
+  if (_isLabelSetCacheEnabled) {
+    auto it = generation.labelSetCache.find(key);
+    if (it != generation.labelSetCache.end()) {
+      return it->second;
+    }
+  }
+
+  static const RumViewContext NoRumView;
+  auto rumView = generation.rumViews.find(entry.rumViewHandle);
+
+  auto labelSetId = CreateLabelSet(
+      generation,
+      entry.threadId,
+      (threadNameId != NameTable::UnnamedId)
+          ? _pThreadList->GetThreadName(threadNameId)
+          : std::string_view(),
+      (rumView != generation.rumViews.end()) ? rumView->second : NoRumView,
+      entry.traceContext,
+      entry.threadGroup != 0
+  );
+  generation.createdLabelSetsCount++;
+
+  if (_isLabelSetCacheEnabled) {
+    generation.labelSetCache.emplace(key, labelSetId);
+  }
+  return labelSetId;
+}
+
 ddog_prof_LabelSetId ProfileExporter::CreateLabelSet(
-    const SampleLabels& labels,
-    std::shared_ptr<ThreadInfo> threadInfo,
-    const RumViewContext& rumView
+    ProfileGeneration& generation,
+    uint32_t threadId,
+    std::string_view threadName,
+    const RumViewContext& rumView,
+    const TraceContext& traceContext,
+    bool isThreadGroup
 ) {
   // Get profile for interning operations
-  ddog_prof_Profile* profile = _aggregator->GetProfile();
+  ddog_prof_Profile* profile = generation.aggregator->GetProfile();
   if (!profile) {
     return ddog_prof_LabelSetId{};
   }
+  const SampleLabels& labels = generation.sampleLabels;
 
   std::vector<ddog_prof_LabelId> labelIdArray;
 
   // Always add process_id label
   labelIdArray.push_back(labels.processIdLabelId);
 
-  // Add thread_id label if thread info is available
-  if (threadInfo) {
+  // Add thread_id label if the thread is known
+  if (threadId != 0) {
     // Use numeric label for thread ID (more efficient than string conversion)
-    int64_t threadId = static_cast<int64_t>(threadInfo->GetThreadId());
-    auto threadIdLabelResult =
-        ddog_prof_Profile_intern_label_num(profile, labels.threadIdKeyId, threadId);
+    auto threadIdLabelResult = ddog_prof_Profile_intern_label_num(
+        profile, labels.threadIdKeyId, static_cast<int64_t>(threadId)
+    );
     if (threadIdLabelResult.tag ==
         DDOG_PROF_LABEL_ID_RESULT_OK_GENERATIONAL_ID_LABEL_ID) {
       labelIdArray.push_back(threadIdLabelResult.ok);
@@ -951,35 +1585,36 @@ ddog_prof_LabelSetId ProfileExporter::CreateLabelSet(
           ")"
       );
     }
+  }
 
-    std::string name;
-    if (threadInfo->GetThreadName(name)) {
-      // Intern the thread name value
-      auto threadNameValueResult =
-          ddog_prof_Profile_intern_string(profile, to_CharSlice(name));
-      if (threadNameValueResult.tag !=
-          DDOG_PROF_STRING_ID_RESULT_OK_GENERATIONAL_ID_STRING_ID) {
+  // folded walltime samples of several threads get the name of their group
+  auto name = isThreadGroup ? ThreadInfo::GetThreadNameGroup(threadName) : threadName;
+  if (!name.empty()) {
+    // Intern the thread name value
+    auto threadNameValueResult =
+        ddog_prof_Profile_intern_string(profile, to_CharSlice(name));
+    if (threadNameValueResult.tag !=
+        DDOG_PROF_STRING_ID_RESULT_OK_GENERATIONAL_ID_STRING_ID) {
+      LogOnce(
+          Error,
+          "Failed to intern thread_name value (tag: ",
+          threadNameValueResult.tag,
+          ")"
+      );
+    } else {
+      auto threadNameLabelResult = ddog_prof_Profile_intern_label_str(
+          profile, labels.threadNameKeyId, threadNameValueResult.ok
+      );
+      if (threadNameLabelResult.tag !=
+          DDOG_PROF_LABEL_ID_RESULT_OK_GENERATIONAL_ID_LABEL_ID) {
         LogOnce(
             Error,
-            "Failed to intern thread_name value (tag: ",
-            threadNameValueResult.tag,
+            "Failed to intern thread_name label (tag: ",
+            threadNameLabelResult.tag,
             ")"
         );
       } else {
-        auto threadNameLabelResult = ddog_prof_Profile_intern_label_str(
-            profile, labels.threadNameKeyId, threadNameValueResult.ok
-        );
-        if (threadNameLabelResult.tag !=
-            DDOG_PROF_LABEL_ID_RESULT_OK_GENERATIONAL_ID_LABEL_ID) {
-          LogOnce(
-              Error,
-              "Failed to intern thread_name label (tag: ",
-              threadNameLabelResult.tag,
-              ")"
-          );
-        } else {
-          labelIdArray.push_back(threadNameLabelResult.ok);
-        }
+        labelIdArray.push_back(threadNameLabelResult.ok);
       }
     }
   }
@@ -999,7 +1634,9 @@ ddog_prof_LabelSetId ProfileExporter::CreateLabelSet(
       }
     }
 
-    if (!rumView.view_name.empty()) {
+    // the samples of a span get the endpoint of their local root span instead (see
+    // AddTraceEndpoints)
+    if (!rumView.view_name.empty() && (traceContext.localRootSpanId == 0)) {
       auto viewNameValueResult =
           ddog_prof_Profile_intern_string(profile, to_CharSlice(rumView.view_name));
       if (viewNameValueResult.tag ==
@@ -1015,6 +1652,29 @@ ddog_prof_LabelSetId ProfileExporter::CreateLabelSet(
     }
   }
 
+  // Add trace context labels if a span was running on the thread
+  if (traceContext.localRootSpanId != 0) {
+    auto localRootSpanIdLabelResult = ddog_prof_Profile_intern_label_num(
+        profile,
+        labels.localRootSpanIdKeyId,
+        static_cast<int64_t>(traceContext.localRootSpanId)
+    );
+    if (localRootSpanIdLabelResult.tag ==
+        DDOG_PROF_LABEL_ID_RESULT_OK_GENERATIONAL_ID_LABEL_ID) {
+      labelIdArray.push_back(localRootSpanIdLabelResult.ok);
+    }
+  }
+
+  if (traceContext.spanId != 0) {
+    auto spanIdLabelResult = ddog_prof_Profile_intern_label_num(
+        profile, labels.spanIdKeyId, static_cast<int64_t>(traceContext.spanId)
+    );
+    if (spanIdLabelResult.tag ==
+        DDOG_PROF_LABEL_ID_RESULT_OK_GENERATIONAL_ID_LABEL_ID) {
+      labelIdArray.push_back(spanIdLabelResult.ok);
+    }
+  }
+
   ddog_prof_Slice_LabelId labelSlice = {
       .ptr = labelIdArray.data(), .len = labelIdArray.size()
   };
@@ -1265,20 +1925,15 @@ bool ProfileExporter::InitializeExporter() {
     return false;
   }
 
-  // Prepare stable tags for exporter creation
-  ddog_Vec_Tag stableTags = ddog_Vec_Tag_new();
+  // Stable tags given to the exporter, also kept for the uploads of the profiles that
+  // are not sent by libdatadog (see UploadQueue)
+  _stableTags.clear();
 
   // Add language tag (required)
-  if (!AddSingleTag(stableTags, "language", "native")) {
-    ddog_Vec_Tag_drop(stableTags);
-    return false;
-  }
+  _stableTags.emplace_back("language", "native");
 
   // Add runtime and hardware details
-  if (!PrepareStableTags(stableTags)) {
-    ddog_Vec_Tag_drop(stableTags);
-    return false;
-  }
+  PrepareStableTags(_stableTags);
 
   // Add service information from configuration if available
   if (_pConfiguration) {
@@ -1287,31 +1942,28 @@ bool ProfileExporter::InitializeExporter() {
     auto version = _pConfiguration->GetVersion();
     auto hostname = _pConfiguration->GetHostname();
 
-    if (!service.empty() && !AddSingleTag(stableTags, "service", service)) {
-      ddog_Vec_Tag_drop(stableTags);
-      return false;
+    if (!service.empty()) {
+      _stableTags.emplace_back("service", service);
     }
-    if (!environment.empty() && !AddSingleTag(stableTags, "env", environment)) {
-      ddog_Vec_Tag_drop(stableTags);
-      return false;
+    if (!environment.empty()) {
+      _stableTags.emplace_back("env", environment);
     }
-    if (!version.empty() && !AddSingleTag(stableTags, "version", version)) {
-      ddog_Vec_Tag_drop(stableTags);
-      return false;
+    if (!version.empty()) {
+      _stableTags.emplace_back("version", version);
     }
-    if (!hostname.empty() && !AddSingleTag(stableTags, "host", hostname)) {
-      ddog_Vec_Tag_drop(stableTags);
-      return false;
+    if (!hostname.empty()) {
+      _stableTags.emplace_back("host", hostname);
     }
 
     // Add user-defined tags from configuration
     const auto& userTags = _pConfiguration->GetUserTags();
-    for (const auto& tag : userTags) {
-      if (!AddSingleTag(stableTags, tag.first, tag.second)) {
-        ddog_Vec_Tag_drop(stableTags);
-        return false;
-      }
-    }
+    _stableTags.insert(_stableTags.end(), userTags.begin(), userTags.end());
+  }
+
+  ddog_Vec_Tag stableTags = ddog_Vec_Tag_new();
+  if (!AddTags(stableTags, _stableTags)) {
+    ddog_Vec_Tag_drop(stableTags);
+    return false;
   }
 
   // Create exporter
@@ -1371,6 +2023,41 @@ bool ProfileExporter::InitializeExporter() {
     return false;
   }
 
+  // The next attempts of a failed upload and the spooled profiles cannot go through
+  // libdatadog (see UploadQueue): without this client, they are lost
+  _pIntakeClient = std::make_unique<IntakeClient>(
+      IntakeClient::GetProfilesUrl(_agentMode, _exportUrl),
+      _agentMode ? std::string() : _apiKey,
+      _kProfilerUserAgent,
+      _kProfilerVersion,
+      std::chrono::milliseconds(EXPORT_TIMEOUT_MS)
+  );
+  if (!_pIntakeClient->Initialize()) {
+    Log::Warn("Failed profile uploads will not be retried");
+    _pIntakeClient.reset();
+  }
+
+  return true;
+}
+
+bool ProfileExporter::CreateUploadSpool() {
+  if ((_pConfiguration == nullptr) || (_pIntakeClient == nullptr) ||
+      (_pConfiguration->GetUploadSpoolMaxSize() == 0)) {
+    return false;
+  }
+
+  // the tags, hence the service, of the spooled profiles are kept: the processes of
+  // the same service share their spool
+  auto directory = _pConfiguration->GetUploadSpoolDirectory() /
+                   UploadSpool::ToFileName(_pConfiguration->GetServiceName());
+  _pUploadSpool = std::make_unique<UploadSpool>(
+      directory, _pConfiguration->GetUploadSpoolMaxSize()
+  );
+  if (!_pUploadSpool->Initialize()) {
+    _pUploadSpool.reset();
+    return false;
+  }
+
   return true;
 }
 
@@ -1426,76 +2113,80 @@ bool ProfileExporter::CreateExporterEndpoint(ddog_prof_Endpoint& endpoint) {
   return true;
 }
 
-bool ProfileExporter::ExportProfile(
-    const ddog_prof_EncodedProfile* encodedProfile,
-    uint32_t profileSeq,
-    const std::string& rumRecordsJson
-) {
-  if (!_exporter.inner || !encodedProfile) {
-    _lastError = "Exporter not initialized or invalid profile";
-    return false;
+UploadStatus ProfileExporter::Send(PendingUpload& upload) {
+  // Called on the upload queue thread: errors are logged instead of being kept in
+  // _lastError. Only the first attempt has the encoded profile.
+  if (upload.encodedProfile.inner == nullptr) {
+    return SendProfileBytes(upload);
   }
 
-  // Prepare additional tags (per-export metadata)
-  ddog_Vec_Tag additionalTags = ddog_Vec_Tag_new();
-  if (!PrepareAdditionalTags(additionalTags, profileSeq)) {
-    ddog_Vec_Tag_drop(additionalTags);
-    return false;
+  if (!_exporter.inner) {
+    Log::Error("Exporter not initialized: profile #", upload.exportId, " dropped");
+    Discard(upload);
+    return UploadStatus::Rejected;
   }
 
-  // Get profile bytes for file creation
-  auto bytesResult = ddog_prof_EncodedProfile_bytes(
-      const_cast<ddog_prof_EncodedProfile*>(encodedProfile)
-  );
-  if (bytesResult.tag != DDOG_PROF_RESULT_BYTE_SLICE_OK_BYTE_SLICE) {
-    _lastError = "Failed to get profile bytes";
+  // The stable tags were given to the exporter: only the tags of the export are added
+  auto exportTags = std::span<const tag>(upload.exportTags);
+  ddog_Vec_Tag additionalTags = ddog_Vec_Tag_new();
+  if (!AddTags(
+          additionalTags,
+          exportTags.subspan((std::min)(_stableTags.size(), exportTags.size()))
+      )) {
     ddog_Vec_Tag_drop(additionalTags);
-    return false;
+    Discard(upload);
+    return UploadStatus::Rejected;
   }
 
   // Pass the RUM records JSON through optional_internal_metadata_json.
   // libdatadog embeds it in the `internal` field of the profile's event.json,
   // so no separate file attachment is needed. The backing std::string must
-  // outlive the Request_build call; it's a function-scoped local.
+  // outlive the Request_build call; it's owned by the upload.
   ddog_CharSlice internalMetadataSlice{};
   const ddog_CharSlice* internalMetadataPtr = nullptr;
-  if (!rumRecordsJson.empty()) {
-    internalMetadataSlice = to_CharSlice(rumRecordsJson);
+  if (!upload.internalMetadataJson.empty()) {
+    internalMetadataSlice = to_CharSlice(upload.internalMetadataJson);
     internalMetadataPtr = &internalMetadataSlice;
   }
 
+  // Memory usage of the profiler (see MemoryBudget), stored in the `info` field
+  ddog_CharSlice infoSlice{};
+  const ddog_CharSlice* infoPtr = nullptr;
+  if (!upload.infoJson.empty()) {
+    infoSlice = to_CharSlice(upload.infoJson);
+    infoPtr = &infoSlice;
+  }
+
   // Build request - time information is now embedded in the EncodedProfile
   auto requestResult = ddog_prof_Exporter_Request_build(
       &_exporter,
-      const_cast<ddog_prof_EncodedProfile*>(encodedProfile),  // profile
+      &upload.encodedProfile,                 // profile
       ddog_prof_Exporter_Slice_File_empty(),  // files_to_compress_and_export
       ddog_prof_Exporter_Slice_File_empty(),  // files_to_export_unmodified
       &additionalTags,                        // optional_additional_tags
       internalMetadataPtr,                    // optional_internal_metadata_json
-      nullptr                                 // optional_info_json
+      infoPtr                                 // optional_info_json
   );
 
   ddog_Vec_Tag_drop(additionalTags);
 
+  // The request (if any) now owns the profile; dropping the emptied handle is a no-op
+  ddog_prof_EncodedProfile_drop(&upload.encodedProfile);
+
   if (requestResult.tag != DDOG_PROF_REQUEST_RESULT_OK_HANDLE_REQUEST) {
-    _lastError = "Failed to build export request";
     if (requestResult.tag == DDOG_PROF_REQUEST_RESULT_ERR_HANDLE_REQUEST) {
       auto& error = requestResult.err;
       std::string errorMessage = std::string(
           reinterpret_cast<const char*>(error.message.ptr), error.message.len
       );
-      _lastError += ": " + errorMessage;
       Log::Error("Request build failed: ", errorMessage);
-
-      // TODO: check if we need to drop it all the time
-      //       i.e. call it before returning false
       ddog_Error_drop(&requestResult.err);
     } else {
       Log::Error(
           "Request build failed with unknown error (tag: ", requestResult.tag, ")"
       );
     }
-    return false;
+    return UploadStatus::Rejected;
   }
 
   ddog_prof_Request request = requestResult.ok;
@@ -1506,111 +2197,179 @@ bool ProfileExporter::ExportProfile(
   // Request is consumed by send, so we don't need to drop it
 
   if (sendResult.tag == DDOG_PROF_RESULT_HTTP_STATUS_ERR_HTTP_STATUS) {
-    _consecutiveErrors++;
-    _lastError = "Failed to send profile";
     auto& error = sendResult.err;
     std::string errorMessage = std::string(
         reinterpret_cast<const char*>(error.message.ptr), error.message.len
     );
-    _lastError += ": " + errorMessage;
     ddog_Error_drop(&sendResult.err);
 
     Log::Error(
-        "Send profile failed: ",
+        "Send profile #",
+        upload.exportId,
+        " failed: ",
         errorMessage,
-        " (consecutive errors: ",
-        _consecutiveErrors,
-        "/",
-        MAX_CONSECUTIVE_ERRORS,
-        ", URL: ",
+        " (URL: ",
         _exportUrl,
         ")"
     );
 
-    // Don't fail completely unless we have too many consecutive errors
-    return _consecutiveErrors < MAX_CONSECUTIVE_ERRORS;
+    // the upload queue backs off before the next attempt
+    return UploadStatus::Failed;
   }
 
-  // Success - reset error counter
-  _consecutiveErrors = 0;
+  return GetUploadStatus(upload, sendResult.ok.code);
+}
+
+UploadStatus ProfileExporter::SendProfileBytes(PendingUpload& upload) {
+  if ((_pIntakeClient == nullptr) || upload.profileBytes.empty()) {
+    Log::Warn("Profile #", upload.exportId, " cannot be sent again: dropped");
+    return UploadStatus::Rejected;
+  }
 
-  // Check HTTP response code
-  uint16_t responseCode = sendResult.ok.code;
-  bool responseOk = CheckExportResponse(responseCode);
+  uint16_t responseCode = 0;
+  std::string errorMessage;
+  if (!_pIntakeClient->Send(
+          SerializeEventToJson(upload), upload.profileBytes, responseCode, errorMessage
+      )) {
+    Log::Error(
+        "Send profile #",
+        upload.exportId,
+        " failed: ",
+        errorMessage,
+        " (URL: ",
+        _pIntakeClient->GetUrl(),
+        ")"
+    );
+    return UploadStatus::Failed;
+  }
 
-  Log::Info(
-      "Successfully sent profile, HTTP ",
-      responseCode,
-      " (size: ",
-      bytesResult.ok.len,
-      " bytes)"
-  );
+  return GetUploadStatus(upload, responseCode);
+}
 
-  return responseOk;
+void ProfileExporter::Discard(PendingUpload& upload) {
+  ddog_prof_EncodedProfile_drop(&upload.encodedProfile);
 }
 
-bool ProfileExporter::PrepareAdditionalTags(ddog_Vec_Tag& tags, uint32_t profileSeq) {
+void ProfileExporter::PrepareAdditionalTags(tags& additionalTags, uint32_t profileSeq) {
   // Add profile sequence number
-  if (!AddSingleTag(tags, TAG_PROFILE_SEQ, std::to_string(profileSeq))) {
-    return false;
-  }
+  additionalTags.emplace_back(TAG_PROFILE_SEQ, std::to_string(profileSeq));
 
   // Add process ID as additional tag
-  if (!AddSingleTag(tags, "pid", std::to_string(_processId))) {
-    return false;
-  }
+  additionalTags.emplace_back("pid", std::to_string(_processId));
 
   // Add RUM application ID tag (set once via SetRumApplicationId)
   if (!_rumApplicationId.empty()) {
-    if (!AddSingleTag(tags, TAG_RUM_APPLICATION_ID, _rumApplicationId)) {
-      return false;
-    }
+    additionalTags.emplace_back(TAG_RUM_APPLICATION_ID, _rumApplicationId);
   }
 
   // Note: RUM session IDs are no longer emitted as a tag. They are now
   // embedded in the optional_internal_metadata_json payload under
   // "rum_session_ids", alongside the per-view vitals.
-
-  return true;
 }
 
-bool ProfileExporter::CheckExportResponse(uint16_t responseCode) {
+UploadStatus ProfileExporter::GetUploadStatus(
+    const PendingUpload& upload, uint16_t responseCode
+) {
   constexpr uint16_t HTTP_OK = 200;
   constexpr uint16_t HTTP_ACCEPTED = 202;
   constexpr uint16_t HTTP_MULTIPLE_CHOICES = 300;
   constexpr uint16_t HTTP_FORBIDDEN = 403;
   constexpr uint16_t HTTP_NOT_FOUND = 404;
-  constexpr uint16_t HTTP_GATEWAY_TIMEOUT = 504;
+  constexpr uint16_t HTTP_REQUEST_TIMEOUT = 408;
+  constexpr uint16_t HTTP_TOO_MANY_REQUESTS = 429;
+  constexpr uint16_t HTTP_INTERNAL_SERVER_ERROR = 500;
 
   if (responseCode >= HTTP_OK && responseCode < HTTP_MULTIPLE_CHOICES) {
-    // Success range
-    if (responseCode == HTTP_ACCEPTED) {
-      // HTTP 202 Accepted is normal for profile uploads
-      return true;
-    } else if (responseCode != HTTP_OK) {
+    // Success range: HTTP 202 Accepted is normal for profile uploads
+    if ((responseCode != HTTP_ACCEPTED) && (responseCode != HTTP_OK)) {
       Log::Warn("Unexpected success code: ", responseCode);
     }
-    return true;
+    Log::Info(
+        "Successfully sent profile #",
+        upload.exportId,
+        ", HTTP ",
+        responseCode,
+        " (size: ",
+        upload.size,
+        " bytes, ",
+        upload.attemptsCount,
+        " failed attempts)"
+    );
+    return UploadStatus::Sent;
   }
 
   // Handle specific error codes
   switch (responseCode) {
-    case HTTP_GATEWAY_TIMEOUT:
-      Log::Warn("Timeout (504), dropping profile");
-      return true;  // Don't treat as failure, just drop this profile
+    case HTTP_REQUEST_TIMEOUT:
+    case HTTP_TOO_MANY_REQUESTS:
+      // the agent or the intake is overloaded: the upload queue backs off
+      Log::Warn("HTTP ", responseCode, " for profile #", upload.exportId, ", retrying");
+      return UploadStatus::Failed;
 
     case HTTP_FORBIDDEN:
       Log::Error("Forbidden (403), check API key");
-      return false;  // This is a configuration error
+      return UploadStatus::Rejected;  // This is a configuration error
 
     case HTTP_NOT_FOUND:
       Log::Error("Not found (404), profiles not accepted");
-      return false;  // This is a configuration error
+      return UploadStatus::Rejected;  // This is a configuration error
 
     default:
+      if (responseCode >= HTTP_INTERNAL_SERVER_ERROR) {
+        // the agent is up but the intake is not (or the intake is down)
+        Log::Warn(
+            "HTTP ", responseCode, " for profile #", upload.exportId, ", retrying"
+        );
+        return UploadStatus::Failed;
+      }
+
       Log::Warn("HTTP error ", responseCode, " (continuing)");
-      return true;  // Continue profiling despite HTTP error
+      return UploadStatus::Rejected;  // Continue profiling despite HTTP error
+  }
+}
+
+std::string ProfileExporter::SerializeEventToJson(const PendingUpload& upload) {
+  // Same event.json as the one built by libdatadog for the first attempt
+  auto toRfc3339 = [](int64_t timeMs) {
+    auto time = std::chrono::sys_time<std::chrono::milliseconds>(
+        std::chrono::milliseconds(timeMs)
+    );
+    return std::format("{:%FT%TZ}", time);
+  };
+
+  std::ostringstream ss;
+  ss << "{\"attachments\":[\"profile.pprof\"],\"tags_profiler\":\"";
+  for (size_t i = 0; i < upload.exportTags.size(); i++) {
+    if (i > 0) {
+      ss << ',';
+    }
+    EscapeJsonString(ss, upload.exportTags[i].first);
+    ss << ':';
+    EscapeJsonString(ss, upload.exportTags[i].second);
   }
+  ss << "\",\"start\":\"" << toRfc3339(upload.startMs) << "\",\"end\":\""
+     << toRfc3339(upload.endMs) << "\",\"family\":\"native\",\"version\":\"4\"";
+
+  ss << ",\"endpoint_counts\":";
+  if (upload.endpointCounts.empty()) {
+    ss << "null";
+  } else {
+    ss << "{\"counts\":{";
+    for (size_t i = 0; i < upload.endpointCounts.size(); i++) {
+      if (i > 0) {
+        ss << ',';
+      }
+      ss << '"';
+      EscapeJsonString(ss, upload.endpointCounts[i].first);
+      ss << "\":" << upload.endpointCounts[i].second;
+    }
+    ss << "}}";
+  }
+
+  ss << ",\"internal\":"
+     << (upload.internalMetadataJson.empty() ? "{}" : upload.internalMetadataJson);
+  ss << ",\"info\":" << (upload.infoJson.empty() ? "{}" : upload.infoJson) << "}";
+  return ss.str();
 }
 
 void ProfileExporter::CleanupExporter() {
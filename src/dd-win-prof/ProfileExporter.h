@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <optional>
 #include <span>
@@ -12,28 +13,76 @@
 #include <unordered_map>
 
 #include "Configuration.h"
+#include "IntakeClient.h"
+#include "MemoryBudget.h"
 #include "PprofAggregator.h"
 #include "RumContext.h"
+#include "RumViewRegistry.h"
 #include "Sample.h"
+#include "SampleAggregationTable.h"
+#include "SymbolCache.h"
+#include "SymbolRangeCache.h"
 #include "Symbolication.h"
+#include "ThreadList.h"
+#include "TraceContext.h"
+#include "UploadQueue.h"
+#include "UploadSpool.h"
 #include "datadog/profiling.h"
 #include "pch.h"
 
-class ProfileExporter {
+class ProfileExporter : public IProfileSender {
  public:
   ProfileExporter(
       Configuration* pConfiguration,
       std::span<const SampleValueType> sampleTypeDefinitions,
-      IRumRecordProvider* pRumRecordProvider = nullptr
+      IRumRecordProvider* pRumRecordProvider = nullptr,
+      ThreadList* pThreadList = nullptr,
+      const RumViewRegistry* pRumViewRegistry = nullptr,
+      TraceEndpoints* pTraceEndpoints = nullptr,
+      MemoryBudget* pMemoryBudget = nullptr
   );
   ~ProfileExporter();
   bool Initialize();
-  bool Add(std::shared_ptr<Sample> const& sample);
+
+  // Adding samples does not allocate memory per sample: they are folded into the
+  // pre-aggregation table of the active profile (only new callstacks are stored).
+  // The thread of each new callstack is looked up in the ThreadList (if any) to get
+  // its name when the profile is exported. The RUM view handles of the samples are
+  // resolved in the RumViewRegistry (if any) once per view and per profile. The
+  // endpoint of each local root span is kept to be set in the profile on export.
+  // Under memory pressure (see MemoryBudget), the samples of a batch lose their
+  // timestamp, then the samples with a new callstack or new labels are dropped.
+  bool Add(const Sample& sample);
+  size_t Add(std::span<const Sample> samples);
   bool Export(bool lastCall = false);
+
+  // Double-buffered export: samples are always added to the active profile while the
+  // retired one is serialized and uploaded.
+  //   - RotateProfile() swaps the active and retired profiles in O(1); it must be
+  //     serialized with Add() by the caller (i.e. SamplesCollector::_exportLock).
+  //   - ExportRetiredProfile() serializes and resets the retired profile, then hands
+  //     the serialized profile to the upload queue without waiting for the network;
+  //     it never touches the active profile so it can run concurrently with Add().
+  // Export() is simply RotateProfile() followed by ExportRetiredProfile().
+  bool RotateProfile();
+  bool ExportRetiredProfile(bool lastCall = false);
   void Cleanup(
       bool skipExporterCleanup = false
   );  // Explicit cleanup with option to skip exporter cleanup
 
+  // Statistics about the last exported profile (for diagnostics and benchmarks)
+  struct ExportStats {
+    uint64_t samplesCount = 0;         // samples added to the profile
+    uint64_t droppedSamplesCount = 0;  // samples dropped under memory pressure
+    size_t uniqueSamplesCount = 0;     // entries left after aggregation
+    size_t pprofSamplesCount = 0;      // samples added to the libdatadog profile
+    size_t labelSetsCount = 0;         // label sets created (shared by the entries)
+    size_t profileSize = 0;            // serialized profile size in bytes
+    std::chrono::nanoseconds flushDuration{0};
+    std::chrono::nanoseconds serializeDuration{0};
+  };
+  const ExportStats& GetLastExportStats() const { return _lastExportStats; }
+
   // Check if properly initialized
   bool IsInitialized() const { return _initialized; }
   const std::string& GetLastError() const { return _lastError; }
@@ -57,6 +106,10 @@ class ProfileExporter {
   );
   static void EscapeJsonString(std::ostream& out, const std::string& s);
 
+  // event.json of a profile sent without libdatadog (see IntakeClient), with the same
+  // fields as the one built by libdatadog. Public so unit tests can exercise it.
+  static std::string SerializeEventToJson(const PendingUpload& upload);
+
   // Configuration methods for debug file writing
   // These methods allow enabling/disabling writing of pprof files to disk for debugging
   // purposes. When enabled, each exported profile will be written to a timestamped
@@ -75,33 +128,31 @@ class ProfileExporter {
   void SetDebugPprofPrefix(const std::string& prefix) { _debugPprofPrefix = prefix; }
   const std::string& GetDebugPprofPrefix() const { return _debugPprofPrefix; }
 
+  // The label set of an entry is reused by the entries of the same thread and RUM view
+  // (only disabled to measure the cache in benchmarks)
+  void SetLabelSetCacheEnabled(bool enabled) { _isLabelSetCacheEnabled = enabled; }
+
   // Export tags (stable metadata set at export time)
-  bool PrepareStableTags(ddog_Vec_Tag& tags);
-  bool AddSingleTag(ddog_Vec_Tag& tags, std::string_view key, std::string_view value);
+  void PrepareStableTags(tags& stableTags);
+  bool AddTags(ddog_Vec_Tag& vecTags, std::span<const tag> tags);
 
   // Export functionality
   bool InitializeExporter();
   bool CreateExporterEndpoint(ddog_prof_Endpoint& endpoint);
+  bool CreateUploadSpool();
   bool BuildExportUrl();
-  bool ExportProfile(
-      const ddog_prof_EncodedProfile* encodedProfile,
-      uint32_t profileSeq,
-      const std::string& rumRecordsJson = {}
-  );
-  bool PrepareAdditionalTags(ddog_Vec_Tag& tags, uint32_t profileSeq);
-  bool CheckExportResponse(uint16_t responseCode);
+  void PrepareAdditionalTags(tags& additionalTags, uint32_t profileSeq);
   void CleanupExporter();
 
- private:
-  // Helper methods for location/function/mapping management
-  std::optional<ddog_prof_LocationId> InternLocation(uint64_t address);
-  std::optional<ddog_prof_FunctionId> InternFunction(
-      const CachedSymbolInfo& symbolInfo, ddog_prof_Profile* profile
-  );
-  std::optional<ddog_prof_MappingId> InternMapping(
-      const CachedSymbolInfo& symbolInfo, ddog_prof_Profile* profile
-  );
+  // Called by the upload queue thread for the serialized profiles (see UploadQueue):
+  // the first attempt goes through libdatadog, the next ones through the IntakeClient.
+  // HTTP 408, 429 and 5xx are retried.
+  UploadStatus Send(PendingUpload& upload) override;
+  void Discard(PendingUpload& upload) override;
+  UploadStatus SendProfileBytes(PendingUpload& upload);
+  UploadStatus GetUploadStatus(const PendingUpload& upload, uint16_t responseCode);
 
+ private:
   // Sample labels (per-sample metadata that gets interned)
   struct SampleLabels {
     ddog_prof_LabelId processIdLabelId;
@@ -111,13 +162,110 @@ class ProfileExporter {
     ddog_prof_StringId threadNameKeyId;  // String ID for thread_name key
     ddog_prof_StringId rumViewIdKeyId;   // String ID for "rum.view_id" key
     ddog_prof_StringId traceEndpointKeyId;  // String ID for "trace endpoint" key
+    ddog_prof_StringId localRootSpanIdKeyId;  // String ID for "local root span id" key
+    ddog_prof_StringId spanIdKeyId;           // String ID for "span id" key
+  };
+
+  // Everything that belongs to one profile being built: the pre-aggregated samples,
+  // the libdatadog profile, the ids interned in it and the per-profile caches
+  // (location and mapping ids become invalid when the profile is reset).
+  struct ProfileGeneration {
+    ProfileGeneration(size_t valuesCount, bool isTimelineEnabled)
+        : samples(valuesCount, isTimelineEnabled) {}
+
+    // Samples are folded here by Add() and flushed into the aggregator at export time
+    SampleAggregationTable samples;
+
+    std::unique_ptr<dd_win_prof::PprofAggregator> aggregator;
+    SampleLabels sampleLabels;
+
+    // Per-profile caches
+    std::unordered_map<uint64_t, ddog_prof_LocationId> locationCache;
+    // Key: hash of (ModuleNameId, BuildIdId) for uniqueness
+    std::unordered_map<uint64_t, ddog_prof_MappingId> mappingCache;
+    // Key: start address of the symbol range (see SymbolRangeCache)
+    std::unordered_map<uint64_t, ddog_prof_FunctionId> functionCache;
+
+    // Callstack and labels interned for each entry of the samples table when flushing
+    struct InternedEntry {
+      uint32_t locationsOffset;
+      uint32_t locationsCount;
+      ddog_prof_LabelSetId labelsetId;
+      bool isValid;
+    };
+    std::vector<InternedEntry> internedEntries;
+    std::vector<ddog_prof_LocationId> locationIds;
+
+    // Strings of the RUM views of the samples, resolved when the first sample of a
+    // view is added to the generation (see RumViewRegistry)
+    std::unordered_map<uint32_t, RumViewContext> rumViews;
+
+    // Endpoint of the local root spans of the samples (see TraceEndpoints), set in the
+    // libdatadog profile on export
+    std::unordered_map<uint64_t, uint32_t> localRootSpanEndpoints;
+
+    // Label sets created when flushing, by thread, thread name, RUM view and span
+    struct LabelSetKey {
+      uint32_t threadId;
+      uint32_t threadNameId;  // see ThreadInfo::GetThreadNameId
+      uint64_t threadGroup;
+      uint32_t rumViewHandle;
+      uint64_t localRootSpanId;
+      uint64_t spanId;
+
+      bool operator==(const LabelSetKey& other) const = default;
+    };
+    struct LabelSetKeyHash {
+      size_t operator()(const LabelSetKey& key) const;
+    };
+    std::unordered_map<LabelSetKey, ddog_prof_LabelSetId, LabelSetKeyHash>
+        labelSetCache;
+    size_t createdLabelSetsCount = 0;
+
+    // Set when the generation is retired
+    std::chrono::time_point<std::chrono::system_clock> startTime;
+    std::chrono::time_point<std::chrono::system_clock> endTime;
+    uint32_t exportId = 0;
+    size_t persistentSymbolCacheSize = 0;
   };
 
-  bool InternSampleLabels(SampleLabels& labels);
+  std::unique_ptr<ProfileGeneration> CreateProfileGeneration();
+  bool ResetProfileGeneration(ProfileGeneration& generation);
+  void ApplyMemoryPressure(ProfileGeneration& generation);
+  void ReportExportMemoryUsage(const ProfileGeneration& generation);
+  std::string SerializeInfoToJson() const;
+  size_t FlushAggregatedSamples(ProfileGeneration& generation);
+  bool InternAggregatedEntries(ProfileGeneration& generation);
+
+  // Helper methods for location/function/mapping management
+  std::optional<ddog_prof_LocationId> InternLocation(
+      ProfileGeneration& generation, uint64_t address
+  );
+  std::optional<ddog_prof_FunctionId> InternFunction(
+      ProfileGeneration& generation,
+      const CachedSymbolInfo& symbolInfo,
+      ddog_prof_Profile* profile
+  );
+  std::optional<CachedSymbolInfo> Symbolicate(uint64_t address, uint32_t exportId);
+  std::optional<ddog_prof_MappingId> InternMapping(
+      ProfileGeneration& generation,
+      const CachedSymbolInfo& symbolInfo,
+      ddog_prof_Profile* profile
+  );
+
+  bool InternSampleLabels(ddog_prof_Profile* profile, SampleLabels& labels);
+  void ResolveRumView(ProfileGeneration& generation, uint32_t rumViewHandle);
+  void AddTraceEndpoints(ProfileGeneration& generation);
+  ddog_prof_LabelSetId GetOrCreateLabelSet(
+      ProfileGeneration& generation, const SampleAggregationTable::Entry& entry
+  );
   ddog_prof_LabelSetId CreateLabelSet(
-      const SampleLabels& labels,
-      std::shared_ptr<ThreadInfo> threadInfo,
-      const RumViewContext& rumView
+      ProfileGeneration& generation,
+      uint32_t threadId,
+      std::string_view threadName,
+      const RumViewContext& rumView,
+      const TraceContext& traceContext,
+      bool isThreadGroup
   );
 
   // Debug file writing methods
@@ -164,11 +312,12 @@ class ProfileExporter {
   static constexpr const char* LABEL_THREAD_NAME = "thread_name";
   static constexpr const char* LABEL_RUM_VIEW_ID = "rum.view_id";
   static constexpr const char* LABEL_TRACE_ENDPOINT = "trace endpoint";
+  static constexpr const char* LABEL_LOCAL_ROOT_SPAN_ID = "local root span id";
+  static constexpr const char* LABEL_SPAN_ID = "span id";
 
   // Cache management
   void ClearCaches();
   void CleanupUnusedCacheEntries(uint32_t currentExportId);
-  void OnExportStart();  // New method to manage cache lifecycle
 
   // Utility methods
   std::string ComputeRuntimeId();
@@ -193,14 +342,27 @@ class ProfileExporter {
   std::string _exportUrl;
   std::string _apiKey;
   bool _agentMode;  // true for agent, false for agentless
-  uint32_t _consecutiveErrors;
-  static constexpr uint32_t MAX_CONSECUTIVE_ERRORS = 3;
   static constexpr int EXPORT_TIMEOUT_MS = 10000;
+  tags _stableTags;                               // given to the exporter
+  std::unique_ptr<IntakeClient> _pIntakeClient;   // unless the URL is not supported
+  std::unique_ptr<UploadSpool> _pUploadSpool;     // unless disabled
+  std::unique_ptr<UploadQueue> _pUploadQueue;     // only when the export is enabled
 
   // libdatadog components
   ddog_prof_ManagedStringStorage _stringStorage;
   std::unique_ptr<Symbolication> _symbolication;
-  std::unique_ptr<dd_win_prof::PprofAggregator> _aggregator;
+
+  // Active generation receives the samples; the retired one is waiting to be (or is
+  // being) exported. They are swapped by RotateProfile().
+  std::unique_ptr<ProfileGeneration> _activeProfile;
+  std::unique_ptr<ProfileGeneration> _retiredProfile;
+  std::atomic<bool> _isRetiredProfilePending;
+
+  // In timeline mode, each sample keeps its timestamp in the profile; otherwise,
+  // samples with the same callstack and labels are merged into one pprof sample
+  bool _isTimelineEnabled;
+  bool _isLabelSetCacheEnabled = true;
+  ExportStats _lastExportStats;
 
   // Cache structures
   struct LocationCacheEntry {
@@ -209,26 +371,20 @@ class ProfileExporter {
   };
 
   // Persistent cache - keeps expensive symbolication results across exports
-  std::unordered_map<uint64_t, CachedSymbolInfo> _persistentSymbolCache;
-
-  // Per-export cache - cleared on each export since location IDs become invalid after
-  // profile reset
-  std::unordered_map<uint64_t, ddog_prof_LocationId> _currentExportLocationCache;
-
-  // Mapping cache - maps module identifier to mapping ID (cleared per export like
-  // locations) Key: hash of (ModuleNameId, BuildIdId) for uniqueness
-  std::unordered_map<uint64_t, ddog_prof_MappingId> _currentExportMappingCache;
+  // (only accessed on the export path, i.e. when the retired profile is flushed);
+  // bounded by DD_PROFILING_SYMBOL_CACHE_SIZE
+  SymbolCache _persistentSymbolCache;
+  // symbols of the functions (or modules) already resolved: the other addresses of
+  // the same range don't need a DbgHelp symbol lookup; bounded like the symbol cache
+  SymbolRangeCache _symbolRanges;
 
   // Export tracking
   uint32_t _currentExportId;
-  std::chrono::time_point<std::chrono::system_clock> _profileStartTime;
 
-  // number of sent profiles before cleaning up caches
+  // number of sent profiles before cleaning up caches: the symbols not used since the
+  // previous cleanup are evicted
   static constexpr uint32_t CACHE_CLEANUP_THRESHOLD = 100;
 
-  // Interned sample labels (reused across samples)
-  SampleLabels _sampleLabels;
-
   // RUM application ID (set once, emitted as profile tag per-export)
   std::string _rumApplicationId;
 
@@ -236,4 +392,19 @@ class ProfileExporter {
   IRumRecordProvider* _pRumRecordProvider;
   std::vector<RumViewRecord> _viewRecordsBuffer;
   std::vector<RumSessionRecord> _sessionRecordsBuffer;
+
+  // used to get the name of the sampled threads (optional)
+  ThreadList* _pThreadList;
+
+  // used to get the strings of the RUM views of the samples (optional)
+  const RumViewRegistry* _pRumViewRegistry;
+
+  // endpoints of the local root spans and their counts (optional)
+  TraceEndpoints* _pTraceEndpoints;
+  std::vector<std::pair<uint32_t, int64_t>> _endpointCountsBuffer;
+
+  // memory used by the profiles and the upload queue, reported in the info JSON of
+  // the profiles (optional)
+  MemoryBudget* _pMemoryBudget;
+  MemoryPressure _memoryPressure;  // applied to the active profile by Add()
 };
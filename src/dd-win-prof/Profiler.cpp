@@ -45,6 +45,17 @@ bool Profiler::StartProfiling() {
   _pCpuTimeProvider = std::make_unique<CpuTimeProvider>(valueTypeProvider);
   _pCpuWallTimeProvider = std::make_unique<WallTimeProvider>(valueTypeProvider);
 
+  // the rings of the providers are allocated once for all
+  _pMemoryBudget = std::make_unique<MemoryBudget>(_pConfiguration->GetMaxMemory());
+  size_t ringsSize = 0;
+  if (_pConfiguration->IsCpuProfilingEnabled()) {
+    ringsSize += _pCpuTimeProvider->GetMemorySize();
+  }
+  if (_pConfiguration->IsWallTimeProfilingEnabled()) {
+    ringsSize += _pCpuWallTimeProvider->GetMemorySize();
+  }
+  _pMemoryBudget->SetUsage(MemoryStage::SampleRings, ringsSize);
+
   // create the thread responsible for looping through the thread list
   _pStackSamplerLoop = std::make_unique<StackSamplerLoop>(
       _pConfiguration.get(),
@@ -52,7 +63,8 @@ bool Profiler::StartProfiling() {
       _pCpuTimeProvider.get(),
       _pCpuWallTimeProvider.get(),
       this,
-      this
+      this,
+      _pMemoryBudget.get()
   );
 
   // get the values definition from the different providers...
@@ -61,7 +73,13 @@ bool Profiler::StartProfiling() {
 
   //... and pass them to the exporter
   _pProfileExporter = std::make_unique<ProfileExporter>(
-      _pConfiguration.get(), sampleTypeDefinitions, this
+      _pConfiguration.get(),
+      sampleTypeDefinitions,
+      this,
+      _pThreadList.get(),
+      &_rumViews,
+      &_traceEndpoints,
+      _pMemoryBudget.get()
   );
 
   // Initialize the ProfileExporter
@@ -82,7 +100,10 @@ bool Profiler::StartProfiling() {
 
   // create the samples collector and pass it the exporter
   _pSamplesCollector = std::make_unique<SamplesCollector>(
-      _pConfiguration.get(), _pProfileExporter.get()
+      _pConfiguration.get(),
+      _pProfileExporter.get(),
+      _pStackSamplerLoop.get(),
+      _pThreadList.get()
   );
 
   // register the providers to the collector
@@ -154,9 +175,42 @@ bool Profiler::AddCurrentThread() {
   return true;
 }
 
+// ThreadInfo of the calling thread, looked up once per thread: the trace context is
+// published each time a span starts or ends on the thread
+static thread_local std::shared_ptr<ThreadInfo> CurrentThreadInfo;
+
 void Profiler::RemoveCurrentThread() {
   auto tid = ::GetCurrentThreadId();
   _pThreadList->RemoveThread(tid);
+  CurrentThreadInfo.reset();
+}
+
+bool Profiler::SetTraceContext(
+    uint64_t localRootSpanId, uint64_t spanId, const char* endpoint
+) {
+  if (CurrentThreadInfo == nullptr) {
+    CurrentThreadInfo = _pThreadList->FindThread(::GetCurrentThreadId());
+    if (CurrentThreadInfo == nullptr) {
+      return false;
+    }
+  }
+
+  TraceContext context{localRootSpanId, spanId, TraceEndpoints::NoEndpoint};
+  if ((localRootSpanId != 0) && (endpoint != nullptr)) {
+    context.endpointId = _traceEndpoints.Intern(endpoint);
+  }
+
+  // a local root span is counted for its endpoint when it starts, i.e. when it is
+  // published as the current span (a span running on several threads is counted
+  // once per thread)
+  auto& slot = CurrentThreadInfo->GetTraceContextSlot();
+  if ((localRootSpanId != 0) && (spanId == localRootSpanId) &&
+      (slot.GetLocalRootSpanId() != localRootSpanId)) {
+    _traceEndpoints.CountLocalRootSpan(context.endpointId);
+  }
+
+  slot.Write(context);
+  return true;
 }
 
 static std::string GenerateUuidV4() {
@@ -264,6 +318,7 @@ void Profiler::CompleteCurrentView() {
 
   _currentRumView.view_id.clear();
   _currentRumView.view_name.clear();
+  _rumViews.Leave();
 }
 
 bool Profiler::SetRumView(const RumViewValues* pContext) {
@@ -293,6 +348,8 @@ bool Profiler::SetRumView(const RumViewValues* pContext) {
 
   for (auto& a : _pendingVitalsNs) a.store(0, std::memory_order_relaxed);
 
+  // published last: the samples taken from now on belong to the new view
+  _rumViews.Enter(_currentRumView.view_id, _currentRumView.view_name);
   return true;
 }
 
@@ -324,6 +381,8 @@ bool Profiler::GetCurrentViewContext(RumViewContext& context) const {
   return true;
 }
 
+uint32_t Profiler::GetCurrentViewHandle() const { return _rumViews.GetCurrentHandle(); }
+
 void Profiler::ConsumeViewRecords(std::vector<RumViewRecord>& records) {
   std::unique_lock lock(_rumContextMutex);
   _completedViewRecords.swap(records);
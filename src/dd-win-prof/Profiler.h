@@ -6,11 +6,14 @@
 
 #include "Configuration.h"
 #include "CpuTimeProvider.h"
+#include "MemoryBudget.h"
 #include "ProfileExporter.h"
 #include "RumContext.h"
+#include "RumViewRegistry.h"
 #include "SamplesCollector.h"
 #include "StackSamplerLoop.h"
 #include "ThreadList.h"
+#include "TraceContext.h"
 #include "dd-win-prof.h"
 #include "dd-win-rum-private.h"
 #include "pch.h"
@@ -40,8 +43,13 @@ class Profiler : public IRumViewContextProvider,
   bool SetRumSession(const RumSessionContext* pContext);
   bool SetRumView(const RumViewValues* pContext);
 
+  // Trace context of the calling thread (called from the C API, lock-free once the
+  // thread and the endpoint are known)
+  bool SetTraceContext(uint64_t localRootSpanId, uint64_t spanId, const char* endpoint);
+
   // IRumViewContextProvider implementation
   bool GetCurrentViewContext(RumViewContext& context) const override;
+  uint32_t GetCurrentViewHandle() const override;
 
   // IRumRecordProvider implementation
   void ConsumeViewRecords(std::vector<RumViewRecord>& records) override;
@@ -75,6 +83,9 @@ class Profiler : public IRumViewContextProvider,
   std::atomic<bool> _isStarted;
 
   std::unique_ptr<ThreadList> _pThreadList;
+
+  // memory used by the samples pipeline: must outlive the sampler and the exporter
+  std::unique_ptr<MemoryBudget> _pMemoryBudget;
   std::unique_ptr<StackSamplerLoop> _pStackSamplerLoop;
 
   // providers
@@ -91,6 +102,14 @@ class Profiler : public IRumViewContextProvider,
   mutable std::shared_mutex _rumContextMutex;
   RumViewContext _currentRumView;
 
+  // Views published to the sampler (handle of the current view) and resolved by the
+  // exporter; updated under _rumContextMutex exclusive
+  RumViewRegistry _rumViews;
+
+  // Endpoints of the local root spans published with SetTraceContext (the trace
+  // context itself is stored in the ThreadInfo of each thread)
+  TraceEndpoints _traceEndpoints;
+
   void CompleteCurrentView();     // caller must hold _rumContextMutex exclusive
   void CompleteCurrentSession();  // caller must hold _rumContextMutex exclusive
 
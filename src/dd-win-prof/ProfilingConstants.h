@@ -4,10 +4,15 @@
 
 #pragma once
 
+#include <cstddef>
+
 namespace dd_win_prof {
 // Maximum depth for a single stack
 inline constexpr size_t kMaxStackDepth{512};
 
+// Maximum number of values for a single sample
+inline constexpr size_t kMaxValuesCount{16};
+
 // Other shared constants can be added here as needed
 // inline constexpr size_t kMaxCacheSize{10000};
 // inline constexpr uint32_t kCacheCleanupThreshold{5};
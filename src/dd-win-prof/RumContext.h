@@ -44,6 +44,11 @@ class IRumViewContextProvider {
   // Returns true and fills 'context' with a copy of the current view if active.
   // Returns false if no view is currently active.
   virtual bool GetCurrentViewContext(RumViewContext& context) const = 0;
+
+  // Called from the sampler hot path (lock-free, no copy).
+  // Returns the handle of the current view in the RumViewRegistry, or
+  // RumViewRegistry::NoView (0) if no view is currently active.
+  virtual uint32_t GetCurrentViewHandle() const = 0;
 };
 
 class IViewVitalsAccumulator {
@@ -0,0 +1,50 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "RumViewRegistry.h"
+
+#include "pch.h"
+
+RumViewRegistry::RumViewRegistry()
+    : _records(Capacity), _nextHandle(NoView + 1), _currentHandle(NoView) {}
+
+uint32_t RumViewRegistry::Enter(std::string_view viewId, std::string_view viewName) {
+  uint32_t handle = NoView;
+  {
+    std::lock_guard<std::mutex> lock(_recordsMutex);
+
+    handle = _nextHandle++;
+    if (_nextHandle == NoView) {
+      _nextHandle = NoView + 1;
+    }
+
+    // the record is complete before its handle is published
+    auto& record = _records[handle % Capacity];
+    record.handle = handle;
+    record.view.view_id.assign(viewId);
+    record.view.view_name.assign(viewName);
+  }
+
+  _currentHandle.store(handle, std::memory_order_release);
+  return handle;
+}
+
+void RumViewRegistry::Leave() {
+  _currentHandle.store(NoView, std::memory_order_release);
+}
+
+bool RumViewRegistry::Resolve(uint32_t handle, RumViewContext& view) const {
+  if (handle == NoView) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(_recordsMutex);
+  auto const& record = _records[handle % Capacity];
+  if (record.handle != handle) {
+    return false;
+  }
+
+  view = record.view;
+  return true;
+}
@@ -0,0 +1,62 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "RumContext.h"
+#include "pch.h"
+
+// Interned RUM views: each view entered by the application is registered once as an
+// immutable record identified by a 32-bit handle. The sampler only reads the handle
+// of the current view (one atomic load: no lock nor string copy) and stores it in the
+// samples; the exporter resolves the handles into the view strings once per profile.
+//
+// The records are kept in a fixed ring: the record of a view is overwritten once
+// Capacity newer views have been entered, long after its samples have been exported.
+// Resolving an overwritten handle fails (the samples lose their view labels).
+class RumViewRegistry {
+ public:
+  // handle of the samples taken outside of any view
+  static constexpr uint32_t NoView = 0;
+  static constexpr size_t Capacity = 1024;
+
+ public:
+  RumViewRegistry();
+
+  // Register a new view and make it the current one: return its handle
+  uint32_t Enter(std::string_view viewId, std::string_view viewName);
+
+  // No current view anymore (the record of the previous one can still be resolved)
+  void Leave();
+
+  // Sampler hot path: NoView if there is no current view
+  inline uint32_t GetCurrentHandle() const {
+    return _currentHandle.load(std::memory_order_acquire);
+  }
+
+  // Copy the strings of the view: return false if the handle is unknown or if its
+  // record has been overwritten
+  bool Resolve(uint32_t handle, RumViewContext& view) const;
+
+ private:
+  struct Record {
+    uint32_t handle = NoView;
+    RumViewContext view;
+  };
+
+ private:
+  // the writers (view changes) and the exporter are serialized; the sampler never
+  // takes this lock
+  mutable std::mutex _recordsMutex;
+  std::vector<Record> _records;
+  uint32_t _nextHandle;
+
+  std::atomic<uint32_t> _currentHandle;
+};
@@ -4,21 +4,27 @@
 
 #include "Sample.h"
 
+#include <algorithm>
+
 #include "pch.h"
 
-// TODO: update the values vector size if more than 16 slots are needed
-size_t Sample::ValuesCount = 16;  // should be set BEFORE any sample gets created
+size_t Sample::ValuesCount =
+    dd_win_prof::kMaxValuesCount;  // should be set BEFORE any sample gets created
 
 Sample::Sample(
     std::chrono::nanoseconds timestamp,
-    std::shared_ptr<ThreadInfo> threadInfo,
-    uint64_t* pFrames,
-    size_t framesCount
+    uint32_t threadId,
+    std::span<const uint64_t> frames
 )
-    : _timestamp(timestamp),
-      _callstack(pFrames, pFrames + framesCount),
-      _values(ValuesCount, 0),  // Initialize with zeros for sane defaults
-      _threadInfo(std::move(threadInfo)) {}
+    : _timestamp(timestamp), _threadId(threadId), _frames(frames) {}
+
+void Sample::SetValuesCount(size_t count) {
+  if (count > dd_win_prof::kMaxValuesCount) {
+    throw std::invalid_argument("count");
+  }
+
+  ValuesCount = count;
+}
 
 void Sample::AddValue(std::int64_t value, size_t index) {
   if (index >= ValuesCount) {
@@ -27,3 +33,39 @@ void Sample::AddValue(std::int64_t value, size_t index) {
 
   _values[index] = value;
 }
+
+Sample& SampleBatch::Add(
+    std::chrono::nanoseconds timestamp,
+    uint32_t threadId,
+    std::span<const uint64_t> frames
+) {
+  auto storage = AllocateFrames(frames.size());
+  std::copy_n(frames.begin(), storage.size(), storage.begin());
+
+  return _samples.emplace_back(timestamp, threadId, storage);
+}
+
+std::span<uint64_t> SampleBatch::AllocateFrames(size_t count) {
+  // a callstack is never split between two chunks
+  count = std::min(count, FramesChunkSize);
+  if ((_currentChunk < _framesChunks.size()) &&
+      (_currentChunkOffset + count > FramesChunkSize)) {
+    _currentChunk++;
+    _currentChunkOffset = 0;
+  }
+
+  if (_currentChunk == _framesChunks.size()) {
+    _framesChunks.push_back(std::make_unique<uint64_t[]>(FramesChunkSize));
+    _currentChunkOffset = 0;
+  }
+
+  auto* pFrames = _framesChunks[_currentChunk].get() + _currentChunkOffset;
+  _currentChunkOffset += count;
+  return {pFrames, count};
+}
+
+void SampleBatch::Clear() {
+  _samples.clear();
+  _currentChunk = 0;
+  _currentChunkOffset = 0;
+}
@@ -3,46 +3,109 @@
 // (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
 
 #pragma once
-#include "RumContext.h"
+#include <array>
+
+#include "ProfilingConstants.h"
 #include "SampleValueType.h"
-#include "ThreadInfo.h"
+#include "TraceContext.h"
 #include "pch.h"
 
+// Compact sample record: creating, copying or moving a Sample never allocates.
+// - the thread is identified by its id (no reference counting)
+// - the values are stored inline (only the first ValuesCount ones are used)
+// - the frames are NOT owned: they usually point into the arena of the SampleBatch
+//   the sample belongs to, so a Sample must not outlive its batch
 class Sample {
  public:
   static size_t ValuesCount;
 
  public:
+  Sample() = default;
   Sample(
       std::chrono::nanoseconds timestamp,
-      std::shared_ptr<ThreadInfo> threadInfo,
-      uint64_t* pFrames,
-      size_t framesCount
+      uint32_t threadId,
+      std::span<const uint64_t> frames
   );
 
-  // let compiler generating the move and copy ctors/assignment operators
-  Sample(const Sample&) = default;
-  Sample& operator=(const Sample& sample) = default;
-  Sample(Sample&& sample) noexcept = default;
-  Sample& operator=(Sample&& other) noexcept = default;
-
   void AddValue(std::int64_t value, size_t index);
 
   // Static setter for ValuesCount
-  static void SetValuesCount(size_t count) { ValuesCount = count; }
+  static void SetValuesCount(size_t count);
+
+  inline std::chrono::nanoseconds GetTimestamp() const { return _timestamp; }
+  inline uint32_t GetThreadId() const { return _threadId; }
+  // see ThreadInfo::GetGeneration(); 0 if unknown
+  inline uint64_t GetThreadGeneration() const { return _threadGeneration; }
+  void SetThreadGeneration(uint64_t generation) { _threadGeneration = generation; }
+
+  // Folded walltime samples stand for several waiting threads of the same thread name
+  // group (see WalltimeSampleFolder): the thread id is the one of the first thread.
+  // Both are 0 for the other samples.
+  inline uint64_t GetThreadGroup() const { return _threadGroup; }
+  inline uint32_t GetFoldedThreadsCount() const { return _foldedThreadsCount; }
+  void SetThreadGroup(uint64_t threadGroup, uint32_t foldedThreadsCount) {
+    _threadGroup = threadGroup;
+    _foldedThreadsCount = foldedThreadsCount;
+  }
+  inline std::span<const uint64_t> GetFrames() const { return _frames; }
+  inline std::span<const int64_t> GetValues() const {
+    return {_values.data(), ValuesCount};
+  }
+
+  // handle of the RUM view in the RumViewRegistry (0 = no view): the view strings are
+  // resolved by the exporter
+  void SetRumViewHandle(uint32_t handle) { _rumViewHandle = handle; }
+  inline uint32_t GetRumViewHandle() const { return _rumViewHandle; }
+
+  // span running on the thread when it was sampled (empty if none)
+  void SetTraceContext(const TraceContext& context) { _traceContext = context; }
+  inline const TraceContext& GetTraceContext() const { return _traceContext; }
+
+ private:
+  std::chrono::nanoseconds _timestamp{0};
+  uint32_t _threadId = 0;
+  uint64_t _threadGeneration = 0;
+  uint64_t _threadGroup = 0;
+  uint32_t _foldedThreadsCount = 0;
+  std::span<const uint64_t> _frames;
+  std::array<int64_t, dd_win_prof::kMaxValuesCount> _values{};
+  uint32_t _rumViewHandle = 0;
+  TraceContext _traceContext;
+};
 
-  inline std::chrono::nanoseconds GetTimestamp() { return _timestamp; }
-  inline std::span<const uint64_t> GetFrames() { return _callstack; }
-  inline std::span<const int64_t> GetValues() { return _values; }
-  inline std::shared_ptr<ThreadInfo> GetThreadInfo() { return _threadInfo; }
+// Samples collected together with the storage of their frames.
+// Both the samples vector and the frames chunks are kept when the batch is cleared so
+// that, once warmed up, filling a batch does not allocate anymore.
+class SampleBatch {
+ public:
+  SampleBatch() = default;
+  SampleBatch(const SampleBatch&) = delete;
+  SampleBatch& operator=(const SampleBatch&) = delete;
+
+  // Copy the frames into the batch arena and return the new sample
+  Sample& Add(
+      std::chrono::nanoseconds timestamp,
+      uint32_t threadId,
+      std::span<const uint64_t> frames
+  );
+
+  void Clear();
 
-  void SetRumViewContext(RumViewContext&& ctx) { _rumViewContext = std::move(ctx); }
-  const RumViewContext& GetRumViewContext() const { return _rumViewContext; }
+  inline std::span<const Sample> GetSamples() const { return _samples; }
+  inline size_t Size() const { return _samples.size(); }
+  inline bool Empty() const { return _samples.empty(); }
 
  private:
-  std::chrono::nanoseconds _timestamp;
-  std::vector<uint64_t> _callstack;
-  std::vector<int64_t> _values;
-  std::shared_ptr<ThreadInfo> _threadInfo;
-  RumViewContext _rumViewContext;
+  std::span<uint64_t> AllocateFrames(size_t count);
+
+ private:
+  // a chunk can hold at least 128 full callstacks (512 KB)
+  static constexpr size_t FramesChunkSize = 128 * dd_win_prof::kMaxStackDepth;
+
+  std::vector<Sample> _samples;
+
+  // chunks are never reallocated (unlike a vector) so the frames spans stay valid
+  std::vector<std::unique_ptr<uint64_t[]>> _framesChunks;
+  size_t _currentChunk = 0;
+  size_t _currentChunkOffset = 0;
 };
@@ -0,0 +1,239 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "SampleAggregationTable.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "Symbolication.h"
+#include "pch.h"
+
+SampleAggregationTable::SampleAggregationTable(
+    size_t valuesCount, bool isTimelineEnabled, size_t initialCapacity
+)
+    : _valuesCount(valuesCount),
+      _samplesCount(0),
+      _droppedSamplesCount(0),
+      _maxEntriesCount(0),
+      _isTimelineEnabled(isTimelineEnabled),
+      _isTimelineSuspended(false) {
+  size_t capacity = std::bit_ceil(std::max<size_t>(initialCapacity, 16));
+  _slots.resize(capacity, 0);
+  _mask = capacity - 1;
+}
+
+uint64_t SampleAggregationTable::ComputeHash(
+    std::span<const uint64_t> frames,
+    uint32_t threadId,
+    uint64_t threadGroup,
+    uint32_t rumViewHandle,
+    const TraceContext& traceContext
+) {
+  uint64_t hash = frames.size();
+  for (auto frame : frames) {
+    hash_combine(hash, frame);
+  }
+
+  hash_combine(hash, threadId);
+  hash_combine(hash, threadGroup);
+  hash_combine(hash, rumViewHandle);
+  hash_combine(hash, traceContext.localRootSpanId);
+  hash_combine(hash, traceContext.spanId);
+
+  return hash;
+}
+
+bool SampleAggregationTable::IsSameKey(
+    const Entry& entry,
+    uint64_t hash,
+    std::span<const uint64_t> frames,
+    uint32_t threadId,
+    uint64_t threadGroup,
+    uint32_t rumViewHandle,
+    const TraceContext& traceContext
+) const {
+  if ((entry.hash != hash) || (entry.framesCount != frames.size()) ||
+      (entry.threadId != threadId) || (entry.threadGroup != threadGroup) ||
+      (entry.rumViewHandle != rumViewHandle) || (entry.traceContext != traceContext)) {
+    return false;
+  }
+
+  return std::memcmp(
+             _frames.data() + entry.framesOffset,
+             frames.data(),
+             frames.size() * sizeof(uint64_t)
+         ) == 0;
+}
+
+SampleAggregationTable::Entry* SampleAggregationTable::Add(
+    std::span<const uint64_t> frames,
+    std::span<const int64_t> values,
+    uint32_t threadId,
+    uint32_t rumViewHandle,
+    std::chrono::nanoseconds timestamp,
+    uint64_t threadGroup,
+    const TraceContext& traceContext
+) {
+  auto hash = ComputeHash(frames, threadId, threadGroup, rumViewHandle, traceContext);
+  auto valuesCount = std::min(values.size(), _valuesCount);
+
+  // linear probing until the same key or an empty slot is found
+  size_t slot = hash & _mask;
+  while (_slots[slot] != 0) {
+    size_t entryIndex = _slots[slot] - 1;
+    if (IsSameKey(
+            _entries[entryIndex],
+            hash,
+            frames,
+            threadId,
+            threadGroup,
+            rumViewHandle,
+            traceContext
+        )) {
+      _samplesCount++;
+      int64_t* pValues = _values.data() + entryIndex * _valuesCount;
+      for (size_t i = 0; i < valuesCount; i++) {
+        pValues[i] += values[i];
+      }
+
+      if (_isTimelineEnabled) {
+        AddTimedSample(entryIndex, values, timestamp);
+      }
+      return nullptr;
+    }
+
+    slot = (slot + 1) & _mask;
+  }
+
+  if ((_maxEntriesCount != 0) && (_entries.size() >= _maxEntriesCount)) {
+    _droppedSamplesCount++;
+    return nullptr;
+  }
+
+  // new key: store its frames and values in the arenas
+  Entry entry;
+  entry.hash = hash;
+  entry.framesOffset = static_cast<uint32_t>(_frames.size());
+  entry.framesCount = static_cast<uint32_t>(frames.size());
+  entry.threadId = threadId;
+  entry.threadGroup = threadGroup;
+  entry.rumViewHandle = rumViewHandle;
+  entry.traceContext = traceContext;
+
+  _frames.insert(_frames.end(), frames.begin(), frames.end());
+  AppendValues(_values, values);
+  _entries.push_back(std::move(entry));
+  _slots[slot] = static_cast<uint32_t>(_entries.size());
+  _samplesCount++;
+
+  if (_isTimelineEnabled) {
+    AddTimedSample(_entries.size() - 1, values, timestamp);
+  }
+
+  if (_entries.size() * MaxLoadDenominator > _slots.size() * MaxLoadNumerator) {
+    Grow();
+  }
+
+  return &_entries.back();
+}
+
+void SampleAggregationTable::AppendValues(
+    std::vector<int64_t>& arena, std::span<const int64_t> values
+) const {
+  // missing values are zeroed and extra ones are ignored
+  auto valuesCount = std::min(values.size(), _valuesCount);
+  arena.insert(arena.end(), values.begin(), values.begin() + valuesCount);
+  arena.resize(arena.size() + (_valuesCount - valuesCount), 0);
+}
+
+void SampleAggregationTable::AddTimedSample(
+    size_t entryIndex,
+    std::span<const int64_t> values,
+    std::chrono::nanoseconds timestamp
+) {
+  if (!_isTimelineSuspended) {
+    _timedSamples.push_back(
+        {static_cast<uint32_t>(entryIndex), static_cast<int64_t>(timestamp.count())}
+    );
+    AppendValues(_timedValues, values);
+    return;
+  }
+
+  // the entries created since the last suspended sample get zeroed values
+  if (_untimedValues.size() < _entries.size() * _valuesCount) {
+    _untimedValues.resize(_entries.size() * _valuesCount, 0);
+  }
+
+  int64_t* pValues = _untimedValues.data() + entryIndex * _valuesCount;
+  auto valuesCount = std::min(values.size(), _valuesCount);
+  for (size_t i = 0; i < valuesCount; i++) {
+    pValues[i] += values[i];
+  }
+}
+
+std::span<const int64_t> SampleAggregationTable::GetUntimedValues(
+    size_t entryIndex
+) const {
+  // entries created after the last suspended sample have no untimed values
+  if ((entryIndex + 1) * _valuesCount > _untimedValues.size()) {
+    return {};
+  }
+
+  return {_untimedValues.data() + entryIndex * _valuesCount, _valuesCount};
+}
+
+size_t SampleAggregationTable::GetMemorySize() const {
+  return _slots.capacity() * sizeof(uint32_t) + _entries.capacity() * sizeof(Entry) +
+         _frames.capacity() * sizeof(uint64_t) +
+         (_values.capacity() + _timedValues.capacity() + _untimedValues.capacity()) *
+             sizeof(int64_t) +
+         _timedSamples.capacity() * sizeof(TimedSample);
+}
+
+void SampleAggregationTable::Grow() {
+  size_t capacity = _slots.size() * 2;
+  _slots.assign(capacity, 0);
+  _mask = capacity - 1;
+
+  // only the index needs to be rebuilt: the entries are not moved
+  for (size_t i = 0; i < _entries.size(); i++) {
+    size_t slot = _entries[i].hash & _mask;
+    while (_slots[slot] != 0) {
+      slot = (slot + 1) & _mask;
+    }
+    _slots[slot] = static_cast<uint32_t>(i + 1);
+  }
+}
+
+void SampleAggregationTable::Clear(bool releaseMemory) {
+  _samplesCount = 0;
+  _droppedSamplesCount = 0;
+
+  if (releaseMemory) {
+    // back to the initial capacity of the index (the arenas will grow again)
+    size_t capacity = std::min<size_t>(_slots.size(), 1024);
+    std::vector<uint32_t>(capacity, 0).swap(_slots);
+    _mask = capacity - 1;
+    std::vector<Entry>().swap(_entries);
+    std::vector<uint64_t>().swap(_frames);
+    std::vector<int64_t>().swap(_values);
+    std::vector<TimedSample>().swap(_timedSamples);
+    std::vector<int64_t>().swap(_timedValues);
+    std::vector<int64_t>().swap(_untimedValues);
+    return;
+  }
+
+  if (!_entries.empty()) {
+    std::fill(_slots.begin(), _slots.end(), 0);
+  }
+
+  _entries.clear();
+  _frames.clear();
+  _values.clear();
+  _timedSamples.clear();
+  _timedValues.clear();
+  _untimedValues.clear();
+}
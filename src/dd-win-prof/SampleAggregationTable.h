@@ -0,0 +1,172 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "ThreadInfo.h"
+#include "TraceContext.h"
+#include "pch.h"
+
+// Pre-aggregation of samples before they are sent to libdatadog.
+// Samples with the same callstack and the same labels (thread id or thread group, RUM
+// view handle, trace context) are folded into a single entry whose values are summed
+// in place. The entries are interned into the pprof profile only once, at export time,
+// so the FFI cost depends on the number of unique stacks instead of the number of
+// samples.
+//
+// In timeline mode, each sample is also recorded with its timestamp and its own values
+// (pointing to its entry): the callstack and labels are still interned once per entry
+// but one pprof sample per recorded sample is needed to keep the timeline.
+//
+// The table uses open addressing (linear probing) on an index array whose size is a
+// power of 2; the entries themselves are stored densely so iterating over them when
+// flushing does not need to skip empty slots. Frames and values are stored in flat
+// arenas to avoid per-entry allocations.
+//
+// Under memory pressure (see MemoryBudget), the owner can suspend the timeline: the
+// next samples are only summed into their entry (without timestamp) instead of being
+// recorded one by one, and can limit the number of entries: the samples with a new
+// callstack or new labels are then dropped.
+//
+// Not thread-safe: the owner is responsible for the synchronization.
+class SampleAggregationTable {
+ public:
+  struct Entry {
+    uint64_t hash;
+    uint32_t framesOffset;
+    uint32_t framesCount;
+    uint32_t threadId;
+    uint64_t threadGroup;  // folded walltime samples only (see Sample::GetThreadGroup)
+    uint32_t rumViewHandle;  // see RumViewRegistry
+    TraceContext traceContext;
+
+    // not part of the key: can be set by the owner when the entry is created
+    std::shared_ptr<ThreadInfo> threadInfo;
+  };
+
+  // sample recorded in timeline mode
+  struct TimedSample {
+    uint32_t entryIndex;
+    int64_t timestamp;  // in nanoseconds
+  };
+
+ public:
+  explicit SampleAggregationTable(
+      size_t valuesCount, bool isTimelineEnabled = false, size_t initialCapacity = 1024
+  );
+
+  // Sum the values into the entry matching the callstack and the labels (the entry is
+  // created the first time they are seen). The timestamp is only kept in timeline mode.
+  // Return the entry if it has just been created (nullptr otherwise, including when the
+  // sample is dropped); the pointer is only valid until the next call.
+  Entry* Add(
+      std::span<const uint64_t> frames,
+      std::span<const int64_t> values,
+      uint32_t threadId,
+      uint32_t rumViewHandle,
+      std::chrono::nanoseconds timestamp = std::chrono::nanoseconds::zero(),
+      uint64_t threadGroup = 0,
+      const TraceContext& traceContext = {}
+  );
+
+  // Remove all entries; the allocated memory is kept for the next profile unless
+  // releaseMemory is true
+  void Clear(bool releaseMemory = false);
+
+  // Timeline mode only: while suspended, the samples are summed into their entry
+  // without timestamp (see GetUntimedValues)
+  void SetTimelineSuspended(bool isSuspended) { _isTimelineSuspended = isSuspended; }
+
+  // The samples that would create an entry beyond this count are dropped (0 = no limit)
+  void SetMaxEntriesCount(size_t maxEntriesCount) {
+    _maxEntriesCount = maxEntriesCount;
+  }
+
+  // Estimation of the allocated memory in bytes
+  size_t GetMemorySize() const;
+
+  inline size_t GetEntriesCount() const { return _entries.size(); }
+  inline uint64_t GetSamplesCount() const { return _samplesCount; }
+  inline uint64_t GetDroppedSamplesCount() const { return _droppedSamplesCount; }
+  inline size_t GetValuesCount() const { return _valuesCount; }
+  inline bool IsTimelineEnabled() const { return _isTimelineEnabled; }
+  inline const std::vector<Entry>& GetEntries() const { return _entries; }
+
+  inline std::span<const uint64_t> GetFrames(const Entry& entry) const {
+    return {_frames.data() + entry.framesOffset, entry.framesCount};
+  }
+
+  inline std::span<const int64_t> GetValues(size_t entryIndex) const {
+    return {_values.data() + entryIndex * _valuesCount, _valuesCount};
+  }
+
+  // timeline mode only (empty otherwise)
+  inline const std::vector<TimedSample>& GetTimedSamples() const {
+    return _timedSamples;
+  }
+
+  inline std::span<const int64_t> GetTimedValues(size_t timedSampleIndex) const {
+    return {_timedValues.data() + timedSampleIndex * _valuesCount, _valuesCount};
+  }
+
+  // timeline mode only: sum of the samples added to the entry while the timeline was
+  // suspended (empty if the timeline has never been suspended)
+  inline bool HasUntimedSamples() const { return !_untimedValues.empty(); }
+  std::span<const int64_t> GetUntimedValues(size_t entryIndex) const;
+
+ private:
+  static uint64_t ComputeHash(
+      std::span<const uint64_t> frames,
+      uint32_t threadId,
+      uint64_t threadGroup,
+      uint32_t rumViewHandle,
+      const TraceContext& traceContext
+  );
+  bool IsSameKey(
+      const Entry& entry,
+      uint64_t hash,
+      std::span<const uint64_t> frames,
+      uint32_t threadId,
+      uint64_t threadGroup,
+      uint32_t rumViewHandle,
+      const TraceContext& traceContext
+  ) const;
+  void Grow();
+  void AppendValues(std::vector<int64_t>& arena, std::span<const int64_t> values) const;
+  void AddTimedSample(
+      size_t entryIndex,
+      std::span<const int64_t> values,
+      std::chrono::nanoseconds timestamp
+  );
+
+ private:
+  // max load factor = 7/10
+  static constexpr size_t MaxLoadNumerator = 7;
+  static constexpr size_t MaxLoadDenominator = 10;
+
+  // index + 1 of the entry in _entries (0 means empty slot)
+  std::vector<uint32_t> _slots;
+  size_t _mask;
+
+  std::vector<Entry> _entries;
+  std::vector<uint64_t> _frames;
+  std::vector<int64_t> _values;
+  size_t _valuesCount;
+  uint64_t _samplesCount;
+  uint64_t _droppedSamplesCount;
+  size_t _maxEntriesCount;
+
+  bool _isTimelineEnabled;
+  bool _isTimelineSuspended;
+  std::vector<TimedSample> _timedSamples;
+  std::vector<int64_t> _timedValues;
+  // allocated the first time the timeline is suspended: one set of values per entry
+  std::vector<int64_t> _untimedValues;
+};
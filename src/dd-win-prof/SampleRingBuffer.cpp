@@ -0,0 +1,128 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "SampleRingBuffer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "pch.h"
+
+SampleRingBuffer::SampleRingBuffer(size_t capacity)
+    : _capacity(std::bit_ceil(std::max<size_t>(capacity, 2))),
+      _mask(_capacity - 1),
+      _slots(std::make_unique<Slot[]>(_capacity)),
+      _pWakeupSignal(nullptr),
+      _highWaterMark(_capacity / 2),
+      _head(0),
+      _cachedTail(0),
+      _droppedCount(0),
+      _tail(0),
+      _peakPendingCount(0) {}
+
+void SampleRingBuffer::SetWakeupSignal(WakeupSignal* pSignal, size_t highWaterMark) {
+  _pWakeupSignal = pSignal;
+  _highWaterMark =
+      (highWaterMark == 0) ? _capacity / 2 : (std::min)(highWaterMark, _capacity);
+}
+
+SampleRingBuffer::Slot* SampleRingBuffer::TryReserve() {
+  auto head = _head.load(std::memory_order_relaxed);
+
+  // only read the consumer position when the ring looks full
+  if (head - _cachedTail >= _capacity) {
+    _cachedTail = _tail.load(std::memory_order_acquire);
+    if (head - _cachedTail >= _capacity) {
+      _droppedCount.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+  }
+
+  Slot* pSlot = &_slots[head & _mask];
+  pSlot->values.fill(0);
+  pSlot->framesCount = 0;
+  return pSlot;
+}
+
+void SampleRingBuffer::Commit() {
+  // publish the slot content written by the producer
+  auto head = _head.load(std::memory_order_relaxed) + 1;
+  _head.store(head, std::memory_order_release);
+
+  if (_pWakeupSignal == nullptr) {
+    return;
+  }
+
+  // the cached consumer position is refreshed only when the ring looks above the
+  // high-water mark: a drain since the last refresh could have emptied it
+  if (head - _cachedTail >= _highWaterMark) {
+    _cachedTail = _tail.load(std::memory_order_acquire);
+    if (head - _cachedTail >= _highWaterMark) {
+      _pWakeupSignal->Notify();
+    }
+  }
+}
+
+bool SampleRingBuffer::TryPush(
+    std::chrono::nanoseconds timestamp,
+    uint32_t threadId,
+    std::span<const uint64_t> frames,
+    std::span<const int64_t> values
+) {
+  Slot* pSlot = TryReserve();
+  if (pSlot == nullptr) {
+    return false;
+  }
+
+  auto framesCount = std::min(frames.size(), dd_win_prof::kMaxStackDepth);
+  auto valuesCount = std::min(values.size(), dd_win_prof::kMaxValuesCount);
+
+  pSlot->timestamp = timestamp;
+  pSlot->threadId = threadId;
+  pSlot->threadGeneration = 0;
+  pSlot->threadGroup = 0;
+  pSlot->foldedThreadsCount = 0;
+  pSlot->rumViewHandle = 0;
+  pSlot->traceContext = {};
+  pSlot->framesCount = static_cast<uint16_t>(framesCount);
+  std::memcpy(pSlot->frames, frames.data(), framesCount * sizeof(uint64_t));
+  std::copy_n(values.begin(), valuesCount, pSlot->values.begin());
+
+  Commit();
+  return true;
+}
+
+size_t SampleRingBuffer::Drain(SampleBatch& destination) {
+  auto tail = _tail.load(std::memory_order_relaxed);
+  auto head = _head.load(std::memory_order_acquire);
+
+  auto valuesCount = Sample::ValuesCount;
+  for (auto current = tail; current != head; current++) {
+    Slot& slot = _slots[current & _mask];
+
+    // the frames are copied into the batch arena
+    auto& sample = destination.Add(
+        slot.timestamp,
+        slot.threadId,
+        std::span<const uint64_t>(slot.frames, slot.framesCount)
+    );
+    for (size_t i = 0; i < valuesCount; i++) {
+      sample.AddValue(slot.values[i], i);
+    }
+    sample.SetThreadGeneration(slot.threadGeneration);
+    sample.SetThreadGroup(slot.threadGroup, slot.foldedThreadsCount);
+    sample.SetRumViewHandle(slot.rumViewHandle);
+    sample.SetTraceContext(slot.traceContext);
+  }
+
+  // give the slots back to the producer
+  _tail.store(head, std::memory_order_release);
+
+  auto count = static_cast<size_t>(head - tail);
+  if (count > _peakPendingCount.load(std::memory_order_relaxed)) {
+    _peakPendingCount.store(count, std::memory_order_relaxed);
+  }
+  return count;
+}
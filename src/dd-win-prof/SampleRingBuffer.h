@@ -0,0 +1,111 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "ProfilingConstants.h"
+#include "Sample.h"
+#include "WakeupSignal.h"
+#include "pch.h"
+
+// Single-producer / single-consumer ring of preallocated sample slots.
+// The sampler thread (producer) writes the callstack and the values of a sample
+// directly into a slot: no lock is taken and no memory is allocated, so Add never
+// waits for the DD_worker thread (consumer) that drains the ring in batches.
+// When the ring is full, the sample is dropped and counted. To avoid it without
+// polling, the consumer can be notified when the ring gets half full.
+//
+// Usage on the producer side:
+//   auto* pSlot = ring.TryReserve();
+//   if (pSlot != nullptr) {
+//     ... fill the slot ...
+//     ring.Commit();
+//   }
+//
+// IMPORTANT: only one thread may produce and only one thread may consume.
+class SampleRingBuffer {
+ public:
+  struct Slot {
+    std::chrono::nanoseconds timestamp;
+    uint32_t threadId;
+    uint64_t threadGeneration;
+    // folded walltime samples only (see WalltimeSampleFolder), 0 otherwise
+    uint64_t threadGroup;
+    uint32_t foldedThreadsCount;
+    uint32_t rumViewHandle;  // see RumViewRegistry
+    TraceContext traceContext;
+    std::array<int64_t, dd_win_prof::kMaxValuesCount> values;
+    uint16_t framesCount;
+    uint64_t frames[dd_win_prof::kMaxStackDepth];
+  };
+
+  // 512 slots ~= 2 MB per provider: enough to absorb the samples of 64 threads
+  // during several sampling periods if DD_worker is late
+  static constexpr size_t DefaultCapacity = 512;
+
+ public:
+  explicit SampleRingBuffer(size_t capacity = DefaultCapacity);
+  ~SampleRingBuffer() = default;
+
+  SampleRingBuffer(const SampleRingBuffer&) = delete;
+  SampleRingBuffer& operator=(const SampleRingBuffer&) = delete;
+
+  // Producer side: return a slot with zeroed values or nullptr if the ring is full.
+  // The slot is visible to the consumer only after Commit() is called.
+  Slot* TryReserve();
+  void Commit();
+
+  // Producer side helper: copy the given sample fields into a reserved slot.
+  // Return false (and count a dropped sample) if the ring is full.
+  bool TryPush(
+      std::chrono::nanoseconds timestamp,
+      uint32_t threadId,
+      std::span<const uint64_t> frames,
+      std::span<const int64_t> values
+  );
+
+  // Consumer side: append all committed samples to destination and free their slots
+  size_t Drain(SampleBatch& destination);
+
+  // Set before producing: Commit() notifies the signal when the committed samples
+  // reach highWaterMark (half the capacity if 0)
+  void SetWakeupSignal(WakeupSignal* pSignal, size_t highWaterMark = 0);
+
+  size_t GetCapacity() const { return _capacity; }
+  size_t GetHighWaterMark() const { return _highWaterMark; }
+  size_t GetMemorySize() const { return _capacity * sizeof(Slot); }
+  uint64_t GetDroppedCount() const {
+    return _droppedCount.load(std::memory_order_relaxed);
+  }
+
+  // Max number of samples drained at once since the previous call
+  size_t GetAndResetPeakPendingCount() {
+    return _peakPendingCount.exchange(0, std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr size_t CacheLineSize = 64;
+
+  const size_t _capacity;
+  const size_t _mask;
+  std::unique_ptr<Slot[]> _slots;
+  WakeupSignal* _pWakeupSignal;
+  size_t _highWaterMark;
+
+  // written by the producer only: next slot to write
+  alignas(CacheLineSize) std::atomic<uint64_t> _head;
+  uint64_t _cachedTail;  // producer copy of _tail to avoid reading it at each push
+  std::atomic<uint64_t> _droppedCount;
+
+  // written by the consumer only: next slot to read
+  alignas(CacheLineSize) std::atomic<uint64_t> _tail;
+  std::atomic<size_t> _peakPendingCount;
+};
@@ -19,6 +19,12 @@ std::vector<SampleValueTypeProvider::Offset> SampleValueTypeProvider::GetOrRegis
   for (auto const& valueType : valueTypes) {
     size_t idx = GetOffset(valueType);
     if (idx == -1) {
+      if (_sampleTypeDefinitions.size() == dd_win_prof::kMaxValuesCount) {
+        throw std::runtime_error(
+            "Cannot register more than " +
+            std::to_string(dd_win_prof::kMaxValuesCount) + " value types"
+        );
+      }
       idx = _sampleTypeDefinitions.size();
       _sampleTypeDefinitions.push_back(valueType);
     }
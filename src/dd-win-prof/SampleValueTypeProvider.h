@@ -6,6 +6,7 @@
 
 #include <span>
 
+#include "ProfilingConstants.h"
 #include "Sample.h"
 #include "pch.h"
 
@@ -15,12 +15,22 @@
 static std::atomic<bool> g_shutdownReceived{false};
 
 SamplesCollector::SamplesCollector(
-    Configuration* pConfiguration, ProfileExporter* exporter
+    Configuration* pConfiguration,
+    ProfileExporter* exporter,
+    StackSamplerLoop* pStackSamplerLoop,
+    ThreadList* pThreadList
 )
-    : _uploadInterval(pConfiguration->GetUploadInterval()), _exporter(exporter) {}
+    : _uploadInterval(pConfiguration->GetUploadInterval()),
+      _isWorkerStopped(false),
+      _signaledWakeupsCount(0),
+      _timedWakeupsCount(0),
+      _exporter(exporter),
+      _pStackSamplerLoop(pStackSamplerLoop),
+      _pThreadList(pThreadList) {}
 
 void SamplesCollector::Register(ISamplesProvider* samplesProvider) {
   _samplesProviders.push_front(std::make_pair(samplesProvider, 0));
+  samplesProvider->SetWakeupSignal(&_wakeupSignal);
 }
 
 void SamplesCollector::Start() {
@@ -35,7 +45,8 @@ void SamplesCollector::Start() {
 }
 
 void SamplesCollector::Stop(bool shutdownOngoing) {
-  _workerThreadPromise.set_value();
+  _isWorkerStopped = true;
+  _wakeupSignal.Notify();
   _workerThread.join();
 
   _exporterThreadPromise.set_value();
@@ -49,15 +60,36 @@ void SamplesCollector::Stop(bool shutdownOngoing) {
     // libdatadog asks for a thread to be created, and the OS says NO.
   } else {
     // Normal shutdown - collect samples and export
+    if (_pThreadList != nullptr) {
+      _pThreadList->RefreshThreadNames();
+    }
     CollectSamples(_samplesProviders);
     Export(true);
   }
 }
 
 void SamplesCollector::SamplesWork() {
-  const auto future = _workerThreadPromise.get_future();
+  auto nextNamesRefresh = OpSysTools::GetHighPrecisionTimestamp();
+  while (!_isWorkerStopped) {
+    auto timeout = nextNamesRefresh - OpSysTools::GetHighPrecisionTimestamp();
+    if (_wakeupSignal.WaitFor((std::max)(timeout, 0ns))) {
+      _signaledWakeupsCount++;
+    } else {
+      _timedWakeupsCount++;
+    }
+    if (_isWorkerStopped) {
+      break;
+    }
+
+    // off the sampling and export paths: they only read the interned names
+    auto now = OpSysTools::GetHighPrecisionTimestamp();
+    if (now >= nextNamesRefresh) {
+      nextNamesRefresh = now + ThreadNamesRefreshPeriod;
+      if (_pThreadList != nullptr) {
+        _pThreadList->RefreshThreadNames();
+      }
+    }
 
-  while (future.wait_for(CollectingPeriod) == std::future_status::timeout) {
     CollectSamples(_samplesProviders);
   }
 }
@@ -74,19 +106,51 @@ void SamplesCollector::ExportWork() {
 }
 
 void SamplesCollector::Export(bool lastCall) {
-  bool success = false;
-
   try {
-    std::lock_guard lock(_exportLock);
+    std::lock_guard uploadLock(_uploadLock);
 
-    Log::Debug("Collected samples per provider:");
-    for (auto& samplesProvider : _samplesProviders) {
-      auto name = samplesProvider.first->GetName();
-      Log::Debug("  ", name, " : ", samplesProvider.second);
-      samplesProvider.second = 0;
+    bool rotated = false;
+    {
+      // only hold the collection lock while swapping the profiles
+      std::lock_guard lock(_exportLock);
+
+      // the samples waiting in the providers belong to the profile being retired
+      CollectSamples(_samplesProviders);
+
+      Log::Debug(
+          "Collected samples per provider (DD_worker wakeups: ",
+          _signaledWakeupsCount.load(),
+          " signaled, ",
+          _timedWakeupsCount.load(),
+          " timed):"
+      );
+      for (auto& samplesProvider : _samplesProviders) {
+        auto name = samplesProvider.first->GetName();
+        Log::Debug(
+            "  ",
+            name,
+            " : ",
+            samplesProvider.second,
+            " (peak pending: ",
+            samplesProvider.first->GetAndResetPeakPendingCount(),
+            ", total dropped: ",
+            samplesProvider.first->GetDroppedSamplesCount(),
+            ")"
+        );
+        samplesProvider.second = 0;
+      }
+
+      if (_pStackSamplerLoop != nullptr) {
+        _pStackSamplerLoop->LogStatistics();
+      }
+
+      rotated = _exporter->RotateProfile();
     }
 
-    success = _exporter->Export(lastCall);
+    // serialize and upload while the samples keep being added to the active profile
+    if (rotated) {
+      _exporter->ExportRetiredProfile(lastCall);
+    }
   } catch (std::exception const& ex) {
     Log::Error("An exception occurred during export: ", ex.what());
   }
@@ -103,15 +167,11 @@ void SamplesCollector::CollectSamples(
     try {
       std::lock_guard lock(_exportLock);
 
-      std::vector<Sample> samples;
-      auto count = samplesProvider.first->MoveSamples(samples);
+      _samplesBatch.Clear();
+      auto count = samplesProvider.first->MoveSamples(_samplesBatch);
       samplesProvider.second += count;
 
-      // iterate on each sample and add it to the exporter
-      for (auto& sample : samples) {
-        auto samplePtr = std::make_shared<Sample>(std::move(sample));
-        _exporter->Add(samplePtr);
-      }
+      _exporter->Add(_samplesBatch.GetSamples());
     } catch (std::exception const& ex) {
       Log::Error("An exception occurred while collecting samples: ", ex.what());
     }
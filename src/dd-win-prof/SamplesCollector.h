@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <forward_list>
 #include <future>
 #include <mutex>
@@ -12,11 +13,19 @@
 #include "Configuration.h"
 #include "ISamplesProvider.h"
 #include "ProfileExporter.h"
+#include "StackSamplerLoop.h"
+#include "ThreadList.h"
+#include "WakeupSignal.h"
 #include "pch.h"
 
 class SamplesCollector {
  public:
-  SamplesCollector(Configuration* pConfiguration, ProfileExporter* exporter);
+  SamplesCollector(
+      Configuration* pConfiguration,
+      ProfileExporter* exporter,
+      StackSamplerLoop* pStackSamplerLoop = nullptr,  // to log its statistics
+      ThreadList* pThreadList = nullptr  // to refresh the thread names
+  );
   ~SamplesCollector() = default;
   void Start();
   void Stop(bool shutdownOngoing = false);
@@ -25,6 +34,10 @@ class SamplesCollector {
   static bool IsShutdownReceived();
   static void SignalShutdown();
 
+  // DD_worker wakeups: when a provider is half full or to refresh the thread names
+  uint64_t GetSignaledWakeupsCount() const { return _signaledWakeupsCount.load(); }
+  uint64_t GetTimedWakeupsCount() const { return _timedWakeupsCount.load(); }
+
  private:
   void SamplesWork();
   void ExportWork();
@@ -36,7 +49,10 @@ class SamplesCollector {
   // configuration
   const WCHAR* WorkerThreadName = L"DD_worker";
   const WCHAR* ExporterThreadName = L"DD_exporter";
-  inline static constexpr std::chrono::nanoseconds CollectingPeriod = 60ms;
+  // DD_worker does not poll the providers: it sleeps until one of them is half full
+  // (see SampleRingBuffer::SetWakeupSignal) or the thread names must be refreshed.
+  // The samples left in the providers are collected before each export.
+  inline static constexpr std::chrono::nanoseconds ThreadNamesRefreshPeriod = 1s;
 
   std::chrono::seconds _uploadInterval;
   std::chrono::milliseconds _collectingPeriod;
@@ -44,10 +60,22 @@ class SamplesCollector {
   // processing management
   std::thread _workerThread;
   std::thread _exporterThread;
+  // _exportLock serializes adding samples to the exporter and rotating its profile;
+  // _uploadLock serializes the (slow) serialization + upload of the retired profile
+  // so that it never blocks the samples collection.
   std::recursive_mutex _exportLock;
+  std::mutex _uploadLock;
   std::promise<void> _exporterThreadPromise;
-  std::promise<void> _workerThreadPromise;
+  std::atomic<bool> _isWorkerStopped;
+  WakeupSignal _wakeupSignal;
+  std::atomic<uint64_t> _signaledWakeupsCount;
+  std::atomic<uint64_t> _timedWakeupsCount;
 
   std::forward_list<std::pair<ISamplesProvider*, uint64_t>> _samplesProviders;
   ProfileExporter* _exporter;
+  StackSamplerLoop* _pStackSamplerLoop;
+  ThreadList* _pThreadList;
+
+  // reused for each collection so that moving the samples does not allocate
+  SampleBatch _samplesBatch;
 };
@@ -0,0 +1,163 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "SamplingIteration.h"
+
+#include <algorithm>
+
+#include "pch.h"
+
+using namespace std::chrono_literals;
+
+SamplingIteration::SamplingIteration(
+    ThreadList* pThreadList,
+    IThreadSampler* pSampler,
+    uint32_t cpuThreadsThreshold,
+    uint32_t walltimeThreadsThreshold,
+    uint32_t coresCount
+)
+    : _pThreadList(pThreadList),
+      _pSampler(pSampler),
+      _cpuThreadsThreshold(cpuThreadsThreshold),
+      _walltimeThreadsThreshold(walltimeThreadsThreshold),
+      _coresCount(coresCount) {
+  _iteratorCpuTime = _pThreadList->CreateIterator();
+  _iteratorWallTime = _pThreadList->CreateIterator();
+}
+
+void SamplingIteration::RunCpu(
+    const ThreadList::ReadGuard& guard, uint32_t samplerThreadId
+) {
+  uint32_t sampledThreads = 0;
+  uint32_t managedThreadsCount = static_cast<uint32_t>(_pThreadList->Count());
+  uint32_t sampledThreadsCount = (std::min)(managedThreadsCount, _cpuThreadsThreshold);
+
+  for (uint32_t i = 0; i < sampledThreadsCount && !_pSampler->IsStopRequested();
+       i++) {
+    ThreadInfo* pThreadInfo = _pThreadList->LoopNext(_iteratorCpuTime, guard);
+    if (pThreadInfo != nullptr) {
+      // don't sample the sampling thread
+      if (pThreadInfo->GetThreadId() == samplerThreadId) {
+        continue;
+      }
+
+      // sample only if the thread is currently running on a core
+      auto lastConsumption = pThreadInfo->GetCpuConsumption();
+      auto [isRunning, currentConsumption, failure] = _pSampler->IsRunning(pThreadInfo);
+
+      // Note: it is not possible to get this information on Windows 32-bit or in some
+      // cases in 64-bit
+      //       so isRunning should be true if this thread consumed some CPU since the
+      //       last iteration
+      if (failure) {
+        isRunning = (lastConsumption < currentConsumption);
+      }
+
+      if (isRunning) {
+        auto cpuDelta = currentConsumption - lastConsumption;
+
+        // we don't collect a sample for this thread is no CPU was consumed since the
+        // last check
+        if (cpuDelta > 0ms) {
+          auto lastCpuTimestamp = pThreadInfo->GetCpuTimestamp();
+          auto thisSampleTimestamp = _pSampler->GetTimestamp();
+
+          // Work in nanoseconds to avoid precision loss when capping.
+          std::chrono::nanoseconds cpuForSample = cpuDelta;
+
+          // For the first computation, no need to deal with overlapping CPU usage
+          if (lastCpuTimestamp != 0ns) {
+            // detect overlapping CPU usage
+            auto threshold = lastCpuTimestamp + cpuForSample;
+            if (threshold > thisSampleTimestamp) {
+              // Cap to elapsed wall-clock time to avoid over-counting.
+              // Subtract 1µs safety margin to avoid attributing 100% CPU.
+              auto elapsed = thisSampleTimestamp - lastCpuTimestamp;
+              cpuForSample = elapsed > 1us ? elapsed - 1us : 0ns;
+            }
+          }
+
+          // if no sample is recorded, this CPU will be accounted in the next one
+          auto status = _pSampler->CollectOneThreadSample(
+              pThreadInfo,
+              thisSampleTimestamp,
+              cpuForSample,
+              PROFILING_TYPE::CpuTime,
+              WAIT_REASON_NONE
+          );
+          if (status == SampleStatus::Recorded) {
+            pThreadInfo->SetCpuConsumption(currentConsumption, thisSampleTimestamp);
+          }
+
+          // don't scan more threads than nb logical cores
+          sampledThreads++;
+          if (sampledThreads >= _coresCount) {
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+void SamplingIteration::RunWalltime(
+    const ThreadList::ReadGuard& guard,
+    uint32_t samplerThreadId,
+    std::chrono::nanoseconds samplingStart
+) {
+  uint32_t managedThreadsCount = static_cast<uint32_t>(_pThreadList->Count());
+  uint32_t sampledThreadsCount =
+      (std::min)(managedThreadsCount, _walltimeThreadsThreshold);
+
+  uint32_t i = 0;
+
+  ThreadInfo* firstThread = nullptr;
+
+  do {
+    ThreadInfo* pThreadInfo = _pThreadList->LoopNext(_iteratorWallTime, guard);
+
+    // either the list is empty or iterator is not in the array range
+    // so prefer bailing out
+    if (pThreadInfo == nullptr) {
+      break;
+    }
+
+    // don't sample the sampling thread
+    if (pThreadInfo->GetThreadId() == samplerThreadId) {
+      continue;
+    }
+
+    if (firstThread == pThreadInfo) {
+      break;
+    }
+
+    if (firstThread == nullptr) {
+      firstThread = pThreadInfo;
+    }
+
+    // the sample stands for all the time since the previous sample of this thread
+    auto thisSampleTimestamp = _pSampler->GetTimestamp();
+    auto duration =
+        pThreadInfo->GetWalltimeSampleWeight(thisSampleTimestamp, samplingStart);
+
+    // check if the thread is waiting and for for which reason
+    auto [isWaiting, waitReason, failure] = _pSampler->IsWaiting(pThreadInfo);
+    if (failure || !isWaiting) {
+      waitReason = WAIT_REASON_NONE;
+    }
+
+    // get callstack and create sample (possibly mixed with wait information); if no
+    // sample is recorded, this duration will be accounted in the next one. A deferred
+    // sample marks its thread as sampled when it is written.
+    auto status = _pSampler->CollectOneThreadSample(
+        pThreadInfo, thisSampleTimestamp, duration, PROFILING_TYPE::WallTime, waitReason
+    );
+    if (status == SampleStatus::Recorded) {
+      pThreadInfo->SetLastWalltimeSampleTimestamp(thisSampleTimestamp);
+    }
+
+    i++;
+
+  } while (i < sampledThreadsCount && !_pSampler->IsStopRequested());
+}
@@ -0,0 +1,91 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <tuple>
+
+#include "ThreadList.h"
+#include "pch.h"
+
+typedef enum { WallTime, CpuTime } PROFILING_TYPE;
+
+const ULONG WAIT_REASON_NONE = 0xFFFF;
+
+enum class SampleStatus {
+  // not recorded (thread not suspended, stack walk failure or full ring): the CPU and
+  // wall time are then accounted in the next sample
+  Dropped,
+  Recorded,
+  // written at the end of the tick (folded walltime sample): the thread is marked as
+  // sampled only if the sample is written
+  Deferred,
+};
+
+// State of the threads and collection of their samples (replaced by a fake in the
+// tests)
+class IThreadSampler {
+ public:
+  virtual ~IThreadSampler() = default;
+
+  virtual std::chrono::nanoseconds GetTimestamp() = 0;
+
+  // [is running, CPU consumed since the thread started, failure]
+  virtual std::tuple<bool, std::chrono::milliseconds, bool> IsRunning(
+      ThreadInfo* pThreadInfo
+  ) = 0;
+
+  // [is waiting, wait reason, failure]
+  virtual std::tuple<bool, ULONG, bool> IsWaiting(ThreadInfo* pThreadInfo) = 0;
+
+  virtual SampleStatus CollectOneThreadSample(
+      ThreadInfo* pThreadInfo,
+      std::chrono::nanoseconds thisSampleTimestamp,
+      std::chrono::nanoseconds duration,
+      PROFILING_TYPE profilingType,
+      ULONG waitingReason  // only used for WallTime samples
+  ) = 0;
+
+  virtual bool IsStopRequested() = 0;
+};
+
+// Selection and weighting of the threads sampled at each tick of StackSamplerLoop.
+// Beyond the thresholds, the threads are sampled in round robin: each sample stands
+// for all the CPU consumed (or wall time elapsed) since the previous sample of its
+// thread, so the totals stay accurate whatever the number of threads. A thread is
+// only marked as sampled when its sample is recorded.
+class SamplingIteration {
+ public:
+  SamplingIteration(
+      ThreadList* pThreadList,
+      IThreadSampler* pSampler,
+      uint32_t cpuThreadsThreshold,
+      uint32_t walltimeThreadsThreshold,
+      uint32_t coresCount
+  );
+
+  // Check up to cpuThreadsThreshold threads and sample at most coresCount running
+  // threads that consumed CPU since their previous sample
+  void RunCpu(const ThreadList::ReadGuard& guard, uint32_t samplerThreadId);
+
+  // Sample up to walltimeThreadsThreshold threads; the wall time of a thread that was
+  // never sampled is counted from samplingStart
+  void RunWalltime(
+      const ThreadList::ReadGuard& guard,
+      uint32_t samplerThreadId,
+      std::chrono::nanoseconds samplingStart
+  );
+
+ private:
+  ThreadList* _pThreadList;
+  IThreadSampler* _pSampler;
+  uint32_t _cpuThreadsThreshold;
+  uint32_t _walltimeThreadsThreshold;
+  uint32_t _coresCount;
+
+  uint32_t _iteratorCpuTime;
+  uint32_t _iteratorWallTime;
+};
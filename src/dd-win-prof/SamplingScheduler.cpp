@@ -0,0 +1,115 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "SamplingScheduler.h"
+
+#include "pch.h"
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+SystemClock::SystemClock() {
+  _hTimer = ::CreateWaitableTimerExW(
+      nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS
+  );
+}
+
+SystemClock::~SystemClock() {
+  if (_hTimer != nullptr) {
+    ::CloseHandle(_hTimer);
+  }
+}
+
+std::chrono::nanoseconds SystemClock::Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()
+  );
+}
+
+void SystemClock::SleepUntil(std::chrono::nanoseconds deadline) {
+  auto remaining = deadline - Now();
+  if (remaining <= std::chrono::nanoseconds(0)) {
+    return;
+  }
+
+  if (_hTimer != nullptr) {
+    // relative due time in 100 ns units
+    LARGE_INTEGER dueTime;
+    dueTime.QuadPart = -((remaining.count() + 99) / 100);
+    if (::SetWaitableTimer(_hTimer, &dueTime, 0, nullptr, nullptr, FALSE)) {
+      ::WaitForSingleObject(_hTimer, INFINITE);
+      return;
+    }
+  }
+
+  auto remainingMs = std::chrono::ceil<std::chrono::milliseconds>(remaining);
+  ::Sleep(static_cast<DWORD>(remainingMs.count()));
+}
+
+SamplingScheduler::SamplingScheduler(
+    IClock* pClock,
+    std::chrono::nanoseconds period,
+    OverrunPolicy policy,
+    std::chrono::nanoseconds maxJitter,
+    uint32_t seed
+)
+    : _pClock(pClock),
+      _period(period),
+      _policy(policy),
+      // the jitter must not reorder the ticks
+      _maxJitter((std::min)(maxJitter, period / 2)),
+      _random(seed),
+      _nextTick(0),
+      _ticks(0),
+      _overruns(0),
+      _skippedTicks(0) {}
+
+std::chrono::nanoseconds SamplingScheduler::WaitNextTick() {
+  auto now = _pClock->Now();
+  if (_nextTick == std::chrono::nanoseconds(0)) {
+    _nextTick = now + _period;
+  } else if (now > _nextTick) {
+    // the last iteration ended after this tick: run it now and drop the ticks that
+    // are completely in the past (or keep a few of them in catch up mode)
+    _overruns++;
+    uint64_t missedTicks = (now - _nextTick) / _period;
+    if (_policy == OverrunPolicy::CatchUp) {
+      missedTicks = (missedTicks > MaxCatchUpTicks) ? missedTicks - MaxCatchUpTicks : 0;
+    }
+    _nextTick += missedTicks * _period;
+    _skippedTicks += missedTicks;
+  }
+
+  auto deadline = _nextTick + GetJitter();
+  if (deadline > now) {
+    _pClock->SleepUntil(deadline);
+    now = _pClock->Now();
+  }
+  _latenessHistogram.Record((std::max)(now - deadline, std::chrono::nanoseconds(0)));
+
+  _nextTick += _period;
+  _ticks++;
+  return now;
+}
+
+std::chrono::nanoseconds SamplingScheduler::GetJitter() {
+  if (_maxJitter <= std::chrono::nanoseconds(0)) {
+    return std::chrono::nanoseconds(0);
+  }
+
+  std::uniform_int_distribution<int64_t> distribution(
+      -_maxJitter.count(), _maxJitter.count()
+  );
+  return std::chrono::nanoseconds(distribution(_random));
+}
+
+SamplingScheduler::Stats SamplingScheduler::GetAndResetStats() {
+  Stats stats;
+  stats.ticks = _ticks.exchange(0);
+  stats.overruns = _overruns.exchange(0);
+  stats.skippedTicks = _skippedTicks.exchange(0);
+  stats.lateness = _latenessHistogram.GetAndReset();
+  return stats;
+}
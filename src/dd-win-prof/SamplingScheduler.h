@@ -0,0 +1,101 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+#include "DurationHistogram.h"
+#include "pch.h"
+
+// Time source of the scheduler (replaced by a fake clock in the tests)
+class IClock {
+ public:
+  virtual ~IClock() = default;
+  virtual std::chrono::nanoseconds Now() = 0;
+  virtual void SleepUntil(std::chrono::nanoseconds deadline) = 0;
+};
+
+// steady_clock + high resolution waitable timer (::Sleep is rounded to the 15.6 ms
+// system timer tick). Falls back to ::Sleep before Windows 10 1803.
+class SystemClock : public IClock {
+ public:
+  SystemClock();
+  ~SystemClock() override;
+
+  SystemClock(const SystemClock&) = delete;
+  SystemClock& operator=(const SystemClock&) = delete;
+
+  std::chrono::nanoseconds Now() override;
+  void SleepUntil(std::chrono::nanoseconds deadline) override;
+
+ private:
+  HANDLE _hTimer;
+};
+
+// What to do with the ticks missed while an iteration lasted longer than the period
+enum class OverrunPolicy {
+  // run the late tick immediately and drop the other missed ones
+  Skip,
+  // run the missed ticks back to back (at most MaxCatchUpTicks)
+  CatchUp,
+};
+
+// Deadline based scheduling of the sampling iterations: the ticks are at absolute
+// times (start + n * period) so the iterations duration and the timer slack do not
+// accumulate as with Sleep(period). An optional random jitter is added to each
+// deadline (not to the schedule) to avoid sampling in lockstep with periodic work.
+class SamplingScheduler {
+ public:
+  static constexpr uint32_t MaxCatchUpTicks = 4;
+
+  struct Stats {
+    uint64_t ticks = 0;
+    uint64_t overruns = 0;      // iterations that ended after the next deadline
+    uint64_t skippedTicks = 0;  // ticks dropped because of overruns
+    DurationHistogram::Counts lateness;  // wake up time - deadline
+  };
+
+ public:
+  SamplingScheduler(
+      IClock* pClock,
+      std::chrono::nanoseconds period,
+      OverrunPolicy policy = OverrunPolicy::Skip,
+      std::chrono::nanoseconds maxJitter = std::chrono::nanoseconds(0),
+      uint32_t seed = std::random_device{}()
+  );
+
+  SamplingScheduler(const SamplingScheduler&) = delete;
+  SamplingScheduler& operator=(const SamplingScheduler&) = delete;
+
+  // Wait for the next tick and return the current time.
+  // The first tick is one period after the first call.
+  std::chrono::nanoseconds WaitNextTick();
+
+  // Return the statistics since the last call (can be called from another thread)
+  Stats GetAndResetStats();
+
+  std::chrono::nanoseconds GetPeriod() const { return _period; }
+
+ private:
+  std::chrono::nanoseconds GetJitter();
+
+ private:
+  IClock* _pClock;
+  const std::chrono::nanoseconds _period;
+  const OverrunPolicy _policy;
+  const std::chrono::nanoseconds _maxJitter;
+  std::minstd_rand _random;
+
+  // 0 = not started
+  std::chrono::nanoseconds _nextTick;
+
+  std::atomic<uint64_t> _ticks;
+  std::atomic<uint64_t> _overruns;
+  std::atomic<uint64_t> _skippedTicks;
+  DurationHistogram _latenessHistogram;
+};
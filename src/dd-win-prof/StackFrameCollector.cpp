@@ -9,7 +9,10 @@
 StackFrameCollector::NtQueryInformationThreadDelegate_t
     StackFrameCollector::s_ntQueryInformationThreadDelegate = nullptr;
 
-StackFrameCollector::StackFrameCollector() {}
+StackFrameCollector::StackFrameCollector()
+    : _unwindTable(&_unwindInfoCache), _unwinder(&_unwindTable) {
+  _unwindInfoCache.StartInvalidationOnModuleUnload();
+}
 
 StackFrameCollector::~StackFrameCollector() {}
 
@@ -34,19 +37,20 @@ bool StackFrameCollector::CaptureStack(
   // frames; the caller (StackSamplerLoop) does not read it back, so we avoid
   // the ~1.2 KB-per-sample copy that a const-ref + local snapshot would cost.
 
+  if (_unwinder.GetStrategy() == UnwindStrategy::FramePointers) {
+    return UnwindInPlace(hThread, seedContext, pFrames, framesCount, isTruncated);
+  }
+
   // Get thread stack limits:
   DWORD64 stackLimit = 0;
   DWORD64 stackBase = 0;
   TryGetThreadStackBoundaries(hThread, &stackLimit, &stackBase);
 
   uint64_t imageBaseAddress = 0;
-  UNWIND_HISTORY_TABLE historyTable;
-  ::RtlZeroMemory(&historyTable, sizeof(UNWIND_HISTORY_TABLE));
-  historyTable.Search = TRUE;
-
   void* pHandlerData = nullptr;
   DWORD64 establisherFrame = 0;
   const PKNONVOLATILE_CONTEXT_POINTERS pNonVolatileContextPtrsIsNull = nullptr;
+  RUNTIME_FUNCTION functionTableEntry;
   RUNTIME_FUNCTION* pFunctionTableEntry;
 
   framesCount = 0;
@@ -57,13 +61,27 @@ bool StackFrameCollector::CaptureStack(
     }
     pFrames[framesCount++] = seedContext.Rip;
 
-    __try {
-      // Sometimes, we could hit an access violation, so catch it and just return.
-      // We want to prevent this from killing the application
-      pFunctionTableEntry =
-          ::RtlLookupFunctionEntry(seedContext.Rip, &imageBaseAddress, &historyTable);
-    } __except (EXCEPTION_EXECUTE_HANDLER) {
-      return false;
+    // the same return addresses are found from one sample to the next: the cache
+    // avoids most of the function table searches (and the locks they might take)
+    pFunctionTableEntry = &functionTableEntry;
+    bool isCached =
+        _unwindInfoCache.TryGet(seedContext.Rip, imageBaseAddress, functionTableEntry);
+    if (!isCached) {
+      uint64_t cacheEpoch = _unwindInfoCache.GetEpoch();
+      __try {
+        // Sometimes, we could hit an access violation, so catch it and just return.
+        // We want to prevent this from killing the application
+        pFunctionTableEntry =
+            ::RtlLookupFunctionEntry(seedContext.Rip, &imageBaseAddress, nullptr);
+      } __except (EXCEPTION_EXECUTE_HANDLER) {
+        return false;
+      }
+
+      if (nullptr != pFunctionTableEntry) {
+        _unwindInfoCache.Add(
+            seedContext.Rip, imageBaseAddress, *pFunctionTableEntry, cacheEpoch
+        );
+      }
     }
 
     // RtlLookupFunctionEntry() may try to acquire global locks. The
@@ -146,7 +164,7 @@ bool StackFrameCollector::CaptureStack(
 }
 
 bool StackFrameCollector::TrySuspendThread(
-    std::shared_ptr<ThreadInfo> pThreadInfo, CONTEXT& seedContext
+    ThreadInfo* pThreadInfo, CONTEXT& seedContext
 ) {
   HANDLE hThread = pThreadInfo->GetOsThreadHandle();
   DWORD suspendCount = ::SuspendThread(hThread);
@@ -183,23 +201,60 @@ bool StackFrameCollector::TrySuspendThread(
   return false;
 }
 
-bool StackFrameCollector::ValidatePointerInStack(
-    DWORD64 pointerValue, DWORD64 stackLimit, DWORD64 stackBase
+bool StackFrameCollector::CaptureStackSnapshot(
+    HANDLE hThread, const CONTEXT& context, StackSnapshot& snapshot
 ) {
-  // Validate that the establisherFrame 8-byte aligned:
-  if (0 != (0x7 & pointerValue)) {
+  DWORD64 stackLimit = 0;
+  DWORD64 stackBase = 0;
+  if (!TryGetThreadStackBoundaries(hThread, &stackLimit, &stackBase)) {
     return false;
   }
 
-  // Validate stack limits. Attention! This may not apply to kernel frames / DPC stacks
-  // (http://www.nynaeve.net/?p=106):
-  if ((stackLimit != 0 || stackBase != 0) &&
-      (pointerValue < stackLimit || stackBase <= pointerValue)) {
-    // Remember that stack grows downwards, i.e. stackLimit <= stackBase.
-    return false;
-  }
+  return snapshot.Capture(context, stackLimit, stackBase);
+}
 
-  return true;
+bool StackFrameCollector::UnwindStackSnapshot(
+    const StackSnapshot& snapshot,
+    uint64_t* pFrames,
+    uint16_t& framesCount,
+    bool& isTruncated
+) {
+  UnwindRegisters registers = snapshot.GetRegisters();
+  return _unwinder.Unwind(
+      registers,
+      snapshot,
+      snapshot.GetStackLimit(),
+      snapshot.GetStackBase(),
+      pFrames,
+      framesCount,
+      isTruncated
+  );
+}
+
+bool StackFrameCollector::UnwindInPlace(
+    HANDLE hThread,
+    const CONTEXT& seedContext,
+    uint64_t* pFrames,
+    uint16_t& framesCount,
+    bool& isTruncated
+) {
+  DWORD64 stackLimit = 0;
+  DWORD64 stackBase = 0;
+  TryGetThreadStackBoundaries(hThread, &stackLimit, &stackBase);
+
+  UnwindRegisters registers = UnwindRegisters::FromContext(seedContext);
+  InPlaceStackMemory memory;
+  return _unwinder.Unwind(
+      registers, memory, stackLimit, stackBase, pFrames, framesCount, isTruncated
+  );
+}
+
+bool StackFrameCollector::ValidatePointerInStack(
+    DWORD64 pointerValue, DWORD64 stackLimit, DWORD64 stackBase
+) {
+  // Attention! This may not apply to kernel frames / DPC stacks
+  // (http://www.nynaeve.net/?p=106)
+  return StackUnwinder::IsValidStackPointer(pointerValue, stackLimit, stackBase);
 }
 
 constexpr THREADINFOCLASS ThreadInfoClass_ThreadBasicInformation =
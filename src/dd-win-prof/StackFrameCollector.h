@@ -6,7 +6,10 @@
 
 #include <winternl.h>
 
+#include "StackSnapshot.h"
+#include "StackUnwinder.h"
 #include "ThreadInfo.h"
+#include "UnwindInfoCache.h"
 #include "pch.h"
 
 class StackFrameCollector {
@@ -41,12 +44,42 @@ class StackFrameCollector {
   // https://devblogs.microsoft.com/oldnewthing/20150205-00/?p=44743).
   // On success, seedContext is populated with CONTEXT_FULL and the caller MUST
   // eventually call ::ResumeThread on the thread.
-  bool TrySuspendThread(std::shared_ptr<ThreadInfo> pThreadInfo, CONTEXT& seedContext);
+  bool TrySuspendThread(ThreadInfo* pThreadInfo, CONTEXT& seedContext);
+
+  // Stack snapshot mode: while the thread is suspended, only copy its registers and
+  // the top of its stack...
+  bool CaptureStackSnapshot(
+      HANDLE hThread, const CONTEXT& context, StackSnapshot& snapshot
+  );
+
+  // ...and unwind this copy once the thread has been resumed
+  bool UnwindStackSnapshot(
+      const StackSnapshot& snapshot,
+      uint64_t* pFrames,
+      uint16_t& framesCount,
+      bool& isTruncated
+  );
+
+  // Walk the callers with the rbp chain (falling back to the unwind data where it
+  // looks broken) instead of the unwind data only
+  void SetUnwindStrategy(UnwindStrategy strategy) { _unwinder.SetStrategy(strategy); }
+  UnwindStrategy GetUnwindStrategy() const { return _unwinder.GetStrategy(); }
+
+  // function table lookups shared by all the samples
+  UnwindInfoCache* GetUnwindInfoCache() { return &_unwindInfoCache; }
 
  private:
   bool TryGetThreadStackBoundaries(
       HANDLE threadHandle, DWORD64* pStackLimit, DWORD64* pStackBase
   );
+  // same walk as for a snapshot but reading the suspended thread memory in place
+  bool UnwindInPlace(
+      HANDLE hThread,
+      const CONTEXT& seedContext,
+      uint64_t* pFrames,
+      uint16_t& framesCount,
+      bool& isTruncated
+  );
   bool ValidatePointerInStack(
       DWORD64 pointerValue, DWORD64 stackLimit, DWORD64 stackBase
   );
@@ -61,4 +94,8 @@ class StackFrameCollector {
       PULONG ReturnLength
   );
   static NtQueryInformationThreadDelegate_t s_ntQueryInformationThreadDelegate;
+
+  UnwindInfoCache _unwindInfoCache;
+  ImageUnwindTable _unwindTable;
+  StackUnwinder _unwinder;
 };
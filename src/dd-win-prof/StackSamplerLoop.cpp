@@ -12,34 +12,66 @@
 
 constexpr const wchar_t* ThreadName = L"DD_StackSampler";
 
+// below, querying each sampled thread is cheaper than querying all the threads
+constexpr uint32_t MinThreadsForStateSnapshot = 16;
+
+// when enabled, the jitter of each tick is at most 1/10 of the sampling period
+constexpr int MaxJitterRatio = 10;
+
 StackSamplerLoop::StackSamplerLoop(
     Configuration* pConfiguration,
     ThreadList* pThreadList,
     CpuTimeProvider* pCpuTimeProvider,
     WallTimeProvider* pWallTimeProvider,
     IRumViewContextProvider* pRumViewContextProvider,
-    IViewVitalsAccumulator* pViewVitalsAccumulator
+    IViewVitalsAccumulator* pViewVitalsAccumulator,
+    const MemoryBudget* pMemoryBudget
 )
-    : _samplingPeriod(pConfiguration->CpuWallTimeSamplingPeriod()),
+    : _shutdownRequested(false),
+      _pLoopThread(nullptr),
+      _samplingPeriod(pConfiguration->CpuWallTimeSamplingPeriod()),
+      _samplingStart(0ns),
+      _scheduler(
+          &_clock,
+          _samplingPeriod,
+          OverrunPolicy::Skip,
+          pConfiguration->IsSamplingJitterEnabled() ? _samplingPeriod / MaxJitterRatio
+                                                    : 0ns
+      ),
       _cpuThreadsThreshold(pConfiguration->CpuThreadsThreshold()),
       _walltimeThreadsThreshold(pConfiguration->WalltimeThreadsThreshold()),
-      _shutdownRequested(false),
+      _isWalltimeFoldingEnabled(pConfiguration->IsWalltimeFoldingEnabled()),
       _pThreadList(pThreadList),
+      _iteration(
+          pThreadList,
+          this,
+          pConfiguration->CpuThreadsThreshold(),
+          pConfiguration->WalltimeThreadsThreshold(),
+          OsSpecificApi::GetProcessorCount()
+      ),
       _pCpuTimeProvider(pCpuTimeProvider),
       _pWallTimeProvider(pWallTimeProvider),
       _pRumViewContextProvider(pRumViewContextProvider),
       _pViewVitalsAccumulator(pViewVitalsAccumulator),
-      _iteratorCpuTime(0),
-      _iteratorWallTime(0),
-      _pLoopThread(nullptr) {
-  _iteratorCpuTime = _pThreadList->CreateIterator();
-  _iteratorWallTime = _pThreadList->CreateIterator();
-  _nbCores = OsSpecificApi::GetProcessorCount();
-
+      _pMemoryBudget(pMemoryBudget) {
   // deal with configuration
   if (!pConfiguration->IsCpuProfilingEnabled()) {
     _pCpuTimeProvider = nullptr;
   }
+
+  if (pConfiguration->IsStackSnapshotEnabled()) {
+    _pStackSnapshot = std::make_unique<StackSnapshot>();
+  }
+
+  if (pConfiguration->IsFramePointerUnwindingEnabled()) {
+    _stackFrameCollector.SetUnwindStrategy(UnwindStrategy::FramePointers);
+  }
+
+  if (pConfiguration->GetSuspensionDeadline() > 0ms) {
+    _pWatchdog = std::make_unique<SuspensionWatchdog>(
+        &_threadControl, pConfiguration->GetSuspensionDeadline()
+    );
+  }
 }
 
 StackSamplerLoop::~StackSamplerLoop() { Stop(); }
@@ -50,6 +82,12 @@ void StackSamplerLoop::Start() {
     return;
   }
 
+  if (_pWatchdog != nullptr) {
+    _pWatchdog->Start();
+  }
+
+  // the wall time of the threads registered before is accounted from now
+  _samplingStart = OpSysTools::GetHighPrecisionTimestamp();
   _pLoopThread = std::make_unique<std::thread>([this] {
     OpSysTools::SetNativeThreadName(ThreadName);
     MainLoop();
@@ -66,13 +104,21 @@ void StackSamplerLoop::Stop() {
     } catch (const std::exception&) {
     }
   }
+
+  // the sampler thread is gone: no more suspended threads to watch
+  if (_pWatchdog != nullptr) {
+    _pWatchdog->Stop();
+  }
 }
 
 void StackSamplerLoop::MainLoop() {
-  DWORD samplingPeriodMs = static_cast<DWORD>(_samplingPeriod.count() / 1000000);
   while (!_shutdownRequested) {
     try {
-      ::Sleep(samplingPeriodMs);
+      _scheduler.WaitNextTick();
+      if (ShouldSkipTick()) {
+        continue;
+      }
+
       MainLoopIteration();
     } catch (...) {
       Log::Error("Unknown Exception in StackSamplerLoop::MainLoop.");
@@ -80,259 +126,456 @@ void StackSamplerLoop::MainLoop() {
   }
 }
 
-void StackSamplerLoop::MainLoopIteration() {
-  if (_pCpuTimeProvider != nullptr) {
-    CpuProfilingIteration();
+bool StackSamplerLoop::ShouldSkipTick() {
+  if ((_pMemoryBudget == nullptr) ||
+      !_pMemoryBudget->IsAtLeast(MemoryPressure::ReduceSampling)) {
+    _pressureTicksCount = 0;
+    return false;
   }
 
-  if (_pWallTimeProvider != nullptr) {
-    WalltimeProfilingIteration();
+  // halve the sampling rate: the CPU and wall time of the threads are not lost but
+  // accounted in their next sample
+  _pressureTicksCount++;
+  if ((_pressureTicksCount % 2) == 0) {
+    return false;
   }
+
+  _skippedTicksCount++;
+  return true;
 }
 
-void StackSamplerLoop::CpuProfilingIteration() {
-  uint32_t sampledThreads = 0;
-  uint32_t managedThreadsCount = static_cast<uint32_t>(_pThreadList->Count());
-  uint32_t sampledThreadsCount = (std::min)(managedThreadsCount, _cpuThreadsThreshold);
-  std::shared_ptr<ThreadInfo> pThreadInfo = nullptr;
-
-  for (uint32_t i = 0; i < sampledThreadsCount && !_shutdownRequested; i++) {
-    pThreadInfo = _pThreadList->LoopNext(_iteratorCpuTime);
-    if (pThreadInfo != nullptr) {
-      // don't sample the sampling thread
-      if (pThreadInfo->GetThreadId() == ::GetCurrentThreadId()) {
-        pThreadInfo.reset();
-        continue;
-      }
+void StackSamplerLoop::LogStatistics() {
+  Log::Debug(
+      "Threads suspension time: ",
+      DurationHistogram::ToString(_suspensionTimeHistogram.GetAndReset())
+  );
+
+  auto cacheStats = GetUnwindInfoCache()->GetAndResetStats();
+  Log::Debug(
+      "Unwind info cache: hits=",
+      cacheStats.hits,
+      " misses=",
+      cacheStats.misses,
+      " invalidated=",
+      cacheStats.invalidatedEntries
+  );
+
+  // threads resumed by the suspension watchdog
+  if (_pWatchdog != nullptr) {
+    auto counts = _pWatchdog->GetStallsHistogram()->GetAndReset();
+    if (counts.count > 0) {
+      Log::Info("Stuck stack walks: ", DurationHistogram::ToString(counts));
+    }
+  }
 
-      // sample only if the thread is currently running on a core
-      auto lastConsumption = pThreadInfo->GetCpuConsumption();
-      auto [isRunning, currentConsumption, failure] =
-          OsSpecificApi::IsRunning(pThreadInfo->GetOsThreadHandle());
-
-      // Note: it is not possible to get this information on Windows 32-bit or in some
-      // cases in 64-bit
-      //       so isRunning should be true if this thread consumed some CPU since the
-      //       last iteration
-      if (failure) {
-        isRunning = (lastConsumption < currentConsumption);
-      }
+  // callstacks of parked threads reused instead of unwound
+  auto reusedWithoutSuspension = _reusedWithoutSuspensionCount.exchange(0);
+  auto reusedAfterSuspension = _reusedAfterSuspensionCount.exchange(0);
+  auto unwoundWaitingThreads = _unwoundWaitingThreadsCount.exchange(0);
+  auto waitingSamples =
+      reusedWithoutSuspension + reusedAfterSuspension + unwoundWaitingThreads;
+  if (waitingSamples > 0) {
+    Log::Debug(
+        "Cached callstacks: reused without suspension=",
+        reusedWithoutSuspension,
+        " reused after suspension=",
+        reusedAfterSuspension,
+        " unwound=",
+        unwoundWaitingThreads,
+        " hit ratio=",
+        (reusedWithoutSuspension + reusedAfterSuspension) * 100 / waitingSamples,
+        "%"
+    );
+  }
 
-      if (isRunning) {
-        // if it was waiting, reset the waiting timestamp
-        // TODO: not sure if a wait sample should be generated in case it was waiting
-        // when we detect that it is now running...
-        //       maybe the cpu iteration should happen before the walltime iteration?
-        pThreadInfo->SetLastWaitSampleTimestamp(0ns);
-
-        auto cpuDelta = currentConsumption - lastConsumption;
-
-        // we don't collect a sample for this thread is no CPU was consumed since the
-        // last check
-        if (cpuDelta > 0ms) {
-          auto lastCpuTimestamp = pThreadInfo->GetCpuTimestamp();
-          auto thisSampleTimestamp = OpSysTools::GetHighPrecisionTimestamp();
-
-          // Work in nanoseconds to avoid precision loss when capping.
-          std::chrono::nanoseconds cpuForSample = cpuDelta;
-
-          // For the first computation, no need to deal with overlapping CPU usage
-          if (lastCpuTimestamp != 0ns) {
-            // detect overlapping CPU usage
-            auto threshold = lastCpuTimestamp + cpuForSample;
-            if (threshold > thisSampleTimestamp) {
-              // Cap to elapsed wall-clock time to avoid over-counting.
-              // Subtract 1µs safety margin to avoid attributing 100% CPU.
-              auto elapsed = thisSampleTimestamp - lastCpuTimestamp;
-              cpuForSample = elapsed > 1us ? elapsed - 1us : 0ns;
-            }
-          }
-
-          pThreadInfo->SetCpuConsumption(currentConsumption, thisSampleTimestamp);
-
-          CollectOneThreadSample(
-              pThreadInfo,
-              thisSampleTimestamp,
-              cpuForSample,
-              PROFILING_TYPE::CpuTime,
-              WAIT_REASON_NONE
-          );
-
-          // don't scan more threads than nb logical cores
-          sampledThreads++;
-          if (sampledThreads >= _nbCores) {
-            break;
-          }
-        }
-      }
-      pThreadInfo.reset();
-    }
+  auto foldedThreads = _foldedThreadsCount.exchange(0);
+  auto foldedSamples = _foldedSamplesCount.exchange(0);
+  if (foldedThreads > 0) {
+    Log::Debug(
+        "Folded walltime samples: ",
+        foldedThreads,
+        " threads in ",
+        foldedSamples,
+        " samples"
+    );
   }
-}
 
-void StackSamplerLoop::WalltimeProfilingIteration() {
-  uint32_t managedThreadsCount = static_cast<uint32_t>(_pThreadList->Count());
-  uint32_t sampledThreadsCount =
-      (std::min)(managedThreadsCount, _walltimeThreadsThreshold);
+  auto tornTraceContexts = _tornTraceContextsCount.exchange(0);
+  if (tornTraceContexts > 0) {
+    Log::Debug("Trace contexts not read: ", tornTraceContexts, " samples");
+  }
 
-  uint32_t i = 0;
+  auto schedulerStats = _scheduler.GetAndResetStats();
+  Log::Debug(
+      "Sampling ticks: ",
+      schedulerStats.ticks,
+      " overruns=",
+      schedulerStats.overruns,
+      " skipped=",
+      schedulerStats.skippedTicks,
+      " lateness: ",
+      DurationHistogram::ToString(schedulerStats.lateness)
+  );
+
+  auto skippedTicks = _skippedTicksCount.exchange(0);
+  if (skippedTicks > 0) {
+    Log::Info("Sampling ticks skipped under memory pressure: ", skippedTicks);
+  }
+}
 
-  ThreadInfo* firstThread = nullptr;
-  std::shared_ptr<ThreadInfo> pThreadInfo = nullptr;
+void StackSamplerLoop::MainLoopIteration() {
+  // one system call for all the threads instead of one per sampled thread
+  uint32_t threadsCount = static_cast<uint32_t>(_pThreadList->Count());
+  uint32_t queriedThreadsCount = 0;
+  if (_pCpuTimeProvider != nullptr) {
+    queriedThreadsCount += (std::min)(threadsCount, _cpuThreadsThreshold);
+  }
+  if (_pWallTimeProvider != nullptr) {
+    queriedThreadsCount += (std::min)(threadsCount, _walltimeThreadsThreshold);
+  }
+  if (queriedThreadsCount >= MinThreadsForStateSnapshot) {
+    _threadStates.Refresh();
+  } else {
+    _threadStates.Clear();
+  }
 
-  do {
-    pThreadInfo = _pThreadList->LoopNext(_iteratorWallTime);
+  if (_pCpuTimeProvider != nullptr) {
+    CpuProfilingIteration();
+  }
 
-    // either the list is empty or iterator is not in the array range
-    // so prefer bailing out
-    if (pThreadInfo == nullptr) {
-      break;
-    }
+  if (_pWallTimeProvider != nullptr) {
+    WalltimeProfilingIteration();
+  }
+}
 
-    // don't sample the sampling thread
-    DWORD threadId = pThreadInfo->GetThreadId();
-    if (pThreadInfo->GetThreadId() == ::GetCurrentThreadId()) {
-      pThreadInfo.reset();
-      continue;
-    }
+void StackSamplerLoop::CpuProfilingIteration() {
+  // the threads returned by LoopNext stay alive until the end of the iteration
+  ThreadList::ReadGuard guard(*_pThreadList);
+  _iteration.RunCpu(guard, ::GetCurrentThreadId());
+}
 
-    if (firstThread == pThreadInfo.get()) {
-      pThreadInfo.reset();
-      break;
-    }
+void StackSamplerLoop::WalltimeProfilingIteration() {
+  // the threads returned by LoopNext stay alive until the end of the iteration
+  ThreadList::ReadGuard guard(*_pThreadList);
+  _iteration.RunWalltime(guard, ::GetCurrentThreadId(), _samplingStart);
 
-    if (firstThread == nullptr) {
-      firstThread = pThreadInfo.get();
-    }
+  if (!_walltimeFolder.IsEmpty()) {
+    FlushFoldedSamples();
+  }
+}
 
-    auto thisSampleTimestamp = OpSysTools::GetHighPrecisionTimestamp();
-    auto prevSampleTimestamp =
-        pThreadInfo->SetLastWalltimeSampleTimestamp(thisSampleTimestamp);
-    auto duration = ComputeWallTime(thisSampleTimestamp, prevSampleTimestamp);
+std::chrono::nanoseconds StackSamplerLoop::GetTimestamp() {
+  return OpSysTools::GetHighPrecisionTimestamp();
+}
 
-    // check if the thread is waiting and for for which reason
-    auto [isWaiting, waitReason, failure] =
-        OsSpecificApi::IsWaiting(pThreadInfo->GetOsThreadHandle());
-    if (failure || !isWaiting) {
-      waitReason = WAIT_REASON_NONE;
-    }
+std::tuple<bool, std::chrono::milliseconds, bool> StackSamplerLoop::IsRunning(
+    ThreadInfo* pThreadInfo
+) {
+  // threads created after the snapshot are queried directly
+  auto pState = _threadStates.Find(pThreadInfo->GetThreadId());
+  if (pState == nullptr) {
+    return OsSpecificApi::IsRunning(pThreadInfo->GetOsThreadHandle());
+  }
 
-    // get callstack and create sample (possibly mixed with wait information)
-    CollectOneThreadSample(
-        pThreadInfo, thisSampleTimestamp, duration, PROFILING_TYPE::WallTime, waitReason
-    );
+  return {OsSpecificApi::IsRunningThreadState(pState->state), pState->cpuTime, false};
+}
 
-    pThreadInfo.reset();
-    i++;
+std::tuple<bool, ULONG, bool> StackSamplerLoop::IsWaiting(ThreadInfo* pThreadInfo) {
+  auto pState = _threadStates.Find(pThreadInfo->GetThreadId());
+  if (pState == nullptr) {
+    return OsSpecificApi::IsWaiting(pThreadInfo->GetOsThreadHandle());
+  }
 
-  } while (i < sampledThreadsCount && !_shutdownRequested);
+  bool isWaiting = OsSpecificApi::IsWaitingThreadState(pState->state);
+  return {isWaiting, pState->waitReason, false};
 }
 
-void StackSamplerLoop::CollectOneThreadSample(
-    std::shared_ptr<ThreadInfo>& pThreadInfo,
+SampleStatus StackSamplerLoop::CollectOneThreadSample(
+    ThreadInfo* pThreadInfo,
     std::chrono::nanoseconds thisSampleTimestamp,
     std::chrono::nanoseconds duration,
     PROFILING_TYPE profilingType,
     ULONG waitingReason
 ) {
+  // the last stack walk of this thread got stuck: leave it alone for a while
+  if (pThreadInfo->IsSamplingBackedOff(thisSampleTimestamp)) {
+    return SampleStatus::Dropped;
+  }
+
+  // A thread parked in the same wait keeps the same callstack: if it has not been
+  // scheduled since its callstack was cached, reuse it without suspending the thread
+  CachedCallstack& cachedCallstack = pThreadInfo->GetCachedCallstack();
+  bool isWaiting = (profilingType == PROFILING_TYPE::WallTime) &&
+                   (waitingReason != WAIT_REASON_NONE);
+  const ThreadStateSnapshot::ThreadState* pState =
+      isWaiting ? _threadStates.Find(pThreadInfo->GetThreadId()) : nullptr;
+  bool hasContextSwitches = (pState != nullptr);
+  ULONG contextSwitches = hasContextSwitches ? pState->contextSwitches : 0;
+  if (hasContextSwitches && cachedCallstack.IsUnchanged(contextSwitches)) {
+    auto status = RecordSample(
+        pThreadInfo,
+        thisSampleTimestamp,
+        duration,
+        profilingType,
+        waitingReason,
+        cachedCallstack.GetFrames()
+    );
+    if (status == SampleStatus::Dropped) {
+      return status;
+    }
+
+    cachedCallstack.OnReusedWithoutSuspension(contextSwitches);
+    _reusedWithoutSuspensionCount.fetch_add(1, std::memory_order_relaxed);
+    return status;
+  }
+
   // Suspend the thread AND grab its CONTEXT in one shot. The CONTEXT acts both
   // as the suspend-fence (per Raymond Chen) and as the unwind seed below, so we
   // pay for a single GetThreadContext per sample instead of two.
   // The CONTEXT is ~1.2 KB on x64; we keep a single instance on the stack and
   // let CaptureStack mutate it in place (RtlVirtualUnwind rewrites the
   // register state frame-by-frame) instead of copying it.
+  auto suspensionStart = std::chrono::steady_clock::now();
   CONTEXT seedContext;
   if (!_stackFrameCollector.TrySuspendThread(pThreadInfo, seedContext)) {
-    return;
+    return SampleStatus::Dropped;
+  }
+
+  HANDLE hThread = pThreadInfo->GetOsThreadHandle();
+  if (_pWatchdog != nullptr) {
+    _pWatchdog->OnThreadSuspended(hThread);
   }
 
+  // CaptureStack rewrites the context while unwinding: keep the top of the stack
+  uint64_t rip = seedContext.Rip;
+  uint64_t rsp = seedContext.Rsp;
+  uint64_t stackHash = isWaiting ? CachedCallstack::HashStackTop(rsp) : 0;
+  bool isCachedCallstackReused = cachedCallstack.Matches(rip, rsp, stackHash);
+
   bool isTruncated = false;
   uint64_t frames[MaxFrameCount];
   uint16_t framesCount = MaxFrameCount;
-  bool isStackCaptured = (_stackFrameCollector.CaptureStack(
-      pThreadInfo->GetOsThreadHandle(), seedContext, frames, framesCount, isTruncated
-  ));
-  // resume the thread before doing any allocation that could cause a deadlock
-  ::ResumeThread(pThreadInfo->GetOsThreadHandle());
-
-  if (isStackCaptured) {
-    // set a null address for the last frame in case of truncated stack
-    if (isTruncated) {
-      frames[framesCount - 1] = 0;
+  bool isStackCaptured = false;
+
+  // In stack snapshot mode, the stack is only copied while the thread is suspended.
+  // Otherwise (or if the copy fails), it is unwound in place.
+  bool isSnapshotCaptured = false;
+  if (!isCachedCallstackReused) {
+    isSnapshotCaptured = (_pStackSnapshot != nullptr) &&
+                         _stackFrameCollector.CaptureStackSnapshot(
+                             hThread, seedContext, *_pStackSnapshot
+                         );
+    if (!isSnapshotCaptured) {
+      isStackCaptured = _stackFrameCollector.CaptureStack(
+          hThread, seedContext, frames, framesCount, isTruncated
+      );
     }
+  }
 
-    // Snapshot the current RUM view context (shared-lock, fast copy)
-    RumViewContext rumView;
-    bool hasRumView = false;
-    if (_pRumViewContextProvider != nullptr) {
-      hasRumView = _pRumViewContextProvider->GetCurrentViewContext(rumView);
+  // resume the thread before doing any allocation that could cause a deadlock
+  bool isStackWalkStuck = false;
+  if (_pWatchdog != nullptr) {
+    isStackWalkStuck = !_pWatchdog->ResumeThread();
+  } else {
+    ::ResumeThread(hThread);
+  }
+  _suspensionTimeHistogram.Record(std::chrono::steady_clock::now() - suspensionStart);
+
+  // the watchdog resumed the thread while its stack was walked: the frames might
+  // not belong to the same stack
+  if (isStackWalkStuck) {
+    pThreadInfo->OnStuckStackWalk(thisSampleTimestamp);
+    Log::Debug(
+        "Stuck stack walk for thread #",
+        pThreadInfo->GetThreadId(),
+        " (",
+        pThreadInfo->GetStuckStackWalksCount(),
+        " in a row)"
+    );
+    return SampleStatus::Dropped;
+  }
+  pThreadInfo->OnStackWalkCompleted();
+
+  // same context as when the callstack was cached: no need to unwind it again
+  if (isCachedCallstackReused) {
+    auto status = RecordSample(
+        pThreadInfo,
+        thisSampleTimestamp,
+        duration,
+        profilingType,
+        waitingReason,
+        cachedCallstack.GetFrames()
+    );
+    if (status == SampleStatus::Dropped) {
+      return status;
     }
 
-    // create a sample
-    if (profilingType == PROFILING_TYPE::CpuTime) {
-      Sample sample = Sample(thisSampleTimestamp, pThreadInfo, frames, framesCount);
-      if (hasRumView) {
-        sample.SetRumViewContext(std::move(rumView));
-      }
-      _pCpuTimeProvider->Add(std::move(sample), duration);
+    cachedCallstack.OnReusedAfterSuspension(hasContextSwitches, contextSwitches);
+    _reusedAfterSuspensionCount.fetch_add(1, std::memory_order_relaxed);
+    return status;
+  }
 
-      if (hasRumView && _pViewVitalsAccumulator != nullptr) {
-        _pViewVitalsAccumulator->AccumulateViewVitals(
-            ViewVitalKind::CpuTime, duration.count()
-        );
-      }
-    } else if (profilingType == PROFILING_TYPE::WallTime) {
-      std::chrono::nanoseconds waitDuration = 0ns;
-
-      // check if the thread is waiting
-      if (waitingReason != WAIT_REASON_NONE) {
-        // compute the "current" wait duration
-        // since we don't have the start/ end time of the wait, we "jump" from wait to
-        // wait
-        auto lastWaitTimestamp =
-            pThreadInfo->SetLastWaitSampleTimestamp(thisSampleTimestamp);
-        if (lastWaitTimestamp != 0ns) {
-          waitDuration = thisSampleTimestamp - lastWaitTimestamp;
-        } else {
-          waitDuration = _samplingPeriod;  // at least one sampling period has elapsed
-                                           // since the last wait sample
-        }
-      }
+  if (isSnapshotCaptured) {
+    isStackCaptured = _stackFrameCollector.UnwindStackSnapshot(
+        *_pStackSnapshot, frames, framesCount, isTruncated
+    );
+  }
 
-      Sample sample = Sample(thisSampleTimestamp, pThreadInfo, frames, framesCount);
-      if (hasRumView) {
-        sample.SetRumViewContext(std::move(rumView));
-      }
-      _pWallTimeProvider->Add(std::move(sample), duration, waitDuration, waitingReason);
+  if (!isStackCaptured) {
+    return SampleStatus::Dropped;
+  }
 
-      if (hasRumView && _pViewVitalsAccumulator != nullptr) {
-        _pViewVitalsAccumulator->AccumulateViewVitals(
-            ViewVitalKind::WaitTime, waitDuration.count()
-        );
-      }
-    } else {
-      // should neven happen
-    }
+  // set a null address for the last frame in case of truncated stack
+  if (isTruncated) {
+    frames[framesCount - 1] = 0;
+  }
+
+  // the thread is resumed: the callstack can be copied
+  std::span<const uint64_t> callstack(frames, framesCount);
+  if (isWaiting) {
+    cachedCallstack.Update(
+        rip, rsp, stackHash, callstack, hasContextSwitches, contextSwitches
+    );
+    _unwoundWaitingThreadsCount.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    cachedCallstack.Invalidate();
   }
+
+  return RecordSample(
+      pThreadInfo,
+      thisSampleTimestamp,
+      duration,
+      profilingType,
+      waitingReason,
+      callstack
+  );
 }
 
-std::chrono::nanoseconds StackSamplerLoop::ComputeWallTime(
-    std::chrono::nanoseconds currentTimestampNs,
-    std::chrono::nanoseconds prevTimestampNs
+SampleStatus StackSamplerLoop::RecordSample(
+    ThreadInfo* pThreadInfo,
+    std::chrono::nanoseconds thisSampleTimestamp,
+    std::chrono::nanoseconds duration,
+    PROFILING_TYPE profilingType,
+    ULONG waitingReason,
+    std::span<const uint64_t> callstack
 ) {
-  if (prevTimestampNs == 0ns) {
-    // prevTimestampNs = 0 means that it is the first time the wall time is computed for
-    // a given thread
-    // --> at least one sampling period has elapsed
-    return _samplingPeriod;
+  // span running on the thread: the thread might be running again and changing it,
+  // so a torn read is dropped instead of being retried
+  TraceContext traceContext;
+  if (!pThreadInfo->GetTraceContextSlot().TryRead(traceContext)) {
+    traceContext = {};
+    _tornTraceContextsCount.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // the samples of the waiting threads are written together at the end of the tick
+  // (unless they belong to a span)
+  if (_isWalltimeFoldingEnabled && (profilingType == PROFILING_TYPE::WallTime) &&
+      (waitingReason != WAIT_REASON_NONE) && traceContext.IsEmpty()) {
+    _walltimeFolder.Add(
+        pThreadInfo->GetThreadId(),
+        pThreadInfo->GetGeneration(),
+        pThreadInfo->GetThreadNameGroupKey(),
+        callstack,
+        duration,
+        pThreadInfo,
+        thisSampleTimestamp
+    );
+    return SampleStatus::Deferred;
   }
 
-  if (prevTimestampNs > 0ns) {
-    auto durationNs = currentTimestampNs - prevTimestampNs;
-    return (std::max)(0ns, durationNs);
+  // current RUM view (one atomic load: the exporter resolves the view strings)
+  uint32_t rumViewHandle = (_pRumViewContextProvider != nullptr)
+                               ? _pRumViewContextProvider->GetCurrentViewHandle()
+                               : RumViewRegistry::NoView;
+  bool hasRumView = (rumViewHandle != RumViewRegistry::NoView);
+
+  // write the sample into the provider ring (no allocation)
+  uint32_t threadId = pThreadInfo->GetThreadId();
+  uint64_t threadGeneration = pThreadInfo->GetGeneration();
+  if (profilingType == PROFILING_TYPE::CpuTime) {
+    if (!_pCpuTimeProvider->Add(
+            thisSampleTimestamp,
+            threadId,
+            threadGeneration,
+            callstack,
+            rumViewHandle,
+            traceContext,
+            duration
+        )) {
+      return SampleStatus::Dropped;
+    }
+
+    if (hasRumView && _pViewVitalsAccumulator != nullptr) {
+      _pViewVitalsAccumulator->AccumulateViewVitals(
+          ViewVitalKind::CpuTime, duration.count()
+      );
+    }
+  } else if (profilingType == PROFILING_TYPE::WallTime) {
+    // since we don't have the start/end time of the wait, a waiting thread is
+    // considered waiting for all the time the sample stands for
+    std::chrono::nanoseconds waitDuration =
+        (waitingReason != WAIT_REASON_NONE) ? duration : 0ns;
+
+    if (!_pWallTimeProvider->Add(
+            thisSampleTimestamp,
+            threadId,
+            threadGeneration,
+            callstack,
+            rumViewHandle,
+            traceContext,
+            duration,
+            waitDuration,
+            waitingReason
+        )) {
+      return SampleStatus::Dropped;
+    }
+
+    if (hasRumView && _pViewVitalsAccumulator != nullptr) {
+      _pViewVitalsAccumulator->AccumulateViewVitals(
+          ViewVitalKind::WaitTime, waitDuration.count()
+      );
+    }
   } else {
-    // this should never happen
-    // count at least one sampling period
-    return _samplingPeriod;
+    // should neven happen
+    return SampleStatus::Dropped;
   }
+
+  return SampleStatus::Recorded;
+}
+
+void StackSamplerLoop::FlushFoldedSamples() {
+  auto timestamp = OpSysTools::GetHighPrecisionTimestamp();
+
+  uint32_t rumViewHandle = (_pRumViewContextProvider != nullptr)
+                               ? _pRumViewContextProvider->GetCurrentViewHandle()
+                               : RumViewRegistry::NoView;
+  bool hasRumView = (rumViewHandle != RumViewRegistry::NoView);
+
+  // a dropped sample (full ring) is counted by the provider like the other samples;
+  // its threads are not marked as sampled so their wall time goes to the next sample
+  auto stats = _walltimeFolder.Flush(
+      [this, timestamp, rumViewHandle](
+          const WalltimeSampleFolder::Record& record, std::span<const uint64_t> frames
+      ) {
+        return _pWallTimeProvider->AddFolded(
+            timestamp,
+            record.threadId,
+            record.threadGeneration,
+            record.threadGroup,
+            record.threadsCount,
+            frames,
+            rumViewHandle,
+            record.duration
+        );
+      }
+  );
+
+  if (hasRumView && _pViewVitalsAccumulator != nullptr) {
+    _pViewVitalsAccumulator->AccumulateViewVitals(
+        ViewVitalKind::WaitTime, stats.duration.count()
+    );
+  }
+
+  _foldedThreadsCount.fetch_add(stats.threadsCount, std::memory_order_relaxed);
+  _foldedSamplesCount.fetch_add(stats.samplesCount, std::memory_order_relaxed);
 }
@@ -4,20 +4,25 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "Configuration.h"
 #include "CpuTimeProvider.h"
+#include "DurationHistogram.h"
+#include "MemoryBudget.h"
 #include "ProfilingConstants.h"
-#include "RumContext.h"
+#include "RumViewRegistry.h"
+#include "SamplingIteration.h"
+#include "SamplingScheduler.h"
 #include "StackFrameCollector.h"
+#include "SuspensionWatchdog.h"
 #include "ThreadList.h"
+#include "ThreadStateSnapshot.h"
+#include "WalltimeSampleFolder.h"
 #include "WalltimeProvider.h"
 #include "pch.h"
 
-typedef enum { WallTime, CpuTime } PROFILING_TYPE;
-
-const ULONG WAIT_REASON_NONE = 0xFFFF;
-
-class StackSamplerLoop {
+class StackSamplerLoop : private IThreadSampler {
  public:
   StackSamplerLoop(
       Configuration* pConfiguration,
@@ -25,29 +30,55 @@ class StackSamplerLoop {
       CpuTimeProvider* pCpuTimeProvider,
       WallTimeProvider* pWallTimeProvider,
       IRumViewContextProvider* pRumViewContextProvider = nullptr,
-      IViewVitalsAccumulator* pViewVitalsAccumulator = nullptr
+      IViewVitalsAccumulator* pViewVitalsAccumulator = nullptr,
+      const MemoryBudget* pMemoryBudget = nullptr
   );
   ~StackSamplerLoop();
 
   void Start();
   void Stop();
 
+  // suspension times, unwind info cache, stuck stack walks, cached callstacks, folded
+  // samples, scheduling and ticks skipped under memory pressure (on export)
+  void LogStatistics();
+
+  // how long the sampled threads are kept suspended
+  DurationHistogram* GetSuspensionTimeHistogram() { return &_suspensionTimeHistogram; }
+  UnwindInfoCache* GetUnwindInfoCache() {
+    return _stackFrameCollector.GetUnwindInfoCache();
+  }
+
  private:
   void MainLoop();
   void MainLoopIteration();
+  bool ShouldSkipTick();
   void CpuProfilingIteration();
   void WalltimeProfilingIteration();
-  void CollectOneThreadSample(
-      std::shared_ptr<ThreadInfo>& pThreadInfo,
+
+  // IThreadSampler
+  std::chrono::nanoseconds GetTimestamp() override;
+  std::tuple<bool, std::chrono::milliseconds, bool> IsRunning(
+      ThreadInfo* pThreadInfo
+  ) override;
+  std::tuple<bool, ULONG, bool> IsWaiting(ThreadInfo* pThreadInfo) override;
+  SampleStatus CollectOneThreadSample(
+      ThreadInfo* pThreadInfo,
       std::chrono::nanoseconds thisSampleTimestamp,
       std::chrono::nanoseconds duration,
       PROFILING_TYPE profilingType,
       ULONG waitingReason
-  );  // waitingReason is only used for WallTime samples
-  std::chrono::nanoseconds ComputeWallTime(
-      std::chrono::nanoseconds currentTimestampNs,
-      std::chrono::nanoseconds prevTimestampNs
+  ) override;
+  bool IsStopRequested() override { return _shutdownRequested; }
+
+  SampleStatus RecordSample(
+      ThreadInfo* pThreadInfo,
+      std::chrono::nanoseconds thisSampleTimestamp,
+      std::chrono::nanoseconds duration,
+      PROFILING_TYPE profilingType,
+      ULONG waitingReason,
+      std::span<const uint64_t> callstack
   );
+  void FlushFoldedSamples();
 
  private:
   static const int MaxFrameCount = dd_win_prof::kMaxStackDepth;
@@ -57,18 +88,50 @@ class StackSamplerLoop {
 
   // configuration
   std::chrono::nanoseconds _samplingPeriod;
+  std::chrono::nanoseconds _samplingStart;
+
+  SystemClock _clock;
+  SamplingScheduler _scheduler;
   uint32_t _cpuThreadsThreshold;
   uint32_t _walltimeThreadsThreshold;
-
-  uint32_t _nbCores;
+  bool _isWalltimeFoldingEnabled;
 
   ThreadList* _pThreadList;
-  uint32_t _iteratorCpuTime;
-  uint32_t _iteratorWallTime;
+
+  // threads sampled at each tick
+  SamplingIteration _iteration;
+
+  // state of all the threads, refreshed once per tick when there are enough threads
+  ThreadStateSnapshot _threadStates;
+
+  // samples of the waiting threads of the current tick, when folding is enabled
+  WalltimeSampleFolder _walltimeFolder;
 
   StackFrameCollector _stackFrameCollector;
+  std::unique_ptr<StackSnapshot> _pStackSnapshot;  // only in stack snapshot mode
+  DurationHistogram _suspensionTimeHistogram;
+  OsThreadControl _threadControl;
+  std::unique_ptr<SuspensionWatchdog> _pWatchdog;  // nullptr if disabled
   CpuTimeProvider* _pCpuTimeProvider;
   WallTimeProvider* _pWallTimeProvider;
   IRumViewContextProvider* _pRumViewContextProvider;
   IViewVitalsAccumulator* _pViewVitalsAccumulator;
+
+  // one tick out of two is skipped under memory pressure (optional)
+  const MemoryBudget* _pMemoryBudget;
+  uint64_t _pressureTicksCount = 0;
+  std::atomic<uint64_t> _skippedTicksCount{0};
+
+  // walltime samples of waiting threads (read on export): callstack reused without
+  // suspending the thread, reused after checking its context, or unwound
+  std::atomic<uint64_t> _reusedWithoutSuspensionCount{0};
+  std::atomic<uint64_t> _reusedAfterSuspensionCount{0};
+  std::atomic<uint64_t> _unwoundWaitingThreadsCount{0};
+
+  // walltime samples of waiting threads folded into fewer samples (read on export)
+  std::atomic<uint64_t> _foldedThreadsCount{0};
+  std::atomic<uint64_t> _foldedSamplesCount{0};
+
+  // trace contexts being written while read (the samples get no trace context)
+  std::atomic<uint64_t> _tornTraceContextsCount{0};
 };
@@ -0,0 +1,63 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "StackSnapshot.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "pch.h"
+
+StackSnapshot::StackSnapshot(size_t capacity)
+    : _capacity(capacity),
+      _buffer(std::make_unique<uint8_t[]>(capacity)),
+      _stackLimit(0),
+      _stackBase(0),
+      _start(0),
+      _size(0) {}
+
+bool StackSnapshot::Capture(
+    const CONTEXT& context, uint64_t stackLimit, uint64_t stackBase
+) {
+  _size = 0;
+
+  // without the boundaries, we could read past the end of the stack
+  uint64_t rsp = context.Rsp;
+  if ((stackBase == 0) || (rsp < stackLimit) || (rsp >= stackBase)) {
+    return false;
+  }
+
+  size_t size = static_cast<size_t>(std::min<uint64_t>(stackBase - rsp, _capacity));
+  if (!CopyStack(_buffer.get(), rsp, size)) {
+    return false;
+  }
+
+  _registers = UnwindRegisters::FromContext(context);
+  _stackLimit = stackLimit;
+  _stackBase = stackBase;
+  _start = rsp;
+  _size = size;
+  return true;
+}
+
+bool StackSnapshot::CopyStack(uint8_t* pDestination, uint64_t source, size_t size) {
+  __try {
+    // the committed part of a stack is between its limit and its base but a guard
+    // page or a stack switch (e.g. fibers) could still trigger an access violation
+    std::memcpy(pDestination, reinterpret_cast<const void*>(source), size);
+    return true;
+  } __except (EXCEPTION_EXECUTE_HANDLER) {
+    return false;
+  }
+}
+
+bool StackSnapshot::ReadUInt64(uint64_t address, uint64_t& value) const {
+  if ((address < _start) || (_size < sizeof(uint64_t)) ||
+      (address - _start > _size - sizeof(uint64_t))) {
+    return false;
+  }
+
+  std::memcpy(&value, _buffer.get() + (address - _start), sizeof(uint64_t));
+  return true;
+}
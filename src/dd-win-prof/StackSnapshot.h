@@ -0,0 +1,53 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "StackUnwinder.h"
+#include "pch.h"
+
+// Copy of the registers and of the top of the stack of a suspended thread.
+// Capturing the snapshot is the only work done while the thread is suspended: it is
+// unwound from the copy after being resumed. The buffer is allocated once and
+// reused for every sample.
+class StackSnapshot : public IStackMemory {
+ public:
+  static constexpr size_t DefaultCapacity = 64 * 1024;
+
+ public:
+  explicit StackSnapshot(size_t capacity = DefaultCapacity);
+
+  StackSnapshot(const StackSnapshot&) = delete;
+  StackSnapshot& operator=(const StackSnapshot&) = delete;
+
+  // Copy the registers and up to capacity bytes of stack from rsp to stackBase.
+  // The stack boundaries must be known.
+  bool Capture(const CONTEXT& context, uint64_t stackLimit, uint64_t stackBase);
+
+  // IStackMemory: only the copied window can be read
+  bool ReadUInt64(uint64_t address, uint64_t& value) const override;
+
+  const UnwindRegisters& GetRegisters() const { return _registers; }
+  uint64_t GetStackLimit() const { return _stackLimit; }
+  uint64_t GetStackBase() const { return _stackBase; }
+  uint64_t GetStart() const { return _start; }
+  size_t GetSize() const { return _size; }
+  size_t GetCapacity() const { return _capacity; }
+
+ private:
+  static bool CopyStack(uint8_t* pDestination, uint64_t source, size_t size);
+
+ private:
+  const size_t _capacity;
+  std::unique_ptr<uint8_t[]> _buffer;
+
+  UnwindRegisters _registers;
+  uint64_t _stackLimit;
+  uint64_t _stackBase;
+  uint64_t _start;  // address of the first copied byte (rsp)
+  size_t _size;
+};
@@ -0,0 +1,688 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "StackUnwinder.h"
+
+#include <cstring>
+
+#include "pch.h"
+
+namespace {
+// UNWIND_INFO layout
+// (https://learn.microsoft.com/cpp/build/exception-handling-x64#struct-unwind_info)
+struct UnwindInfoHeader {
+  uint8_t versionAndFlags;  // version: 3 bits, flags: 5 bits
+  uint8_t sizeOfProlog;
+  uint8_t countOfCodes;
+  uint8_t frameRegisterAndOffset;  // register: 4 bits, scaled offset: 4 bits
+};
+
+constexpr uint8_t UnwindFlagChainInfo = 0x4;
+
+// an UnwindData with the lowest bit set points to another RUNTIME_FUNCTION
+constexpr uint32_t RuntimeFunctionIndirect = 0x1;
+
+// number of 16-bit slots used by an unwind operation (0 if unknown)
+size_t GetSlotsCount(UnwindOp op, uint8_t opInfo) {
+  switch (op) {
+    case UnwindOp::PushNonVolatile:
+    case UnwindOp::AllocSmall:
+    case UnwindOp::SetFramePointer:
+    case UnwindOp::PushMachineFrame:
+      return 1;
+    case UnwindOp::SaveNonVolatile:
+    case UnwindOp::SaveXmm128:
+    case UnwindOp::Epilog:
+      return 2;
+    case UnwindOp::SaveNonVolatileFar:
+    case UnwindOp::SaveXmm128Far:
+      return 3;
+    case UnwindOp::AllocLarge:
+      return (opInfo == 0) ? 2 : 3;
+    default:
+      return 0;
+  }
+}
+
+// 32-bit operand stored in the two slots following the operation
+uint64_t GetFarOperand(const uint16_t* pCodes, size_t index) {
+  return pCodes[index + 1] | (static_cast<uint64_t>(pCodes[index + 2]) << 16);
+}
+}  // namespace
+
+UnwindRegisters UnwindRegisters::FromContext(const CONTEXT& context) {
+  UnwindRegisters registers;
+  registers.rip = context.Rip;
+  registers.gpr[0] = context.Rax;
+  registers.gpr[1] = context.Rcx;
+  registers.gpr[2] = context.Rdx;
+  registers.gpr[3] = context.Rbx;
+  registers.gpr[4] = context.Rsp;
+  registers.gpr[5] = context.Rbp;
+  registers.gpr[6] = context.Rsi;
+  registers.gpr[7] = context.Rdi;
+  registers.gpr[8] = context.R8;
+  registers.gpr[9] = context.R9;
+  registers.gpr[10] = context.R10;
+  registers.gpr[11] = context.R11;
+  registers.gpr[12] = context.R12;
+  registers.gpr[13] = context.R13;
+  registers.gpr[14] = context.R14;
+  registers.gpr[15] = context.R15;
+  return registers;
+}
+
+ImageUnwindTable::ImageUnwindTable(UnwindInfoCache* pCache) : _pCache(pCache) {}
+
+bool ImageUnwindTable::LookupFunctionEntry(
+    uint64_t rip, uint64_t& imageBase, RUNTIME_FUNCTION& entry
+) {
+  if (_pCache == nullptr) {
+    return LookupImageFunctionEntry(rip, imageBase, entry);
+  }
+
+  if (_pCache->TryGet(rip, imageBase, entry)) {
+    return true;
+  }
+
+  uint64_t cacheEpoch = _pCache->GetEpoch();
+  if (!LookupImageFunctionEntry(rip, imageBase, entry)) {
+    return false;
+  }
+  _pCache->Add(rip, imageBase, entry, cacheEpoch);
+  return true;
+}
+
+bool ImageUnwindTable::LookupImageFunctionEntry(
+    uint64_t rip, uint64_t& imageBase, RUNTIME_FUNCTION& entry
+) {
+  __try {
+    // RtlLookupFunctionEntry() may try to acquire global locks. When a snapshot is
+    // unwound, the thread is not suspended anymore. When the stack is unwound in place
+    // (see StackFrameCollector::UnwindInPlace), the thread is still suspended: the
+    // SuspensionWatchdog resumes it if the lookup gets stuck and the stack is then
+    // discarded.
+    RUNTIME_FUNCTION* pEntry = ::RtlLookupFunctionEntry(rip, &imageBase, nullptr);
+    if (pEntry == nullptr) {
+      return false;
+    }
+
+    entry = *pEntry;
+    return true;
+  } __except (EXCEPTION_EXECUTE_HANDLER) {
+    return false;
+  }
+}
+
+bool ImageUnwindTable::ReadImage(uint64_t address, void* pBuffer, size_t size) {
+  __try {
+    std::memcpy(pBuffer, reinterpret_cast<const void*>(address), size);
+    return true;
+  } __except (EXCEPTION_EXECUTE_HANDLER) {
+    return false;
+  }
+}
+
+bool InPlaceStackMemory::ReadUInt64(uint64_t address, uint64_t& value) const {
+  __try {
+    value = *reinterpret_cast<const uint64_t*>(address);
+    return true;
+  } __except (EXCEPTION_EXECUTE_HANDLER) {
+    return false;
+  }
+}
+
+StackUnwinder::StackUnwinder(IUnwindTable* pUnwindTable, UnwindStrategy strategy)
+    : _pUnwindTable(pUnwindTable), _strategy(strategy) {}
+
+bool StackUnwinder::Unwind(
+    UnwindRegisters& registers,
+    const IStackMemory& memory,
+    uint64_t stackLimit,
+    uint64_t stackBase,
+    uint64_t* pFrames,
+    uint16_t& framesCount,
+    bool& isTruncated
+) {
+  isTruncated = false;
+  uint16_t maxFramesCount = framesCount;
+  uint64_t& rsp = registers.gpr[UnwindRegisters::Rsp];
+
+  framesCount = 0;
+  do {
+    if (framesCount >= maxFramesCount) {
+      isTruncated = true;
+      break;
+    }
+    pFrames[framesCount++] = registers.rip;
+
+    uint64_t previousRsp = rsp;
+    uint64_t establisherFrame = rsp;
+    FrameResult result;
+
+    // the top frame can be interrupted anywhere (prolog, epilog, function without
+    // frame) where rbp is not its frame base: only its callers follow the chain
+    if ((_strategy == UnwindStrategy::FramePointers) && (framesCount > 1) &&
+        TryUnwindFramePointer(registers, memory, stackLimit, stackBase)) {
+      establisherFrame = rsp - 2 * sizeof(uint64_t);
+      result = FrameResult::Unwound;
+    } else {
+      result = UnwindFrame(registers, memory, establisherFrame);
+    }
+
+    if (result == FrameResult::MemoryNotReadable) {
+      // the stack goes beyond the readable memory: keep the frames unwound so far
+      // and let the caller replace the extra slot by the truncation marker
+      if (framesCount < maxFramesCount) {
+        pFrames[framesCount++] = 0;
+      }
+      isTruncated = true;
+      break;
+    }
+
+    if (result == FrameResult::Failed) {
+      return false;
+    }
+
+    // Sanity checks: the stack pointer must stay in the stack and only go up
+    if (!IsValidStackPointer(establisherFrame, stackLimit, stackBase) ||
+        !IsValidStackPointer(rsp, stackLimit, stackBase) || (rsp <= previousRsp)) {
+      return false;
+    }
+  } while (registers.rip != 0);
+
+  return true;
+}
+
+bool StackUnwinder::TryUnwindFramePointer(
+    UnwindRegisters& registers,
+    const IStackMemory& memory,
+    uint64_t stackLimit,
+    uint64_t stackBase
+) {
+  uint64_t& rsp = registers.gpr[UnwindRegisters::Rsp];
+  uint64_t& rbp = registers.gpr[UnwindRegisters::Rbp];
+
+  // the frame record (saved rbp + return address) must be above the stack pointer
+  if (!IsValidStackPointer(rbp, stackLimit, stackBase) || (rbp < rsp)) {
+    return false;
+  }
+
+  uint64_t callerRbp;
+  uint64_t returnAddress;
+  if (!memory.ReadUInt64(rbp, callerRbp) ||
+      !memory.ReadUInt64(rbp + sizeof(uint64_t), returnAddress)) {
+    return false;
+  }
+
+  // a broken chain returns into the stack or links to a lower frame record. A caller
+  // that does not use rbp as frame pointer is only detected at the next frame
+  bool areBoundariesKnown = (stackLimit != 0) || (stackBase != 0);
+  if ((returnAddress == 0) ||
+      (areBoundariesKnown && (returnAddress >= stackLimit) &&
+       (returnAddress < stackBase))) {
+    return false;
+  }
+  if (IsValidStackPointer(callerRbp, stackLimit, stackBase) && (callerRbp <= rbp)) {
+    return false;
+  }
+
+  registers.rip = returnAddress;
+  rsp = rbp + 2 * sizeof(uint64_t);
+  rbp = callerRbp;
+  return true;
+}
+
+StackUnwinder::FrameResult StackUnwinder::UnwindFrame(
+    UnwindRegisters& registers, const IStackMemory& memory, uint64_t& establisherFrame
+) {
+  uint64_t& rsp = registers.gpr[UnwindRegisters::Rsp];
+
+  uint64_t imageBase = 0;
+  RUNTIME_FUNCTION entry;
+  bool isReturnAddressPopped = false;
+  if (_pUnwindTable->LookupFunctionEntry(registers.rip, imageBase, entry)) {
+    auto result = ApplyUnwindCodes(
+        registers, memory, imageBase, entry, isReturnAddressPopped, establisherFrame
+    );
+    if (result != FrameResult::Unwound) {
+      return result;
+    }
+  }
+  // else: no unwind data means a leaf function that did not touch the stack
+
+  if (!isReturnAddressPopped) {
+    if (!memory.ReadUInt64(rsp, registers.rip)) {
+      return FrameResult::MemoryNotReadable;
+    }
+    rsp += sizeof(uint64_t);
+  }
+
+  return FrameResult::Unwound;
+}
+
+StackUnwinder::FrameResult StackUnwinder::ApplyUnwindCodes(
+    UnwindRegisters& registers,
+    const IStackMemory& memory,
+    uint64_t imageBase,
+    const RUNTIME_FUNCTION& entry,
+    bool& isReturnAddressPopped,
+    uint64_t& establisherFrame
+) {
+  uint64_t& rsp = registers.gpr[UnwindRegisters::Rsp];
+
+  RUNTIME_FUNCTION function = entry;
+  if ((function.UnwindData & RuntimeFunctionIndirect) != 0) {
+    if (!_pUnwindTable->ReadImage(
+            imageBase + (function.UnwindData & ~RuntimeFunctionIndirect),
+            &function,
+            sizeof(function)
+        )) {
+      return FrameResult::Failed;
+    }
+  }
+
+  for (int chainIndex = 0; chainIndex < MaxChainedEntries; chainIndex++) {
+    uint64_t infoAddress = imageBase + function.UnwindData;
+    UnwindInfoHeader header;
+    if (!_pUnwindTable->ReadImage(infoAddress, &header, sizeof(header))) {
+      return FrameResult::Failed;
+    }
+
+    uint8_t version = header.versionAndFlags & 0x7;
+    uint8_t flags = header.versionAndFlags >> 3;
+    if ((version != 1) && (version != 2)) {
+      return FrameResult::Failed;
+    }
+
+    uint16_t codes[256];
+    size_t codesCount = header.countOfCodes;
+    if ((codesCount != 0) &&
+        !_pUnwindTable->ReadImage(
+            infoAddress + sizeof(header), codes, codesCount * sizeof(uint16_t)
+        )) {
+      return FrameResult::Failed;
+    }
+
+    // in the prolog, only the operations already executed must be undone
+    uint64_t functionStart = imageBase + function.BeginAddress;
+    uint64_t prologOffset = UINT64_MAX;
+    if ((registers.rip >= functionStart) &&
+        (registers.rip - functionStart < header.sizeOfProlog)) {
+      prologOffset = registers.rip - functionStart;
+    } else if ((chainIndex == 0) && IsInEpilog(registers.rip, imageBase, function)) {
+      // the epilog has already undone part of the prolog: emulate the rest of it
+      isReturnAddressPopped = true;
+      return UnwindEpilog(registers, memory, imageBase, function);
+    }
+
+    // the frame register only gives the frame base once the prolog has set it
+    uint64_t frame = rsp;
+    uint8_t frameRegister = header.frameRegisterAndOffset & 0xF;
+    if (frameRegister != 0) {
+      for (size_t i = 0; i < codesCount; i++) {
+        auto op = static_cast<UnwindOp>((codes[i] >> 8) & 0xF);
+        if ((op == UnwindOp::SetFramePointer) && ((codes[i] & 0xFF) <= prologOffset)) {
+          frame = registers.gpr[frameRegister] -
+                  16 * static_cast<uint64_t>(header.frameRegisterAndOffset >> 4);
+          break;
+        }
+      }
+    }
+
+    if (chainIndex == 0) {
+      establisherFrame = frame;
+    }
+
+    for (size_t i = 0; i < codesCount;) {
+      uint8_t codeOffset = codes[i] & 0xFF;
+      auto op = static_cast<UnwindOp>((codes[i] >> 8) & 0xF);
+      uint8_t opInfo = codes[i] >> 12;
+      size_t slotsCount = GetSlotsCount(op, opInfo);
+      if ((slotsCount == 0) || (i + slotsCount > codesCount)) {
+        return FrameResult::Failed;
+      }
+
+      // skip the operations not executed yet and the version 2 epilog descriptions
+      if ((codeOffset > prologOffset) || (op == UnwindOp::Epilog)) {
+        i += slotsCount;
+        continue;
+      }
+
+      uint64_t offset = 0;
+      switch (op) {
+        case UnwindOp::PushNonVolatile:
+          if (!memory.ReadUInt64(rsp, registers.gpr[opInfo])) {
+            return FrameResult::MemoryNotReadable;
+          }
+          rsp += sizeof(uint64_t);
+          break;
+
+        case UnwindOp::AllocLarge:
+          rsp += (opInfo == 0) ? (static_cast<uint64_t>(codes[i + 1]) * 8)
+                               : GetFarOperand(codes, i);
+          break;
+
+        case UnwindOp::AllocSmall:
+          rsp += (static_cast<uint64_t>(opInfo) * 8) + 8;
+          break;
+
+        case UnwindOp::SetFramePointer:
+          rsp = frame;
+          break;
+
+        case UnwindOp::SaveNonVolatile:
+        case UnwindOp::SaveNonVolatileFar:
+          offset = (op == UnwindOp::SaveNonVolatile)
+                       ? (static_cast<uint64_t>(codes[i + 1]) * 8)
+                       : GetFarOperand(codes, i);
+          if (!memory.ReadUInt64(frame + offset, registers.gpr[opInfo])) {
+            return FrameResult::MemoryNotReadable;
+          }
+          break;
+
+        case UnwindOp::SaveXmm128:
+        case UnwindOp::SaveXmm128Far:
+          // xmm registers are not needed to walk the stack
+          break;
+
+        case UnwindOp::PushMachineFrame:
+          // interrupt/exception frame: the optional error code, then rip, cs, eflags,
+          // rsp and ss were pushed
+          if (opInfo != 0) {
+            rsp += sizeof(uint64_t);
+          }
+          if (!memory.ReadUInt64(rsp, registers.rip) ||
+              !memory.ReadUInt64(rsp + 3 * sizeof(uint64_t), rsp)) {
+            return FrameResult::MemoryNotReadable;
+          }
+          isReturnAddressPopped = true;
+          break;
+
+        default:
+          return FrameResult::Failed;
+      }
+
+      i += slotsCount;
+    }
+
+    if ((flags & UnwindFlagChainInfo) == 0) {
+      return FrameResult::Unwound;
+    }
+
+    // the chained RUNTIME_FUNCTION follows the codes array (padded to an even count)
+    uint64_t chainAddress =
+        infoAddress + sizeof(header) + ((codesCount + 1) & ~1ull) * sizeof(uint16_t);
+    if (!_pUnwindTable->ReadImage(chainAddress, &function, sizeof(function))) {
+      return FrameResult::Failed;
+    }
+  }
+
+  return FrameResult::Failed;
+}
+
+bool StackUnwinder::ReadCodeByte(uint64_t address, uint8_t& value) {
+  return _pUnwindTable->ReadImage(address, &value, sizeof(value));
+}
+
+bool StackUnwinder::IsInEpilog(
+    uint64_t rip, uint64_t imageBase, const RUNTIME_FUNCTION& function
+) {
+  // x64 epilogs have a strict form: an optional "add rsp, imm" or
+  // "lea rsp, [frame register + disp]", pops of non volatile registers and then
+  // a ret or a jmp
+  // (https://learn.microsoft.com/cpp/build/prolog-and-epilog#epilog-code)
+  uint64_t pc = rip;
+  uint8_t bytes[3];
+  if (!_pUnwindTable->ReadImage(pc, bytes, sizeof(bytes))) {
+    return false;
+  }
+
+  if ((bytes[0] & 0xF8) == 0x48) {
+    if ((bytes[1] == 0x81) || (bytes[1] == 0x83)) {
+      // add rsp, imm32 / imm8
+      if ((bytes[0] != 0x48) || (bytes[2] != 0xC4)) {
+        return false;
+      }
+      pc += (bytes[1] == 0x81) ? 7 : 4;
+    } else if (bytes[1] == 0x8D) {
+      // lea rsp, [reg + disp8/disp32]: no REX.R/REX.X, rsp as destination, no SIB
+      uint8_t mod = bytes[2] >> 6;
+      if (((bytes[0] & 0x06) != 0) || (((bytes[2] >> 3) & 0x7) != 4) ||
+          ((bytes[2] & 0x7) == 4) || ((mod != 1) && (mod != 2))) {
+        return false;
+      }
+      pc += (mod == 1) ? 4 : 7;
+    }
+  }
+
+  uint64_t functionStart = imageBase + function.BeginAddress;
+  uint64_t functionEnd = imageBase + function.EndAddress;
+  for (int i = 0; i < MaxEpilogInstructions; i++) {
+    uint8_t opcode;
+    if (!ReadCodeByte(pc, opcode)) {
+      return false;
+    }
+
+    // skip the REX prefix of pop r8-r15
+    if ((opcode & 0xF0) == 0x40) {
+      pc++;
+      if (!ReadCodeByte(pc, opcode)) {
+        return false;
+      }
+    }
+
+    if ((opcode >= 0x58) && (opcode <= 0x5F)) {
+      // pop reg
+      pc++;
+      continue;
+    }
+
+    if ((opcode == 0xC3) || (opcode == 0xC2)) {
+      // ret / ret imm16
+      return true;
+    }
+
+    if (opcode == 0xF3) {
+      // rep ret
+      uint8_t next;
+      return ReadCodeByte(pc + 1, next) && (next == 0xC3);
+    }
+
+    if ((opcode == 0xE9) || (opcode == 0xEB)) {
+      int64_t displacement = 0;
+      if (opcode == 0xE9) {
+        int32_t disp32;
+        if (!_pUnwindTable->ReadImage(pc + 1, &disp32, sizeof(disp32))) {
+          return false;
+        }
+        displacement = disp32 + 5;
+      } else {
+        uint8_t disp8;
+        if (!ReadCodeByte(pc + 1, disp8)) {
+          return false;
+        }
+        displacement = static_cast<int8_t>(disp8) + 2;
+      }
+
+      // a jump in the function continues the epilog; outside, it is a tail call
+      uint64_t target = pc + displacement;
+      if ((target >= functionStart) && (target < functionEnd)) {
+        pc = target;
+        continue;
+      }
+      return true;
+    }
+
+    if (opcode == 0xFF) {
+      // jmp qword ptr [rip + disp32] tail call
+      uint8_t modrm;
+      return ReadCodeByte(pc + 1, modrm) && (modrm == 0x25);
+    }
+
+    return false;
+  }
+
+  return false;
+}
+
+StackUnwinder::FrameResult StackUnwinder::UnwindEpilog(
+    UnwindRegisters& registers,
+    const IStackMemory& memory,
+    uint64_t imageBase,
+    const RUNTIME_FUNCTION& function
+) {
+  // emulate the epilog instructions already validated by IsInEpilog
+  uint64_t& rsp = registers.gpr[UnwindRegisters::Rsp];
+  uint64_t functionStart = imageBase + function.BeginAddress;
+  uint64_t functionEnd = imageBase + function.EndAddress;
+
+  uint64_t pc = registers.rip;
+  for (int i = 0; i < MaxEpilogInstructions; i++) {
+    uint8_t rex = 0;
+    uint8_t opcode;
+    if (!ReadCodeByte(pc, opcode)) {
+      return FrameResult::Failed;
+    }
+    if ((opcode & 0xF0) == 0x40) {
+      rex = opcode & 0xF;
+      pc++;
+      if (!ReadCodeByte(pc, opcode)) {
+        return FrameResult::Failed;
+      }
+    }
+    size_t registerExtension = ((rex & 0x1) != 0) ? 8 : 0;
+
+    if ((opcode >= 0x58) && (opcode <= 0x5F)) {
+      // pop reg
+      size_t reg = (opcode - 0x58) + registerExtension;
+      if (!memory.ReadUInt64(rsp, registers.gpr[reg])) {
+        return FrameResult::MemoryNotReadable;
+      }
+      rsp += sizeof(uint64_t);
+      pc++;
+      continue;
+    }
+
+    switch (opcode) {
+      case 0x81: {
+        // add rsp, imm32
+        int32_t imm32;
+        if (!_pUnwindTable->ReadImage(pc + 2, &imm32, sizeof(imm32))) {
+          return FrameResult::Failed;
+        }
+        rsp += imm32;
+        pc += 6;
+        continue;
+      }
+
+      case 0x83: {
+        // add rsp, imm8
+        uint8_t imm8;
+        if (!ReadCodeByte(pc + 2, imm8)) {
+          return FrameResult::Failed;
+        }
+        rsp += static_cast<int8_t>(imm8);
+        pc += 3;
+        continue;
+      }
+
+      case 0x8D: {
+        // lea rsp, [reg + disp8/disp32]
+        uint8_t modrm;
+        if (!ReadCodeByte(pc + 1, modrm)) {
+          return FrameResult::Failed;
+        }
+        uint64_t base = registers.gpr[(modrm & 0x7) + registerExtension];
+        if ((modrm >> 6) == 1) {
+          uint8_t disp8;
+          if (!ReadCodeByte(pc + 2, disp8)) {
+            return FrameResult::Failed;
+          }
+          rsp = base + static_cast<int8_t>(disp8);
+          pc += 3;
+        } else {
+          int32_t disp32;
+          if (!_pUnwindTable->ReadImage(pc + 2, &disp32, sizeof(disp32))) {
+            return FrameResult::Failed;
+          }
+          rsp = base + disp32;
+          pc += 6;
+        }
+        continue;
+      }
+
+      case 0xE9:
+      case 0xEB: {
+        int64_t displacement = 0;
+        if (opcode == 0xE9) {
+          int32_t disp32;
+          if (!_pUnwindTable->ReadImage(pc + 1, &disp32, sizeof(disp32))) {
+            return FrameResult::Failed;
+          }
+          displacement = disp32 + 5;
+        } else {
+          uint8_t disp8;
+          if (!ReadCodeByte(pc + 1, disp8)) {
+            return FrameResult::Failed;
+          }
+          displacement = static_cast<int8_t>(disp8) + 2;
+        }
+
+        uint64_t target = pc + displacement;
+        if ((target >= functionStart) && (target < functionEnd)) {
+          pc = target;
+          continue;
+        }
+
+        // tail call: the stack is back to its state at the function entry
+        break;
+      }
+
+      case 0xC2:
+      case 0xC3:
+      case 0xF3:
+      case 0xFF:
+        // ret, ret imm16 (the callee pops the arguments), rep ret, indirect tail call
+        break;
+
+      default:
+        return FrameResult::Failed;
+    }
+
+    // pop the return address
+    if (!memory.ReadUInt64(rsp, registers.rip)) {
+      return FrameResult::MemoryNotReadable;
+    }
+    rsp += sizeof(uint64_t);
+
+    if (opcode == 0xC2) {
+      uint16_t imm16;
+      if (!_pUnwindTable->ReadImage(pc + 1, &imm16, sizeof(imm16))) {
+        return FrameResult::Failed;
+      }
+      rsp += imm16;
+    }
+    return FrameResult::Unwound;
+  }
+
+  return FrameResult::Failed;
+}
+
+bool StackUnwinder::IsValidStackPointer(
+    uint64_t pointer, uint64_t stackLimit, uint64_t stackBase
+) {
+  // must be 8-byte aligned
+  if ((pointer & 0x7) != 0) {
+    return false;
+  }
+
+  // stack limits are not always known (stack grows downwards: limit <= base)
+  if (((stackLimit != 0) || (stackBase != 0)) &&
+      ((pointer < stackLimit) || (stackBase <= pointer))) {
+    return false;
+  }
+
+  return true;
+}
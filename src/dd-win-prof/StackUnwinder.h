@@ -0,0 +1,169 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <cstdint>
+
+#include "UnwindInfoCache.h"
+#include "pch.h"
+
+// Read access to the stack of the sampled thread (e.g. a copy taken while it was
+// suspended). Addresses are the ones seen by the thread.
+class IStackMemory {
+ public:
+  virtual ~IStackMemory() = default;
+  virtual bool ReadUInt64(uint64_t address, uint64_t& value) const = 0;
+};
+
+// Access to the x64 unwind data (.pdata/.xdata) and code of the loaded images
+class IUnwindTable {
+ public:
+  virtual ~IUnwindTable() = default;
+
+  // Return false if no function with unwind data contains rip (leaf function)
+  virtual bool LookupFunctionEntry(
+      uint64_t rip, uint64_t& imageBase, RUNTIME_FUNCTION& entry
+  ) = 0;
+
+  // Copy bytes of an image: unwind info or instructions (for epilog detection)
+  virtual bool ReadImage(uint64_t address, void* pBuffer, size_t size) = 0;
+};
+
+// Unwind table of the images loaded in the current process
+class ImageUnwindTable : public IUnwindTable {
+ public:
+  // the lookups are cached if a cache is provided
+  explicit ImageUnwindTable(UnwindInfoCache* pCache = nullptr);
+
+  bool LookupFunctionEntry(
+      uint64_t rip, uint64_t& imageBase, RUNTIME_FUNCTION& entry
+  ) override;
+  bool ReadImage(uint64_t address, void* pBuffer, size_t size) override;
+
+ private:
+  static bool LookupImageFunctionEntry(
+      uint64_t rip, uint64_t& imageBase, RUNTIME_FUNCTION& entry
+  );
+
+ private:
+  UnwindInfoCache* _pCache;
+};
+
+// Memory of a suspended thread, read in place
+class InPlaceStackMemory : public IStackMemory {
+ public:
+  bool ReadUInt64(uint64_t address, uint64_t& value) const override;
+};
+
+// How the caller of each frame is found
+enum class UnwindStrategy : uint8_t {
+  // .pdata/.xdata unwind data, like RtlVirtualUnwind: one function table lookup per
+  // frame
+  UnwindTables,
+
+  // Follow the rbp chain ([rbp] = caller rbp, [rbp + 8] = return address) without
+  // any lookup and fall back to the unwind data for the frames where the chain looks
+  // broken. Only accurate for modules built with frame pointers
+  // (push rbp; mov rbp, rsp): a function that does not maintain the chain is skipped
+  FramePointers,
+};
+
+// x64 unwind operation codes
+// (https://learn.microsoft.com/cpp/build/exception-handling-x64#unwind-operation-code)
+enum class UnwindOp : uint8_t {
+  PushNonVolatile = 0,
+  AllocLarge = 1,
+  AllocSmall = 2,
+  SetFramePointer = 3,
+  SaveNonVolatile = 4,
+  SaveNonVolatileFar = 5,
+  Epilog = 6,  // version 2 only
+  SpareCode = 7,
+  SaveXmm128 = 8,
+  SaveXmm128Far = 9,
+  PushMachineFrame = 10,
+};
+
+// Integer registers needed to unwind, indexed by their x64 encoding
+// (rax = 0, rcx, rdx, rbx, rsp = 4, rbp = 5, rsi, rdi, r8 ... r15)
+struct UnwindRegisters {
+  static constexpr size_t RegistersCount = 16;
+  static constexpr size_t Rsp = 4;
+  static constexpr size_t Rbp = 5;
+
+  uint64_t rip = 0;
+  uint64_t gpr[RegistersCount] = {};
+
+  static UnwindRegisters FromContext(const CONTEXT& context);
+};
+
+// Walk the stack the way RtlVirtualUnwind does but without touching the memory of
+// the thread: the stack is only read through IStackMemory and the unwind data through
+// IUnwindTable. This allows unwinding from a copy of the stack, after the thread has
+// been resumed, and testing the unwinder against synthetic stacks.
+class StackUnwinder {
+ public:
+  explicit StackUnwinder(
+      IUnwindTable* pUnwindTable, UnwindStrategy strategy = UnwindStrategy::UnwindTables
+  );
+
+  UnwindStrategy GetStrategy() const { return _strategy; }
+  void SetStrategy(UnwindStrategy strategy) { _strategy = strategy; }
+
+  // Same contract as StackFrameCollector::CaptureStack: framesCount is the size of
+  // pFrames on input and the number of frames on output. The registers are MUTATED.
+  // A stack that goes beyond the readable memory is returned as truncated.
+  bool Unwind(
+      UnwindRegisters& registers,
+      const IStackMemory& memory,
+      uint64_t stackLimit,
+      uint64_t stackBase,
+      uint64_t* pFrames,
+      uint16_t& framesCount,
+      bool& isTruncated
+  );
+
+  // 8-byte aligned and, if the boundaries are known, in [stackLimit, stackBase)
+  static bool IsValidStackPointer(
+      uint64_t pointer, uint64_t stackLimit, uint64_t stackBase
+  );
+
+ private:
+  enum class FrameResult { Unwound, MemoryNotReadable, Failed };
+
+  bool TryUnwindFramePointer(
+      UnwindRegisters& registers,
+      const IStackMemory& memory,
+      uint64_t stackLimit,
+      uint64_t stackBase
+  );
+  FrameResult UnwindFrame(
+      UnwindRegisters& registers, const IStackMemory& memory, uint64_t& establisherFrame
+  );
+  FrameResult ApplyUnwindCodes(
+      UnwindRegisters& registers,
+      const IStackMemory& memory,
+      uint64_t imageBase,
+      const RUNTIME_FUNCTION& entry,
+      bool& isReturnAddressPopped,
+      uint64_t& establisherFrame
+  );
+  bool IsInEpilog(uint64_t rip, uint64_t imageBase, const RUNTIME_FUNCTION& function);
+  FrameResult UnwindEpilog(
+      UnwindRegisters& registers,
+      const IStackMemory& memory,
+      uint64_t imageBase,
+      const RUNTIME_FUNCTION& function
+  );
+  bool ReadCodeByte(uint64_t address, uint8_t& value);
+
+ private:
+  // guard against corrupted unwind data
+  static constexpr int MaxChainedEntries = 32;
+  static constexpr int MaxEpilogInstructions = 32;
+
+  IUnwindTable* _pUnwindTable;
+  UnwindStrategy _strategy;
+};
@@ -0,0 +1,108 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "SuspensionWatchdog.h"
+
+#include "OpSysTools.h"
+#include "pch.h"
+
+namespace {
+int64_t GetNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()
+  )
+      .count();
+}
+}  // namespace
+
+SuspensionWatchdog::SuspensionWatchdog(
+    IThreadControl* pThreadControl, std::chrono::milliseconds deadline
+)
+    : _pThreadControl(pThreadControl),
+      _deadline(deadline),
+      _state(Idle),
+      _hSuspendedThread(nullptr),
+      _suspensionStartNs(0) {}
+
+SuspensionWatchdog::~SuspensionWatchdog() { Stop(); }
+
+void SuspensionWatchdog::Start() {
+  if (_watchdogThread.joinable()) {
+    return;
+  }
+
+  _watchdogThread = std::thread([this] {
+    OpSysTools::SetNativeThreadName(WatchdogThreadName);
+    WatchdogLoop();
+  });
+}
+
+void SuspensionWatchdog::Stop() {
+  if (!_watchdogThread.joinable()) {
+    return;
+  }
+
+  _watchdogThreadPromise.set_value();
+  _watchdogThread.join();
+}
+
+void SuspensionWatchdog::WatchdogLoop() {
+  // checking twice per deadline bounds a suspension to 1.5 deadline
+  auto period = (std::max)(_deadline / 2, std::chrono::milliseconds(1));
+  const auto future = _watchdogThreadPromise.get_future();
+  while (future.wait_for(period) == std::future_status::timeout) {
+    CheckSuspension();
+  }
+}
+
+void SuspensionWatchdog::OnThreadSuspended(HANDLE hThread) {
+  // only the sampler thread changes the state out of ForceResumed/Idle
+  uint64_t state = _state.load();
+  uint64_t sequence = (state & ~StatusMask) + SequenceIncrement;
+
+  // published by the state store below
+  _hSuspendedThread.store(hThread, std::memory_order_relaxed);
+  _suspensionStartNs.store(GetNowNs(), std::memory_order_relaxed);
+  _state.store(sequence | Suspended);
+}
+
+bool SuspensionWatchdog::ResumeThread() {
+  uint64_t state = _state.load();
+  uint64_t sequence = state & ~StatusMask;
+  if (((state & StatusMask) == Suspended) &&
+      _state.compare_exchange_strong(state, sequence | Idle)) {
+    _pThreadControl->ResumeThread(_hSuspendedThread.load(std::memory_order_relaxed));
+    return true;
+  }
+
+  // the watchdog won the race: the thread is already running
+  auto stallDuration = std::chrono::nanoseconds(
+      GetNowNs() - _suspensionStartNs.load(std::memory_order_relaxed)
+  );
+  _stallsHistogram.Record(stallDuration);
+  _state.store(sequence | Idle);
+  return false;
+}
+
+bool SuspensionWatchdog::CheckSuspension() {
+  uint64_t state = _state.load();
+  if ((state & StatusMask) != Suspended) {
+    return false;
+  }
+
+  // these values might belong to a newer suspension: the CAS would then fail
+  HANDLE hThread = _hSuspendedThread.load(std::memory_order_relaxed);
+  auto suspensionStartNs = _suspensionStartNs.load(std::memory_order_relaxed);
+  if (std::chrono::nanoseconds(GetNowNs() - suspensionStartNs) < _deadline) {
+    return false;
+  }
+
+  uint64_t sequence = state & ~StatusMask;
+  if (!_state.compare_exchange_strong(state, sequence | ForceResumed)) {
+    return false;
+  }
+
+  _pThreadControl->ResumeThread(hThread);
+  return true;
+}
@@ -0,0 +1,89 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+#include "DurationHistogram.h"
+#include "pch.h"
+
+// Resume a suspended thread (replaced by a fake in the tests)
+class IThreadControl {
+ public:
+  virtual ~IThreadControl() = default;
+  virtual void ResumeThread(HANDLE hThread) = 0;
+};
+
+class OsThreadControl : public IThreadControl {
+ public:
+  void ResumeThread(HANDLE hThread) override { ::ResumeThread(hThread); }
+};
+
+// While a thread is suspended, the sampler might wait for a lock owned by this thread
+// (e.g. the loader lock taken by RtlLookupFunctionEntry): both would be stuck
+// forever. The watchdog thread resumes the target when the sampler keeps it suspended
+// longer than a deadline; the sampler then ignores the stack it was walking.
+//
+// The suspension state is a single atomic word (sequence number + status) so that
+// exactly one of the sampler or the watchdog resumes the thread: the one that
+// succeeds to change the status of the current suspension.
+class SuspensionWatchdog {
+ public:
+  SuspensionWatchdog(
+      IThreadControl* pThreadControl, std::chrono::milliseconds deadline
+  );
+  ~SuspensionWatchdog();
+
+  SuspensionWatchdog(const SuspensionWatchdog&) = delete;
+  SuspensionWatchdog& operator=(const SuspensionWatchdog&) = delete;
+
+  void Start();
+  void Stop();
+
+  // Sampler thread: the thread has just been suspended...
+  void OnThreadSuspended(HANDLE hThread);
+
+  // ...and must be resumed. Return false if the watchdog already resumed it: the
+  // stack walk was stuck and its result must be ignored
+  bool ResumeThread();
+
+  // Watchdog thread: resume the thread if its suspension is past the deadline.
+  // Return true if it was resumed.
+  bool CheckSuspension();
+
+  // how long the stuck stack walks lasted (the count is the number of stalls)
+  DurationHistogram* GetStallsHistogram() { return &_stallsHistogram; }
+  std::chrono::milliseconds GetDeadline() const { return _deadline; }
+
+ private:
+  enum Status : uint64_t {
+    Idle = 0,
+    Suspended = 1,
+    ForceResumed = 2,
+  };
+  static constexpr uint64_t StatusMask = 0x3;
+  static constexpr uint64_t SequenceIncrement = 0x4;
+
+  void WatchdogLoop();
+
+ private:
+  const WCHAR* WatchdogThreadName = L"DD_watchdog";
+
+  IThreadControl* _pThreadControl;
+  const std::chrono::milliseconds _deadline;
+
+  // sequence << 2 | status
+  std::atomic<uint64_t> _state;
+  std::atomic<HANDLE> _hSuspendedThread;
+  std::atomic<int64_t> _suspensionStartNs;
+
+  DurationHistogram _stallsHistogram;
+
+  std::thread _watchdogThread;
+  std::promise<void> _watchdogThreadPromise;
+};
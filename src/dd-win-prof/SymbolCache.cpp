@@ -0,0 +1,123 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "SymbolCache.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "pch.h"
+
+SymbolCache::SymbolCache(size_t capacity)
+    : _capacity(capacity),
+      _hand(0),
+      _hitsCount(0),
+      _missesCount(0),
+      _evictionsCount(0) {}
+
+const CachedSymbolInfo* SymbolCache::Find(uint64_t address, uint32_t exportId) {
+  auto it = _slots.find(address);
+  if (it == _slots.end()) {
+    _missesCount++;
+    return nullptr;
+  }
+
+  _hitsCount++;
+  auto& entry = _entries[it->second];
+  entry.isReferenced = true;
+  entry.lastUsedExportId = exportId;
+  return &entry.symbol;
+}
+
+void SymbolCache::Insert(
+    uint64_t address, const CachedSymbolInfo& symbol, uint32_t exportId
+) {
+  if ((_capacity == 0) || (_entries.size() < _capacity)) {
+    // grow as needed but never beyond the capacity
+    if ((_capacity != 0) && (_entries.size() == _entries.capacity())) {
+      _entries.reserve(std::min(_capacity, std::max<size_t>(64, _entries.size() * 2)));
+    }
+
+    _slots[address] = static_cast<uint32_t>(_entries.size());
+    _entries.push_back(Entry{address, exportId, false, symbol});
+    return;
+  }
+
+  auto slot = FindVictim();
+  auto& entry = _entries[slot];
+  _slots.erase(entry.address);
+  _evictionsCount++;
+
+  entry = Entry{address, exportId, false, symbol};
+  _slots[address] = static_cast<uint32_t>(slot);
+}
+
+size_t SymbolCache::FindVictim() {
+  // at most one full turn: all the reference bits are cleared during the first one
+  while (true) {
+    auto slot = _hand;
+    _hand = (_hand + 1) % _entries.size();
+
+    auto& entry = _entries[slot];
+    if (!entry.isReferenced) {
+      return slot;
+    }
+    entry.isReferenced = false;
+  }
+}
+
+size_t SymbolCache::EvictUnused(uint32_t currentExportId, uint32_t maxAge) {
+  size_t evictedCount = 0;
+  size_t slot = 0;
+  while (slot < _entries.size()) {
+    // the export ids might wrap around
+    if (currentExportId - _entries[slot].lastUsedExportId > maxAge) {
+      RemoveAt(slot);
+      evictedCount++;
+    } else {
+      slot++;
+    }
+  }
+
+  if (_hand >= _entries.size()) {
+    _hand = 0;
+  }
+  _evictionsCount += evictedCount;
+  return evictedCount;
+}
+
+void SymbolCache::RemoveAt(size_t slot) {
+  // the last entry takes the free slot
+  _slots.erase(_entries[slot].address);
+  if (slot != _entries.size() - 1) {
+    _entries[slot] = _entries.back();
+    _slots[_entries[slot].address] = static_cast<uint32_t>(slot);
+  }
+  _entries.pop_back();
+}
+
+void SymbolCache::Clear() {
+  _entries.clear();
+  _slots.clear();
+  _hand = 0;
+  _hitsCount = 0;
+  _missesCount = 0;
+  _evictionsCount = 0;
+}
+
+size_t SymbolCache::GetMemorySize() const {
+  // the nodes of the index are estimated with their next pointer and cached hash
+  using SlotNode = std::pair<const uint64_t, uint32_t>;
+  return _entries.capacity() * sizeof(Entry) +
+         _slots.size() * (sizeof(SlotNode) + 2 * sizeof(void*)) +
+         _slots.bucket_count() * sizeof(void*);
+}
+
+std::string SymbolCache::ToJson() const {
+  std::ostringstream ss;
+  ss << "{\"size\":" << GetSize() << ",\"capacity\":" << _capacity
+     << ",\"hits\":" << _hitsCount << ",\"misses\":" << _missesCount
+     << ",\"evictions\":" << _evictionsCount << "}";
+  return ss.str();
+}
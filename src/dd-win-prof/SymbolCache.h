@@ -0,0 +1,81 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Symbolication.h"
+#include "pch.h"
+
+// Symbols of the addresses already resolved, kept across exports
+// (DD_PROFILING_SYMBOL_CACHE_SIZE entries at most).
+//
+// When full, an entry is evicted with the CLOCK algorithm: the hand sweeps the slots
+// and evicts the first entry that was not used since the previous sweep, giving the
+// used ones a second chance. New entries are not marked as used so the addresses seen
+// only once (e.g. JIT-compiled code executed once) are evicted first, while the hot
+// ones stay whatever the number of cold addresses.
+//
+// Each entry also remembers the last export that used it so the entries of unloaded
+// modules or collected JIT code can be evicted even if the cache is not full.
+//
+// Not thread-safe: only used on the export path.
+class SymbolCache {
+ public:
+  // 0 means unlimited
+  explicit SymbolCache(size_t capacity);
+
+  SymbolCache(const SymbolCache&) = delete;
+  SymbolCache& operator=(const SymbolCache&) = delete;
+
+  // Return the symbol of the address (nullptr if unknown); the pointer is only valid
+  // until the next insertion
+  const CachedSymbolInfo* Find(uint64_t address, uint32_t exportId);
+
+  // The address must not be in the cache
+  void Insert(uint64_t address, const CachedSymbolInfo& symbol, uint32_t exportId);
+
+  // Evict the entries not used during the last maxAge exports; return the number of
+  // evicted entries
+  size_t EvictUnused(uint32_t currentExportId, uint32_t maxAge);
+
+  void Clear();
+
+  inline size_t GetSize() const { return _entries.size(); }
+  inline size_t GetCapacity() const { return _capacity; }
+  size_t GetMemorySize() const;
+  inline uint64_t GetHitsCount() const { return _hitsCount; }
+  inline uint64_t GetMissesCount() const { return _missesCount; }
+  inline uint64_t GetEvictionsCount() const { return _evictionsCount; }
+
+  // e.g. {"size":1024,"capacity":65536,"hits":10000,"misses":1024,"evictions":0}
+  std::string ToJson() const;
+
+ private:
+  struct Entry {
+    uint64_t address;
+    uint32_t lastUsedExportId;
+    bool isReferenced;  // used since the last pass of the hand
+    CachedSymbolInfo symbol;
+  };
+
+  size_t FindVictim();
+  void RemoveAt(size_t slot);
+
+ private:
+  const size_t _capacity;
+
+  // slots swept by the hand and index of the slot of each address
+  std::vector<Entry> _entries;
+  std::unordered_map<uint64_t, uint32_t> _slots;
+  size_t _hand;
+
+  uint64_t _hitsCount;
+  uint64_t _missesCount;
+  uint64_t _evictionsCount;
+};
@@ -0,0 +1,98 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "SymbolRangeCache.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "pch.h"
+
+SymbolRangeCache::SymbolRangeCache(size_t capacity) : _capacity(capacity) {}
+
+const CachedSymbolInfo* SymbolRangeCache::Find(uint64_t address, uint32_t exportId) {
+  // last range starting at or before the address
+  auto it = std::upper_bound(
+      _ranges.begin(),
+      _ranges.end(),
+      address,
+      [](uint64_t value, const Range& range) { return value < range.start; }
+  );
+  if ((it == _ranges.begin()) || (address >= std::prev(it)->end)) {
+    _missesCount++;
+    return nullptr;
+  }
+
+  _hitsCount++;
+  auto& range = *std::prev(it);
+  range.lastUsedExportId = exportId;
+  return &range.symbol;
+}
+
+void SymbolRangeCache::Insert(
+    uint64_t start, uint64_t end, const CachedSymbolInfo& symbol, uint32_t exportId
+) {
+  if (start >= end) {
+    return;
+  }
+
+  // The evictions are batched to keep the insertions amortized O(n): the ranges used
+  // during the current export are the hot ones and are kept.
+  if ((_capacity != 0) && (_ranges.size() >= _capacity)) {
+    EvictUnused(exportId, 0);
+    if (_ranges.size() >= _capacity) {
+      return;
+    }
+  }
+
+  // the ranges don't overlap so they are also sorted by end address: the overlapping
+  // ones are contiguous
+  auto first = std::upper_bound(
+      _ranges.begin(),
+      _ranges.end(),
+      start,
+      [](uint64_t value, const Range& range) { return value < range.end; }
+  );
+  auto last = std::lower_bound(
+      first,
+      _ranges.end(),
+      end,
+      [](const Range& range, uint64_t value) { return range.start < value; }
+  );
+
+  auto it = _ranges.erase(first, last);
+  _ranges.insert(it, Range{start, end, exportId, symbol});
+}
+
+size_t SymbolRangeCache::EvictUnused(uint32_t currentExportId, uint32_t maxAge) {
+  // keep the ranges sorted
+  auto it = std::remove_if(
+      _ranges.begin(),
+      _ranges.end(),
+      [currentExportId, maxAge](const Range& range) {
+        // the export ids might wrap around
+        return currentExportId - range.lastUsedExportId > maxAge;
+      }
+  );
+  auto evictedCount = static_cast<size_t>(std::distance(it, _ranges.end()));
+  _ranges.erase(it, _ranges.end());
+
+  _evictionsCount += evictedCount;
+  return evictedCount;
+}
+
+void SymbolRangeCache::Clear() {
+  _ranges.clear();
+  _hitsCount = 0;
+  _missesCount = 0;
+  _evictionsCount = 0;
+}
+
+std::string SymbolRangeCache::ToJson() const {
+  std::ostringstream ss;
+  ss << "{\"size\":" << GetSize() << ",\"capacity\":" << _capacity
+     << ",\"hits\":" << _hitsCount << ",\"misses\":" << _missesCount
+     << ",\"evictions\":" << _evictionsCount << "}";
+  return ss.str();
+}
@@ -0,0 +1,76 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Symbolication.h"
+#include "pch.h"
+
+// Symbols of the [start, end) address ranges already resolved by DbgHelp: a function
+// when the callstacks are symbolized, a module otherwise. The addresses of the same
+// range share the same symbol (except the line number), so DbgHelp is only called for
+// the first address of each range.
+//
+// The ranges are kept sorted by start address in a dense array searched by binary
+// search: a lookup touches log2(n) entries without any allocation, and insertions only
+// happen on misses (i.e. rarely once the hot functions are known).
+//
+// Like SymbolCache, it is bounded (DD_PROFILING_SYMBOL_CACHE_SIZE ranges at most) and
+// each range remembers the last export that used it: when full, the ranges not used
+// during the current export are evicted to make room, and the ranges of code that is
+// not executed anymore are evicted by EvictUnused even if the cache is not full.
+//
+// Not thread-safe: only used on the export path.
+class SymbolRangeCache {
+ public:
+  // 0 means unlimited
+  explicit SymbolRangeCache(size_t capacity);
+
+  // Return the symbol of the range containing the address (nullptr if unknown); the
+  // pointer is only valid until the next insertion
+  const CachedSymbolInfo* Find(uint64_t address, uint32_t exportId);
+
+  // The ranges overlapping the new one are replaced (e.g. a module unloaded and another
+  // one loaded at the same address). Empty ranges are ignored, as well as new ranges
+  // when all the ranges were used during the current export.
+  void Insert(
+      uint64_t start, uint64_t end, const CachedSymbolInfo& symbol, uint32_t exportId
+  );
+
+  // Evict the ranges not used during the last maxAge exports; return the number of
+  // evicted ranges
+  size_t EvictUnused(uint32_t currentExportId, uint32_t maxAge);
+
+  void Clear();
+
+  inline size_t GetSize() const { return _ranges.size(); }
+  inline size_t GetCapacity() const { return _capacity; }
+  inline size_t GetMemorySize() const { return _ranges.capacity() * sizeof(Range); }
+  inline uint64_t GetHitsCount() const { return _hitsCount; }
+  inline uint64_t GetMissesCount() const { return _missesCount; }
+  inline uint64_t GetEvictionsCount() const { return _evictionsCount; }
+
+  // e.g. {"size":512,"capacity":65536,"hits":10000,"misses":512,"evictions":0}
+  std::string ToJson() const;
+
+ private:
+  struct Range {
+    uint64_t start;
+    uint64_t end;
+    uint32_t lastUsedExportId;
+    CachedSymbolInfo symbol;
+  };
+
+ private:
+  const size_t _capacity;
+
+  std::vector<Range> _ranges;
+  uint64_t _hitsCount = 0;
+  uint64_t _missesCount = 0;
+  uint64_t _evictionsCount = 0;
+};
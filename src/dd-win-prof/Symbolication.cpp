@@ -92,6 +92,8 @@ std::optional<CachedSymbolInfo> Symbolication::SymbolicateAndIntern(
       result.BuildIdId = cachedModule.BuildIdId;
       result.ModuleBaseAddress = cachedModule.ModuleBaseAddress;
       result.ModuleSize = cachedModule.ModuleSize;
+      result.rangeStart = cachedModule.ModuleBaseAddress;
+      result.rangeEnd = cachedModule.ModuleBaseAddress + cachedModule.ModuleSize;
 
       if (result.ModuleBaseAddress != 0 && result.ModuleSize != 0) {
         if (address < result.ModuleBaseAddress ||
@@ -136,6 +138,10 @@ std::optional<CachedSymbolInfo> Symbolication::SymbolicateAndIntern(
     result.FunctionNameId = functionNameResult.ok;
     result.displacement = static_cast<uint64_t>(displacement64);
 
+    // the size is unknown for the symbols coming from the exports table
+    result.rangeStart = pSymbol->Address;
+    result.rangeEnd = (pSymbol->Size != 0) ? pSymbol->Address + pSymbol->Size : 0;
+
     // Try to get line information
     IMAGEHLP_LINE64 line = {0};
     line.SizeOfStruct = sizeof(IMAGEHLP_LINE64);
@@ -156,12 +162,39 @@ std::optional<CachedSymbolInfo> Symbolication::SymbolicateAndIntern(
     // SymFromAddr failed - address not found, return unknown symbol
     // Note: module info was already populated above if available
     result.FunctionNameId = _emptyStringId;
+
+    // the other addresses of the module might be known
+    result.rangeStart = 0;
+    result.rangeEnd = 0;
   }
 
   result.isValid = true;
   return result;
 }
 
+CachedSymbolInfo Symbolication::SymbolicateInRange(
+    uint64_t address, const CachedSymbolInfo& rangeSymbol
+) {
+  // same module (and function if symbolized)
+  CachedSymbolInfo result = rangeSymbol;
+  result.displacement = 0;
+  result.lineNumber = 0;
+  if (!_isInitialized || !_symbolizeFrames) {
+    return result;
+  }
+
+  result.displacement = address - rangeSymbol.rangeStart;
+
+  IMAGEHLP_LINE64 line = {0};
+  line.SizeOfStruct = sizeof(IMAGEHLP_LINE64);
+  DWORD displacement32 = 0;
+  if (SymGetLineFromAddr64(GetCurrentProcess(), address, &displacement32, &line)) {
+    result.lineNumber = line.LineNumber;
+  }
+
+  return result;
+}
+
 bool Symbolication::RefreshModules() {
   if (!_isInitialized) return false;
 
@@ -29,6 +29,10 @@ struct CachedSymbolInfo {
   uint32_t ModuleSize;                       // Module size in bytes (for mapping)
   uint64_t displacement;
   uint32_t lineNumber;
+  // addresses sharing this symbol but the line number (see SymbolRangeCache): the
+  // function if symbolized, the module otherwise; empty if unknown
+  uint64_t rangeStart;
+  uint64_t rangeEnd;
   bool isValid;
 
   CachedSymbolInfo()
@@ -40,6 +44,8 @@ struct CachedSymbolInfo {
         ModuleSize(0),
         displacement(0),
         lineNumber(0),
+        rangeStart(0),
+        rangeEnd(0),
         isValid(false) {}
 };
 
@@ -74,6 +80,12 @@ class Symbolication {
       uint64_t address, ddog_prof_ManagedStringStorage& stringStorage
   );
 
+  // Symbol of an address in the range of a known symbol (see SymbolRangeCache): only
+  // the line number and the displacement are looked up, if the frames are symbolized
+  CachedSymbolInfo SymbolicateInRange(
+      uint64_t address, const CachedSymbolInfo& rangeSymbol
+  );
+
   // Check if symbolication is initialized
   bool IsInitialized() const { return _isInitialized; }
 
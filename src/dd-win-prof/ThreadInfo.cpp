@@ -4,13 +4,34 @@
 
 #include "ThreadInfo.h"
 
+#include <functional>
+
 #include "pch.h"
 
 ThreadInfo::ThreadInfo(uint32_t tid, HANDLE hThread)
     : _tid(tid),
       _hThread(ScopedHandle(hThread)),
+      _registrationTimestamp{OpSysTools::GetHighPrecisionTimestamp()},
       _lastWalltimeSampleTimestamp{0ns},
-      _lastWaitSampleTimestamp{0ns},  // the first time a thread is seen as waiting, the
-                                      // sampling period is accounted as wait time
       _cpuConsumption{0ms},
-      _timestamp{0ns} {}
+      _timestamp{0ns},
+      _threadNameGroupKey{ComputeThreadNameGroupKey({})} {}
+
+std::string_view ThreadInfo::GetThreadNameGroup(std::string_view name) {
+  auto isPoolSuffix = [](char c) {
+    return ((c >= '0') && (c <= '9')) || (c == ' ') || (c == '-') || (c == '_') ||
+           (c == '#') || (c == '.') || (c == ':');
+  };
+
+  size_t length = name.size();
+  while ((length > 0) && isPoolSuffix(name[length - 1])) {
+    length--;
+  }
+
+  // a name made only of digits is its own group
+  return (length > 0) ? name.substr(0, length) : name;
+}
+
+uint64_t ThreadInfo::ComputeThreadNameGroupKey(std::string_view name) {
+  return std::hash<std::string_view>{}(GetThreadNameGroup(name)) | 1;
+}
@@ -4,8 +4,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <string_view>
+
+#include "CachedCallstack.h"
 #include "OpSysTools.h"
 #include "ScopedHandle.h"
+#include "TraceContext.h"
 #include "pch.h"
 
 // NOTE:
@@ -14,6 +19,12 @@ class ThreadInfo {
   ThreadInfo(uint32_t tid, HANDLE hThread);
 
   uint32_t GetThreadId() const { return _tid; }
+
+  // Set by ThreadList when the thread is registered: the slot index (low 32 bits) and
+  // the number of times this slot was used (high 32 bits). Two registrations of the
+  // same OS thread id never share the same generation.
+  inline uint64_t GetGeneration() const { return _generation; }
+  inline void SetGeneration(uint64_t generation) { _generation = generation; }
   inline HANDLE GetOsThreadHandle() const { return _hThread; }
 
   inline std::chrono::nanoseconds SetLastWalltimeSampleTimestamp(
@@ -24,6 +35,21 @@ class ThreadInfo {
     return prevValue;
   }
 
+  // Wall time represented by a sample of this thread taken now: the time elapsed
+  // since its previous sample, or since it was registered (but not before the
+  // sampling started) for the first one.
+  // When there are more threads than the walltime threshold, a thread is not sampled
+  // at each tick: weighting its samples by the inverse of its sampling rate keeps the
+  // totals equal to the real wall time, whatever the number of threads.
+  inline std::chrono::nanoseconds GetWalltimeSampleWeight(
+      std::chrono::nanoseconds now, std::chrono::nanoseconds samplingStart
+  ) const {
+    auto start = (_lastWalltimeSampleTimestamp != 0ns)
+                     ? _lastWalltimeSampleTimestamp
+                     : (std::max)(_registrationTimestamp, samplingStart);
+    return (std::max)(0ns, now - start);
+  }
+
   inline std::chrono::milliseconds GetCpuConsumption() const { return _cpuConsumption; }
 
   inline std::chrono::nanoseconds GetCpuTimestamp() const { return _timestamp; }
@@ -38,37 +64,72 @@ class ThreadInfo {
     return prevValue;
   }
 
-  inline std::chrono::nanoseconds SetLastWaitSampleTimestamp(
-      std::chrono::nanoseconds timestamp
-  ) {
-    auto prevValue = _lastWaitSampleTimestamp;
-    _lastWaitSampleTimestamp = timestamp;
-    return prevValue;
+  // After a stuck stack walk (see SuspensionWatchdog), the thread is not sampled for
+  // a while: the delay doubles with each consecutive stall
+  inline bool IsSamplingBackedOff(std::chrono::nanoseconds now) const {
+    return now < _samplingBackoffEnd;
   }
 
-  inline bool GetThreadName(std::string& name) {
-    if (_hasThreadName) {
-      name = _threadName;
-      return true;
-    }
+  inline void OnStuckStackWalk(std::chrono::nanoseconds now) {
+    std::chrono::nanoseconds backoff =
+        MinSamplingBackoff * (1 << (std::min)(_stuckStackWalksCount, 6u));
+    _samplingBackoffEnd = now + (std::min)(backoff, MaxSamplingBackoff);
+    _stuckStackWalksCount++;
+  }
+
+  inline void OnStackWalkCompleted() { _stuckStackWalksCount = 0; }
+
+  inline uint32_t GetStuckStackWalksCount() const { return _stuckStackWalksCount; }
 
-    if (OpSysTools::GetNativeThreadName(_hThread, _threadName)) {
-      _hasThreadName = true;
-      name = _threadName;
-      return true;
-    }
+  // Callstack reused while the thread stays parked in the same wait (sampler only)
+  inline CachedCallstack& GetCachedCallstack() { return _cachedCallstack; }
 
-    return false;
+  // Name shared by the threads of a pool: the thread name without its trailing number
+  // and separators ("Worker #12" -> "Worker")
+  static std::string_view GetThreadNameGroup(std::string_view name);
+
+  // Identifies the thread name group when folding the samples of waiting threads
+  // (never 0). Updated with the name by the thread names refresher.
+  inline uint64_t GetThreadNameGroupKey() const {
+    return _threadNameGroupKey.load(std::memory_order_relaxed);
   }
 
+  // the lowest bit is set so that unnamed threads also get a valid key
+  static uint64_t ComputeThreadNameGroupKey(std::string_view name);
+
+  // Current name of the thread, interned in the ThreadList names table (see
+  // ThreadList::RefreshThreadNames) so that it can be read without any syscall. The
+  // version is incremented each time the thread is renamed.
+  inline uint32_t GetThreadNameId() const {
+    return static_cast<uint32_t>(_threadName.load(std::memory_order_acquire));
+  }
+
+  inline uint32_t GetThreadNameVersion() const {
+    return static_cast<uint32_t>(_threadName.load(std::memory_order_acquire) >> 32);
+  }
+
+  // Thread names refresher only
+  inline void SetThreadName(uint32_t nameId, uint64_t groupKey) {
+    uint64_t version = GetThreadNameVersion() + 1;
+    _threadNameGroupKey.store(groupKey, std::memory_order_relaxed);
+    _threadName.store((version << 32) | nameId, std::memory_order_release);
+  }
+
+  // Span running on the thread, written by the thread itself (SetTraceContext API)
+  // and read by the sampler without lock
+  inline TraceContextSlot& GetTraceContextSlot() { return _traceContext; }
+
  private:
-  // we don't handle the case where a thread ID is reused by the OS after a thread has
-  // exited so only keep track of the OS thread ID
+  // the OS might reuse the thread ID after the thread has exited: the generation
+  // identifies this thread in samples and cached state
   uint32_t _tid;
+  uint64_t _generation = 0;
 
   ScopedHandle _hThread;
 
-  // will be used for walltime
+  std::chrono::nanoseconds _registrationTimestamp;
+
+  // timestamp of the last walltime sample
   std::chrono::nanoseconds _lastWalltimeSampleTimestamp;
 
   // last CPU consumption in milliseconds
@@ -77,13 +138,17 @@ class ThreadInfo {
   // timestamp of the last CPU consumption sample
   std::chrono::nanoseconds _timestamp;
 
-  // keep track of the last time this thread was seen as waiting
-  // --> should be reset to 0 when the thread is no more waiting
-  //     (i.e. CPU profiler and lock detection part of walltime profiler)
-  // since we don't have the start/ end time of the wait, we "jump" from wait to wait
-  std::chrono::nanoseconds _lastWaitSampleTimestamp;
+  // consecutive stuck stack walks and end of the current sampling backoff
+  static constexpr std::chrono::nanoseconds MinSamplingBackoff = 1s;
+  static constexpr std::chrono::nanoseconds MaxSamplingBackoff = 60s;
+  uint32_t _stuckStackWalksCount = 0;
+  std::chrono::nanoseconds _samplingBackoffEnd{0ns};
+
+  CachedCallstack _cachedCallstack;
+
+  // name id (low 32 bits) and version (high 32 bits); 0 until the name is known
+  std::atomic<uint64_t> _threadName{0};
+  std::atomic<uint64_t> _threadNameGroupKey;
 
-  // thread name, if available
-  bool _hasThreadName = false;
-  std::string _threadName;
+  TraceContextSlot _traceContext;
 };
@@ -4,52 +4,193 @@
 
 #include "ThreadList.h"
 
+#include <algorithm>
+#include <string>
+
+#include "Log.h"
 #include "pch.h"
 
-const std::uint32_t ThreadList::DefaultThreadListSize = 50;
+const std::uint32_t ThreadList::DefaultThreadListSize = 64;
+
+namespace {
+bool IsValidHandle(ThreadInfo* pThreadInfo) {
+  auto hThread = pThreadInfo->GetOsThreadHandle();
+  return (hThread != static_cast<HANDLE>(NULL)) && (hThread != INVALID_HANDLE_VALUE);
+}
+}  // namespace
+
+ThreadList::ReadGuard::ReadGuard(ThreadList& threadList) : _threadList(threadList) {
+  _threadList.EnterReader();
+}
+
+ThreadList::ReadGuard::~ReadGuard() { _threadList.LeaveReader(); }
+
+ThreadList::Slots::Slots(uint32_t capacity)
+    : capacity(capacity), threads(new std::atomic<ThreadInfo*>[capacity]) {
+  for (uint32_t i = 0; i < capacity; i++) {
+    threads[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
 
-ThreadList::ThreadList() { _threads.reserve(DefaultThreadListSize); }
+ThreadList::ThreadList()
+    : _pSlots(new Slots(DefaultThreadListSize)),
+      _slotsInUse(0),
+      _threadsCount(0),
+      _activeReadersCount(0),
+      _hasRetired(false) {
+  _owners.reserve(DefaultThreadListSize);
+  _generations.reserve(DefaultThreadListSize);
+  _slotByTid.reserve(DefaultThreadListSize);
+}
 
 ThreadList::~ThreadList() {
-  std::lock_guard<std::recursive_mutex> lock(_mutex);
+  std::lock_guard<std::mutex> lock(_writersMutex);
+
+  _retiredThreads.clear();
+  _retiredSlots.clear();
+  delete _pSlots.exchange(nullptr);
+}
+
+void ThreadList::EnterReader() {
+  // the slots must be read after this increment is visible to the writers
+  _activeReadersCount.fetch_add(1);
+}
+
+void ThreadList::LeaveReader() {
+  // the last reader destroys the retired threads, unless a writer is busy: it will
+  // do it
+  if ((_activeReadersCount.fetch_sub(1) == 1) && _hasRetired.load()) {
+    std::unique_lock<std::mutex> lock(_writersMutex, std::try_to_lock);
+    if (lock.owns_lock()) {
+      ReclaimRetired();
+    }
+  }
+}
+
+// must be called under _writersMutex
+void ThreadList::ReclaimRetired() {
+  // the retired threads and arrays are not reachable anymore: if there is no reader
+  // now, no reader can still be using them
+  if (_activeReadersCount.load() != 0) {
+    return;
+  }
+
+  _retiredThreads.clear();
+  _retiredSlots.clear();
+  _hasRetired = false;
+}
+
+// must be called under _writersMutex
+uint32_t ThreadList::AllocateSlot() {
+  if (!_freeSlots.empty()) {
+    uint32_t slot = _freeSlots.back();
+    _freeSlots.pop_back();
+    return slot;
+  }
+
+  uint32_t slot = static_cast<uint32_t>(_owners.size());
+  _owners.emplace_back();
+  _generations.push_back(0);
+
+  // double the array: the readers still using the current one keep it until they
+  // leave
+  auto pSlots = _pSlots.load();
+  if (slot == pSlots->capacity) {
+    auto pNewSlots = std::make_unique<Slots>(pSlots->capacity * 2);
+    for (uint32_t i = 0; i < pSlots->capacity; i++) {
+      pNewSlots->threads[i].store(
+          pSlots->threads[i].load(std::memory_order_relaxed), std::memory_order_relaxed
+      );
+    }
+    _pSlots.store(pNewSlots.release());
+    _retiredSlots.emplace_back(pSlots);
+    _hasRetired = true;
+  }
+
+  return slot;
+}
+
+// must be called under _writersMutex
+void ThreadList::FreeSlot(uint32_t slot) {
+  // sequentially consistent with the readers count: see ReclaimRetired()
+  _pSlots.load()->threads[slot].store(nullptr);
+  _retiredThreads.push_back(std::move(_owners[slot]));
+  _hasRetired = true;
+  _freeSlots.push_back(slot);
+  _threadsCount--;
 
-  _threads.clear();
+  // don't let the readers scan the free slots at the end
+  auto slotsInUse = _slotsInUse.load(std::memory_order_relaxed);
+  while ((slotsInUse > 0) && (_owners[slotsInUse - 1] == nullptr)) {
+    slotsInUse--;
+  }
+  _slotsInUse.store(slotsInUse, std::memory_order_release);
 }
 
 void ThreadList::AddThread(uint32_t tid, HANDLE hThread) {
-  std::lock_guard<std::recursive_mutex> lock(_mutex);
+  std::lock_guard<std::mutex> lock(_writersMutex);
+
+  // the detach of the previous thread with this id was missed
+  auto previous = _slotByTid.find(tid);
+  if (previous != _slotByTid.end()) {
+    FreeSlot(previous->second);
+    _slotByTid.erase(previous);
+  }
+
+  uint32_t slot = AllocateSlot();
+  auto pThreadInfo = std::make_shared<ThreadInfo>(tid, hThread);
+  pThreadInfo->SetGeneration(
+      (static_cast<uint64_t>(++_generations[slot]) << 32) | slot
+  );
 
-  // TODO: check if the thread ID already exists in the list but enough for this POC
+  // the thread must be initialized before being visible to the readers
+  _pSlots.load()->threads[slot].store(pThreadInfo.get(), std::memory_order_release);
+  _owners[slot] = std::move(pThreadInfo);
+  _slotByTid.emplace(tid, slot);
+  _threadsCount++;
+  if (slot >= _slotsInUse.load(std::memory_order_relaxed)) {
+    _slotsInUse.store(slot + 1, std::memory_order_release);
+  }
 
-  auto info = std::make_shared<ThreadInfo>(tid, hThread);
-  _threads.push_back(info);
+  ReclaimRetired();
 }
 
 void ThreadList::RemoveThread(uint32_t tid) {
-  std::lock_guard<std::recursive_mutex> lock(_mutex);
+  std::lock_guard<std::mutex> lock(_writersMutex);
 
-  uint32_t pos = 0;
-  for (auto i = _threads.begin(); i != _threads.end(); ++i) {
-    std::shared_ptr<ThreadInfo> pInfo = *i;  // make a copy so it can be moved later
-    if (pInfo->GetThreadId() == tid) {
-      // remove it from the storage
-      _threads.erase(i);
+  auto pos = _slotByTid.find(tid);
+  if (pos == _slotByTid.end()) {
+    return;
+  }
 
-      // iterators might need to be updated
-      UpdateIterators(pos);
+  FreeSlot(pos->second);
+  _slotByTid.erase(pos);
 
-      return;
-    }
-    pos++;
+  ReclaimRetired();
+}
+
+std::shared_ptr<ThreadInfo> ThreadList::FindThread(uint32_t tid) {
+  std::lock_guard<std::mutex> lock(_writersMutex);
+
+  auto pos = _slotByTid.find(tid);
+  if (pos == _slotByTid.end()) {
+    return nullptr;
   }
+
+  return _owners[pos->second];
 }
 
-size_t ThreadList::Count() {
-  std::lock_guard<std::recursive_mutex> lock(_mutex);
+std::shared_ptr<ThreadInfo> ThreadList::FindThread(uint32_t tid, uint64_t generation) {
+  auto pThreadInfo = FindThread(tid);
+  if ((pThreadInfo == nullptr) || (pThreadInfo->GetGeneration() != generation)) {
+    return nullptr;
+  }
 
-  return _threads.size();
+  return pThreadInfo;
 }
 
+size_t ThreadList::Count() { return _threadsCount.load(); }
+
 uint32_t ThreadList::CreateIterator() {
   uint32_t iterator = static_cast<uint32_t>(_iterators.size());
   _iterators.push_back(0);
@@ -57,87 +198,80 @@ uint32_t ThreadList::CreateIterator() {
 }
 
 std::shared_ptr<ThreadInfo> ThreadList::LoopNext(uint32_t iterator) {
-  std::lock_guard<std::recursive_mutex> lock(_mutex);
+  // no writer can free the slot before its owner is copied
+  std::lock_guard<std::mutex> lock(_writersMutex);
 
-  auto activeThreadCount = _threads.size();
-  if (activeThreadCount == 0) {
-    return nullptr;
-  }
+  uint32_t slot = 0;
+  return (LoopNextThread(iterator, slot) != nullptr) ? _owners[slot] : nullptr;
+}
+
+ThreadInfo* ThreadList::LoopNext(uint32_t iterator, const ReadGuard& guard) {
+  uint32_t slot = 0;
+  return LoopNextThread(iterator, slot);
+}
 
+// must be called by a reader or under _writersMutex
+ThreadInfo* ThreadList::LoopNextThread(uint32_t iterator, uint32_t& slot) {
   if (iterator >= _iterators.size()) {
     return nullptr;
   }
 
-  uint32_t pos = _iterators[iterator];
-  std::shared_ptr<ThreadInfo> pInfo = nullptr;
-
-  auto startPos = pos;
-  do {
-    pInfo = _threads[pos];
-    // move the iterator to the next thread and loop
-    // back to the first thread if the end is reached
-    pos = (pos + 1) % activeThreadCount;
-  } while (startPos != pos &&
-           (pInfo->GetOsThreadHandle() == static_cast<HANDLE>(NULL) ||
-            pInfo->GetOsThreadHandle() == INVALID_HANDLE_VALUE));
-
-  _iterators[iterator] = pos;
-
-  // Check if we actually found a valid thread.
-  // The loop exits when startPos == pos OR when we find a valid thread.
-  // If pInfo is invalid, it means we completed a full circle without finding
-  // any valid thread. If pInfo is valid, return it even if startPos == pos
-  // (which happens when the valid thread sits just before the start position).
-  if (pInfo->GetOsThreadHandle() == static_cast<HANDLE>(NULL) ||
-      pInfo->GetOsThreadHandle() == INVALID_HANDLE_VALUE) {
+  // _slotsInUse is updated after the array is grown: read it first
+  uint32_t slotsInUse = _slotsInUse.load(std::memory_order_acquire);
+  auto pSlots = _pSlots.load();
+  slotsInUse = (std::min)(slotsInUse, pSlots->capacity);
+  if (slotsInUse == 0) {
     return nullptr;
   }
 
-  return pInfo;
-}
-
-// NOTE: we know this is called only by one thread so no need to be thread-safe
-void ThreadList::UpdateIterators(uint32_t removalPos) {
-  // Iterators are positions (in the threads vector) pointing to the next thread to
-  // return via LoopNext. So, when a thread is removed from the vector at a position
-  // BEFORE an iterator position, this iterator needs to be moved left by 1 to keep on
-  // pointing to the same thread. There is no need to update iterators pointing to
-  // threads before or at the same spot as the removal position because they will point
-  // to the same thread
-  //
-  // In the following example, the thread at position 1 will be removed and an iterator
-  // is pointing to ^ the thread in the third position (i.e. at pos = 2).
-  //      x
-  //  T0  T1  T2  T3
-  //          ^ = 2
-  // -->          |
-  //  T0  T2  T3  v
-  //      ^ = 1 =(2 - 1)
-  //
-  // After the removal, this iterator should now point to the thread at position 1
-  // instead of 2
-  //
-  // If the new pos is beyond the vector (i.e. the last element was removed),
-  // then reset the iterator to the beginning of the vector:
-  //          x
-  //  T0  T1  T2  (_threads.size() == 2 when this function is called)
-  //          ^ = 2
-  // -->
-  //  T0  T1
-  //  ^ = 0  (reset)
-  //
-  for (auto i = _iterators.begin(); i != _iterators.end(); ++i) {
-    uint32_t pos = *i;
-    if (removalPos < pos) {
-      pos = pos - 1;
+  // skip the free slots and the threads without a valid handle; loop back to the
+  // first slot if the end is reached
+  uint32_t startSlot = (_iterators[iterator] < slotsInUse) ? _iterators[iterator] : 0;
+  for (uint32_t i = 0; i < slotsInUse; i++) {
+    slot = (startSlot + i) % slotsInUse;
+    auto pThreadInfo = pSlots->threads[slot].load();
+    if ((pThreadInfo != nullptr) && IsValidHandle(pThreadInfo)) {
+      // threads added at the end are returned before looping back
+      _iterators[iterator] = slot + 1;
+      return pThreadInfo;
     }
+  }
+
+  return nullptr;
+}
+
+size_t ThreadList::RefreshThreadNames() {
+  ReadGuard guard(*this);
 
-    // reset iterator if needed
-    if (pos >= _threads.size())  // the thread has already been removed from the vector
-    {
-      pos = 0;
+  uint32_t slotsInUse = _slotsInUse.load(std::memory_order_acquire);
+  auto pSlots = _pSlots.load();
+  slotsInUse = (std::min)(slotsInUse, pSlots->capacity);
+
+  std::string name;
+  size_t renamedCount = 0;
+  for (uint32_t slot = 0; slot < slotsInUse; slot++) {
+    auto pThreadInfo = pSlots->threads[slot].load();
+    if ((pThreadInfo == nullptr) || !IsValidHandle(pThreadInfo)) {
+      continue;
+    }
+
+    // no description (yet) or failure: keep the last known name
+    name.clear();
+    if (!OpSysTools::GetNativeThreadName(pThreadInfo->GetOsThreadHandle(), name)) {
+      continue;
     }
 
-    *i = pos;
+    uint32_t nameId = NameTable::UnnamedId;
+    if (!_threadNames.TryIntern(name, nameId)) {
+      LogOnce(Warn, "Too many thread names: the new names are not tracked");
+      continue;
+    }
+
+    if (nameId != pThreadInfo->GetThreadNameId()) {
+      pThreadInfo->SetThreadName(nameId, ThreadInfo::ComputeThreadNameGroupKey(name));
+      renamedCount++;
+    }
   }
+
+  return renamedCount;
 }
@@ -4,34 +4,113 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+#include "NameTable.h"
 #include "ThreadInfo.h"
 #include "pch.h"
 
+// Registry of the threads to sample, read without lock (RCU style):
+// - each thread gets a slot in an array of atomic pointers; the slots of the exited
+//   threads are reused. A tid -> slot index gives O(1) registration and removal.
+// - readers (the sampler) announce themselves with a ReadGuard (one atomic increment)
+//   and iterate the slots in round robin
+// - writers (DLL_THREAD_ATTACH/DETACH) are serialized and never wait for the readers:
+//   the removed ThreadInfo (and the arrays replaced when growing) are destroyed
+//   later, once no reader is active.
 class ThreadList {
+ public:
+  // While a guard is alive, the threads returned by LoopNext(iterator, guard) are
+  // not destroyed, even if they are removed from the list
+  class ReadGuard {
+   public:
+    explicit ReadGuard(ThreadList& threadList);
+    ~ReadGuard();
+
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+
+   private:
+    ThreadList& _threadList;
+  };
+
  public:
   ThreadList();
   ~ThreadList();
 
+  // If the thread id is already registered (its detach was missed and the OS reused
+  // the id), the previous thread is replaced
   void AddThread(uint32_t tid, HANDLE hThread);
   void RemoveThread(uint32_t tid);
 
-  // we can't use a lock in a const method so... don't make it const
+  // return nullptr if the thread is not (or no more) in the list
+  std::shared_ptr<ThreadInfo> FindThread(uint32_t tid);
+
+  // same but also nullptr if the thread id now belongs to another registration
+  std::shared_ptr<ThreadInfo> FindThread(uint32_t tid, uint64_t generation);
+
   size_t Count();
 
+  // Iterators belong to a single reader thread
   uint32_t CreateIterator();
   std::shared_ptr<ThreadInfo> LoopNext(uint32_t iterator);
 
+  // Same without reference counting: the thread is valid while the guard is alive
+  ThreadInfo* LoopNext(uint32_t iterator, const ReadGuard& guard);
+
+  // Read the name of each thread and publish the ones that changed (threads are often
+  // named after they start, and renamed when a pool reuses them). Called
+  // periodically by a single background thread so that the samplers and the exporter
+  // never call GetThreadDescription. Return the number of renamed threads.
+  size_t RefreshThreadNames();
+
+  // Name of ThreadInfo::GetThreadNameId(); valid as long as the list
+  inline std::string_view GetThreadName(uint32_t nameId) const {
+    return _threadNames.GetName(nameId);
+  }
+
  private:
-  void UpdateIterators(uint32_t pos);
+  struct Slots {
+    explicit Slots(uint32_t capacity);
+
+    const uint32_t capacity;
+    std::unique_ptr<std::atomic<ThreadInfo*>[]> threads;
+  };
+
+  void EnterReader();
+  void LeaveReader();
+  uint32_t AllocateSlot();
+  void FreeSlot(uint32_t slot);
+  void ReclaimRetired();
+  ThreadInfo* LoopNextThread(uint32_t iterator, uint32_t& slot);
 
  private:
   static const std::uint32_t DefaultThreadListSize;
 
-  std::recursive_mutex _mutex;
-  std::vector<std::shared_ptr<ThreadInfo>> _threads;
+  std::atomic<Slots*> _pSlots;
+  // slots after this one are all free
+  std::atomic<uint32_t> _slotsInUse;
+  std::atomic<size_t> _threadsCount;
+  std::atomic<uint32_t> _activeReadersCount;
+
+  // writers only (under _writersMutex): ownership of the threads of each slot, number
+  // of uses of each slot, free slots (reused LIFO) and tid -> slot index
+  std::mutex _writersMutex;
+  std::vector<std::shared_ptr<ThreadInfo>> _owners;
+  std::vector<uint32_t> _generations;
+  std::vector<uint32_t> _freeSlots;
+  std::unordered_map<uint32_t, uint32_t> _slotByTid;
+
+  // removed threads and replaced arrays, destroyed when no reader is active
+  std::vector<std::shared_ptr<ThreadInfo>> _retiredThreads;
+  std::vector<std::unique_ptr<Slots>> _retiredSlots;
+  std::atomic<bool> _hasRetired;
+
+  // names of the threads, interned by RefreshThreadNames
+  NameTable _threadNames;
 
-  // An iterator is just a position in the vector corresponding to the next thread to be
-  // returned by LoopNext so keep track of them in a vector of positions initialized to
-  // 0
+  // An iterator is the index of the slot to check first in the next LoopNext call
   std::vector<uint32_t> _iterators;
 };
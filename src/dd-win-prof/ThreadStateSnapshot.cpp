@@ -0,0 +1,179 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "ThreadStateSnapshot.h"
+
+#include "pch.h"
+
+namespace {
+constexpr ULONG SystemProcessInformation = 5;
+constexpr NTSTATUS StatusInfoLengthMismatch = static_cast<NTSTATUS>(0xC0000004L);
+
+// for a few hundreds of processes; grows if needed
+constexpr size_t InitialBufferSize = 512 * 1024;
+
+typedef NTSTATUS(WINAPI* NtQuerySystemInformation_)(ULONG, PVOID, ULONG, PULONG);
+
+NtQuerySystemInformation_ GetNtQuerySystemInformation() {
+  static NtQuerySystemInformation_ pNtQuerySystemInformation = []() {
+    auto hModule = ::GetModuleHandleW(L"ntdll.dll");
+    if (hModule == nullptr) {
+      return static_cast<NtQuerySystemInformation_>(nullptr);
+    }
+
+    return reinterpret_cast<NtQuerySystemInformation_>(
+        ::GetProcAddress(hModule, "NtQuerySystemInformation")
+    );
+  }();
+
+  return pNtQuerySystemInformation;
+}
+
+size_t GetIndex(uint32_t tid, size_t mask) {
+  // thread ids are multiples of 4
+  return (static_cast<size_t>(tid >> 2) * 0x9E3779B1u) & mask;
+}
+}  // namespace
+
+ThreadStateSnapshot::ThreadStateSnapshot() : _threadsCount(0), _isValid(false) {}
+
+bool ThreadStateSnapshot::Refresh() {
+#ifdef _WIN64
+  auto pNtQuerySystemInformation = GetNtQuerySystemInformation();
+  if (pNtQuerySystemInformation == nullptr) {
+    Clear();
+    return false;
+  }
+
+  if (_buffer.empty()) {
+    _buffer.resize(InitialBufferSize);
+  }
+
+  // processes and threads might be created between two calls
+  for (int retry = 0; retry < 4; retry++) {
+    ULONG returnedSize = 0;
+    NTSTATUS status = pNtQuerySystemInformation(
+        SystemProcessInformation,
+        _buffer.data(),
+        static_cast<ULONG>(_buffer.size()),
+        &returnedSize
+    );
+    if (status == StatusInfoLengthMismatch) {
+      _buffer.resize(
+          (std::max)(_buffer.size() * 2, static_cast<size_t>(returnedSize) + 64 * 1024)
+      );
+      continue;
+    }
+
+    if (status < 0) {
+      break;
+    }
+
+    return Parse(_buffer.data(), returnedSize, ::GetCurrentProcessId());
+  }
+#endif
+
+  Clear();
+  return false;
+}
+
+bool ThreadStateSnapshot::Parse(const uint8_t* pBuffer, size_t size, uint32_t pid) {
+  Clear();
+
+  size_t offset = 0;
+  while (offset + sizeof(ProcessEntry) <= size) {
+    auto pProcess = reinterpret_cast<const ProcessEntry*>(pBuffer + offset);
+    size_t threadsSize = pProcess->NumberOfThreads * sizeof(ThreadEntry);
+    if (offset + sizeof(ProcessEntry) + threadsSize > size) {
+      break;  // truncated buffer
+    }
+
+    if (reinterpret_cast<uintptr_t>(pProcess->UniqueProcessId) == pid) {
+      Reset(pProcess->NumberOfThreads);
+
+      auto pThreads = reinterpret_cast<const ThreadEntry*>(pProcess + 1);
+      for (ULONG i = 0; i < pProcess->NumberOfThreads; i++) {
+        auto const& thread = pThreads[i];
+        ThreadState state;
+        state.tid = static_cast<uint32_t>(
+            reinterpret_cast<uintptr_t>(thread.UniqueThread)
+        );
+        state.state = thread.ThreadState;
+        state.waitReason = thread.WaitReason;
+        state.contextSwitches = thread.ContextSwitches;
+        state.cpuTime = std::chrono::milliseconds(
+            (thread.KernelTime.QuadPart + thread.UserTime.QuadPart) / 10'000
+        );
+        Insert(state);
+      }
+
+      _isValid = true;
+      return true;
+    }
+
+    if (pProcess->NextEntryOffset == 0) {
+      break;
+    }
+    offset += pProcess->NextEntryOffset;
+  }
+
+  return false;
+}
+
+const ThreadStateSnapshot::ThreadState* ThreadStateSnapshot::Find(uint32_t tid) const {
+  if (_threadsCount == 0 || tid == 0) {
+    return nullptr;
+  }
+
+  size_t mask = _table.size() - 1;
+  for (size_t index = GetIndex(tid, mask);; index = (index + 1) & mask) {
+    auto const& slot = _table[index];
+    if (slot.tid == tid) {
+      return &slot;
+    }
+    if (slot.tid == 0) {
+      return nullptr;
+    }
+  }
+}
+
+void ThreadStateSnapshot::Clear() {
+  if (_threadsCount != 0) {
+    std::fill(_table.begin(), _table.end(), ThreadState{});
+    _threadsCount = 0;
+  }
+  _isValid = false;
+}
+
+void ThreadStateSnapshot::Reset(size_t threadsCount) {
+  // keep the table at most half full
+  size_t capacity = 16;
+  while (capacity < threadsCount * 2) {
+    capacity *= 2;
+  }
+
+  if (capacity > _table.size()) {
+    _table.assign(capacity, ThreadState{});
+  }
+}
+
+void ThreadStateSnapshot::Insert(const ThreadState& state) {
+  if (state.tid == 0) {
+    return;
+  }
+
+  size_t mask = _table.size() - 1;
+  for (size_t index = GetIndex(state.tid, mask);; index = (index + 1) & mask) {
+    auto& slot = _table[index];
+    if (slot.tid == 0) {
+      slot = state;
+      _threadsCount++;
+      return;
+    }
+    if (slot.tid == state.tid) {
+      slot = state;
+      return;
+    }
+  }
+}
@@ -0,0 +1,90 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "pch.h"
+
+// State, wait reason and CPU time of all the threads of the process, fetched with a
+// single NtQuerySystemInformation(SystemProcessInformation) call per sampling tick
+// instead of one NtQueryInformationThread call per sampled thread.
+//
+// The threads are stored in a flat open addressing table indexed by thread id; the
+// buffers are reused from one refresh to the next.
+class ThreadStateSnapshot {
+ public:
+  struct ThreadState {
+    uint32_t tid = 0;  // 0 = empty slot
+    ULONG state = 0;   // ThreadState of SYSTEM_THREAD_INFORMATION
+    ULONG waitReason = 0;
+    ULONG contextSwitches = 0;
+    std::chrono::milliseconds cpuTime{0};  // user + kernel
+  };
+
+  // x64 layout of the SystemProcessInformation entries: each process entry is
+  // followed by NumberOfThreads thread entries
+  struct ProcessEntry {
+    ULONG NextEntryOffset;  // 0 for the last process
+    ULONG NumberOfThreads;
+    uint8_t Reserved1[48];
+    UNICODE_STRING ImageName;
+    LONG BasePriority;
+    HANDLE UniqueProcessId;
+    uint8_t Reserved2[0x100 - 0x58];
+  };
+  static_assert(sizeof(void*) != 8 || sizeof(ProcessEntry) == 0x100);
+
+  struct ThreadEntry {
+    LARGE_INTEGER KernelTime;  // 100 ns units
+    LARGE_INTEGER UserTime;
+    LARGE_INTEGER CreateTime;
+    ULONG WaitTime;
+    PVOID StartAddress;
+    HANDLE UniqueProcess;
+    HANDLE UniqueThread;
+    LONG Priority;
+    LONG BasePriority;
+    ULONG ContextSwitches;
+    ULONG ThreadState;
+    ULONG WaitReason;
+  };
+  static_assert(sizeof(void*) != 8 || sizeof(ThreadEntry) == 0x50);
+
+ public:
+  ThreadStateSnapshot();
+
+  ThreadStateSnapshot(const ThreadStateSnapshot&) = delete;
+  ThreadStateSnapshot& operator=(const ThreadStateSnapshot&) = delete;
+
+  // Query the threads of the current process. Return false (and an empty snapshot)
+  // if the query failed: the callers should fall back to per-thread queries
+  bool Refresh();
+
+  // Keep the threads of the given process from a SystemProcessInformation buffer
+  bool Parse(const uint8_t* pBuffer, size_t size, uint32_t pid);
+
+  // nullptr if the thread was not found
+  const ThreadState* Find(uint32_t tid) const;
+
+  void Clear();
+  bool IsValid() const { return _isValid; }
+  size_t GetThreadsCount() const { return _threadsCount; }
+
+ private:
+  void Reset(size_t threadsCount);
+  void Insert(const ThreadState& state);
+
+ private:
+  // SystemProcessInformation result (grows to the size returned by the system)
+  std::vector<uint8_t> _buffer;
+
+  // power of 2 size, at most half full
+  std::vector<ThreadState> _table;
+  size_t _threadsCount;
+  bool _isValid;
+};
@@ -0,0 +1,72 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "TraceContext.h"
+
+#include "pch.h"
+
+void TraceContextSlot::Write(const TraceContext& context) {
+  // odd sequence: a reader seeing it (or seeing it change) discards what it read
+  auto sequence = _sequence.load(std::memory_order_relaxed);
+  _sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  _localRootSpanId.store(context.localRootSpanId, std::memory_order_relaxed);
+  _spanId.store(context.spanId, std::memory_order_relaxed);
+  _endpointId.store(context.endpointId, std::memory_order_relaxed);
+
+  _sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool TraceContextSlot::TryRead(TraceContext& context) const {
+  for (int attempt = 0; attempt < MaxReadAttempts; attempt++) {
+    auto sequence = _sequence.load(std::memory_order_acquire);
+    if ((sequence & 1) != 0) {
+      continue;
+    }
+
+    context.localRootSpanId = _localRootSpanId.load(std::memory_order_relaxed);
+    context.spanId = _spanId.load(std::memory_order_relaxed);
+    context.endpointId = _endpointId.load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (_sequence.load(std::memory_order_relaxed) == sequence) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+TraceEndpoints::TraceEndpoints()
+    : _counts(std::make_unique<std::atomic<uint32_t>[]>(NameTable::MaxNamesCount)) {}
+
+uint32_t TraceEndpoints::Intern(std::string_view endpoint) {
+  uint32_t endpointId = NoEndpoint;
+  if (endpoint.empty() || !_endpoints.TryIntern(endpoint, endpointId)) {
+    return NoEndpoint;
+  }
+
+  return endpointId;
+}
+
+void TraceEndpoints::CountLocalRootSpan(uint32_t endpointId) {
+  if ((endpointId == NoEndpoint) || (endpointId >= NameTable::MaxNamesCount)) {
+    return;
+  }
+
+  _counts[endpointId].fetch_add(1, std::memory_order_relaxed);
+}
+
+void TraceEndpoints::ConsumeCounts(std::vector<std::pair<uint32_t, int64_t>>& counts) {
+  counts.clear();
+
+  auto endpointsCount = _endpoints.Count();
+  for (uint32_t endpointId = 1; endpointId < endpointsCount; endpointId++) {
+    auto count = _counts[endpointId].exchange(0, std::memory_order_relaxed);
+    if (count != 0) {
+      counts.emplace_back(endpointId, static_cast<int64_t>(count));
+    }
+  }
+}
@@ -0,0 +1,84 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "NameTable.h"
+#include "pch.h"
+
+// Span running on a thread, published by the instrumented code with SetTraceContext
+// (see dd-win-prof.h). The endpoint of the local root span is interned in
+// TraceEndpoints.
+struct TraceContext {
+  uint64_t localRootSpanId = 0;
+  uint64_t spanId = 0;
+  uint32_t endpointId = NameTable::UnnamedId;
+
+  inline bool IsEmpty() const { return (localRootSpanId == 0) && (spanId == 0); }
+  bool operator==(const TraceContext& other) const = default;
+};
+
+// Trace context of a thread, written by the thread itself and read by the sampler
+// without lock: a sequence lock (odd while a write is in progress) detects the reads
+// torn by a concurrent write. The sampler never waits for the writer: the thread might
+// be suspended in the middle of a write, so a read gives up after a few attempts and
+// the sample gets no trace context.
+class TraceContextSlot {
+ public:
+  // Owning thread only
+  void Write(const TraceContext& context);
+  inline uint64_t GetLocalRootSpanId() const {
+    return _localRootSpanId.load(std::memory_order_relaxed);
+  }
+
+  // Any thread: return false if the context could not be read consistently
+  bool TryRead(TraceContext& context) const;
+
+ private:
+  static constexpr int MaxReadAttempts = 4;
+
+  std::atomic<uint32_t> _sequence{0};
+  std::atomic<uint64_t> _localRootSpanId{0};
+  std::atomic<uint64_t> _spanId{0};
+  std::atomic<uint32_t> _endpointId{NameTable::UnnamedId};
+};
+
+// Endpoints of the local root spans (e.g. "GET /users") and number of local root spans
+// started for each of them since the last export. The endpoints are interned by the
+// threads publishing their trace context and the counts are consumed by the exporter.
+class TraceEndpoints {
+ public:
+  static constexpr uint32_t NoEndpoint = NameTable::UnnamedId;
+
+ public:
+  TraceEndpoints();
+
+  // Return NoEndpoint if the endpoint is empty or if the table is full
+  uint32_t Intern(std::string_view endpoint);
+
+  // The view stays valid as long as the table
+  inline std::string_view GetEndpoint(uint32_t endpointId) const {
+    return _endpoints.GetName(endpointId);
+  }
+
+  // Lock-free: called when a local root span starts
+  void CountLocalRootSpan(uint32_t endpointId);
+
+  // Replace the content of counts by the (endpoint id, count) pairs counted since the
+  // previous call
+  void ConsumeCounts(std::vector<std::pair<uint32_t, int64_t>>& counts);
+
+ private:
+  NameTable _endpoints;
+
+  // indexed by endpoint id
+  std::unique_ptr<std::atomic<uint32_t>[]> _counts;
+};
@@ -0,0 +1,204 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "UnwindInfoCache.h"
+
+#include <bit>
+#include <thread>
+
+#include "pch.h"
+
+namespace {
+// The loader notifications are not declared in the Windows SDK headers
+// (https://learn.microsoft.com/windows/win32/devnotes/ldrdllnotification)
+constexpr ULONG LdrDllNotificationReasonUnloaded = 2;
+
+struct LdrDllNotificationData {
+  ULONG Flags;
+  const void* FullDllName;  // PCUNICODE_STRING
+  const void* BaseDllName;  // PCUNICODE_STRING
+  void* DllBase;
+  ULONG SizeOfImage;
+};
+
+typedef void(__stdcall* LdrDllNotificationFunction_t)(
+    ULONG reason, const void* pNotificationData, void* pContext
+);
+typedef NTSTATUS(__stdcall* LdrRegisterDllNotificationDelegate_t)(
+    ULONG flags, LdrDllNotificationFunction_t callback, void* pContext, void** pCookie
+);
+typedef NTSTATUS(__stdcall* LdrUnregisterDllNotificationDelegate_t)(void* cookie);
+
+FARPROC GetNtdllFunction(const char* name) {
+  HMODULE moduleHandle = ::GetModuleHandleW(L"ntdll.dll");
+  if (moduleHandle == NULL) {
+    return nullptr;
+  }
+  return ::GetProcAddress(moduleHandle, name);
+}
+}  // namespace
+
+UnwindInfoCache::UnwindInfoCache(size_t capacity)
+    : _capacity(std::bit_ceil(capacity)),
+      _indexShift(64 - std::countr_zero(_capacity)),
+      _entries(std::make_unique<Entry[]>(_capacity)),
+      _epoch(0),
+      _hits(0),
+      _misses(0),
+      _invalidatedEntries(0),
+      _pNotificationCookie(nullptr) {}
+
+UnwindInfoCache::~UnwindInfoCache() { StopInvalidationOnModuleUnload(); }
+
+size_t UnwindInfoCache::GetIndex(uint64_t rip) const {
+  // Fibonacci hashing: close return addresses end up in different entries
+  return static_cast<size_t>((rip * 0x9E3779B97F4A7C15ull) >> _indexShift);
+}
+
+bool UnwindInfoCache::TryGet(
+    uint64_t rip, uint64_t& imageBase, RUNTIME_FUNCTION& entry
+) {
+  Entry& slot = _entries[GetIndex(rip)];
+
+  uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+  if (((sequence & 1) == 0) && (slot.rip.load(std::memory_order_relaxed) == rip)) {
+    uint64_t base = slot.imageBase.load(std::memory_order_relaxed);
+    uint64_t addresses = slot.beginAndEndAddresses.load(std::memory_order_relaxed);
+    uint32_t unwindData = slot.unwindData.load(std::memory_order_relaxed);
+
+    // the values are consistent only if no writer has changed the entry meanwhile
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+      imageBase = base;
+      entry.BeginAddress = static_cast<uint32_t>(addresses);
+      entry.EndAddress = static_cast<uint32_t>(addresses >> 32);
+      entry.UnwindData = unwindData;
+      _hits.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  _misses.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void UnwindInfoCache::Add(
+    uint64_t rip, uint64_t imageBase, const RUNTIME_FUNCTION& entry, uint64_t epoch
+) {
+  Entry& slot = _entries[GetIndex(rip)];
+
+  // the entry is being invalidated: don't wait, the next sample will add it
+  uint64_t sequence;
+  if (!TryLock(slot, sequence)) {
+    return;
+  }
+
+  // a module unloaded since the lookup might be the one of this entry
+  if (_epoch.load() == epoch) {
+    slot.rip.store(rip, std::memory_order_relaxed);
+    slot.imageBase.store(imageBase, std::memory_order_relaxed);
+    slot.beginAndEndAddresses.store(
+        entry.BeginAddress | (static_cast<uint64_t>(entry.EndAddress) << 32),
+        std::memory_order_relaxed
+    );
+    slot.unwindData.store(entry.UnwindData, std::memory_order_relaxed);
+  }
+
+  Unlock(slot, sequence);
+}
+
+void UnwindInfoCache::Invalidate(uint64_t imageBase) {
+  // entries added after this point check the epoch and are not stored...
+  _epoch.fetch_add(1);
+
+  // ...and the ones being added are seen once their writer unlocks them
+  uint64_t invalidatedEntries = 0;
+  for (size_t i = 0; i < _capacity; i++) {
+    Entry& slot = _entries[i];
+    uint64_t sequence;
+    while (!TryLock(slot, sequence)) {
+      std::this_thread::yield();
+    }
+
+    if ((slot.rip.load(std::memory_order_relaxed) != 0) &&
+        (slot.imageBase.load(std::memory_order_relaxed) == imageBase)) {
+      slot.rip.store(0, std::memory_order_relaxed);
+      invalidatedEntries++;
+    }
+
+    Unlock(slot, sequence);
+  }
+
+  _invalidatedEntries.fetch_add(invalidatedEntries, std::memory_order_relaxed);
+}
+
+bool UnwindInfoCache::TryLock(Entry& entry, uint64_t& sequence) {
+  sequence = entry.sequence.load(std::memory_order_relaxed);
+  if ((sequence & 1) != 0) {
+    return false;
+  }
+  if (!entry.sequence.compare_exchange_strong(sequence, sequence + 1)) {
+    return false;
+  }
+
+  // readers must not see the new values without the odd sequence
+  std::atomic_thread_fence(std::memory_order_release);
+  return true;
+}
+
+void UnwindInfoCache::Unlock(Entry& entry, uint64_t sequence) {
+  entry.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool UnwindInfoCache::StartInvalidationOnModuleUnload() {
+  if (_pNotificationCookie != nullptr) {
+    return true;
+  }
+
+  auto registerDllNotification = reinterpret_cast<LdrRegisterDllNotificationDelegate_t>(
+      GetNtdllFunction("LdrRegisterDllNotification")
+  );
+  if (registerDllNotification == nullptr) {
+    return false;
+  }
+
+  return registerDllNotification(0, OnDllNotification, this, &_pNotificationCookie) >=
+         0;
+}
+
+void UnwindInfoCache::StopInvalidationOnModuleUnload() {
+  if (_pNotificationCookie == nullptr) {
+    return;
+  }
+
+  auto unregisterDllNotification =
+      reinterpret_cast<LdrUnregisterDllNotificationDelegate_t>(
+          GetNtdllFunction("LdrUnregisterDllNotification")
+      );
+  if (unregisterDllNotification != nullptr) {
+    unregisterDllNotification(_pNotificationCookie);
+  }
+  _pNotificationCookie = nullptr;
+}
+
+void __stdcall UnwindInfoCache::OnDllNotification(
+    ULONG reason, const void* pNotificationData, void* pContext
+) {
+  // called under the loader lock
+  if ((reason != LdrDllNotificationReasonUnloaded) || (pNotificationData == nullptr)) {
+    return;
+  }
+
+  auto pData = static_cast<const LdrDllNotificationData*>(pNotificationData);
+  auto pCache = static_cast<UnwindInfoCache*>(pContext);
+  pCache->Invalidate(reinterpret_cast<uint64_t>(pData->DllBase));
+}
+
+UnwindInfoCache::Stats UnwindInfoCache::GetAndResetStats() {
+  Stats stats;
+  stats.hits = _hits.exchange(0, std::memory_order_relaxed);
+  stats.misses = _misses.exchange(0, std::memory_order_relaxed);
+  stats.invalidatedEntries = _invalidatedEntries.exchange(0, std::memory_order_relaxed);
+  return stats;
+}
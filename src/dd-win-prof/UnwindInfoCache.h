@@ -0,0 +1,91 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "pch.h"
+
+// Cache of RtlLookupFunctionEntry results keyed by instruction pointer (mostly
+// return addresses, which are the same from one sample to the next).
+//
+// - bounded: direct-mapped table, a new address replaces the previous one in its slot
+// - lock-free: each slot is protected by a sequence number (seqlock). A reader never
+//   waits (a slot being written is a miss) and a writer skips a busy slot.
+// - invalidated per module: the entries of an unloaded module are removed (see
+//   StartInvalidationOnModuleUnload) so that a module loaded at the same address does
+//   not get stale unwind data
+class UnwindInfoCache {
+ public:
+  static constexpr size_t DefaultCapacity = 4096;  // must be a power of 2
+
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t invalidatedEntries = 0;
+  };
+
+ public:
+  explicit UnwindInfoCache(size_t capacity = DefaultCapacity);
+  ~UnwindInfoCache();
+
+  UnwindInfoCache(const UnwindInfoCache&) = delete;
+  UnwindInfoCache& operator=(const UnwindInfoCache&) = delete;
+
+  bool TryGet(uint64_t rip, uint64_t& imageBase, RUNTIME_FUNCTION& entry);
+
+  // The epoch must be read before the lookup: the result is not cached if a module
+  // has been unloaded in the meantime
+  uint64_t GetEpoch() const { return _epoch.load(); }
+  void Add(
+      uint64_t rip, uint64_t imageBase, const RUNTIME_FUNCTION& entry, uint64_t epoch
+  );
+
+  // Remove the entries of the module loaded at imageBase
+  void Invalidate(uint64_t imageBase);
+
+  // Call Invalidate when a module is unloaded (LdrRegisterDllNotification)
+  bool StartInvalidationOnModuleUnload();
+  void StopInvalidationOnModuleUnload();
+
+  Stats GetAndResetStats();
+  size_t GetCapacity() const { return _capacity; }
+
+ private:
+  struct Entry {
+    // odd while the entry is written
+    std::atomic<uint64_t> sequence{0};
+
+    // 0 = empty entry
+    std::atomic<uint64_t> rip{0};
+    std::atomic<uint64_t> imageBase{0};
+    std::atomic<uint64_t> beginAndEndAddresses{0};
+    std::atomic<uint32_t> unwindData{0};
+  };
+
+  size_t GetIndex(uint64_t rip) const;
+  static bool TryLock(Entry& entry, uint64_t& sequence);
+  static void Unlock(Entry& entry, uint64_t sequence);
+
+  static void __stdcall OnDllNotification(
+      ULONG reason, const void* pNotificationData, void* pContext
+  );
+
+ private:
+  const size_t _capacity;
+  const int _indexShift;
+  std::unique_ptr<Entry[]> _entries;
+
+  // incremented each time a module is unloaded
+  std::atomic<uint64_t> _epoch;
+
+  std::atomic<uint64_t> _hits;
+  std::atomic<uint64_t> _misses;
+  std::atomic<uint64_t> _invalidatedEntries;
+
+  void* _pNotificationCookie;
+};
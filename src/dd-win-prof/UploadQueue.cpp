@@ -0,0 +1,293 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "UploadQueue.h"
+
+#include "Log.h"
+#include "OpSysTools.h"
+#include "UploadSpool.h"
+#include "pch.h"
+
+UploadQueue::UploadQueue(
+    IProfileSender* pSender,
+    size_t capacity,
+    std::chrono::milliseconds initialBackoff,
+    std::chrono::milliseconds maxBackoff,
+    UploadSpool* pSpool
+)
+    : _pSender(pSender),
+      _pSpool(pSpool),
+      _capacity((std::max)(capacity, size_t{1})),
+      _initialBackoff(initialBackoff),
+      _maxBackoff(maxBackoff),
+      _isStopped(false),
+      _consecutiveFailuresCount(0),
+      _random(std::random_device{}()),
+      _sentCount(0),
+      _failedCount(0),
+      _spooledCount(0),
+      _discardedCount(0) {}
+
+UploadQueue::~UploadQueue() { Stop(false); }
+
+void UploadQueue::Start() {
+  if (_uploaderThread.joinable()) {
+    return;
+  }
+
+  _uploaderThread = std::thread([this] {
+    OpSysTools::SetNativeThreadName(UploaderThreadName);
+    UploadLoop();
+  });
+}
+
+void UploadQueue::Stop(bool sendPendingUploads) {
+  {
+    std::lock_guard lock(_lock);
+    _isStopped = true;
+  }
+  _uploadAvailable.notify_one();
+
+  if (_uploaderThread.joinable()) {
+    _uploaderThread.join();
+  }
+
+  // the spool is not drained here: it would delay the shutdown
+  if (sendPendingUploads) {
+    SendPendingUploads();
+  }
+
+  std::deque<PendingUpload> remainingUploads;
+  {
+    std::lock_guard lock(_lock);
+    remainingUploads.swap(_pendingUploads);
+  }
+  SpillOrDiscard(remainingUploads);
+}
+
+void UploadQueue::Enqueue(PendingUpload&& upload) {
+  std::deque<PendingUpload> overflowUploads;
+  {
+    std::lock_guard lock(_lock);
+    _pendingUploads.push_back(std::move(upload));
+
+    // keep the most recent profiles in memory
+    while (_pendingUploads.size() > _capacity) {
+      overflowUploads.push_back(std::move(_pendingUploads.front()));
+      _pendingUploads.pop_front();
+    }
+  }
+  _uploadAvailable.notify_one();
+
+  if (!overflowUploads.empty()) {
+    Log::Debug("Upload queue full (", _capacity, " profiles)");
+    SpillOrDiscard(overflowUploads);
+  }
+}
+
+std::chrono::milliseconds UploadQueue::ComputeBackoff(
+    uint32_t failuresCount,
+    double jitter,
+    std::chrono::milliseconds initialBackoff,
+    std::chrono::milliseconds maxBackoff
+) {
+  if (failuresCount == 0) {
+    return std::chrono::milliseconds::zero();
+  }
+
+  auto delay = initialBackoff;
+  for (uint32_t i = 1; (i < failuresCount) && (delay < maxBackoff); i++) {
+    delay *= 2;
+  }
+  delay = (std::min)(delay, maxBackoff);
+
+  auto halfDelay = delay / 2;
+  auto jitterMs = static_cast<int64_t>(static_cast<double>(halfDelay.count()) * jitter);
+  return halfDelay + std::chrono::milliseconds(jitterMs);
+}
+
+size_t UploadQueue::GetPendingCount() const {
+  std::lock_guard lock(_lock);
+  return _pendingUploads.size();
+}
+
+size_t UploadQueue::GetPendingSize() const {
+  std::lock_guard lock(_lock);
+  size_t pendingSize = 0;
+  for (const auto& upload : _pendingUploads) {
+    pendingSize += upload.size;
+  }
+  return pendingSize;
+}
+
+uint64_t UploadQueue::GetSentCount() const {
+  std::lock_guard lock(_lock);
+  return _sentCount;
+}
+
+uint64_t UploadQueue::GetFailedCount() const {
+  std::lock_guard lock(_lock);
+  return _failedCount;
+}
+
+uint64_t UploadQueue::GetSpooledCount() const {
+  std::lock_guard lock(_lock);
+  return _spooledCount;
+}
+
+uint64_t UploadQueue::GetDiscardedCount() const {
+  std::lock_guard lock(_lock);
+  return _discardedCount;
+}
+
+void UploadQueue::UploadLoop() {
+  std::unique_lock lock(_lock);
+  while (!_isStopped) {
+    // still backing off: the pending uploads wait for the next attempt
+    if (std::chrono::steady_clock::now() < _nextAttemptTime) {
+      _uploadAvailable.wait_until(lock, _nextAttemptTime);
+      continue;
+    }
+
+    PendingUpload upload;
+    if (!TakeNextUpload(lock, upload)) {
+      _uploadAvailable.wait(lock);
+      continue;
+    }
+
+    // stopped while reading the spool: Stop() takes care of the upload
+    if (_isStopped) {
+      _pendingUploads.push_front(std::move(upload));
+      break;
+    }
+
+    // the exporter must be able to enqueue while the profile is being sent
+    lock.unlock();
+    auto status = _pSender->Send(upload);
+    lock.lock();
+
+    OnUploaded(std::move(upload), status);
+  }
+}
+
+bool UploadQueue::TakeNextUpload(
+    std::unique_lock<std::mutex>& lock, PendingUpload& upload
+) {
+  // a failed upload is retried before the others
+  if (!_pendingUploads.empty() && (_pendingUploads.front().attemptsCount > 0)) {
+    upload = std::move(_pendingUploads.front());
+    _pendingUploads.pop_front();
+    return true;
+  }
+
+  // the spooled uploads are older than the queued ones; reading the spool must not
+  // block the exporter
+  while ((_pSpool != nullptr) && !_pSpool->IsEmpty()) {
+    lock.unlock();
+    bool isRead = _pSpool->ReadOldest(upload);
+    lock.lock();
+
+    // otherwise, the spooled file was corrupted or taken by another process
+    if (isRead) {
+      return true;
+    }
+  }
+
+  if (_pendingUploads.empty()) {
+    return false;
+  }
+
+  upload = std::move(_pendingUploads.front());
+  _pendingUploads.pop_front();
+  return true;
+}
+
+void UploadQueue::SendPendingUploads() {
+  std::unique_lock lock(_lock);
+
+  // don't delay the shutdown with attempts that would time out
+  while (!_pendingUploads.empty() && (_consecutiveFailuresCount == 0)) {
+    auto upload = std::move(_pendingUploads.front());
+    _pendingUploads.pop_front();
+
+    lock.unlock();
+    auto status = _pSender->Send(upload);
+    lock.lock();
+
+    OnUploaded(std::move(upload), status);
+  }
+}
+
+void UploadQueue::SpillOrDiscard(std::deque<PendingUpload>& uploads) {
+  // called without holding the lock: writing to the spool is slow
+  uint64_t spooledCount = 0;
+  uint64_t discardedCount = 0;
+  for (auto& upload : uploads) {
+    // the serialized bytes are kept to be sent later
+    _pSender->Discard(upload);
+
+    if ((_pSpool != nullptr) && _pSpool->Write(upload)) {
+      spooledCount++;
+      continue;
+    }
+
+    discardedCount++;
+    Log::Warn(
+        "Profile #",
+        upload.exportId,
+        " discarded after ",
+        upload.attemptsCount,
+        " failed attempts"
+    );
+  }
+
+  std::lock_guard lock(_lock);
+  _spooledCount += spooledCount;
+  _discardedCount += discardedCount;
+}
+
+void UploadQueue::OnUploaded(PendingUpload&& upload, UploadStatus status) {
+  if (status == UploadStatus::Sent) {
+    _sentCount++;
+  } else {
+    _failedCount++;
+  }
+
+  // the endpoint could be reached: a rejected upload is not retried
+  if (status != UploadStatus::Failed) {
+    if (_consecutiveFailuresCount > 0) {
+      Log::Info(
+          "Profiles upload resumed after ",
+          _consecutiveFailuresCount,
+          " failed attempts (",
+          _pendingUploads.size(),
+          " pending profiles)"
+      );
+    }
+    _consecutiveFailuresCount = 0;
+    _nextAttemptTime = {};
+    return;
+  }
+
+  _consecutiveFailuresCount++;
+  std::uniform_real_distribution<double> jitter(0.0, 1.0);
+  auto backoff = ComputeBackoff(
+      _consecutiveFailuresCount, jitter(_random), _initialBackoff, _maxBackoff
+  );
+  _nextAttemptTime = std::chrono::steady_clock::now() + backoff;
+
+  // retried first by the next attempt
+  upload.attemptsCount++;
+  _pendingUploads.push_front(std::move(upload));
+
+  Log::Warn(
+      "Profile upload failed ",
+      _consecutiveFailuresCount,
+      " times in a row: next attempt in ",
+      backoff.count(),
+      "ms (",
+      _pendingUploads.size(),
+      " pending profiles)"
+  );
+}
@@ -0,0 +1,153 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "TagsHelper.h"
+#include "datadog/profiling.h"
+#include "pch.h"
+
+class UploadSpool;
+
+// Serialized profile waiting to be uploaded, with everything needed to build its
+// request again: the encoded profile is only used by the first attempt (libdatadog
+// consumes it) while the next ones, possibly made by another process after being
+// spooled, send the serialized bytes
+struct PendingUpload {
+  uint32_t exportId = 0;
+  ddog_prof_EncodedProfile encodedProfile{};  // inner is null once consumed
+  std::vector<uint8_t> profileBytes;          // compressed pprof
+  int64_t startMs = 0;                        // since epoch
+  int64_t endMs = 0;
+  tags exportTags;  // stable tags of the exporter followed by the tags of the export
+  std::vector<std::pair<std::string, int64_t>> endpointCounts;
+  std::string internalMetadataJson;
+  std::string infoJson;
+  uint32_t attemptsCount = 0;  // failed attempts
+  size_t size = 0;             // in bytes
+};
+
+enum class UploadStatus {
+  Sent,      // accepted by the agent or the intake
+  Rejected,  // reached the agent or the intake but refused: retrying would not help
+  Failed,    // agent or intake not reachable or overloaded: retried later
+};
+
+// Upload the profiles (replaced by a fake intake in the tests)
+class IProfileSender {
+ public:
+  virtual ~IProfileSender() = default;
+
+  // The encoded profile (if any) is consumed, whatever the status: a failed upload is
+  // sent again from its serialized bytes
+  virtual UploadStatus Send(PendingUpload& upload) = 0;
+
+  // Release the encoded profile of an upload that is discarded or spooled
+  virtual void Discard(PendingUpload& upload) = 0;
+};
+
+// Uploader stage between the exporter and the agent/intake: the exporter enqueues the
+// serialized profiles and never waits for the network. The uploader thread sends them
+// in order.
+//
+// When the agent or the intake cannot be reached, the failed profile is kept and the
+// next attempt is delayed by a jittered exponential backoff so that a down endpoint is
+// not hit by every profile (the jitter spreads the retries of the processes restarted
+// at the same time). The failed profile is retried first; once it is sent, the
+// profiles exported meanwhile follow.
+//
+// The queue is bounded: when it is full, the oldest profile is spilled to the spool
+// directory (if any, see UploadSpool) or discarded. The spooled profiles are older
+// than the queued ones, so they are sent first: the spool drains as soon as the
+// endpoint is reachable again, including after a restart of the process.
+class UploadQueue {
+ public:
+  UploadQueue(
+      IProfileSender* pSender,
+      size_t capacity = DefaultCapacity,
+      std::chrono::milliseconds initialBackoff = DefaultInitialBackoff,
+      std::chrono::milliseconds maxBackoff = DefaultMaxBackoff,
+      UploadSpool* pSpool = nullptr
+  );
+  ~UploadQueue();
+
+  UploadQueue(const UploadQueue&) = delete;
+  UploadQueue& operator=(const UploadQueue&) = delete;
+
+  void Start();
+
+  // The queued uploads are sent before returning unless sendPendingUploads is false
+  // (e.g. the process is exiting) or the endpoint is not reachable: they are then
+  // spilled to the spool, or discarded without spool
+  void Stop(bool sendPendingUploads = true);
+
+  // Never blocks on the network: the upload is sent by the uploader thread
+  void Enqueue(PendingUpload&& upload);
+
+  // Delay before the next attempt after failuresCount consecutive failures, in
+  // [delay/2, delay] where delay doubles with each failure up to maxBackoff; jitter is
+  // in [0, 1)
+  static std::chrono::milliseconds ComputeBackoff(
+      uint32_t failuresCount,
+      double jitter,
+      std::chrono::milliseconds initialBackoff,
+      std::chrono::milliseconds maxBackoff
+  );
+
+  size_t GetPendingCount() const;  // in memory (not spooled)
+  size_t GetPendingSize() const;   // serialized size of the pending profiles in bytes
+  uint64_t GetSentCount() const;
+  uint64_t GetFailedCount() const;  // failed or rejected attempts
+  uint64_t GetSpooledCount() const;
+  uint64_t GetDiscardedCount() const;
+
+ public:
+  static constexpr size_t DefaultCapacity = 8;
+  static constexpr std::chrono::milliseconds DefaultInitialBackoff{10'000};
+  static constexpr std::chrono::milliseconds DefaultMaxBackoff{300'000};
+
+ private:
+  void UploadLoop();
+  bool TakeNextUpload(std::unique_lock<std::mutex>& lock, PendingUpload& upload);
+  void SendPendingUploads();
+  void OnUploaded(PendingUpload&& upload, UploadStatus status);
+  void SpillOrDiscard(std::deque<PendingUpload>& uploads);
+
+ private:
+  const WCHAR* UploaderThreadName = L"DD_uploader";
+
+  IProfileSender* _pSender;
+  UploadSpool* _pSpool;
+  const size_t _capacity;
+  const std::chrono::milliseconds _initialBackoff;
+  const std::chrono::milliseconds _maxBackoff;
+
+  mutable std::mutex _lock;
+  std::condition_variable _uploadAvailable;
+  std::deque<PendingUpload> _pendingUploads;
+  bool _isStopped;
+
+  // backoff state (guarded by _lock)
+  uint32_t _consecutiveFailuresCount;
+  std::chrono::steady_clock::time_point _nextAttemptTime;
+  std::mt19937 _random;
+
+  uint64_t _sentCount;
+  uint64_t _failedCount;
+  uint64_t _spooledCount;
+  uint64_t _discardedCount;
+
+  std::thread _uploaderThread;
+};
@@ -0,0 +1,362 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "UploadSpool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "Log.h"
+#include "pch.h"
+
+namespace {
+// The leftovers of a process killed while writing or reading a file are removed
+// after this delay (the other processes might still be using them)
+constexpr auto StaleFileDelay = std::chrono::minutes(10);
+
+class SpoolWriter {
+ public:
+  explicit SpoolWriter(std::vector<uint8_t>& buffer) : _buffer(buffer) {}
+
+  template <typename T>
+  void Write(T value) {
+    auto pValue = reinterpret_cast<const uint8_t*>(&value);
+    _buffer.insert(_buffer.end(), pValue, pValue + sizeof(T));
+  }
+
+  void Write(const std::string& value) {
+    Write(static_cast<uint32_t>(value.size()));
+    _buffer.insert(_buffer.end(), value.begin(), value.end());
+  }
+
+ private:
+  std::vector<uint8_t>& _buffer;
+};
+
+// Every read is bounds checked: the file might be truncated or corrupted
+class SpoolReader {
+ public:
+  explicit SpoolReader(std::span<const uint8_t> buffer) : _buffer(buffer), _offset(0) {}
+
+  template <typename T>
+  bool Read(T& value) {
+    if (_buffer.size() - _offset < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&value, _buffer.data() + _offset, sizeof(T));
+    _offset += sizeof(T);
+    return true;
+  }
+
+  bool Read(std::string& value) {
+    uint32_t size = 0;
+    if (!Read(size) || (_buffer.size() - _offset < size)) {
+      return false;
+    }
+    value.assign(reinterpret_cast<const char*>(_buffer.data() + _offset), size);
+    _offset += size;
+    return true;
+  }
+
+  std::span<const uint8_t> ReadRemaining() {
+    auto remaining = _buffer.subspan(_offset);
+    _offset = _buffer.size();
+    return remaining;
+  }
+
+ private:
+  std::span<const uint8_t> _buffer;
+  size_t _offset;
+};
+}  // namespace
+
+UploadSpool::UploadSpool(fs::path directory, uint64_t maxSize)
+    : _directory(std::move(directory)),
+      _maxSize(maxSize),
+      _processId(::GetCurrentProcessId()),
+      _size(0),
+      _evictedCount(0) {}
+
+bool UploadSpool::Initialize() {
+  std::error_code ec;
+  fs::create_directories(_directory, ec);
+  if (ec) {
+    Log::Warn(
+        "Failed to create the upload spool directory ",
+        _directory.string(),
+        ": ",
+        ec.message()
+    );
+    return false;
+  }
+
+  RemoveStaleFiles();
+
+  std::lock_guard lock(_lock);
+  for (const auto& entry : fs::directory_iterator(_directory, ec)) {
+    if (!entry.is_regular_file(ec) || (entry.path().extension() != FileExtension)) {
+      continue;
+    }
+
+    auto size = entry.file_size(ec);
+    if (ec) {
+      continue;
+    }
+    _files.push_back({entry.path().filename().string(), size});
+    _size += size;
+  }
+  std::sort(_files.begin(), _files.end(), [](const auto& left, const auto& right) {
+    return left.name < right.name;
+  });
+
+  if (!_files.empty()) {
+    Log::Info(
+        _files.size(),
+        " spooled profiles found in ",
+        _directory.string(),
+        " (",
+        _size,
+        " bytes)"
+    );
+  }
+  return true;
+}
+
+bool UploadSpool::Write(const PendingUpload& upload) {
+  auto content = Serialize(upload);
+  if (content.size() > _maxSize) {
+    Log::Warn(
+        "Profile #",
+        upload.exportId,
+        " too large to be spooled (",
+        content.size(),
+        " bytes for a spool of ",
+        _maxSize,
+        " bytes)"
+    );
+    return false;
+  }
+
+  // the file is renamed once complete so that a partial file is never read
+  auto name = GetFileName(upload);
+  auto tempPath = _directory / (name + TempExtension);
+  {
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(content.data()), content.size());
+    if (!file) {
+      file.close();
+      std::error_code ec;
+      fs::remove(tempPath, ec);
+      Log::Warn("Failed to write spooled profile ", tempPath.string());
+      return false;
+    }
+  }
+
+  std::lock_guard lock(_lock);
+  while (!_files.empty() && (_size + content.size() > _maxSize)) {
+    std::error_code ec;
+    fs::remove(_directory / _files.front().name, ec);
+    _size -= _files.front().size;
+    _files.pop_front();
+    _evictedCount++;
+  }
+
+  std::error_code ec;
+  fs::rename(tempPath, _directory / name, ec);
+  if (ec) {
+    fs::remove(tempPath, ec);
+    Log::Warn("Failed to rename spooled profile ", tempPath.string());
+    return false;
+  }
+
+  AddFile({std::move(name), content.size()});
+  return true;
+}
+
+bool UploadSpool::ReadOldest(PendingUpload& upload) {
+  SpooledFile file;
+  {
+    std::lock_guard lock(_lock);
+    if (_files.empty()) {
+      return false;
+    }
+    file = std::move(_files.front());
+    _files.pop_front();
+    _size -= file.size;
+  }
+
+  // another process sharing the spool might have claimed it first
+  auto claimedPath = _directory / (file.name + ClaimedExtension);
+  std::error_code ec;
+  fs::rename(_directory / file.name, claimedPath, ec);
+  if (ec) {
+    return false;
+  }
+
+  std::vector<uint8_t> content;
+  {
+    std::ifstream stream(claimedPath, std::ios::binary);
+    content.assign(
+        std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()
+    );
+  }
+  fs::remove(claimedPath, ec);
+
+  if (!Deserialize(content, upload)) {
+    Log::Warn("Corrupted spooled profile ", file.name, " deleted");
+    return false;
+  }
+  return true;
+}
+
+bool UploadSpool::IsEmpty() const {
+  std::lock_guard lock(_lock);
+  return _files.empty();
+}
+
+size_t UploadSpool::GetFilesCount() const {
+  std::lock_guard lock(_lock);
+  return _files.size();
+}
+
+uint64_t UploadSpool::GetSize() const {
+  std::lock_guard lock(_lock);
+  return _size;
+}
+
+uint64_t UploadSpool::GetEvictedCount() const {
+  std::lock_guard lock(_lock);
+  return _evictedCount;
+}
+
+std::vector<uint8_t> UploadSpool::Serialize(const PendingUpload& upload) {
+  std::vector<uint8_t> buffer;
+  buffer.reserve(upload.profileBytes.size() + 4096);
+
+  SpoolWriter writer(buffer);
+  writer.Write(Magic);
+  writer.Write(FormatVersion);
+  writer.Write(upload.exportId);
+  writer.Write(upload.attemptsCount);
+  writer.Write(upload.startMs);
+  writer.Write(upload.endMs);
+
+  writer.Write(static_cast<uint32_t>(upload.exportTags.size()));
+  for (const auto& [key, value] : upload.exportTags) {
+    writer.Write(key);
+    writer.Write(value);
+  }
+
+  writer.Write(static_cast<uint32_t>(upload.endpointCounts.size()));
+  for (const auto& [endpoint, count] : upload.endpointCounts) {
+    writer.Write(endpoint);
+    writer.Write(count);
+  }
+
+  writer.Write(upload.internalMetadataJson);
+  writer.Write(upload.infoJson);
+
+  // the profile takes the rest of the file
+  buffer.insert(buffer.end(), upload.profileBytes.begin(), upload.profileBytes.end());
+  return buffer;
+}
+
+bool UploadSpool::Deserialize(std::span<const uint8_t> buffer, PendingUpload& upload) {
+  SpoolReader reader(buffer);
+
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  if (!reader.Read(magic) || (magic != Magic) || !reader.Read(version) ||
+      (version != FormatVersion)) {
+    return false;
+  }
+
+  if (!reader.Read(upload.exportId) || !reader.Read(upload.attemptsCount) ||
+      !reader.Read(upload.startMs) || !reader.Read(upload.endMs)) {
+    return false;
+  }
+
+  uint32_t tagsCount = 0;
+  if (!reader.Read(tagsCount)) {
+    return false;
+  }
+  upload.exportTags.clear();
+  for (uint32_t i = 0; i < tagsCount; i++) {
+    auto& [key, value] = upload.exportTags.emplace_back();
+    if (!reader.Read(key) || !reader.Read(value)) {
+      return false;
+    }
+  }
+
+  uint32_t endpointsCount = 0;
+  if (!reader.Read(endpointsCount)) {
+    return false;
+  }
+  upload.endpointCounts.clear();
+  for (uint32_t i = 0; i < endpointsCount; i++) {
+    auto& [endpoint, count] = upload.endpointCounts.emplace_back();
+    if (!reader.Read(endpoint) || !reader.Read(count)) {
+      return false;
+    }
+  }
+
+  if (!reader.Read(upload.internalMetadataJson) || !reader.Read(upload.infoJson)) {
+    return false;
+  }
+
+  auto profile = reader.ReadRemaining();
+  if (profile.empty()) {
+    return false;
+  }
+  upload.profileBytes.assign(profile.begin(), profile.end());
+  upload.size = upload.profileBytes.size();
+  upload.encodedProfile = {};
+  return true;
+}
+
+std::string UploadSpool::ToFileName(std::string_view name) {
+  std::string fileName;
+  fileName.reserve(name.size());
+  for (char c : name) {
+    bool isValid = ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) ||
+                   ((c >= '0') && (c <= '9')) || (c == '-') || (c == '_');
+    fileName.push_back(isValid ? c : '_');
+  }
+  return fileName;
+}
+
+std::string UploadSpool::GetFileName(const PendingUpload& upload) const {
+  // zero padded so that the names are sorted by start time
+  return std::format(
+      "{:020}-{}-{}{}", upload.startMs, _processId, upload.exportId, FileExtension
+  );
+}
+
+void UploadSpool::AddFile(SpooledFile&& file) {
+  // usually the most recent profile, but a retried one is older
+  auto isBefore = [](const std::string& name, const SpooledFile& other) {
+    return name < other.name;
+  };
+  auto it = std::upper_bound(_files.begin(), _files.end(), file.name, isBefore);
+  _size += file.size;
+  _files.insert(it, std::move(file));
+}
+
+void UploadSpool::RemoveStaleFiles() {
+  std::error_code ec;
+  auto staleTime = fs::file_time_type::clock::now() - StaleFileDelay;
+  for (const auto& entry : fs::directory_iterator(_directory, ec)) {
+    auto extension = entry.path().extension();
+    if ((extension != TempExtension) && (extension != ClaimedExtension)) {
+      continue;
+    }
+
+    auto lastWriteTime = entry.last_write_time(ec);
+    if (!ec && (lastWriteTime < staleTime)) {
+      fs::remove(entry.path(), ec);
+    }
+  }
+}
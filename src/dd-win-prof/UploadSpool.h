@@ -0,0 +1,83 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "UploadQueue.h"
+#include "pch.h"
+
+// Size-capped directory of the profiles that could not be uploaded (see UploadQueue):
+// one file per profile with its serialized bytes and the metadata of its request, so
+// that it can be sent later, possibly by another process of the same service.
+//
+// The file names start with the profile start time so that the oldest profile comes
+// first; when the cap is reached, the oldest profiles are evicted. A file is claimed
+// (renamed) before being read so that a profile is not sent twice by the processes
+// sharing the directory. The size is only tracked for the files known by this process
+// (spooled by it or found at initialization).
+class UploadSpool {
+ public:
+  UploadSpool(fs::path directory, uint64_t maxSize);
+
+  // Create the directory and index the profiles spooled by the previous processes
+  bool Initialize();
+
+  // Evict the oldest profiles to stay under the cap; false if the profile alone is
+  // larger than the cap or cannot be written
+  bool Write(const PendingUpload& upload);
+
+  // Remove the oldest profile from the spool; false if there is none or if it cannot be
+  // read (a corrupted file is deleted)
+  bool ReadOldest(PendingUpload& upload);
+
+  bool IsEmpty() const;
+  size_t GetFilesCount() const;
+  uint64_t GetSize() const;  // in bytes
+  uint64_t GetEvictedCount() const;
+  const fs::path& GetDirectory() const { return _directory; }
+
+  // Serialized format of a spooled profile (exposed for the tests)
+  static std::vector<uint8_t> Serialize(const PendingUpload& upload);
+  static bool Deserialize(std::span<const uint8_t> buffer, PendingUpload& upload);
+
+  // Replace the characters that are not valid in a file name (e.g. service name), '.'
+  // included so that the name cannot point to a parent directory
+  static std::string ToFileName(std::string_view name);
+
+ public:
+  static constexpr const char* FileExtension = ".ddspool";
+
+ private:
+  struct SpooledFile {
+    std::string name;  // sorted by start time
+    uint64_t size;
+  };
+
+  std::string GetFileName(const PendingUpload& upload) const;
+  void AddFile(SpooledFile&& file);
+  void RemoveStaleFiles();
+
+ private:
+  static constexpr const char* TempExtension = ".tmp";
+  static constexpr const char* ClaimedExtension = ".claimed";
+  static constexpr uint32_t Magic = 0x53504444;  // "DDPS"
+  static constexpr uint32_t FormatVersion = 1;
+
+  const fs::path _directory;
+  const uint64_t _maxSize;
+  uint32_t _processId;
+
+  mutable std::mutex _lock;
+  std::deque<SpooledFile> _files;  // oldest first
+  uint64_t _size;
+  uint64_t _evictedCount;
+};
@@ -0,0 +1,43 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <semaphore>
+
+#include "pch.h"
+
+// Wake up a thread waiting for work. Notify() is lock-free and never waits, so it can
+// be called by the sampler thread; the notifications sent while the waiting thread is
+// busy are merged into a single wakeup.
+class WakeupSignal {
+ public:
+  // Any thread
+  void Notify() {
+    if (_isPending.load(std::memory_order_relaxed) ||
+        _isPending.exchange(true, std::memory_order_acq_rel)) {
+      return;
+    }
+    _semaphore.release();
+  }
+
+  // Waiting thread only: return false if not notified before the timeout
+  bool WaitFor(std::chrono::nanoseconds timeout) {
+    if (!_semaphore.try_acquire_for(timeout)) {
+      return false;
+    }
+
+    // the work published before this point is seen by the caller; the next
+    // notification wakes it up again
+    _isPending.store(false, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  // set from the first notification until the wakeup: the semaphore count stays <= 1
+  std::atomic<bool> _isPending{false};
+  std::binary_semaphore _semaphore{0};
+};
@@ -11,19 +11,62 @@ class WallTimeProvider : public CollectorBase {
  public:
   WallTimeProvider(SampleValueTypeProvider& valueTypeProvider);
 
-  inline void Add(
-      Sample&& sample,
+  inline bool Add(
+      std::chrono::nanoseconds timestamp,
+      uint32_t threadId,
+      uint64_t threadGeneration,
+      std::span<const uint64_t> frames,
+      uint32_t rumViewHandle,
+      const TraceContext& traceContext,
       std::chrono::nanoseconds walltimeDuration,
       std::chrono::nanoseconds waitDuration,
       ULONG waitingReason
   ) {
-    auto offsets = GetValueOffsets();
-    sample.AddValue(walltimeDuration.count(), offsets[0]);
-    sample.AddValue(waitDuration.count(), offsets[1]);
+    auto* pSlot = ReserveSample(
+        timestamp, threadId, threadGeneration, frames, rumViewHandle, traceContext
+    );
+    if (pSlot == nullptr) {
+      return false;
+    }
+
+    auto const& offsets = GetValueOffsets();
+    pSlot->values[offsets[0]] = walltimeDuration.count();
+    pSlot->values[offsets[1]] = waitDuration.count();
 
     // TODO: copy waiting reason into a label
 
-    CollectorBase::Add(std::move(sample));
+    CommitSample();
+    return true;
+  }
+
+  // Sample standing for threadsCount threads waiting with the same callstack: the
+  // duration is the sum of their wall (and wait) times (see WalltimeSampleFolder)
+  inline bool AddFolded(
+      std::chrono::nanoseconds timestamp,
+      uint32_t threadId,
+      uint64_t threadGeneration,
+      uint64_t threadGroup,
+      uint32_t threadsCount,
+      std::span<const uint64_t> frames,
+      uint32_t rumViewHandle,
+      std::chrono::nanoseconds duration
+  ) {
+    // only the waiting threads without trace context are folded
+    auto* pSlot =
+        ReserveSample(timestamp, threadId, threadGeneration, frames, rumViewHandle, {});
+    if (pSlot == nullptr) {
+      return false;
+    }
+
+    pSlot->threadGroup = threadGroup;
+    pSlot->foldedThreadsCount = threadsCount;
+
+    auto const& offsets = GetValueOffsets();
+    pSlot->values[offsets[0]] = duration.count();
+    pSlot->values[offsets[1]] = duration.count();
+
+    CommitSample();
+    return true;
   }
 
   static std::vector<SampleValueType> SampleTypeDefinitions;
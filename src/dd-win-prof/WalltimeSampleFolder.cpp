@@ -0,0 +1,83 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#include "WalltimeSampleFolder.h"
+
+#include <algorithm>
+
+#include "Symbolication.h"
+#include "pch.h"
+
+void WalltimeSampleFolder::Add(
+    uint32_t threadId,
+    uint64_t threadGeneration,
+    uint64_t threadGroup,
+    std::span<const uint64_t> frames,
+    std::chrono::nanoseconds duration,
+    ThreadInfo* pThreadInfo,
+    std::chrono::nanoseconds sampleTimestamp
+) {
+  uint64_t hash = frames.size();
+  for (auto frame : frames) {
+    hash_combine(hash, frame);
+  }
+
+  for (size_t i = 0; i < _records.size(); i++) {
+    auto& record = _records[i];
+    if (IsSameKey(record, hash, threadGroup, frames)) {
+      record.threadsCount++;
+      record.duration += duration;
+      AddPendingThread(i, pThreadInfo, sampleTimestamp);
+      return;
+    }
+  }
+
+  Record record;
+  record.hash = hash;
+  record.threadGroup = threadGroup;
+  record.threadId = threadId;
+  record.threadGeneration = threadGeneration;
+  record.threadsCount = 1;
+  record.duration = duration;
+  record.framesOffset = static_cast<uint32_t>(_frames.size());
+  record.framesCount = static_cast<uint32_t>(frames.size());
+
+  _frames.insert(_frames.end(), frames.begin(), frames.end());
+  _records.push_back(record);
+  AddPendingThread(_records.size() - 1, pThreadInfo, sampleTimestamp);
+}
+
+void WalltimeSampleFolder::AddPendingThread(
+    size_t recordIndex,
+    ThreadInfo* pThreadInfo,
+    std::chrono::nanoseconds sampleTimestamp
+) {
+  if (pThreadInfo != nullptr) {
+    _pendingThreads.push_back(
+        PendingThread{static_cast<uint32_t>(recordIndex), pThreadInfo, sampleTimestamp}
+    );
+  }
+}
+
+void WalltimeSampleFolder::Clear() {
+  _records.clear();
+  _frames.clear();
+  _pendingThreads.clear();
+}
+
+bool WalltimeSampleFolder::IsSameKey(
+    const Record& record,
+    uint64_t hash,
+    uint64_t threadGroup,
+    std::span<const uint64_t> frames
+) const {
+  if ((record.hash != hash) || (record.threadGroup != threadGroup) ||
+      (record.framesCount != frames.size())) {
+    return false;
+  }
+
+  return std::equal(
+      frames.begin(), frames.end(), _frames.begin() + record.framesOffset
+  );
+}
@@ -0,0 +1,128 @@
+// Unless explicitly stated otherwise all files in this repository are licensed under
+// the Apache 2 License. This product includes software developed at Datadog
+// (https://www.datadoghq.com/). Copyright 2025 Datadog, Inc.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "ThreadInfo.h"
+#include "pch.h"
+
+// Folding of the walltime samples of the waiting threads collected during one sampling
+// tick: the threads of a pool parked in the same wait produce a single record (with
+// the number of threads and the sum of their durations) instead of one sample each,
+// so there are fewer samples to write into the ring and to aggregate on export.
+// The threads are grouped by callstack and thread name group (see
+// ThreadInfo::GetThreadNameGroup): their thread id is lost. Like the other walltime
+// samples, the folded ones don't keep the wait reason.
+//
+// The threads of a record are only marked as sampled when the record is written: if
+// the ring is full, their wall time is accounted in their next sample.
+//
+// Only used by the sampler thread. There are at most a few records per tick (bounded
+// by the walltime threads threshold) so they are searched linearly; their storage is
+// reused from one tick to the next.
+class WalltimeSampleFolder {
+ public:
+  struct Record {
+    uint64_t hash;
+    uint64_t threadGroup;
+
+    // first thread of the group, to get the name of the group on export
+    uint32_t threadId;
+    uint64_t threadGeneration;
+
+    uint32_t threadsCount;
+    std::chrono::nanoseconds duration;  // wall time = wait time for waiting threads
+    uint32_t framesOffset;
+    uint32_t framesCount;
+  };
+
+  struct FlushStats {
+    uint32_t samplesCount = 0;  // written records
+    uint32_t threadsCount = 0;  // threads of the written records
+    std::chrono::nanoseconds duration{0};
+  };
+
+ public:
+  void Add(
+      uint32_t threadId,
+      uint64_t threadGeneration,
+      uint64_t threadGroup,
+      std::span<const uint64_t> frames,
+      std::chrono::nanoseconds duration,
+      // marked as sampled at sampleTimestamp when the record is written
+      ThreadInfo* pThreadInfo = nullptr,
+      std::chrono::nanoseconds sampleTimestamp = std::chrono::nanoseconds::zero()
+  );
+
+  // Write each record with writeRecord(record, frames), which returns false if the
+  // record is dropped (e.g. full ring), then clear the records. The threads of the
+  // written records are marked as sampled at the timestamp of their sample.
+  // The threads must stay alive until then (see ThreadList::ReadGuard).
+  template <typename WriteRecord>
+  FlushStats Flush(WriteRecord&& writeRecord) {
+    FlushStats stats;
+    _isWritten.assign(_records.size(), false);
+    for (size_t i = 0; i < _records.size(); i++) {
+      const auto& record = _records[i];
+      if (!writeRecord(record, GetFrames(record))) {
+        continue;
+      }
+
+      _isWritten[i] = true;
+      stats.samplesCount++;
+      stats.threadsCount += record.threadsCount;
+      stats.duration += record.duration;
+    }
+
+    for (const auto& pendingThread : _pendingThreads) {
+      if (_isWritten[pendingThread.recordIndex]) {
+        pendingThread.pThreadInfo->SetLastWalltimeSampleTimestamp(
+            pendingThread.sampleTimestamp
+        );
+      }
+    }
+
+    Clear();
+    return stats;
+  }
+
+  // Remove the records but keep their storage
+  void Clear();
+
+  inline bool IsEmpty() const { return _records.empty(); }
+  inline std::span<const Record> GetRecords() const { return _records; }
+  inline std::span<const uint64_t> GetFrames(const Record& record) const {
+    return {_frames.data() + record.framesOffset, record.framesCount};
+  }
+
+ private:
+  void AddPendingThread(
+      size_t recordIndex,
+      ThreadInfo* pThreadInfo,
+      std::chrono::nanoseconds sampleTimestamp
+  );
+  bool IsSameKey(
+      const Record& record,
+      uint64_t hash,
+      uint64_t threadGroup,
+      std::span<const uint64_t> frames
+  ) const;
+
+ private:
+  struct PendingThread {
+    uint32_t recordIndex;
+    ThreadInfo* pThreadInfo;
+    std::chrono::nanoseconds sampleTimestamp;
+  };
+
+  std::vector<Record> _records;
+  std::vector<uint64_t> _frames;
+  std::vector<PendingThread> _pendingThreads;
+  std::vector<bool> _isWritten;
+};
@@ -4,9 +4,23 @@
 
 #pragma once
 
+#include <cstddef>
+
 #include "Configuration.h"
 #include "dd-win-prof.h"
 
+// Size of the first version of ProfilerConfig (before disableTimeline was appended)
+constexpr uint32_t ProfilerConfigV1Size = offsetof(ProfilerConfig, disableTimeline);
+
+// true if the struct passed by the caller (of pSettings->size bytes) contains the field
+#define PROFILER_CONFIG_HAS_FIELD(pSettings, field) \
+  ((pSettings)->size >= offsetof(ProfilerConfig, field) + sizeof((pSettings)->field))
+
+// Accepted values of ProfilerConfig::size: the current one and the previous versions
+inline bool IsValidProfilerConfigSize(uint32_t size) {
+  return (size == sizeof(ProfilerConfig)) || (size == ProfilerConfigV1Size);
+}
+
 // Applies ProfilerConfig fields to a Configuration object.
 // When pSettings->noEnvVars is true, resets to defaults first so that
 // only the explicit struct fields take effect.
@@ -16,7 +16,8 @@ DD_WIN_PROF_API bool SetupProfiler(const ProfilerConfig* pSettings) {
     return false;
   }
 
-  if (pSettings->size != sizeof(ProfilerConfig)) {
+  // callers built with an older header pass a smaller struct
+  if (!IsValidProfilerConfigSize(pSettings->size)) {
     Log::Warn("Invalid profiler configuration structure.");
     return false;
   }
@@ -87,6 +88,16 @@ DD_WIN_PROF_API bool LeaveCurrentView() {
   return profiler->LeaveCurrentView();
 }
 
+DD_WIN_PROF_API bool SetTraceContext(
+    uint64_t localRootSpanId, uint64_t spanId, const char* endpoint
+) {
+  auto profiler = Profiler::GetInstance();
+  if (profiler == nullptr) {
+    return false;
+  }
+  return profiler->SetTraceContext(localRootSpanId, spanId, endpoint);
+}
+
 DD_WIN_PROF_API bool SetRumSession(const RumSessionContext* pContext) {
   auto profiler = Profiler::GetInstance();
   if (profiler == nullptr) {
@@ -50,6 +50,14 @@ typedef struct _ProfilerConfig {
   //       via DD_TRACE_LOG_DIRECTORY (default: %PROGRAMDATA%\Datadog Tracer\logs)
   const char* pprofOutputDirectory;  // override for pprof debug output directory
                                      // (default: empty = disabled)
+
+  // NOTE: new fields are appended below so that the size of the struct changes; they
+  //       are ignored if the size set by the caller does not cover them
+
+  // samples aggregation
+  bool disableTimeline;  // if true, samples with the same callstack and labels are
+                         // aggregated without timestamp: smaller profiles but no
+                         // timeline view (default: false = timeline enabled)
 } ProfilerConfig;
 
 extern "C" {
@@ -72,6 +80,16 @@ DD_WIN_PROF_API bool EnterView(const char* viewName);
 // Returns true if a view was active and is now cleared, false if no view was active.
 DD_WIN_PROF_API bool LeaveCurrentView();
 
+// Publish the span currently running on the calling thread: its samples get the
+// "local root span id" and "span id" labels, and the endpoint of the local root span
+// (e.g. "GET /users", can be null) is attached to them. Each local root span published
+// with spanId == localRootSpanId is counted for its endpoint.
+// Call it again when the current span changes and with 0 ids when it ends.
+// Returns false if the calling thread is not known by the profiler.
+DD_WIN_PROF_API bool SetTraceContext(
+    uint64_t localRootSpanId, uint64_t spanId, const char* endpoint
+);
+
 // Environment Variables (independent controls):
 // DD_PROFILING_ENABLED: Controls whether profiler CAN be started
 //   - false/0: Blocks all profiling (security override)